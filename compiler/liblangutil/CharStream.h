@@ -52,9 +52,11 @@
 
 #pragma once
 
+#include <algorithm>
 #include <cstdint>
 #include <string>
 #include <tuple>
+#include <utility>
 
 namespace solidity::langutil
 {
@@ -68,14 +70,37 @@ class CharStream
 {
 public:
 	CharStream() = default;
-	explicit CharStream(std::string const& _source, std::string const& name):
-		m_source(_source), m_name(name) {}
+	/// Takes the source by value, so callers that do not need the text afterwards can move it in.
+	explicit CharStream(std::string _source, std::string name):
+		m_source(std::move(_source)), m_name(std::move(name)) {}
 
 	int position() const { return m_position; }
 	bool isPastEndOfInput(size_t _charsForward = 0) const { return (m_position + _charsForward) >= m_source.size(); }
 
 	char get(size_t _charsForward = 0) const { return m_source[m_position + _charsForward]; }
 	char advanceAndGet(size_t _chars = 1);
+	/// Advances the position while @a _predicate holds for the current character.
+	/// Works directly on the buffer, so long runs (whitespace, comments, identifiers) are skipped
+	/// without the per-character end of input checks of advanceAndGet().
+	/// @returns The character of the current location after update (0 at the end of input).
+	template <typename Predicate>
+	char advanceWhile(Predicate _predicate)
+	{
+		char const* const begin = m_source.data();
+		char const* const end = begin + m_source.size();
+		char const* it = begin + std::min(m_position, m_source.size());
+		while (it != end && _predicate(*it))
+			++it;
+		m_position = static_cast<size_t>(it - begin);
+		return it == end ? 0 : *it;
+	}
+	/// Moves to the first occurrence of @a _text at or after the current position or to the end of input.
+	/// @returns The character of the current location after update (0 at the end of input).
+	char advanceTo(char const* _text)
+	{
+		m_position = std::min(m_source.find(_text, m_position), m_source.size());
+		return isPastEndOfInput() ? 0 : m_source[m_position];
+	}
 	/// Sets scanner position to @ _amount characters backwards in source text.
 	/// @returns The character of the current location after update is returned.
 	char rollback(size_t _amount);
@@ -90,6 +90,17 @@ ostream& operator<<(ostream& os, ScannerError _errorCode)
 	return os << to_string(_errorCode);
 }
 
+namespace
+{
+
+/// @returns false for the bytes a line terminator (see Scanner::isUnicodeLinebreak) can start with.
+bool isNotLinebreakStart(char _c)
+{
+	return (_c < 0x0a || 0x0d < _c) && uint8_t(_c) != 0xc2 && uint8_t(_c) != 0xe2;
+}
+
+}
+
 /// Scoped helper for literal recording. Automatically drops the literal
 /// if aborting the scanning before it's complete.
 enum LiteralType
@@ -261,24 +272,28 @@ Token Scanner::selectToken(char _next, Token _then, Token _else)
 bool Scanner::skipWhitespace()
 {
 	int const startPosition = sourcePos();
-	while (isWhiteSpace(m_char))
-		advance();
+	advanceWhile(isWhiteSpace);
 	// Return whether or not we skipped any characters.
 	return sourcePos() != startPosition;
 }
 
 void Scanner::skipWhitespaceExceptUnicodeLinebreak()
 {
-	while (isWhiteSpace(m_char) && !isUnicodeLinebreak())
-		advance();
+	advanceWhile([](char _c) { return _c == ' ' || _c == '\t'; });
 }
 
 Token Scanner::skipSingleLineComment()
 {
 	// Line terminator is not part of the comment. If it is a
 	// non-ascii line terminator, it will result in a parser error.
-	while (!isUnicodeLinebreak())
-		if (!advance()) break;
+	while (true)
+	{
+		advanceWhile(isNotLinebreakStart);
+		if (isSourcePastEndOfInput() || isUnicodeLinebreak())
+			break;
+		// A multi-byte character which is not a line terminator.
+		advance();
+	}
 
 	return Token::Whitespace;
 }
@@ -334,8 +349,11 @@ Token Scanner::scanSingleLineDocComment()
 			// Any line terminator that is not '\n' is considered to end the
 			// comment.
 			break;
-		addCommentLiteralChar(m_char);
+		// Take the current character and the rest of the line up to a possible line terminator at once.
+		int const begin = sourcePos();
 		advance();
+		advanceWhile(isNotLinebreakStart);
+		m_skippedComments[NextNext].literal.append(source(), begin, sourcePos() - begin);
 	}
 	literal.complete();
 	return Token::CommentLiteral;
@@ -344,19 +362,15 @@ Token Scanner::scanSingleLineDocComment()
 Token Scanner::skipMultiLineComment()
 {
 	advance();
-	while (!isSourcePastEndOfInput())
+	m_char = m_source->advanceTo("*/");
+	if (!isSourcePastEndOfInput())
 	{
-		char ch = m_char;
-		advance();
-
 		// If we have reached the end of the multi-line comment, we
 		// consume the '/' and insert a whitespace. This way all
 		// multi-line comments are treated as whitespace.
-		if (ch == '*' && m_char == '/')
-		{
-			m_char = ' ';
-			return Token::Whitespace;
-		}
+		m_source->advanceAndGet();
+		m_char = ' ';
+		return Token::Whitespace;
 	}
 	// Unterminated multi-line comment.
 	return setError(ScannerError::IllegalCommentTerminator);
@@ -404,9 +418,12 @@ Token Scanner::scanMultiLineDocComment()
 			endFound = true;
 			break;
 		}
-		addCommentLiteralChar(m_char);
-		charsAdded = true;
+		// Take the current character and the following ones up to a possible line or comment end at once.
+		int const begin = sourcePos();
 		advance();
+		advanceWhile([](char _c) { return _c != '\n' && _c != '\r' && _c != '*'; });
+		m_skippedComments[NextNext].literal.append(source(), begin, sourcePos() - begin);
+		charsAdded = true;
 	}
 	literal.complete();
 	if (!endFound)
@@ -928,10 +945,15 @@ tuple<Token, unsigned, unsigned> Scanner::scanIdentifierOrKeyword()
 {
 	solAssert(isIdentifierStart(m_char), "");
 	LiteralScope literal(this, LITERAL_TYPE_STRING);
-	addLiteralCharAndAdvance();
+	size_t const begin = sourcePos();
+	advance();
 	// Scan the rest of the identifier characters.
-	while (isIdentifierPart(m_char) || (m_char == '.' && m_supportPeriodInIdentifier))
-		addLiteralCharAndAdvance();
+	if (m_supportPeriodInIdentifier)
+		advanceWhile([](char _c) { return isIdentifierPart(_c) || _c == '.'; });
+	else
+		advanceWhile(isIdentifierPart);
+	// Identifiers have no escapes, so the literal is copied from the source text at once.
+	m_tokens[NextNext].literal.assign(source(), begin, sourcePos() - begin);
 	literal.complete();
 	return TokenTraits::fromIdentifierOrKeyword(m_tokens[NextNext].literal);
 }
@@ -195,6 +195,17 @@ private:
 	///@}
 
 	bool advance() { m_char = m_source->advanceAndGet(); return !m_source->isPastEndOfInput(); }
+	/// Advances while @a _predicate holds for the current character. m_char is tested first because
+	/// it does not always match the source (the end of a multi-line comment is turned into a space).
+	template <typename Predicate>
+	void advanceWhile(Predicate _predicate)
+	{
+		if (_predicate(m_char))
+		{
+			advance();
+			m_char = m_source->advanceWhile(_predicate);
+		}
+	}
 	void rollback(int _amount) { m_char = m_source->rollback(_amount); }
 	/// Rolls back to the start of the current token and re-runs the scanner.
 	void rescan();
@@ -134,10 +134,45 @@ struct VariableDeclarationAnnotation: DeclarationAnnotation
 	TypePointer type = nullptr;
 	/// The set of functions this (public state) variable overrides.
 	std::set<CallableDeclaration const*> baseFunctions;
+	/// Set by TVM code generator: the local array of bounded size is kept as a TVM tuple
+	/// instead of {length, dict}.
+	std::optional<bool> isTupleArray;
+};
+
+/// Control flow facts of a statement, used by TVM code generator.
+struct ContInfo
+{
+	static constexpr int CONTINUE_FLAG = 1;
+	static constexpr int BREAK_FLAG = 2;
+	static constexpr int RETURN_FLAG = 4;
+
+	bool canReturn{};
+	bool canBreak{};
+	bool canContinue{};
+	bool alwaysReturns{};
+	bool alwaysBreak{};
+	bool alwaysContinue{};
+
+	bool doThatAlways() const {
+		return alwaysReturns || alwaysBreak || alwaysContinue;
+	}
+
+	bool mayDoThat() const {
+		return canReturn || canBreak || canContinue;
+	}
+};
+
+/// Where return statements are placed in a block.
+enum class LocationReturn {
+	noReturn,
+	Last,
+	Anywhere
 };
 
 struct StatementAnnotation: ASTAnnotation
 {
+	/// Set for all statements of a function at once by ControlFlowScanner.
+	std::optional<ContInfo> contInfo;
 };
 
 struct InlineAssemblyAnnotation: StatementAnnotation
@@ -153,6 +188,7 @@ struct InlineAssemblyAnnotation: StatementAnnotation
 
 struct BlockAnnotation: StatementAnnotation, ScopableAnnotation
 {
+	std::optional<LocationReturn> locationReturn;
 };
 
 struct TryCatchClauseAnnotation: ASTAnnotation, ScopableAnnotation
@@ -0,0 +1,363 @@
+/*
+	This file is part of solidity.
+
+	solidity is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	solidity is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with solidity.  If not, see <http://www.gnu.org/licenses/>.
+*/
+/**
+ * @date 2021
+ * Compact binary form of the JSON AST
+ */
+
+#include <libsolidity/ast/ASTBinary.h>
+
+#include <cstring>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+using namespace std;
+using namespace solidity::frontend;
+
+namespace
+{
+
+char const c_magic[] = {'S', 'A', 'S', 'T'};
+
+enum class Tag: uint8_t
+{
+	Null,
+	False,
+	True,
+	Int,
+	UInt,
+	Real,
+	String,
+	Array,
+	Object
+};
+
+class Writer
+{
+public:
+	explicit Writer(ostream& _out): m_out(_out) {}
+
+	void collectStrings(Json::Value const& _value)
+	{
+		switch (_value.type())
+		{
+		case Json::stringValue:
+			addString(_value.asString());
+			break;
+		case Json::arrayValue:
+			for (Json::Value const& item: _value)
+				collectStrings(item);
+			break;
+		case Json::objectValue:
+			for (auto it = _value.begin(); it != _value.end(); ++it)
+			{
+				addString(it.name());
+				collectStrings(*it);
+			}
+			break;
+		default:
+			break;
+		}
+	}
+
+	void addString(string const& _str)
+	{
+		if (m_stringIndex.emplace(_str, m_strings.size()).second)
+			m_strings.push_back(_str);
+	}
+
+	void writeStringTable()
+	{
+		writeVarint(m_strings.size());
+		for (string const& str: m_strings)
+		{
+			writeVarint(str.size());
+			m_out.write(str.data(), str.size());
+		}
+	}
+
+	void writeString(string const& _str)
+	{
+		writeVarint(m_stringIndex.at(_str));
+	}
+
+	void writeValue(Json::Value const& _value)
+	{
+		switch (_value.type())
+		{
+		case Json::nullValue:
+			writeTag(Tag::Null);
+			break;
+		case Json::booleanValue:
+			writeTag(_value.asBool() ? Tag::True : Tag::False);
+			break;
+		case Json::intValue:
+		{
+			int64_t const value = _value.asInt64();
+			writeTag(Tag::Int);
+			writeVarint((static_cast<uint64_t>(value) << 1) ^ static_cast<uint64_t>(value >> 63));
+			break;
+		}
+		case Json::uintValue:
+			writeTag(Tag::UInt);
+			writeVarint(_value.asUInt64());
+			break;
+		case Json::realValue:
+		{
+			double const value = _value.asDouble();
+			uint64_t bits;
+			memcpy(&bits, &value, sizeof(bits));
+			writeTag(Tag::Real);
+			for (int i = 0; i < 8; ++i)
+				m_out.put(static_cast<char>(bits >> (8 * i)));
+			break;
+		}
+		case Json::stringValue:
+			writeTag(Tag::String);
+			writeString(_value.asString());
+			break;
+		case Json::arrayValue:
+			writeTag(Tag::Array);
+			writeVarint(_value.size());
+			for (Json::Value const& item: _value)
+				writeValue(item);
+			break;
+		case Json::objectValue:
+			writeTag(Tag::Object);
+			writeVarint(_value.size());
+			for (auto it = _value.begin(); it != _value.end(); ++it)
+			{
+				writeString(it.name());
+				writeValue(*it);
+			}
+			break;
+		}
+	}
+
+	void writeVarint(uint64_t _value)
+	{
+		while (_value >= 0x80)
+		{
+			m_out.put(static_cast<char>(_value | 0x80));
+			_value >>= 7;
+		}
+		m_out.put(static_cast<char>(_value));
+	}
+
+private:
+	void writeTag(Tag _tag)
+	{
+		m_out.put(static_cast<char>(_tag));
+	}
+
+	ostream& m_out;
+	vector<string> m_strings;
+	unordered_map<string, size_t> m_stringIndex;
+};
+
+class Reader
+{
+public:
+	explicit Reader(string const& _data): m_data(_data) {}
+
+	bool readHeader()
+	{
+		if (m_data.size() < sizeof(c_magic) + 4 || memcmp(m_data.data(), c_magic, sizeof(c_magic)) != 0)
+			return false;
+		m_pos = sizeof(c_magic);
+		uint32_t version = 0;
+		for (int i = 0; i < 4; ++i)
+			version |= static_cast<uint32_t>(static_cast<uint8_t>(m_data[m_pos++])) << (8 * i);
+		return version == ASTBinary::version;
+	}
+
+	bool readStringTable()
+	{
+		optional<uint64_t> count = readVarint();
+		if (!count || *count > m_data.size())
+			return false;
+		m_strings.reserve(*count);
+		for (uint64_t i = 0; i < *count; ++i)
+		{
+			optional<uint64_t> length = readVarint();
+			if (!length || *length > m_data.size() - m_pos)
+				return false;
+			m_strings.emplace_back(m_data.data() + m_pos, *length);
+			m_pos += *length;
+		}
+		return true;
+	}
+
+	optional<string_view> readString()
+	{
+		optional<uint64_t> index = readVarint();
+		if (!index || *index >= m_strings.size())
+			return nullopt;
+		return m_strings[*index];
+	}
+
+	bool readValue(Json::Value& _value, int _depth = 0)
+	{
+		// ASTs are deep, but not that deep. The limit protects the reader from stack overflow on broken input.
+		if (m_pos >= m_data.size() || _depth > 10000)
+			return false;
+		switch (static_cast<Tag>(m_data[m_pos++]))
+		{
+		case Tag::Null:
+			_value = Json::nullValue;
+			return true;
+		case Tag::False:
+			_value = false;
+			return true;
+		case Tag::True:
+			_value = true;
+			return true;
+		case Tag::Int:
+		{
+			optional<uint64_t> zigzag = readVarint();
+			if (!zigzag)
+				return false;
+			_value = static_cast<Json::Int64>((*zigzag >> 1) ^ (~(*zigzag & 1) + 1));
+			return true;
+		}
+		case Tag::UInt:
+		{
+			optional<uint64_t> value = readVarint();
+			if (!value)
+				return false;
+			_value = static_cast<Json::UInt64>(*value);
+			return true;
+		}
+		case Tag::Real:
+		{
+			if (m_data.size() - m_pos < 8)
+				return false;
+			uint64_t bits = 0;
+			for (int i = 0; i < 8; ++i)
+				bits |= static_cast<uint64_t>(static_cast<uint8_t>(m_data[m_pos++])) << (8 * i);
+			double value;
+			memcpy(&value, &bits, sizeof(value));
+			_value = value;
+			return true;
+		}
+		case Tag::String:
+		{
+			optional<string_view> str = readString();
+			if (!str)
+				return false;
+			_value = Json::Value(str->data(), str->data() + str->size());
+			return true;
+		}
+		case Tag::Array:
+		{
+			optional<uint64_t> size = readVarint();
+			if (!size || *size > m_data.size() - m_pos)
+				return false;
+			_value = Json::Value(Json::arrayValue);
+			_value.resize(static_cast<Json::ArrayIndex>(*size));
+			for (Json::ArrayIndex i = 0; i < *size; ++i)
+				if (!readValue(_value[i], _depth + 1))
+					return false;
+			return true;
+		}
+		case Tag::Object:
+		{
+			optional<uint64_t> size = readVarint();
+			if (!size || *size > m_data.size() - m_pos)
+				return false;
+			_value = Json::Value(Json::objectValue);
+			for (uint64_t i = 0; i < *size; ++i)
+			{
+				optional<string_view> key = readString();
+				if (!key || !readValue(_value[string{*key}], _depth + 1))
+					return false;
+			}
+			return true;
+		}
+		}
+		return false;
+	}
+
+	optional<uint64_t> readVarint()
+	{
+		uint64_t value = 0;
+		for (int shift = 0; shift < 64; shift += 7)
+		{
+			if (m_pos >= m_data.size())
+				return nullopt;
+			auto const byte = static_cast<uint8_t>(m_data[m_pos++]);
+			value |= static_cast<uint64_t>(byte & 0x7F) << shift;
+			if ((byte & 0x80) == 0)
+				return value;
+		}
+		return nullopt;
+	}
+
+	bool atEnd() const
+	{
+		return m_pos == m_data.size();
+	}
+
+private:
+	string const& m_data;
+	size_t m_pos{};
+	vector<string_view> m_strings;
+};
+
+}
+
+void ASTBinary::write(map<string, Json::Value> const& _asts, ostream& _out)
+{
+	Writer writer{_out};
+	for (auto const& [name, ast]: _asts)
+	{
+		writer.addString(name);
+		writer.collectStrings(ast);
+	}
+
+	_out.write(c_magic, sizeof(c_magic));
+	for (int i = 0; i < 4; ++i)
+		_out.put(static_cast<char>(version >> (8 * i)));
+	writer.writeStringTable();
+	writer.writeVarint(_asts.size());
+	for (auto const& [name, ast]: _asts)
+	{
+		writer.writeString(name);
+		writer.writeValue(ast);
+	}
+}
+
+optional<map<string, Json::Value>> ASTBinary::read(string const& _data)
+{
+	Reader reader{_data};
+	if (!reader.readHeader() || !reader.readStringTable())
+		return nullopt;
+	optional<uint64_t> count = reader.readVarint();
+	if (!count)
+		return nullopt;
+	map<string, Json::Value> asts;
+	for (uint64_t i = 0; i < *count; ++i)
+	{
+		optional<string_view> name = reader.readString();
+		if (!name || !reader.readValue(asts[string{*name}]))
+			return nullopt;
+	}
+	if (!reader.atEnd())
+		return nullopt;
+	return asts;
+}
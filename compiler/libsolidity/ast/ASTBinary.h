@@ -0,0 +1,64 @@
+/*
+	This file is part of solidity.
+
+	solidity is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	solidity is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with solidity.  If not, see <http://www.gnu.org/licenses/>.
+*/
+/**
+ * @date 2021
+ * Compact binary form of the JSON AST
+ */
+
+#pragma once
+
+#include <json/json.h>
+
+#include <cstdint>
+#include <map>
+#include <optional>
+#include <ostream>
+#include <string>
+
+namespace solidity::frontend
+{
+
+/**
+ * Binary encoding of the compact JSON AST (see ASTJsonConverter) of several source units.
+ *
+ * Layout (all integers are LEB128 varints unless noted otherwise):
+ *   magic "SAST", version (uint32 little endian)
+ *   string table: count, then length and bytes of each string
+ *   source count, then for each source: name (string index) and the AST value
+ * A value is a tag byte followed by its payload:
+ *   null, false, true: nothing
+ *   int: zigzag varint; uint: varint; real: 8 bytes little endian
+ *   string: string index
+ *   array: size and elements; object: size and pairs of key (string index) and value
+ *
+ * Member names, node types, "src" locations and names are stored once in the string table and the
+ * table comes first, so a reader can keep it as views into a mapped file.
+ */
+class ASTBinary
+{
+public:
+	static uint32_t constexpr version = 1;
+
+	/// Writes the ASTs (@a _asts maps source names to the compact JSON AST) to @a _out.
+	static void write(std::map<std::string, Json::Value> const& _asts, std::ostream& _out);
+
+	/// @returns the ASTs written by write() or nullopt if @a _data is malformed or has another version.
+	/// Used by `solc --ast-binary-to-json`.
+	static std::optional<std::map<std::string, Json::Value>> read(std::string const& _data);
+};
+
+}
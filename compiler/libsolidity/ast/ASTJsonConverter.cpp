@@ -184,7 +184,7 @@ void ASTJsonConverter::appendExpressionAttributes(
 
 void ASTJsonConverter::print(ostream& _stream, ASTNode const& _node)
 {
-	_stream << util::jsonPrettyPrint(toJson(_node));
+	util::jsonPrettyPrint(toJson(_node), _stream);
 }
 
 Json::Value&& ASTJsonConverter::toJson(ASTNode const& _node)
@@ -17,14 +17,21 @@
  */
 
 
+#include <libsolutil/TimeReport.h>
+
 #include "TVM.h"
+#include "TVMABI.hpp"
+#include "TVMCodeStats.hpp"
 #include "TVMContractCompiler.hpp"
+#include "TVMGasEstimator.hpp"
+#include "TVMProfile.hpp"
 
 using namespace solidity::frontend;
 
 solidity::langutil::ErrorReporter* GlobalParams::g_errorReporter{};
 bool GlobalParams::g_withOptimizations{};
 bool GlobalParams::g_withDebugInfo{};
+TVMProfile const* GlobalParams::g_profile{};
 
 void TVMCompilerProceedContract(
     solidity::langutil::ErrorReporter* errorReporter,
@@ -32,11 +39,14 @@ void TVMCompilerProceedContract(
 	std::vector<PragmaDirective const *> const* pragmaDirectives,
 	bool generateAbi,
 	bool generateCode,
+	bool generateCodeStats,
+	bool generateGasEstimate,
 	bool withOptimizations,
 	bool withDebugInfo,
 	const std::string& solFileName,
 	const std::string& outputFolder,
 	const std::string& filePrefix,
+	const std::string& profileFileName,
 	bool doPrintFunctionIds
 ) {
     GlobalParams::g_errorReporter = errorReporter;
@@ -68,16 +78,102 @@ void TVMCompilerProceedContract(
 		pathToFiles = (fs::path(dir) / pathToFiles).string();
     }
 
+	TimeReport::ScopedTimer timer{"contract " + _contract.name()};
+	std::unique_ptr<TVMProfile> profile;
+	if (!profileFileName.empty())
+		profile = TVMProfile::load(profileFileName);
+	GlobalParams::g_profile = profile.get();
 	PragmaDirectiveHelper pragmaHelper{*pragmaDirectives};
 	if (doPrintFunctionIds) {
 		TVMContractCompiler::printFunctionIds(_contract, pragmaHelper);
 	} else {
-		if (generateCode) {
-			TVMContractCompiler::proceedContract(pathToFiles + ".code", _contract, pragmaHelper);
+		if (generateCode || generateCodeStats || generateGasEstimate) {
+			TVMContractCompiler::proceedContract(
+				generateCode ? pathToFiles + ".code" : "",
+				generateCodeStats ? pathToFiles + ".stats.json" : "",
+				generateGasEstimate ? pathToFiles + ".gas.json" : "",
+				_contract,
+				pragmaHelper
+			);
 		}
 		if (generateAbi) {
+			TimeReport::ScopedTimer abiTimer{"abi"};
 			TVMContractCompiler::generateABI(pathToFiles + ".abi.json", &_contract, *pragmaDirectives);
 		}
 	}
+	GlobalParams::g_profile = nullptr;
+
+}
+
+namespace {
+
+Json::Value debugMap(CodeLines const& code) {
+	Json::Value map(Json::arrayValue);
+	int line = 1;
+	for (std::string const& s : code.lines) {
+		std::string::size_type const begin = s.find_first_not_of('\t');
+		if (begin != std::string::npos && s.compare(begin, 5, ".loc ") == 0) {
+			std::string::size_type const comma = s.rfind(", ");
+			if (comma != std::string::npos && comma > begin + 5) {
+				Json::Value entry(Json::objectValue);
+				entry["line"] = line;
+				entry["source"] = s.substr(begin + 5, comma - begin - 5);
+				entry["sourceLine"] = std::stoi(s.substr(comma + 2));
+				map.append(entry);
+			}
+		}
+		line += 1 + static_cast<int>(std::count(s.begin(), s.end(), '\n'));
+	}
+	return map;
+}
+
+} // end anonymous namespace
+
+Json::Value TVMCompilerContractOutputs(
+	solidity::langutil::ErrorReporter* errorReporter,
+	ContractDefinition const& _contract,
+	std::vector<PragmaDirective const *> const& pragmaDirectives,
+	std::set<std::string> const& outputs,
+	bool withOptimizations,
+	bool withDebugInfo
+) {
+	GlobalParams::g_errorReporter = errorReporter;
+	GlobalParams::g_withDebugInfo = withDebugInfo || outputs.count("debugMap");
+	GlobalParams::g_withOptimizations = withOptimizations;
+	GlobalParams::g_profile = nullptr;
 
-}
\ No newline at end of file
+	TimeReport::ScopedTimer timer{"contract " + _contract.name()};
+	PragmaDirectiveHelper pragmaHelper{pragmaDirectives};
+	Json::Value result(Json::objectValue);
+	if (outputs.count("functionIds")) {
+		result["functionIds"] = Json::objectValue;
+		for (auto const& [name, id] : TVMABI::functionIds(_contract, pragmaHelper)) {
+			std::ostringstream hex;
+			hex << "0x" << std::hex << std::setfill('0') << std::setw(8) << id;
+			result["functionIds"][name] = hex.str();
+		}
+	}
+	bool const needsCode =
+		outputs.count("assembly") || outputs.count("codeStats") ||
+		outputs.count("gasEstimates") || outputs.count("debugMap");
+	if (needsCode && _contract.canBeDeployed()) {
+		CodeLines code;
+		{
+			TimeReport::ScopedTimer codegenTimer{"codegen"};
+			code = TVMContractCompiler::generateContractCode(&_contract, pragmaHelper);
+		}
+		if (outputs.count("assembly"))
+			result["assembly"] = code.str();
+		if (outputs.count("codeStats"))
+			result["codeStats"] = TVMCodeStats{code}.toJson(_contract.name());
+		if (outputs.count("gasEstimates"))
+			result["gasEstimates"] = TVMGasEstimator{code}.toJson(_contract.name());
+		if (outputs.count("debugMap"))
+			result["debugMap"] = debugMap(code);
+	}
+	if (outputs.count("abi")) {
+		TimeReport::ScopedTimer abiTimer{"abi"};
+		result["abi"] = TVMABI::generateABIJson(&_contract, pragmaDirectives);
+	}
+	return result;
+}
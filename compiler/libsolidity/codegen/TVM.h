@@ -18,15 +18,23 @@
 
 #pragma once
 
+#include <set>
+#include <string>
 #include <vector>
+#include <json/json.h>
 #include <liblangutil/ErrorReporter.h>
 #include <libsolidity/ast/ASTForward.h>
 
+namespace solidity::frontend {
+class TVMProfile;
+}
+
 class GlobalParams {
 public:
     static solidity::langutil::ErrorReporter* g_errorReporter;
     static bool g_withOptimizations;
     static bool g_withDebugInfo;
+    static solidity::frontend::TVMProfile const* g_profile;
 };
 
 void TVMCompilerProceedContract(
@@ -35,10 +43,25 @@ void TVMCompilerProceedContract(
 	std::vector<solidity::frontend::PragmaDirective const *> const* pragmaDirectives,
 	bool generateAbi,
 	bool generateCode,
+	bool generateCodeStats,
+	bool generateGasEstimate,
 	bool withOptimizations,
 	bool withDebugInfo,
 	const std::string& solFileName,
 	const std::string& outputFolder,
 	const std::string& filePrefix,
+	const std::string& profileFileName,
 	bool doPrintFunctionIds
-);
\ No newline at end of file
+);
+
+/// Generates the TVM outputs of the contract in memory, without touching the file system.
+/// @a outputs selects members of the result: "assembly", "abi", "functionIds", "codeStats", "gasEstimates"
+/// and "debugMap" (assembly line to source line of the .loc markers, implies debug info in "assembly").
+Json::Value TVMCompilerContractOutputs(
+	solidity::langutil::ErrorReporter* errorReporter,
+	solidity::frontend::ContractDefinition const& _contract,
+	std::vector<solidity::frontend::PragmaDirective const *> const& pragmaDirectives,
+	std::set<std::string> const& outputs,
+	bool withOptimizations,
+	bool withDebugInfo
+);
@@ -16,6 +16,7 @@
  */
 
 #include "libsolutil/picosha2.h"
+#include <libsolutil/JSON.h>
 #include <libsolidity/ast/TypeProvider.h>
 
 #include "TVMABI.hpp"
@@ -24,7 +25,7 @@
 
 using namespace solidity::frontend;
 
-void TVMABI::printFunctionIds(
+std::map<std::string, uint32_t> TVMABI::functionIds(
 	ContractDefinition const& contract,
 	PragmaDirectiveHelper const& pragmaHelper
 ) {
@@ -59,6 +60,14 @@ void TVMABI::printFunctionIds(
 		}
 	}
 
+	return map;
+}
+
+void TVMABI::printFunctionIds(
+	ContractDefinition const& contract,
+	PragmaDirectiveHelper const& pragmaHelper
+) {
+	std::map<std::string, uint32_t> map = functionIds(contract, pragmaHelper);
 	std::string lastName = map.rbegin()->first;
 	cout << "{" << endl;
 	for (const auto&[func, functionID] : map) {
@@ -72,9 +81,7 @@ void TVMABI::printFunctionIds(
 	cout << "}";
 }
 
-void TVMABI::generateABI(ContractDefinition const *contract, std::vector<PragmaDirective const *> const &pragmaDirectives,
-						ostream *out) {
-
+Json::Value TVMABI::generateABIJson(ContractDefinition const *contract, std::vector<PragmaDirective const *> const &pragmaDirectives) {
 	PragmaDirectiveHelper pdh{pragmaDirectives};
 	TVMCompilerContext ctx(contract, pdh);
 
@@ -144,6 +151,7 @@ void TVMABI::generateABI(ContractDefinition const *contract, std::vector<PragmaD
 			Json::Value cur;
 			cur["name"] = ename;
 			cur["inputs"] = encodeParams(convertArray(e->parameters()));
+			cur["outputs"] = Json::arrayValue;
 			eventAbi.append(cur);
 		}
 		root["events"] = eventAbi;
@@ -160,14 +168,17 @@ void TVMABI::generateABI(ContractDefinition const *contract, std::vector<PragmaD
 		root["data"] = data;
 	}
 
-//		Json::StreamWriterBuilder builder;
-//		const std::string json_file = Json::writeString(builder, root);
-//		*out << json_file << std::endl;
+	return root;
+}
+
+void TVMABI::generateABI(ContractDefinition const *contract, std::vector<PragmaDirective const *> const &pragmaDirectives,
+						ostream *out) {
+	Json::Value const root = generateABIJson(contract, pragmaDirectives);
 
 	*out << "{\n";
 	*out << "\t" << R"("ABI version": )" << root["ABI version"] << ",\n";
 
-	if (ctx.pragmaHelper().abiVersion() == 2) {
+	if (root.isMember("header")) {
 		*out << "\t" << R"("header": [)";
 		for (unsigned i = 0; i < root["header"].size(); ++i) {
 			*out << root["header"][i];
@@ -213,10 +224,7 @@ void TVMABI::printData(const Json::Value &json, std::ostream* out) {
 		const auto &element = json[f];
 		*out << "\t\t";
 
-		Json::StreamWriterBuilder builder;
-		builder["indentation"] = "";
-		std::unique_ptr<Json::StreamWriter> writer(builder.newStreamWriter());
-		writer->write(element, out);
+		util::jsonCompactPrint(element, *out);
 
 		if (f + 1 != json.size())
 			*out << ",";
@@ -238,11 +246,8 @@ void TVMABI::print(const Json::Value &json, ostream *out) {
 		*out << "\t\t\t" << R"("inputs": [)" << "\n";
 		for (unsigned i = 0; i < function["inputs"].size(); ++i) {
 			const auto& input = function["inputs"][i];
-			Json::StreamWriterBuilder builder;
-			builder["indentation"] = "";
-			std::unique_ptr<Json::StreamWriter> writer(builder.newStreamWriter());
 			*out << "\t\t\t\t";
-			writer->write(input, out);
+			util::jsonCompactPrint(input, *out);
 			if (i + 1 == function["inputs"].size()) {
 				*out << "\n";
 			} else {
@@ -254,11 +259,8 @@ void TVMABI::print(const Json::Value &json, ostream *out) {
 		*out << "\t\t\t" << R"("outputs": [)" << "\n";
 		for (unsigned o = 0; o < function["outputs"].size(); ++o) {
 			const auto& output = function["outputs"][o];
-			Json::StreamWriterBuilder builder;
-			builder["indentation"] = "";
-			std::unique_ptr<Json::StreamWriter> writer(builder.newStreamWriter());
 			*out << "\t\t\t\t";
-			writer->write(output, out);
+			util::jsonCompactPrint(output, *out);
 			if (o + 1 == function["outputs"].size()) {
 				*out << "\n";
 			} else {
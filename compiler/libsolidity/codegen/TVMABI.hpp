@@ -28,10 +28,16 @@ class StackPusherHelper;
 
 class TVMABI {
 public:
+	static std::map<std::string, uint32_t> functionIds(
+		ContractDefinition const& contract,
+		PragmaDirectiveHelper const& pragmaHelper
+	);
 	static void printFunctionIds(
 		ContractDefinition const& contract,
 		PragmaDirectiveHelper const& pragmaHelper
 	 );
+	static Json::Value generateABIJson(ContractDefinition const* contract,
+							std::vector<PragmaDirective const *> const& pragmaDirectives);
 	static void generateABI(ContractDefinition const* contract,
 							std::vector<PragmaDirective const *> const& pragmaDirectives, std::ostream* out = &cout);
 	static string getParamTypeString(Type const* type);
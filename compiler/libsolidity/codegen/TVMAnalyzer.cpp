@@ -19,6 +19,8 @@
 #include "TVMAnalyzer.hpp"
 #include <liblangutil/ErrorReporter.h>
 #include <libsolidity/codegen/TVMConstants.hpp>
+#include <libsolidity/codegen/TVMExpressionCompiler.hpp>
+#include <libsolidity/codegen/TVM.h>
 
 using namespace solidity::frontend;
 using namespace solidity::langutil;
@@ -247,6 +249,720 @@ bool FunctionUsageScanner::visit(const FunctionCall &_functionCall) {
 	return true;
 }
 
+ModifierPrologueScanner::ModifierPrologueScanner(ModifierDefinition const& modifier) {
+	const std::vector<ASTPointer<Statement>>& statements = modifier.body().statements();
+	if (statements.empty() || !to<PlaceholderStatement>(statements.back().get()))
+		return;
+	isPrologueOnly = true;
+	for (size_t i = 0; i + 1 < statements.size(); ++i)
+		statements[i]->accept(*this);
+}
+
+bool ModifierPrologueScanner::visit(PlaceholderStatement const&) {
+	isPrologueOnly = false;
+	return false;
+}
+
+bool ModifierPrologueScanner::visit(Return const&) {
+	isPrologueOnly = false;
+	return false;
+}
+
+bool ModifierPrologueScanner::visit(Identifier const& _identifier) {
+	// `super` is resolved by the contract of the function
+	if (_identifier.name() == "super")
+		isPrologueOnly = false;
+	return false;
+}
+
+bool LoopChangesScanner::visit(Assignment const& _assignment) {
+	markChanged(&_assignment.leftHandSide());
+	return true;
+}
+
+bool LoopChangesScanner::visit(UnaryOperation const& _node) {
+	if (isIn(_node.getOperator(), Token::Inc, Token::Dec, Token::Delete))
+		markChanged(&_node.subExpression());
+	return true;
+}
+
+bool LoopChangesScanner::visit(VariableDeclaration const& _variable) {
+	m_changed.insert(&_variable);
+	return true;
+}
+
+bool LoopChangesScanner::visit(FunctionCall const& _functionCall) {
+	Expression const* callee = &_functionCall.expression();
+	if (auto options = to<FunctionCallOptions>(callee))
+		callee = &options->expression();
+	if (auto ma = to<MemberAccess>(callee)) {
+		// methods can change the object, e.g. `arr.push(x)`
+		markChanged(&ma->expression());
+		if (ma->memberName() == "resetStorage")
+			m_haveInternalCall = true;
+	}
+	auto funcType = to<FunctionType>(callee->annotation().type);
+	if (funcType && isIn(funcType->kind(), FunctionType::Kind::Internal, FunctionType::Kind::DelegateCall))
+		m_haveInternalCall = true;
+	return true;
+}
+
+bool LoopChangesScanner::visit(PlaceholderStatement const&) {
+	m_haveInternalCall = true;
+	return true;
+}
+
+void LoopChangesScanner::markChanged(Expression const* expr) {
+	if (auto identifier = to<Identifier>(expr)) {
+		m_changed.insert(identifier->annotation().referencedDeclaration);
+	} else if (auto indexAccess = to<IndexAccess>(expr)) {
+		markChanged(&indexAccess->baseExpression());
+	} else if (auto memberAccess = to<MemberAccess>(expr)) {
+		markChanged(&memberAccess->expression());
+	} else if (auto tuple = to<TupleExpression>(expr)) {
+		for (ASTPointer<Expression> const& component : tuple->components()) {
+			if (component)
+				markChanged(component.get());
+		}
+	}
+}
+
+bool LoopChangesScanner::isInvariant(Expression const* expr) const {
+	if (to<Literal>(expr) || TVMExpressionCompiler::constValue(*expr).has_value() ||
+		TVMExpressionCompiler::constBool(*expr).has_value())
+		return true;
+	auto identifier = to<Identifier>(expr);
+	if (!identifier)
+		return false;
+	auto var = to<VariableDeclaration>(identifier->annotation().referencedDeclaration);
+	if (!var)
+		return false;
+	return var->isConstant() || isUnchanged(var);
+}
+
+bool LoopChangesScanner::isUnchanged(VariableDeclaration const* var) const {
+	if (var->isStateVariable() && m_haveInternalCall)
+		return false;
+	return (var->isStateVariable() || var->isLocalVariable() || var->isCallableOrCatchParameter()) &&
+		!m_changed.count(var);
+}
+
+MessageTemplateScanner::MessageTemplateScanner(ASTNode const& loop) {
+	loop.accept(*this);
+}
+
+bool MessageTemplateScanner::visit(FunctionCall const& _functionCall) {
+	LoopChangesScanner::visit(_functionCall);
+	std::vector<Expression const*> tail;
+	bool isWorth = false;
+	Expression const* callee = &_functionCall.expression();
+	auto options = to<FunctionCallOptions>(callee);
+	if (options)
+		callee = &options->expression();
+	auto ma = to<MemberAccess>(callee);
+	if (ma && !options && ma->memberName() == "transfer" &&
+		getType(&ma->expression())->category() == Type::Category::Address) {
+		std::vector<ASTPointer<ASTString>> const& names = _functionCall.names();
+		std::vector<ASTPointer<Expression const>> const& args = _functionCall.arguments();
+		for (size_t i = 0; i < args.size(); ++i) {
+			std::string name = names.empty() ? (i == 3 ? "body" : "") : *names.at(i);
+			if (name == "body" || name == "currencies") {
+				tail.push_back(args[i].get());
+				isWorth = true;
+			}
+		}
+	} else if (ma && !isSuper(&ma->expression()) && to<ContractType>(getType(&ma->expression())) &&
+		to<FunctionDefinition>(ma->annotation().referencedDeclaration)) {
+		if (options) {
+			for (size_t i = 0; i < options->names().size(); ++i) {
+				std::string const& name = *options->names().at(i);
+				Expression const* option = options->options().at(i).get();
+				if (name == "extMsg")
+					return true;
+				if (name == "currencies") {
+					tail.push_back(option);
+					isWorth = true;
+				}
+			}
+		}
+		for (ASTPointer<Expression const> const& arg : _functionCall.arguments()) {
+			tail.push_back(arg.get());
+			isWorth = true;
+		}
+	}
+	if (isWorth)
+		m_candidates.emplace_back(&_functionCall, tail);
+	return true;
+}
+
+std::vector<FunctionCall const*> MessageTemplateScanner::calls() const {
+	std::vector<FunctionCall const*> res;
+	for (auto const& [call, tail] : m_candidates) {
+		if (std::all_of(tail.begin(), tail.end(), [&](Expression const* e) { return isInvariant(e); }))
+			res.push_back(call);
+	}
+	return res;
+}
+
+LoopInvariantScanner::LoopInvariantScanner(BreakableStatement const& loop) {
+	if (auto forStatement = to<ForStatement>(&loop)) {
+		if (forStatement->initializationExpression())
+			forStatement->initializationExpression()->accept(*this);
+		m_countReads = true;
+		if (forStatement->condition())
+			forStatement->condition()->accept(*this);
+		if (forStatement->loopExpression())
+			forStatement->loopExpression()->accept(*this);
+		forStatement->body().accept(*this);
+	} else if (auto forEach = to<ForEachStatement>(&loop)) {
+		forEach->rangeExpression()->accept(*this);
+		m_countReads = true;
+		forEach->rangeDeclaration()->accept(*this);
+		forEach->body().accept(*this);
+	} else {
+		m_countReads = true;
+		loop.accept(*this);
+	}
+}
+
+bool LoopInvariantScanner::visit(Identifier const& _identifier) {
+	auto var = to<VariableDeclaration>(_identifier.annotation().referencedDeclaration);
+	if (m_countReads && var && var->isStateVariable() && !var->isConstant())
+		++m_reads[var];
+	return false;
+}
+
+bool LoopInvariantScanner::visit(IndexAccess const& _indexAccess) {
+	if (m_countReads && _indexAccess.indexExpression() &&
+		_indexAccess.baseExpression().annotation().type->category() == Type::Category::Mapping)
+		m_indexAccesses.push_back(&_indexAccess);
+	return true;
+}
+
+std::vector<VariableDeclaration const*> LoopInvariantScanner::stateVariables() const {
+	// mapping elements are read before the loop, so the mapping itself isn't needed for them
+	std::map<VariableDeclaration const*, int> readQty = m_reads;
+	for (std::vector<IndexAccess const*> const& group : mappingReads()) {
+		if (auto identifier = to<Identifier>(&group.front()->baseExpression()))
+			if (auto var = to<VariableDeclaration>(identifier->annotation().referencedDeclaration); readQty.count(var))
+				readQty[var] -= group.size();
+	}
+	std::vector<std::pair<int, VariableDeclaration const*>> reads;
+	for (auto const& [var, qty] : readQty) {
+		if (qty > 0 && isUnchanged(var))
+			reads.emplace_back(qty, var);
+	}
+	std::sort(reads.begin(), reads.end(), [](auto const& a, auto const& b) {
+		return a.first != b.first ? a.first > b.first : a.second->id() < b.second->id();
+	});
+	std::vector<VariableDeclaration const*> res;
+	for (auto const& read : reads)
+		res.push_back(read.second);
+	return res;
+}
+
+std::vector<std::vector<IndexAccess const*>> LoopInvariantScanner::mappingReads() const {
+	// the same element can be read in several places of the loop
+	auto getKey = [](Expression const* e) -> std::string {
+		if (auto identifier = to<Identifier>(e))
+			return "#" + toString(identifier->annotation().referencedDeclaration->id());
+		if (auto value = TVMExpressionCompiler::constValue(*e))
+			return toString(*value);
+		if (auto value = TVMExpressionCompiler::constBool(*e))
+			return *value ? "true" : "false";
+		return "\"" + to<Literal>(e)->value() + "\"";
+	};
+	std::vector<std::vector<IndexAccess const*>> res;
+	std::map<std::pair<std::string, std::string>, size_t> groups;
+	for (IndexAccess const* indexAccess : m_indexAccesses) {
+		if (!isInvariant(&indexAccess->baseExpression()) || !isInvariant(indexAccess->indexExpression()))
+			continue;
+		std::pair<std::string, std::string> key{getKey(&indexAccess->baseExpression()), getKey(indexAccess->indexExpression())};
+		auto it = groups.find(key);
+		if (it == groups.end()) {
+			groups[key] = res.size();
+			res.push_back({indexAccess});
+		} else {
+			res[it->second].push_back(indexAccess);
+		}
+	}
+	return res;
+}
+
+bool TupleArrayScanner::isTupleArray(VariableDeclaration const& var) {
+	if (!var.annotation().isTupleArray.has_value()) {
+		var.annotation().isTupleArray = false;
+		if (GlobalParams::g_withOptimizations && var.isLocalVariable() && !var.isCallableOrCatchParameter() &&
+			isUsualArray(var.type()) && to<Block>(var.scope())) {
+			TupleArrayScanner scanner{var};
+			var.annotation().isTupleArray = scanner.m_isTupleArray && scanner.m_maxLength <= TvmConst::MaxTupleLength;
+		}
+	}
+	return *var.annotation().isTupleArray;
+}
+
+bool TupleArrayScanner::isTupleArray(Expression const* expr) {
+	auto identifier = to<Identifier>(expr);
+	if (!identifier)
+		return false;
+	auto var = to<VariableDeclaration>(identifier->annotation().referencedDeclaration);
+	return var && isTupleArray(*var);
+}
+
+std::optional<int> TupleArrayScanner::initialLength(Expression const* init) {
+	if (init == nullptr)
+		return 0;
+	if (auto tuple = to<TupleExpression>(init); tuple && tuple->isInlineArray())
+		return tuple->components().size();
+	auto call = to<FunctionCall>(init);
+	if (call && to<NewExpression>(&call->expression()) && call->arguments().size() == 1) {
+		std::optional<bigint> length = TVMExpressionCompiler::constValue(*call->arguments().at(0));
+		if (length.has_value() && 0 <= *length && *length <= TvmConst::MaxTupleLength)
+			return static_cast<int>(*length);
+	}
+	return std::nullopt;
+}
+
+TupleArrayScanner::TupleArrayScanner(VariableDeclaration const& var) : m_var{var} {
+	var.scope()->accept(*this);
+}
+
+bool TupleArrayScanner::visit(VariableDeclarationStatement const& _statement) {
+	for (ASTPointer<VariableDeclaration> const& decl : _statement.declarations()) {
+		if (decl.get() == &m_var) {
+			std::optional<int> length = initialLength(_statement.initialValue());
+			if (_statement.declarations().size() != 1 || !length.has_value())
+				m_isTupleArray = false;
+			else
+				m_maxLength += *length;
+		}
+	}
+	return true;
+}
+
+bool TupleArrayScanner::visit(IndexAccess const& _indexAccess) {
+	if (isArray(_indexAccess.baseExpression()) && _indexAccess.indexExpression())
+		m_allowedUses.insert(to<Identifier>(&_indexAccess.baseExpression()));
+	return true;
+}
+
+bool TupleArrayScanner::visit(MemberAccess const& _memberAccess) {
+	if (!isArray(_memberAccess.expression()))
+		return true;
+	const std::string& name = _memberAccess.memberName();
+	if (isIn(name, "length", "empty", "push", "pop"))
+		m_allowedUses.insert(to<Identifier>(&_memberAccess.expression()));
+	if (name == "push") {
+		// the number of pushes in loops isn't known
+		if (m_loopDepth > 0)
+			m_isTupleArray = false;
+		++m_maxLength;
+	}
+	return true;
+}
+
+bool TupleArrayScanner::visit(Identifier const& _identifier) {
+	if (_identifier.annotation().referencedDeclaration == &m_var && !m_allowedUses.count(&_identifier)) {
+		// the array is copied, passed to a function, assigned etc.
+		m_isTupleArray = false;
+	}
+	return false;
+}
+
+bool TupleArrayScanner::visit(WhileStatement const&) {
+	++m_loopDepth;
+	return true;
+}
+
+bool TupleArrayScanner::visit(ForStatement const&) {
+	++m_loopDepth;
+	return true;
+}
+
+bool TupleArrayScanner::visit(ForEachStatement const& _forStatement) {
+	if (isArray(*_forStatement.rangeExpression()))
+		m_allowedUses.insert(to<Identifier>(_forStatement.rangeExpression().get()));
+	++m_loopDepth;
+	return true;
+}
+
+void TupleArrayScanner::endVisit(WhileStatement const&) {
+	--m_loopDepth;
+}
+
+void TupleArrayScanner::endVisit(ForStatement const&) {
+	--m_loopDepth;
+}
+
+void TupleArrayScanner::endVisit(ForEachStatement const&) {
+	--m_loopDepth;
+}
+
+bool TupleArrayScanner::isArray(Expression const& expr) const {
+	auto identifier = to<Identifier>(&expr);
+	return identifier && identifier->annotation().referencedDeclaration == &m_var;
+}
+
+// Finds variables changed in the nodes and arrays whose length can be changed
+class ChangedVariablesScanner: public LoopChangesScanner
+{
+public:
+	explicit ChangedVariablesScanner(std::vector<ASTNode const*> const& nodes) {
+		for (ASTNode const* node : nodes)
+			node->accept(*this);
+	}
+
+	bool visit(Assignment const& _assignment) override {
+		LoopChangesScanner::visit(_assignment);
+		markLengthChanged(&_assignment.leftHandSide());
+		return true;
+	}
+
+	bool visit(UnaryOperation const& _node) override {
+		LoopChangesScanner::visit(_node);
+		if (_node.getOperator() == Token::Delete)
+			markLengthChanged(&_node.subExpression());
+		return true;
+	}
+
+	bool visit(FunctionCall const& _functionCall) override {
+		LoopChangesScanner::visit(_functionCall);
+		if (auto ma = to<MemberAccess>(&_functionCall.expression()))
+			markLengthChanged(&ma->expression());
+		return true;
+	}
+
+	bool visit(VariableDeclaration const& _variable) override {
+		LoopChangesScanner::visit(_variable);
+		m_lengthChanged.insert(&_variable);
+		return true;
+	}
+
+	using LoopChangesScanner::isUnchanged;
+
+	bool isLengthUnchanged(VariableDeclaration const* array) const {
+		if (array->isStateVariable() && m_haveInternalCall)
+			return false;
+		return (array->isStateVariable() || array->isLocalVariable() || array->isCallableOrCatchParameter()) &&
+			!m_lengthChanged.count(array);
+	}
+
+private:
+	void markLengthChanged(Expression const* expr) {
+		if (auto identifier = to<Identifier>(expr)) {
+			m_lengthChanged.insert(identifier->annotation().referencedDeclaration);
+		} else if (auto tuple = to<TupleExpression>(expr)) {
+			for (ASTPointer<Expression> const& component : tuple->components()) {
+				if (component)
+					markLengthChanged(component.get());
+			}
+		}
+	}
+
+	std::set<Declaration const*> m_lengthChanged;
+};
+
+static std::optional<ValueRange> typeRange(Type const* type) {
+	if (auto intType = to<IntegerType>(type))
+		return ValueRange{intType->minValue(), intType->maxValue()};
+	return {};
+}
+
+// Rounds to -inf like TVM DIV
+static bigint floorDiv(bigint const& a, bigint const& b) {
+	bigint q = a / b;
+	if (a % b != 0 && (a < 0) != (b < 0))
+		--q;
+	return q;
+}
+
+ValueRangeScanner::ValueRangeScanner(ContractDefinition const* contract) {
+	if (!GlobalParams::g_withOptimizations || contract == nullptr)
+		return;
+	for (ContractDefinition const* c : contract->annotation().linearizedBaseContracts)
+		c->accept(*this);
+}
+
+std::optional<ValueRange> ValueRangeScanner::range(Expression const& expr) const {
+	if (std::optional<bigint> value = TVMExpressionCompiler::constValue(expr))
+		return ValueRange{*value, *value};
+	if (auto identifier = to<Identifier>(&expr)) {
+		auto it = m_ranges.find(identifier);
+		if (it != m_ranges.end())
+			return it->second;
+	} else if (auto tuple = to<TupleExpression>(&expr)) {
+		if (!tuple->isInlineArray() && tuple->components().size() == 1 && tuple->components().at(0))
+			return range(*tuple->components().at(0));
+	} else if (auto binary = to<BinaryOperation>(&expr)) {
+		if (std::optional<ValueRange> r = binaryRange(binary->getOperator(), binary->leftExpression(), binary->rightExpression()))
+			return r;
+	} else if (auto unary = to<UnaryOperation>(&expr)) {
+		if (unary->getOperator() == Token::Sub) {
+			if (std::optional<ValueRange> r = range(unary->subExpression()))
+				return ValueRange{-r->max, -r->min};
+		}
+	} else if (auto call = to<FunctionCall>(&expr)) {
+		std::optional<ValueRange> type = typeRange(expr.annotation().type);
+		if (type && call->annotation().kind == FunctionCallKind::TypeConversion && call->arguments().size() == 1) {
+			// integer conversion throws if the value doesn't fit
+			std::optional<ValueRange> r = range(*call->arguments().at(0));
+			if (r && r->max >= type->min && r->min <= type->max)
+				return ValueRange{std::max(r->min, type->min), std::min(r->max, type->max)};
+		}
+	}
+	return typeRange(expr.annotation().type);
+}
+
+std::optional<ValueRange> ValueRangeScanner::binaryRange(Token op, Expression const& left, Expression const& right) const {
+	std::optional<ValueRange> l = range(left);
+	std::optional<ValueRange> r = range(right);
+	if (!l || !r)
+		return {};
+	switch (op) {
+		case Token::Add:
+			return ValueRange{l->min + r->min, l->max + r->max};
+		case Token::Sub:
+			return ValueRange{l->min - r->max, l->max - r->min};
+		case Token::Mul: {
+			std::vector<bigint> v{l->min * r->min, l->min * r->max, l->max * r->min, l->max * r->max};
+			return ValueRange{*std::min_element(v.begin(), v.end()), *std::max_element(v.begin(), v.end())};
+		}
+		case Token::Div: {
+			if (r->min <= 0)
+				return {};
+			std::vector<bigint> v{floorDiv(l->min, r->min), floorDiv(l->min, r->max), floorDiv(l->max, r->min), floorDiv(l->max, r->max)};
+			return ValueRange{*std::min_element(v.begin(), v.end()), *std::max_element(v.begin(), v.end())};
+		}
+		case Token::Mod:
+			if (r->min <= 0)
+				return {};
+			return ValueRange{0, r->max - 1};
+		case Token::BitAnd:
+			if (l->min < 0 || r->min < 0)
+				return {};
+			return ValueRange{0, std::min(l->max, r->max)};
+		default:
+			return {};
+	}
+}
+
+bool ValueRangeScanner::fits(ValueRange const& range, Type const* type) {
+	std::optional<ValueRange> t = typeRange(type);
+	return t && t->min <= range.min && range.max <= t->max;
+}
+
+bool ValueRangeScanner::visit(IfStatement const& _node) {
+	_node.condition().accept(*this);
+	visitWithFacts(_node.trueStatement(), unchangedFacts(conditionFacts(_node.condition(), true), {&_node.condition()}));
+	if (_node.falseStatement())
+		visitWithFacts(*_node.falseStatement(), unchangedFacts(conditionFacts(_node.condition(), false), {&_node.condition()}));
+	return false;
+}
+
+bool ValueRangeScanner::visit(WhileStatement const& _node) {
+	_node.condition().accept(*this);
+	std::vector<Fact> facts;
+	if (_node.loopType() == WhileStatement::LoopType::WHILE_DO)
+		facts = unchangedFacts(conditionFacts(_node.condition(), true), {&_node.condition()});
+	visitWithFacts(_node.body(), facts);
+	return false;
+}
+
+bool ValueRangeScanner::visit(ForStatement const& _node) {
+	if (_node.initializationExpression())
+		_node.initializationExpression()->accept(*this);
+	std::vector<Fact> facts;
+	if (_node.condition()) {
+		_node.condition()->accept(*this);
+		facts = unchangedFacts(conditionFacts(*_node.condition(), true), {_node.condition()});
+	}
+	visitWithFacts(_node.body(), facts);
+	// the condition is true before the loop expression if the body doesn't change its variables
+	if (_node.loopExpression())
+		visitWithFacts(*_node.loopExpression(), unchangedFacts(facts, {&_node.body()}));
+	return false;
+}
+
+bool ValueRangeScanner::visit(Block const& _node) {
+	const size_t factQty = m_facts.size();
+	for (ASTPointer<Statement> const& statement : _node.statements()) {
+		visitStatement(*statement);
+		auto expressionStatement = to<ExpressionStatement>(statement.get());
+		auto call = expressionStatement ? to<FunctionCall>(&expressionStatement->expression()) : nullptr;
+		auto funcType = call ? to<FunctionType>(call->expression().annotation().type) : nullptr;
+		if (funcType && funcType->kind() == FunctionType::Kind::Require && !call->arguments().empty()) {
+			// `require(cond)` guards the rest of the block
+			for (Fact const& fact : unchangedFacts(conditionFacts(*call->arguments().at(0), true), {call}))
+				m_facts.push_back(fact);
+		}
+	}
+	m_facts.resize(factQty);
+	return false;
+}
+
+// Facts become false when the statement changes their variables. If the statement is an update
+// of the variable, e.g. `x--` or `x = x + y`, the variable is read before it's changed.
+void ValueRangeScanner::visitStatement(Statement const& _statement) {
+	if (to<Block>(&_statement)) {
+		// statements of the block are checked one by one
+		_statement.accept(*this);
+		return;
+	}
+	Declaration const* updated{};
+	if (auto expressionStatement = to<ExpressionStatement>(&_statement)) {
+		Expression const* expr = &expressionStatement->expression();
+		Expression const* lValue{};
+		if (auto assignment = to<Assignment>(expr))
+			lValue = &assignment->leftHandSide();
+		else if (auto unary = to<UnaryOperation>(expr); unary && isIn(unary->getOperator(), Token::Inc, Token::Dec))
+			lValue = &unary->subExpression();
+		if (auto identifier = to<Identifier>(lValue))
+			updated = identifier->annotation().referencedDeclaration;
+	}
+
+	ChangedVariablesScanner scanner{{&_statement}};
+	std::vector<Fact*> changedLater;
+	for (Fact& fact : m_facts) {
+		if (!fact.isAlive)
+			continue;
+		const bool isChanged = !scanner.isUnchanged(fact.var) || (fact.array && !scanner.isLengthUnchanged(fact.array));
+		if (!isChanged)
+			continue;
+		if (fact.var == updated && !fact.array)
+			changedLater.push_back(&fact);
+		else
+			fact.isAlive = false;
+	}
+	_statement.accept(*this);
+	for (Fact* fact : changedLater)
+		fact->isAlive = false;
+}
+
+bool ValueRangeScanner::visit(Identifier const& _node) {
+	auto var = to<VariableDeclaration>(_node.annotation().referencedDeclaration);
+	std::optional<ValueRange> r = typeRange(_node.annotation().type);
+	if (var == nullptr || !r)
+		return false;
+	bool isRefined = false;
+	for (Fact const& fact : m_facts) {
+		if (fact.isAlive && fact.var == var && fact.range) {
+			r->min = std::max(r->min, fact.range->min);
+			r->max = std::min(r->max, fact.range->max);
+			isRefined = true;
+		}
+	}
+	if (isRefined && r->min <= r->max)
+		m_ranges[&_node] = *r;
+	return false;
+}
+
+bool ValueRangeScanner::visit(IndexAccess const& _node) {
+	auto base = to<Identifier>(&_node.baseExpression());
+	auto index = to<Identifier>(_node.indexExpression());
+	if (base && index) {
+		for (Fact const& fact : m_facts) {
+			if (fact.isAlive && fact.array && fact.array == base->annotation().referencedDeclaration &&
+				fact.var == index->annotation().referencedDeclaration)
+				m_indexesInRange.insert(&_node);
+		}
+	}
+	return true;
+}
+
+std::vector<ValueRangeScanner::Fact> ValueRangeScanner::conditionFacts(Expression const& cond, bool isTrue) const {
+	std::vector<Fact> facts;
+	if (auto tuple = to<TupleExpression>(&cond)) {
+		if (!tuple->isInlineArray() && tuple->components().size() == 1 && tuple->components().at(0))
+			return conditionFacts(*tuple->components().at(0), isTrue);
+	} else if (auto unary = to<UnaryOperation>(&cond)) {
+		if (unary->getOperator() == Token::Not)
+			return conditionFacts(unary->subExpression(), !isTrue);
+	} else if (auto binary = to<BinaryOperation>(&cond)) {
+		Token op = binary->getOperator();
+		if ((op == Token::And && isTrue) || (op == Token::Or && !isTrue)) {
+			facts = conditionFacts(binary->leftExpression(), isTrue);
+			for (Fact const& fact : conditionFacts(binary->rightExpression(), isTrue))
+				facts.push_back(fact);
+		} else if (TokenTraits::isCompareOp(op)) {
+			if (!isTrue) {
+				switch (op) {
+					case Token::LessThan: op = Token::GreaterThanOrEqual; break;
+					case Token::LessThanOrEqual: op = Token::GreaterThan; break;
+					case Token::GreaterThan: op = Token::LessThanOrEqual; break;
+					case Token::GreaterThanOrEqual: op = Token::LessThan; break;
+					case Token::Equal: op = Token::NotEqual; break;
+					default: op = Token::Equal; break;
+				}
+			}
+			Token mirrored = op;
+			switch (op) {
+				case Token::LessThan: mirrored = Token::GreaterThan; break;
+				case Token::LessThanOrEqual: mirrored = Token::GreaterThanOrEqual; break;
+				case Token::GreaterThan: mirrored = Token::LessThan; break;
+				case Token::GreaterThanOrEqual: mirrored = Token::LessThanOrEqual; break;
+				default: break;
+			}
+			addFact(facts, binary->leftExpression(), op, binary->rightExpression());
+			addFact(facts, binary->rightExpression(), mirrored, binary->leftExpression());
+		}
+	}
+	return facts;
+}
+
+// Adds the fact `var op bound`
+void ValueRangeScanner::addFact(std::vector<Fact>& facts, Expression const& var, Token op, Expression const& bound) const {
+	auto identifier = to<Identifier>(&var);
+	auto decl = identifier ? to<VariableDeclaration>(identifier->annotation().referencedDeclaration) : nullptr;
+	if (decl == nullptr || decl->isStateVariable() || !typeRange(decl->type()))
+		return;
+	if (op == Token::LessThan) {
+		auto length = to<MemberAccess>(&bound);
+		auto array = length ? to<Identifier>(&length->expression()) : nullptr;
+		auto arrayType = array ? to<ArrayType>(array->annotation().type) : nullptr;
+		if (arrayType && !arrayType->isByteArray() && length->memberName() == "length")
+			facts.push_back({decl, {}, to<VariableDeclaration>(array->annotation().referencedDeclaration)});
+	}
+	std::optional<ValueRange> b = range(bound);
+	std::optional<ValueRange> t = typeRange(decl->type());
+	if (!b)
+		return;
+	switch (op) {
+		case Token::LessThan:
+			facts.push_back({decl, ValueRange{t->min, b->max - 1}, nullptr});
+			break;
+		case Token::LessThanOrEqual:
+			facts.push_back({decl, ValueRange{t->min, b->max}, nullptr});
+			break;
+		case Token::GreaterThan:
+			facts.push_back({decl, ValueRange{b->min + 1, t->max}, nullptr});
+			break;
+		case Token::GreaterThanOrEqual:
+			facts.push_back({decl, ValueRange{b->min, t->max}, nullptr});
+			break;
+		case Token::Equal:
+			facts.push_back({decl, b, nullptr});
+			break;
+		default:
+			break;
+	}
+}
+
+// Leaves the facts whose variables aren't changed in the nodes
+std::vector<ValueRangeScanner::Fact> ValueRangeScanner::unchangedFacts(std::vector<Fact> facts, std::vector<ASTNode const*> const& nodes) {
+	ChangedVariablesScanner scanner{nodes};
+	facts.erase(std::remove_if(facts.begin(), facts.end(), [&](Fact const& fact) {
+		return !scanner.isUnchanged(fact.var) || (fact.array && !scanner.isLengthUnchanged(fact.array));
+	}), facts.end());
+	return facts;
+}
+
+void ValueRangeScanner::visitWithFacts(Statement const& _statement, std::vector<Fact> const& facts) {
+	const size_t factQty = m_facts.size();
+	m_facts.insert(m_facts.end(), facts.begin(), facts.end());
+	visitStatement(_statement);
+	m_facts.resize(factQty);
+}
+
 bool isFunctionOfFirstType(const FunctionDefinition *f) {
 	LocationReturn locationReturn = ::notNeedsPushContWhenInlining(f->body());
 	if (!f->returnParameters().empty() && isIn(locationReturn, LocationReturn::noReturn, LocationReturn::Anywhere)) {
@@ -262,20 +978,86 @@ bool isFunctionOfFirstType(const FunctionDefinition *f) {
 }
 
 LocationReturn notNeedsPushContWhenInlining(const Block &_block) {
+	return ControlFlowScanner::locationReturn(_block);
+}
+
+ControlFlowScanner::ControlFlowScanner(const ASTNode& node) {
+	node.accept(*this);
+	solAssert(m_frames.empty(), "");
+}
+
+ContInfo const& ControlFlowScanner::info(Statement const& statement) {
+	if (!statement.annotation().contInfo.has_value()) {
+		ControlFlowScanner{statement};
+	}
+	return *statement.annotation().contInfo;
+}
+
+LocationReturn ControlFlowScanner::locationReturn(Block const& block) {
+	if (!block.annotation().locationReturn.has_value()) {
+		ControlFlowScanner{block};
+	}
+	return *block.annotation().locationReturn;
+}
 
-	ast_vec<Statement> statements = _block.statements();
+bool ControlFlowScanner::visitNode(ASTNode const& node) {
+	if (dynamic_cast<Statement const*>(&node)) {
+		m_frames.push_back({ContInfo{}, to<WhileStatement>(&node) != nullptr || to<ForStatement>(&node) != nullptr});
+	}
+	return true;
+}
 
-	LoopScanner bodyScanner{_block};
-	if (!bodyScanner.m_info.canReturn) {
-		return LocationReturn::noReturn;
+void ControlFlowScanner::endVisitNode(ASTNode const& node) {
+	auto statement = dynamic_cast<Statement const*>(&node);
+	if (!statement) {
+		return;
+	}
+	ContInfo info = m_frames.back().info;
+	m_frames.pop_back();
+
+	if (to<Return>(statement)) {
+		info.canReturn = info.alwaysReturns = true;
+	} else if (to<Break>(statement)) {
+		info.canBreak = info.alwaysBreak = true;
+	} else if (to<Continue>(statement)) {
+		info.canContinue = info.alwaysContinue = true;
+	} else if (auto block = to<Block>(statement)) {
+		// statements of the block are already scanned
+		const auto& statements = block->statements();
+		for (const ASTPointer<Statement>& st : statements) {
+			const ContInfo& ci = *st->annotation().contInfo;
+			info.alwaysReturns |= ci.alwaysReturns;
+			info.alwaysBreak |= ci.alwaysBreak;
+			info.alwaysContinue |= ci.alwaysContinue;
+		}
+
+		LocationReturn location = LocationReturn::Anywhere;
+		if (!info.canReturn) {
+			location = LocationReturn::noReturn;
+		} else if (std::none_of(statements.begin(), statements.end() - 1, [](const ASTPointer<Statement>& st) {
+			return st->annotation().contInfo->canReturn;
+		})) {
+			location = to<Return>(statements.back().get()) ? LocationReturn::Last : LocationReturn::Anywhere;
+		}
+		block->annotation().locationReturn = location;
+	} else if (auto ifStatement = to<IfStatement>(statement)) {
+		if (ifStatement->falseStatement()) {
+			const ContInfo& t = *ifStatement->trueStatement().annotation().contInfo;
+			const ContInfo& f = *ifStatement->falseStatement()->annotation().contInfo;
+			info.alwaysReturns = t.alwaysReturns && f.alwaysReturns;
+			info.alwaysBreak = t.alwaysBreak && f.alwaysBreak;
+			info.alwaysContinue = t.alwaysContinue && f.alwaysContinue;
+		}
 	}
+	statement->annotation().contInfo = info;
 
-	for (std::vector<int>::size_type i = 0; i + 1 < statements.size(); ++i) {
-		LoopScanner scanner{*statements[i].get()};
-		if (scanner.m_info.canReturn) {
-			return LocationReturn::Anywhere;
+	if (!m_frames.empty()) {
+		Frame& parent = m_frames.back();
+		parent.info.canReturn |= info.canReturn;
+		// break and continue inside a loop don't leave the statement containing the loop
+		if (!parent.isLoop) {
+			parent.info.canBreak |= info.canBreak;
+			parent.info.canContinue |= info.canContinue;
 		}
 	}
-	bool isLastStatementReturn = to<Return>(statements.back().get()) != nullptr;
-	return isLastStatementReturn ? LocationReturn::Last : LocationReturn::Anywhere;
 }
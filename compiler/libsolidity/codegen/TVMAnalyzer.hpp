@@ -85,53 +85,172 @@ public:
 	bool havePrivateFunctionCall{};
 };
 
+// Checks whether the modifier is `prologue; _;` where the prologue doesn't return and
+// doesn't depend on the function, so it can be compiled once and called from all functions.
+class ModifierPrologueScanner: public ASTConstVisitor
+{
+public:
+	explicit ModifierPrologueScanner(ModifierDefinition const& modifier);
+	bool visit(PlaceholderStatement const&) override;
+	bool visit(Return const&) override;
+	bool visit(Identifier const& _identifier) override;
+	bool isPrologueOnly{};
+};
 
-class LoopScanner: public ASTConstVisitor
+// Collects variables that are changed in the loop. Expressions of constants and of variables
+// that aren't changed have the same value on each iteration.
+class LoopChangesScanner: public ASTConstVisitor
 {
 public:
-	explicit LoopScanner(const ASTNode& node) {
-		node.accept(*this);
-		solAssert(m_loopDepth == 0, "");
-	}
+	bool visit(Assignment const& _assignment) override;
+	bool visit(UnaryOperation const& _node) override;
+	bool visit(FunctionCall const& _functionCall) override;
+	bool visit(VariableDeclaration const& _variable) override;
+	bool visit(PlaceholderStatement const&) override;
 
 protected:
-	bool visit(WhileStatement const&) override {
-		m_loopDepth++;
-		return true;
-	}
-
-	void endVisit(WhileStatement const&) override {
-		m_loopDepth--;
-	}
-
-	bool visit(ForStatement const&) override {
-		m_loopDepth++;
-		return true;
-	}
-
-	void endVisit(ForStatement const&) override {
-		m_loopDepth--;
-	}
-
-	void endVisit(Return const&) override {
-		m_info.canReturn = true;
-	}
-
-	void endVisit(Break const&) override {
-		if (m_loopDepth == 0)
-			m_info.canBreak = true;
-	}
-
-	void endVisit(Continue const&) override {
-		if (m_loopDepth == 0)
-			m_info.canContinue = true;
-	}
+	void markChanged(Expression const* expr);
+	bool isInvariant(Expression const* expr) const;
+	bool isUnchanged(VariableDeclaration const* var) const;
+
+	std::set<Declaration const*> m_changed;
+	// internal functions and the body of the function in a modifier (`_`) can change any state variable
+	bool m_haveInternalCall{};
+};
+
+// Finds sends of internal messages in the loop (`addr.transfer(...)` and remote calls) whose part
+// after the value (currencies and body) doesn't change between iterations. Such part can be built
+// once before the loop.
+class MessageTemplateScanner: public LoopChangesScanner
+{
+public:
+	explicit MessageTemplateScanner(ASTNode const& loop);
+	bool visit(FunctionCall const& _functionCall) override;
+	std::vector<FunctionCall const*> calls() const;
+
+private:
+	// send and expressions of its message tail
+	std::vector<std::pair<FunctionCall const*, std::vector<Expression const*>>> m_candidates;
+};
+
+// Finds state variables and mapping elements that are read but not changed in the loop.
+// They can be read once before the loop and kept on the stack.
+class LoopInvariantScanner: public LoopChangesScanner
+{
+public:
+	explicit LoopInvariantScanner(BreakableStatement const& loop);
+	bool visit(Identifier const& _identifier) override;
+	bool visit(IndexAccess const& _indexAccess) override;
+	// Sorted by number of reads
+	std::vector<VariableDeclaration const*> stateVariables() const;
+	// Reads of the same element are grouped
+	std::vector<std::vector<IndexAccess const*>> mappingReads() const;
+	bool isChanged(Declaration const* var) const { return m_changed.count(var); }
 
 private:
-	int m_loopDepth = 0;
+	std::map<VariableDeclaration const*, int> m_reads;
+	std::vector<IndexAccess const*> m_indexAccesses;
+	// reads in the part of the loop that is executed once (for-init and range of for-each) aren't counted
+	bool m_countReads{};
+};
 
+// Checks whether the local array can be kept as a TVM tuple instead of {length, dict}: it's only
+// indexed, iterated over and changed by push/pop, and its length is bounded by the tuple limit
+// (it's created with a constant length and pushes aren't done in loops).
+class TupleArrayScanner: public ASTConstVisitor
+{
 public:
-	ContInfo m_info;
+	static bool isTupleArray(VariableDeclaration const& var);
+	// Checks whether the expression is an identifier of such array
+	static bool isTupleArray(Expression const* expr);
+	// Length of the array created by the initial value of the declaration
+	static std::optional<int> initialLength(Expression const* init);
+
+private:
+	explicit TupleArrayScanner(VariableDeclaration const& var);
+	bool visit(VariableDeclarationStatement const& _statement) override;
+	bool visit(IndexAccess const& _indexAccess) override;
+	bool visit(MemberAccess const& _memberAccess) override;
+	bool visit(Identifier const& _identifier) override;
+	bool visit(WhileStatement const&) override;
+	bool visit(ForStatement const&) override;
+	bool visit(ForEachStatement const& _forStatement) override;
+	void endVisit(WhileStatement const&) override;
+	void endVisit(ForStatement const&) override;
+	void endVisit(ForEachStatement const&) override;
+	bool isArray(Expression const& expr) const;
+
+	VariableDeclaration const& m_var;
+	std::set<Identifier const*> m_allowedUses;
+	int m_loopDepth{};
+	int m_maxLength{};
+	bool m_isTupleArray{true};
+};
+
+// Bounds of an integer value
+struct ValueRange {
+	bigint min;
+	bigint max;
+};
+
+// Derives bounds of local integer variables from conditions of `if`, `while`, `for` and `require`
+// in the code guarded by the condition until the variables are changed. Bounds of expressions
+// are computed from bounds of the operands, so overflow checks and array bounds checks which can't
+// fail are omitted.
+class ValueRangeScanner: public ASTConstVisitor
+{
+public:
+	explicit ValueRangeScanner(ContractDefinition const* contract);
+	std::optional<ValueRange> range(Expression const& expr) const;
+	std::optional<ValueRange> binaryRange(Token op, Expression const& left, Expression const& right) const;
+	static bool fits(ValueRange const& range, Type const* type);
+	// Index is less than the array length: `for (uint i = 0; i < arr.length; ++i) { arr[i] ... }`
+	bool isIndexInRange(IndexAccess const& indexAccess) const { return m_indexesInRange.count(&indexAccess) != 0; }
+
+	bool visit(IfStatement const& _node) override;
+	bool visit(WhileStatement const& _node) override;
+	bool visit(ForStatement const& _node) override;
+	bool visit(Block const& _node) override;
+	bool visit(Identifier const& _node) override;
+	bool visit(IndexAccess const& _node) override;
+
+private:
+	struct Fact {
+		VariableDeclaration const* var{};
+		std::optional<ValueRange> range;
+		VariableDeclaration const* array{}; // var < array.length
+		bool isAlive{true};
+	};
+	std::vector<Fact> conditionFacts(Expression const& cond, bool isTrue) const;
+	void addFact(std::vector<Fact>& facts, Expression const& var, Token op, Expression const& bound) const;
+	static std::vector<Fact> unchangedFacts(std::vector<Fact> facts, std::vector<ASTNode const*> const& nodes);
+	void visitWithFacts(Statement const& _statement, std::vector<Fact> const& facts);
+	void visitStatement(Statement const& _statement);
+
+	std::vector<Fact> m_facts;
+	std::map<Identifier const*, ValueRange> m_ranges;
+	std::set<IndexAccess const*> m_indexesInRange;
+};
+
+// Computes control flow facts of all statements of the node in one bottom-up pass
+// and saves them to the annotations of statements.
+class ControlFlowScanner: public ASTConstVisitor
+{
+public:
+	explicit ControlFlowScanner(const ASTNode& node);
+	static ContInfo const& info(Statement const& statement);
+	static LocationReturn locationReturn(Block const& block);
+
+protected:
+	bool visitNode(ASTNode const& node) override;
+	void endVisitNode(ASTNode const& node) override;
+
+private:
+	struct Frame {
+		ContInfo info;
+		bool isLoop{};
+	};
+	std::vector<Frame> m_frames;
 };
 
 }
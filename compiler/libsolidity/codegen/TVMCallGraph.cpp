@@ -0,0 +1,170 @@
+/*
+ * Copyright 2018-2019 TON DEV SOLUTIONS LTD.
+ *
+ * Licensed under the  terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License.
+ *
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the  GNU General Public License for more details at: https://www.gnu.org/licenses/gpl-3.0.html
+ */
+/**
+ * @author TON Labs <connect@tonlabs.io>
+ * @date 2021
+ * Graph of internal function calls
+ */
+
+#include "TVMCallGraph.hpp"
+#include "TVMCommons.hpp"
+
+using namespace solidity::frontend;
+
+namespace {
+	bool overrides(CallableDeclaration const* f, CallableDeclaration const* base) {
+		for (CallableDeclaration const* b : f->annotation().baseFunctions) {
+			if (b == base || overrides(b, base))
+				return true;
+		}
+		return false;
+	}
+}
+
+TVMCallGraph::TVMCallGraph(ContractDefinition const* contract) : m_contract{contract} {
+	for (ContractDefinition const* c : contract->annotation().linearizedBaseContracts) {
+		for (FunctionDefinition const* f : c->definedFunctions())
+			addFunction(f);
+	}
+	// called functions are added to the end
+	for (size_t i = 0; i < m_functions.size(); ++i) {
+		m_currentFunction = m_functions[i];
+		m_currentFunction->accept(*this);
+	}
+	m_currentFunction = nullptr;
+
+	for (FunctionDefinition const* f : m_functions) {
+		if (!m_index.count(f))
+			tarjan(f);
+	}
+}
+
+bool TVMCallGraph::isRecursiveCall(FunctionDefinition const* from, FunctionDefinition const* to) const {
+	if (from == to)
+		return true;
+	if (m_component.count(from) && m_component.count(to) && m_graph.at(from).count(to))
+		return m_component.at(from) == m_component.at(to);
+	// the call wasn't found before code generation, so check it directly
+	return isReachable(to, from);
+}
+
+bool TVMCallGraph::isReachable(FunctionDefinition const* from, FunctionDefinition const* to) const {
+	std::set<FunctionDefinition const*> visited{from};
+	std::vector<FunctionDefinition const*> queue{from};
+	while (!queue.empty()) {
+		FunctionDefinition const* v = queue.back();
+		queue.pop_back();
+		if (v == to)
+			return true;
+		auto it = m_graph.find(v);
+		if (it == m_graph.end())
+			continue;
+		for (FunctionDefinition const* u : it->second) {
+			if (visited.insert(u).second)
+				queue.push_back(u);
+		}
+	}
+	return false;
+}
+
+void TVMCallGraph::addFunction(FunctionDefinition const* function) {
+	if (m_graph.count(function))
+		return;
+	m_graph[function];
+	m_functions.push_back(function);
+}
+
+void TVMCallGraph::addCall(Declaration const* declaration, Type const* type, bool isVirtualCall) {
+	auto function = dynamic_cast<FunctionDefinition const*>(declaration);
+	auto functionType = to<FunctionType>(type);
+	if (!m_currentFunction || !function || !function->isImplemented() || !functionType ||
+		!isIn(functionType->kind(), FunctionType::Kind::Internal, FunctionType::Kind::DelegateCall))
+		return;
+	if (isVirtualCall)
+		function = resolveVirtual(function);
+	addFunction(function);
+	m_graph[m_currentFunction].insert(function);
+}
+
+FunctionDefinition const* TVMCallGraph::resolveVirtual(FunctionDefinition const* function) const {
+	if (!function->virtualSemantics())
+		return function;
+	// function is called by name, so its last override is executed
+	for (ContractDefinition const* c : m_contract->annotation().linearizedBaseContracts) {
+		for (FunctionDefinition const* f : c->definedFunctions()) {
+			if (f == function)
+				return function;
+			if (f->name() == function->name() && overrides(f, function))
+				return f;
+		}
+	}
+	return function;
+}
+
+bool TVMCallGraph::visit(Identifier const& _node) {
+	addCall(_node.annotation().referencedDeclaration, _node.annotation().type, true);
+	return false;
+}
+
+bool TVMCallGraph::visit(MemberAccess const& _node) {
+	addCall(_node.annotation().referencedDeclaration, _node.annotation().type, false);
+	return true;
+}
+
+bool TVMCallGraph::visit(ModifierInvocation const& _node) {
+	if (auto modifier = dynamic_cast<ModifierDefinition const*>(_node.name()->annotation().referencedDeclaration)) {
+		// modifiers are inlined into the function
+		resolveModifier(modifier)->body().accept(*this);
+	}
+	return true;
+}
+
+ModifierDefinition const* TVMCallGraph::resolveModifier(ModifierDefinition const* modifier) const {
+	// virtual modifiers are resolved by name
+	for (ContractDefinition const* c : m_contract->annotation().linearizedBaseContracts) {
+		for (ModifierDefinition const* m : c->functionModifiers()) {
+			if (m->name() == modifier->name())
+				return m;
+		}
+	}
+	return modifier;
+}
+
+// Tarjan's algorithm of strongly connected components
+void TVMCallGraph::tarjan(FunctionDefinition const* v) {
+	const int index = m_index.size();
+	m_index[v] = index;
+	m_lowLink[v] = index;
+	m_stack.push_back(v);
+	m_onStack.insert(v);
+	for (FunctionDefinition const* to : m_graph.at(v)) {
+		if (!m_index.count(to)) {
+			tarjan(to);
+			m_lowLink[v] = std::min(m_lowLink[v], m_lowLink[to]);
+		} else if (m_onStack.count(to)) {
+			m_lowLink[v] = std::min(m_lowLink[v], m_index[to]);
+		}
+	}
+	if (m_lowLink[v] == m_index[v]) {
+		std::vector<FunctionDefinition const*> component;
+		FunctionDefinition const* u{};
+		do {
+			u = m_stack.back();
+			m_stack.pop_back();
+			m_onStack.erase(u);
+			m_component[u] = m_components.size();
+			component.push_back(u);
+		} while (u != v);
+		m_components.push_back(component);
+	}
+}
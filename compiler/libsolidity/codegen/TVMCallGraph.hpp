@@ -0,0 +1,62 @@
+/*
+ * Copyright 2018-2019 TON DEV SOLUTIONS LTD.
+ *
+ * Licensed under the  terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License.
+ *
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the  GNU General Public License for more details at: https://www.gnu.org/licenses/gpl-3.0.html
+ */
+/**
+ * @author TON Labs <connect@tonlabs.io>
+ * @date 2021
+ * Graph of internal function calls
+ */
+
+#pragma once
+
+#include <libsolidity/ast/ASTVisitor.h>
+
+namespace solidity::frontend {
+
+// Graph of internal calls of the contract (including calls from modifiers, inline and library
+// functions) built before code generation. Calls inside one strongly connected component can be
+// a part of recursion, so they are compiled as CALL of global function, other calls are macros.
+class TVMCallGraph : private ASTConstVisitor {
+public:
+	explicit TVMCallGraph(ContractDefinition const* contract);
+	bool isRecursiveCall(FunctionDefinition const* from, FunctionDefinition const* to) const;
+	bool isReachable(FunctionDefinition const* from, FunctionDefinition const* to) const;
+	// The function executed when @a function is called by name (not by `super` or a contract name)
+	FunctionDefinition const* resolveVirtual(FunctionDefinition const* function) const;
+	// Strongly connected components, callees go before callers
+	std::vector<std::vector<FunctionDefinition const*>> const& components() const { return m_components; }
+
+private:
+	void addFunction(FunctionDefinition const* function);
+	// Calls of virtual functions by name are linked with the override that is executed
+	void addCall(Declaration const* declaration, Type const* type, bool isVirtualCall);
+	ModifierDefinition const* resolveModifier(ModifierDefinition const* modifier) const;
+	bool visit(Identifier const& _node) override;
+	bool visit(MemberAccess const& _node) override;
+	bool visit(ModifierInvocation const& _node) override;
+	void tarjan(FunctionDefinition const* v);
+
+private:
+	ContractDefinition const* m_contract{};
+	std::vector<FunctionDefinition const*> m_functions; // in order of discovery
+	std::map<FunctionDefinition const*, std::set<FunctionDefinition const*>> m_graph;
+	FunctionDefinition const* m_currentFunction{};
+
+	std::map<FunctionDefinition const*, int> m_index;
+	std::map<FunctionDefinition const*, int> m_lowLink;
+	std::vector<FunctionDefinition const*> m_stack;
+	std::set<FunctionDefinition const*> m_onStack;
+	std::map<FunctionDefinition const*, int> m_component;
+	std::vector<std::vector<FunctionDefinition const*>> m_components;
+};
+
+} // end solidity::frontend
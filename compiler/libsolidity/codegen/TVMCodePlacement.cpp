@@ -0,0 +1,433 @@
+/*
+ * Copyright 2018-2019 TON DEV SOLUTIONS LTD.
+ *
+ * Licensed under the  terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License.
+ *
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the  GNU General Public License for more details at: https://www.gnu.org/licenses/gpl-3.0.html
+ */
+/**
+ * @author TON Labs <connect@tonlabs.io>
+ * @date 2021
+ * Placement of continuations into cells
+ */
+
+#include <boost/algorithm/string.hpp>
+
+#include "TVM.h"
+#include "TVMCodePlacement.hpp"
+#include "TVMCodeStats.hpp"
+#include "TVMProfile.hpp"
+
+namespace solidity::frontend {
+
+struct TVMCodePlacement {
+	struct CellSize {
+		int bits{};
+		int refs{};
+	};
+
+	struct LineInfo {
+		string opcode;
+		string args;
+		bool opens{};    // line opens a continuation or a cell: "PUSHCONT {", "CALLREF {", ...
+		int match{-1};   // index of the line with closing bracket (or opening for "}")
+		int parent{-1};  // index of the line that opens enclosing block
+		int function{-1};
+		bool removed{}; // line is dropped by a rewrite, indices of other lines stay valid
+	};
+
+	static constexpr int MaxRefs = 4;
+	// Bits reserved in each cell, the assembler can add a few bits, e.g. for long jumps
+	static constexpr int ReservedBits = 32;
+	// Cold continuations smaller than that are left inline, a new cell costs more than they save
+	static constexpr int MinColdBits = 32;
+
+	vector<string> lines_;
+	vector<LineInfo> info_;
+	vector<int> headers_;
+	set<string> macros_;
+	map<string, vector<int>> callSites_;
+	map<string, CellSize> macroSizes_;
+	map<string, bool> macroTransfers_;
+	set<string> inProgress_;
+
+	explicit TVMCodePlacement(vector<string> lines) : lines_(std::move(lines)) {
+		analyze();
+	}
+
+	static string callee(const string& args) {
+		if (args.size() >= 2 && args.front() == '$' && args.back() == '$')
+			return args.substr(1, args.size() - 2);
+		return args;
+	}
+
+	void analyze() {
+		info_.assign(lines_.size(), LineInfo{});
+		headers_.clear();
+		macros_.clear();
+		callSites_.clear();
+		macroSizes_.clear();
+		macroTransfers_.clear();
+
+		vector<int> opened;
+		int function = -1;
+		for (int i = 0; i < int(lines_.size()); ++i) {
+			LineInfo& li = info_[i];
+			std::tie(li.opcode, li.args) = TVMCodeStats::splitLine(lines_[i]);
+			string name;
+			if (TVMCodeStats::isFunctionHeader(li.opcode, li.args, name)) {
+				function = i;
+				headers_.push_back(i);
+				if (li.opcode == ".macro")
+					macros_.insert(name);
+				opened.clear();
+				li.function = i;
+				continue;
+			}
+			li.function = function;
+			li.parent = opened.empty() ? -1 : opened.back();
+			if (li.opcode == "}") {
+				solAssert(!opened.empty(), "");
+				info_[opened.back()].match = i;
+				li.match = opened.back();
+				opened.pop_back();
+				continue;
+			}
+			if (!li.args.empty() && li.args.back() == '{') {
+				li.opens = true;
+				li.args.pop_back();
+				boost::algorithm::trim(li.args);
+				opened.push_back(i);
+			}
+			if (li.opcode == "CALL" && function != -1)
+				callSites_[callee(li.args)].push_back(i);
+		}
+	}
+
+	bool is_command(int i) const {
+		if (info_[i].removed)
+			return false;
+		const string& op = info_[i].opcode;
+		return !op.empty() && op[0] != '.' && op != "}";
+	}
+
+	bool is_header(int i) const {
+		return !headers_.empty() && std::binary_search(headers_.begin(), headers_.end(), i);
+	}
+
+	int function_end(int header) const {
+		auto it = std::upper_bound(headers_.begin(), headers_.end(), header);
+		return it == headers_.end() ? int(lines_.size()) : *it;
+	}
+
+	string function_name(int header) const {
+		string name;
+		TVMCodeStats::isFunctionHeader(info_[header].opcode, info_[header].args, name);
+		return name;
+	}
+
+	// Returns the line that opens the cell containing line i or the function header
+	int cell_of(int i) const {
+		int p = info_[i].parent;
+		while (p != -1 && info_[p].opcode == "PUSHCONT")
+			p = info_[p].parent;
+		return p == -1 ? info_[i].function : p;
+	}
+
+	pair<int, int> range_of(int cell) const {
+		if (is_header(cell))
+			return {cell + 1, function_end(cell)};
+		return {cell + 1, info_[cell].match};
+	}
+
+	int next_command(int i) const {
+		for (int j = i + 1; j < int(lines_.size()); ++j) {
+			if (info_[j].removed)
+				continue;
+			if (is_header(j) || info_[j].opcode == "}")
+				return -1;
+			if (is_command(j))
+				return j;
+		}
+		return -1;
+	}
+
+	// Size of the code placed in one cell. Inline continuations and macros are counted in.
+	CellSize cell_size(int begin, int end) {
+		CellSize res;
+		for (int i = begin; i < end; ++i) {
+			const LineInfo& li = info_[i];
+			if (!is_command(i))
+				continue;
+			if (li.opens) {
+				if (li.opcode == "PUSHCONT") {
+					CellSize inner = cell_size(i + 1, li.match);
+					res.bits += (inner.bits <= 15 * 8 ? 8 : 16) + inner.bits;
+					res.refs += inner.refs;
+				} else {
+					res.bits += TVMCodeStats::instructionBitSize(li.opcode, "");
+					res.refs += 1;
+				}
+				i = li.match;
+				continue;
+			}
+			if (li.opcode == "CALL" && macros_.count(callee(li.args))) {
+				CellSize m = macro_size(callee(li.args));
+				res.bits += m.bits;
+				res.refs += m.refs;
+				continue;
+			}
+			res.bits += TVMCodeStats::instructionBitSize(li.opcode, li.args);
+		}
+		return res;
+	}
+
+	CellSize macro_size(const string& name) {
+		if (macroSizes_.count(name))
+			return macroSizes_.at(name);
+		if (inProgress_.count(name))
+			return CellSize{TvmConst::CellBitLength, MaxRefs}; // recursive macros never fit
+		auto it = std::find_if(headers_.begin(), headers_.end(), [&](int h) {
+			return info_[h].opcode == ".macro" && function_name(h) == name;
+		});
+		solAssert(it != headers_.end(), "");
+		inProgress_.insert(name);
+		CellSize res = cell_size(*it + 1, function_end(*it));
+		inProgress_.erase(name);
+		macroSizes_[name] = res;
+		return res;
+	}
+
+	// Checks whether the code leaves the current continuation not by its end,
+	// so it can't be moved to another continuation.
+	bool has_transfer(int begin, int end) {
+		for (int i = begin; i < end; ++i) {
+			const LineInfo& li = info_[i];
+			if (!is_command(i))
+				continue;
+			if (li.opens) {
+				if (isIn(li.opcode, "IFJMPREF", "IFNOTJMPREF"))
+					return true;
+				i = li.match;
+				continue;
+			}
+			if (isIn(li.opcode, "RET", "RETALT", "RETARGS", "RETVARARGS", "RETDATA", "IFRET", "IFNOTRET",
+					 "IFJMP", "IFNOTJMP", "JMPX", "JMPXARGS", "JMPXDATA", "CALLCC", "CALLCCARGS", "CALLXVARARGS") ||
+				isIn(li.opcode, "AGAINEND", "WHILEEND", "UNTILEND", "REPEATEND", "BRANCH", "RETBOOL"))
+				return true;
+			for (const char* prefix : {"SAVE", "SAMEALT", "SETCONT", "POPCTR", "PUSHCTR", "SETRETCTR", "SETALTCTR", "POPSAVE", "ATEXIT"}) {
+				if (boost::starts_with(li.opcode, prefix))
+					return true;
+			}
+			if (boost::icontains(li.args, "c0") || boost::icontains(li.args, "c1"))
+				return true;
+			if (li.opcode == "CALL" && macros_.count(callee(li.args)) && macro_transfer(callee(li.args)))
+				return true;
+		}
+		return false;
+	}
+
+	bool macro_transfer(const string& name) {
+		if (macroTransfers_.count(name))
+			return macroTransfers_.at(name);
+		if (inProgress_.count(name))
+			return true;
+		auto it = std::find_if(headers_.begin(), headers_.end(), [&](int h) {
+			return info_[h].opcode == ".macro" && function_name(h) == name;
+		});
+		solAssert(it != headers_.end(), "");
+		inProgress_.insert(name);
+		bool res = has_transfer(*it + 1, function_end(*it));
+		inProgress_.erase(name);
+		macroTransfers_[name] = res;
+		return res;
+	}
+
+	// Checks that the cell still fits into limits after its size is changed.
+	// Code of macros is placed into the cells of all of their callers.
+	bool fits(int cell, int deltaBits, int deltaRefs, int depth = 0) {
+		if (depth > 8)
+			return false;
+		if (is_header(cell) && info_[cell].opcode == ".macro") {
+			auto it = callSites_.find(function_name(cell));
+			if (it == callSites_.end())
+				return false;
+			for (int site : it->second) {
+				if (!fits(cell_of(site), deltaBits, deltaRefs, depth + 1))
+					return false;
+			}
+			return true;
+		}
+		auto [begin, end] = range_of(cell);
+		CellSize size = cell_size(begin, end);
+		return (deltaBits <= 0 || size.bits + deltaBits <= TvmConst::CellBitLength - ReservedBits) &&
+			   (deltaRefs <= 0 || size.refs + deltaRefs <= MaxRefs);
+	}
+
+	bool ends_with_exception(int begin, int end) const {
+		int last = -1;
+		for (int i = begin; i < end; ++i) {
+			if (!is_command(i))
+				continue;
+			last = i;
+			if (info_[i].opens)
+				i = info_[i].match;
+		}
+		return last != -1 && isIn(info_[last].opcode, "THROW", "THROWANY", "THROWARG", "THROWARGANY");
+	}
+
+	// ".loc file, line" or ";; .loc file, line" if code is generated without debug info
+	static bool parse_location(const string& line, string& sourceName, int& lineNumber) {
+		string s = boost::algorithm::trim_copy(line);
+		if (boost::starts_with(s, ";;"))
+			s = boost::algorithm::trim_copy(s.substr(2));
+		if (!boost::starts_with(s, ".loc "))
+			return false;
+		vector<string> parts;
+		boost::split(parts, s.substr(5), boost::is_any_of(","));
+		if (parts.size() != 2)
+			return false;
+		sourceName = boost::algorithm::trim_copy(parts[0]);
+		lineNumber = std::atoi(parts[1].c_str());
+		return true;
+	}
+
+	// Looks for the profile of "if" statement by its source location that precedes the condition
+	std::optional<bool> profiled_cold(int i) const {
+		if (!GlobalParams::g_profile)
+			return std::nullopt;
+		for (int j = i - 1; j >= 0 && !is_header(j) && j != info_[i].parent; --j) {
+			string sourceName;
+			int line{};
+			if (info_[j].parent != info_[i].parent || !parse_location(lines_[j], sourceName, line))
+				continue;
+			if (line != 0)
+				return GlobalParams::g_profile->isColdBranch(sourceName, line);
+		}
+		return std::nullopt;
+	}
+
+	bool is_cold(int i) const {
+		std::optional<bool> profiled = profiled_cold(i);
+		if (profiled.has_value())
+			return *profiled;
+		return ends_with_exception(i + 1, info_[i].match);
+	}
+
+	// Count of calls of the function from the profile
+	uint64_t weight(int i) const {
+		if (!GlobalParams::g_profile || info_[i].function == -1)
+			return 0;
+		string name = function_name(info_[i].function);
+		for (const char* suffix : {"_macro", "_internal"}) {
+			if (boost::ends_with(name, suffix))
+				name.erase(name.size() - strlen(suffix));
+		}
+		return GlobalParams::g_profile->functionCount(name);
+	}
+
+	// Sizes of macros are memoized, they are recalculated after a macro is rewritten
+	void invalidate(int i) {
+		int function = info_[i].function;
+		if (function != -1 && info_[function].opcode == ".macro")
+			macroSizes_.clear();
+	}
+
+	// PUSHCONT { ... THROW N } IF => IFREF { ... THROW N }
+	// Makes one pass over the code, returns true if something is moved.
+	bool move_cold_continuations() {
+		bool changed = false;
+		for (int i = 0; i < int(lines_.size()); ++i) {
+			LineInfo& li = info_[i];
+			if (li.removed || li.opcode != "PUSHCONT" || !li.opens || !li.args.empty())
+				continue;
+			int j = next_command(li.match);
+			if (j == -1 || !isIn(info_[j].opcode, "IF", "IFNOT", "IFJMP", "IFNOTJMP") || !info_[j].args.empty())
+				continue;
+			if (!is_cold(i))
+				continue;
+			CellSize body = cell_size(i + 1, li.match);
+			if (body.bits < MinColdBits)
+				continue;
+			int deltaBits = 16 - ((body.bits <= 15 * 8 ? 8 : 16) + body.bits) - 8;
+			if (!fits(cell_of(i), deltaBits, 1 - body.refs))
+				continue;
+
+			li.opcode = info_[j].opcode + "REF";
+			boost::replace_first(lines_[i], "PUSHCONT", li.opcode);
+			info_[j].removed = true;
+			invalidate(i);
+			changed = true;
+		}
+		return changed;
+	}
+
+	// CALLREF { ... } => ...
+	// Continuations of hot functions are inlined first, they can occupy the free space of the cells.
+	// Makes one pass over the code, returns true if something is inlined.
+	bool inline_callrefs() {
+		bool changed = false;
+		vector<int> candidates;
+		for (int i = 0; i < int(lines_.size()); ++i) {
+			if (!info_[i].removed && info_[i].opcode == "CALLREF" && info_[i].opens && info_[i].args.empty())
+				candidates.push_back(i);
+		}
+		if (GlobalParams::g_profile) {
+			std::stable_sort(candidates.begin(), candidates.end(), [&](int a, int b) {
+				return weight(a) > weight(b);
+			});
+		}
+		for (int i : candidates) {
+			const LineInfo& li = info_[i];
+			if (has_transfer(i + 1, li.match))
+				continue;
+			CellSize body = cell_size(i + 1, li.match);
+			if (!fits(cell_of(i), body.bits - TVMCodeStats::instructionBitSize("CALLREF", ""), body.refs - 1))
+				continue;
+
+			int end = li.match;
+			for (int k = i + 1; k < end; ++k) {
+				if (!lines_[k].empty() && lines_[k][0] == '\t')
+					lines_[k].erase(0, 1);
+				if (info_[k].parent == i)
+					info_[k].parent = li.parent;
+			}
+			info_[end].removed = true;
+			info_[i].removed = true;
+			invalidate(i);
+			changed = true;
+		}
+		return changed;
+	}
+
+	// Rewrites keep indices of lines, so the code is analyzed only once
+	void run() {
+		while (move_cold_continuations()) {}
+		while (inline_callrefs()) {}
+	}
+
+	vector<string> result() const {
+		vector<string> res;
+		res.reserve(lines_.size());
+		for (int i = 0; i < int(lines_.size()); ++i) {
+			if (!info_[i].removed)
+				res.push_back(lines_[i]);
+		}
+		return res;
+	}
+};
+
+CodeLines optimize_placement(const CodeLines& code) {
+	TVMCodePlacement placement{code.lines};
+	placement.run();
+	CodeLines res = code;
+	res.lines = placement.result();
+	return res;
+}
+
+} // end solidity::frontend
@@ -0,0 +1,29 @@
+/*
+ * Copyright 2018-2019 TON DEV SOLUTIONS LTD.
+ *
+ * Licensed under the  terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License.
+ *
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the  GNU General Public License for more details at: https://www.gnu.org/licenses/gpl-3.0.html
+ */
+/**
+ * @author TON Labs <connect@tonlabs.io>
+ * @date 2021
+ * Placement of continuations into cells
+ */
+
+#pragma once
+
+#include "TVMPusher.hpp"
+
+namespace solidity::frontend {
+
+	// Moves cold continuations (that end with an exception or are cold by profile) to references
+	// and inlines small CALLREF continuations into the cell of the caller if they fit.
+	CodeLines optimize_placement(const CodeLines& code);
+
+} // end solidity::frontend
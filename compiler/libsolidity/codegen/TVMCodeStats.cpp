@@ -0,0 +1,333 @@
+/*
+ * Copyright 2018-2019 TON DEV SOLUTIONS LTD.
+ *
+ * Licensed under the  terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License.
+ *
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the  GNU General Public License for more details at: https://www.gnu.org/licenses/gpl-3.0.html
+ */
+/**
+ * @author TON Labs <connect@tonlabs.io>
+ * @date 2021
+ * Code size statistics of generated TVM assembly
+ */
+
+#include <boost/algorithm/string.hpp>
+
+#include "TVMCodeStats.hpp"
+
+using namespace solidity::frontend;
+
+namespace {
+
+// Opcodes which are encoded by one byte
+const std::set<std::string> oneByteOpcodes = {
+	"NOP", "SWAP", "DUP", "OVER", "DROP", "NIP", "ROT", "ROTREV", "-ROT", "TUCK",
+	"SWAP2", "2SWAP", "DROP2", "2DROP", "DUP2", "2DUP", "OVER2", "2OVER",
+	"PICK", "PUSHX", "ROLLX", "ROLLREVX", "BLKSWX", "REVX", "DROPX", "XCHGX", "DEPTH", "CHKDEPTH",
+	"ADD", "SUB", "SUBR", "MUL", "DIV", "MOD", "INC", "DEC", "NEGATE", "NOT", "AND", "OR", "XOR",
+	"SGN", "LESS", "LEQ", "GREATER", "GEQ", "EQUAL", "NEQ", "CMP", "ISZERO", "ISNEG", "ISPOS", "ISNPOS", "ISNNEG",
+	"TRUE", "FALSE", "ZERO", "ONE", "TWO", "TEN",
+	"NEWC", "ENDC", "CTOS", "ENDS", "STREF", "STSLICE", "STB", "STREFR", "STSLICER", "STBR", "LDREF", "PLDREF",
+	"LDREFRTOS", "NEWDICT", "STDICT", "LDDICT", "PLDDICT", "SKIPDICT",
+	"NULL", "PUSHNULL", "ISNULL",
+	"CALLX", "EXECUTE", "JMPX", "RET", "RETALT", "RETTRUE", "RETFALSE",
+	"IF", "IFNOT", "IFELSE", "IFRET", "IFNOTRET", "IFJMP", "IFNOTJMP", "CONDSEL",
+	"REPEAT", "REPEATEND", "UNTIL", "UNTILEND", "WHILE", "WHILEEND", "AGAIN", "AGAINEND",
+	"PUSHREF", "PUSHREFSLICE", "PUSHREFCONT",
+};
+
+// Opcodes which are encoded by two bytes (most of the opcodes with a short argument,
+// references to continuations), dictionary operations are two bytes too
+const std::set<std::string> twoByteOpcodes = {
+	"ABS", "ACCEPT", "ADDCONST", "ADDRAND", "ATEXIT", "BBITREFS", "BBITS", "BCHKBITSQ", "BDEPTH", "BINDUMP",
+	"BLESS", "BLKDROP", "BLKDROP2", "BLKPUSH", "BLKSWAP", "BLOCKLT", "BRANCH", "BREFS", "BREMBITREFS",
+	"BREMBITS", "BREMREFS", "CALLCC", "CALLCCARGS", "CALLREF", "CALLXVARARGS", "CDATASIZE", "CDATASIZEQ",
+	"CDEPTH", "CHKSIGNS", "CHKSIGNU", "COMMIT", "CONFIGPARAM", "DIVC", "DIVMOD", "DIVR", "EQINT", "FIRST",
+	"FITS", "GETGLOB", "GETGLOBVAR", "GETPARAM", "GTINT", "HASHCU", "HASHSU", "HEXDUMP", "IFJMPREF",
+	"IFNOTJMPREF", "IFNOTREF", "IFREF", "INDEX", "INDEX2", "INDEX3", "INDEXQ", "INDEXVAR", "JMPXARGS",
+	"JMPXDATA", "LDDICTQ", "LDGRAMS", "LDI", "LDIQ", "LDIX", "LDMSGADDR", "LDMSGADDRQ", "LDOPTREF", "LDSLICE",
+	"LDSLICEX", "LDU", "LDUQ", "LDUX", "LDVARUINT16", "LDVARUINT32", "LESSINT", "LSHIFT", "LTIME", "MAX", "MIN",
+	"MINMAX", "MODPOW2", "MULCONST", "MULDIV", "MULDIVC", "MULDIVMOD", "MULDIVR", "MULRSHIFT", "MYADDR",
+	"NEQINT", "NIL", "NOW", "NULLSWAPIF", "NULLSWAPIFNOT", "PAIR", "PARSEMSGADDR", "PLDDICTS", "PLDI",
+	"PLDREFIDX", "PLDREFVAR", "PLDSLICE", "PLDSLICEX", "PLDU", "PLDUX", "POPCTR", "POPROOT", "POPSAVE",
+	"PRINTSTR", "PUSH2", "PUSHCONT", "PUSHCTR", "PUSHPOW2DEC", "PUSHROOT", "RAND", "RANDSEED", "RANDU256",
+	"RAWRESERVE", "RAWRESERVEX", "RETARGS", "RETBOOL", "RETDATA", "RETVARARGS", "REVERSE", "RSHIFT", "SAMEALT",
+	"SAMEALTSAVE", "SAVE", "SBITREFS", "SBITS", "SCHKBITREFSQ", "SCHKBITSQ", "SCHKREFSQ", "SDATASIZE",
+	"SDATASIZEQ", "SDBEGINSX", "SDEMPTY", "SDEPTH", "SDEQ", "SDLEXCMP", "SDSKIPFIRST", "SECOND", "SEMPTY",
+	"SENDRAWMSG", "SETALTCTR", "SETCODE", "SETCONT", "SETGLOB", "SETGLOBVAR", "SETINDEX", "SETINDEXQ",
+	"SETINDEXVAR", "SETINDEXVARQ", "SETRAND", "SETRETCTR", "SETTHIRD", "SHA256U", "SPLIT", "SREFS", "SREMPTY",
+	"SSKIPFIRST", "STBREF", "STBREFR", "STGRAMS", "STI", "STIR", "STIX", "STIXR", "STONE", "STONES", "STOPTREF",
+	"STRDUMP", "STU", "STUR", "STUX", "STUXR", "STVARUINT32", "STZERO", "STZEROES", "SUBSLICE", "THIRD",
+	"THROWANY", "THROWANYIFNOT", "THROWARG", "THROWARGANY", "THROWARGANYIFNOT", "THROWARGIFNOT", "TLEN", "TPOP",
+	"TPUSH", "TRIPLE", "TRY", "TUPLE", "TUPLEVAR", "UBITSIZE", "UFITS", "UNPACKFIRST", "UNPAIR", "UNTUPLE",
+	"UNTUPLEVAR", "VERGRTH16",
+};
+
+bool isNumber(std::string const& s) {
+	if (s.empty())
+		return false;
+	size_t i = s[0] == '-' ? 1 : 0;
+	return i < s.size() && std::all_of(s.begin() + i, s.end(), [](char c) { return std::isdigit(c); });
+}
+
+// Estimated quantity of bits needed to store the signed integer written in decimal
+int signedBitLength(std::string const& value) {
+	size_t digits = value.size() - (value[0] == '-' ? 1 : 0);
+	if (digits <= 18) {
+		int64_t v = std::stoll(value);
+		int len = 1;
+		while (v >= (int64_t{1} << (len - 1)) || v < -(int64_t{1} << (len - 1)))
+			++len;
+		return len;
+	}
+	// log2(10) ~ 3.33
+	return static_cast<int>(digits * 10 / 3) + 2;
+}
+
+// Returns index of stack register written as "s<index>" or -1
+int stackRegister(std::string const& arg) {
+	std::string s = boost::algorithm::trim_copy(arg);
+	if (s.size() < 2 || (s[0] != 's' && s[0] != 'S') || !isNumber(s.substr(1)))
+		return -1;
+	return std::stoi(s.substr(1));
+}
+
+int hexDataBitSize(std::string const& args) {
+	// x<hex> with optional completion tag '_'
+	std::string s = boost::algorithm::trim_copy(args);
+	if (s.empty() || s[0] != 'x')
+		return 0;
+	int len = static_cast<int>(s.size()) - 1;
+	if (s.back() == '_')
+		--len;
+	return 4 * len;
+}
+
+std::vector<std::string> splitArgs(std::string const& args) {
+	std::vector<std::string> res;
+	if (args.empty())
+		return res;
+	boost::split(res, args, boost::is_any_of(","));
+	for (std::string& s : res)
+		boost::algorithm::trim(s);
+	return res;
+}
+
+}
+
+void CodeStatsItem::add(CodeStatsItem const& oth) {
+	instructions += oth.instructions;
+	bits += oth.bits;
+	cells += oth.cells;
+	refs += oth.refs;
+}
+
+Json::Value CodeStatsItem::toJson() const {
+	Json::Value root(Json::objectValue);
+	root["instructions"] = instructions;
+	root["bits"] = bits;
+	root["cells"] = cells;
+	root["refs"] = refs;
+	return root;
+}
+
+TVMCodeStats::TVMCodeStats(CodeLines const& code) {
+	collect(code);
+}
+
+CodeStatsItem TVMCodeStats::total() const {
+	CodeStatsItem res;
+	for (const auto& [name, item] : m_functions)
+		res.add(item);
+	return res;
+}
+
+Json::Value TVMCodeStats::toJson(std::string const& contractName) const {
+	Json::Value root(Json::objectValue);
+	root["contract"] = contractName;
+	root["total"] = total().toJson();
+	Json::Value functions(Json::objectValue);
+	for (const auto& [name, item] : m_functions)
+		functions[name] = item.toJson();
+	root["functions"] = functions;
+	return root;
+}
+
+std::pair<std::string, std::string> TVMCodeStats::splitLine(std::string const& line) {
+	std::string s = line;
+	size_t comment = s.find(';');
+	if (comment != std::string::npos)
+		s = s.substr(0, comment);
+	boost::algorithm::trim(s);
+	size_t space = s.find_first_of(" \t");
+	if (space == std::string::npos)
+		return {s, ""};
+	return {s.substr(0, space), boost::algorithm::trim_copy(s.substr(space + 1))};
+}
+
+bool TVMCodeStats::isFunctionHeader(std::string const& opcode, std::string const& args, std::string& name) {
+	if (opcode == ".macro" || opcode == ".globl") {
+		name = args;
+		return true;
+	}
+	if (opcode == ".internal") {
+		name = boost::starts_with(args, ":") ? args.substr(1) : args;
+		return true;
+	}
+	return false;
+}
+
+int TVMCodeStats::instructionBitSize(std::string const& opcode, std::string const& args) {
+	if (oneByteOpcodes.count(opcode))
+		return 8;
+
+	if (opcode == "PUSHINT") {
+		if (!isNumber(args))
+			return 16;
+		int len = signedBitLength(args);
+		if (len <= 4 && std::stoi(args) >= -5 && std::stoi(args) <= 10)
+			return 8;
+		if (len <= 8)
+			return 16;
+		if (len <= 16)
+			return 24;
+		// PUSHINT with long integer: 16 bits of prefix and length, 19 + 8 * l bits of value
+		int l = std::max(0, (len - 19 + 7) / 8);
+		return 16 + 19 + 8 * l;
+	}
+	if (opcode == "PUSHSLICE")
+		return 16 + hexDataBitSize(args);
+	if (opcode == "STSLICECONST")
+		return 16 + hexDataBitSize(args);
+
+	if (opcode == "PUSH" || opcode == "POP") {
+		int i = stackRegister(args);
+		return 0 <= i && i < 16 ? 8 : 16;
+	}
+	if (opcode == "XCHG") {
+		std::vector<std::string> regs = splitArgs(args);
+		if (regs.size() == 1 || (regs.size() == 2 && (stackRegister(regs[0]) == 0 || stackRegister(regs[0]) == 1))) {
+			int i = stackRegister(regs.back());
+			return 0 <= i && i < 16 ? 8 : 16;
+		}
+		return 16;
+	}
+	if (opcode == "PUSH3" || opcode == "XCHG3")
+		return 24;
+
+	if (opcode == "THROW" || opcode == "THROWIF" || opcode == "THROWIFNOT") {
+		if (isNumber(args) && std::stoi(args) < 64)
+			return 16;
+		return 24;
+	}
+
+	if (opcode == "CALL" || opcode == "JMP") {
+		// CALLDICT: short form has one byte of function id
+		if (isNumber(args) && std::stoi(args) >= 256)
+			return 24;
+		return 16;
+	}
+
+	if (twoByteOpcodes.count(opcode) || boost::starts_with(opcode, "DICT"))
+		return 16;
+
+	// The size is only a heuristic for placement and statistics. Overestimating an opcode the
+	// table does not know yet is harmless, failing the compilation on it is not.
+	return 24;
+}
+
+void TVMCodeStats::collect(CodeLines const& code) {
+	struct Frame {
+		bool isCell{}; // frame is placed in a separate cell
+		int bits{};
+	};
+	std::string function;
+	std::vector<Frame> frames;
+
+	auto finishCell = [&](int bits) {
+		CodeStatsItem& item = m_functions[function];
+		item.cells += 1 + std::max(0, (bits - 1) / TvmConst::CellBitLength);
+	};
+
+	auto finishFunction = [&]() {
+		if (!function.empty() && !frames.empty()) {
+			finishCell(frames.front().bits);
+		}
+		frames.clear();
+	};
+
+	for (std::string const& line : code.lines) {
+		auto [opcode, args] = splitLine(line);
+		if (opcode.empty()) {
+			continue;
+		}
+
+		std::string name;
+		if (isFunctionHeader(opcode, args, name)) {
+			finishFunction();
+			function = name;
+			m_functions[function];
+			frames.push_back(Frame{true, 0});
+			continue;
+		}
+		if (function.empty() || frames.empty()) {
+			continue;
+		}
+		CodeStatsItem& item = m_functions[function];
+
+		if (opcode == "}") {
+			solAssert(frames.size() >= 2, "");
+			Frame frame = frames.back();
+			frames.pop_back();
+			if (frame.isCell) {
+				finishCell(frame.bits);
+			} else {
+				// PUSHCONT: short form for bodies up to 15 bytes
+				int header = frame.bits <= 15 * 8 ? 8 : 16;
+				frames.back().bits += header + frame.bits;
+				item.bits += header;
+			}
+			continue;
+		}
+
+		bool opensBlock = !args.empty() && args.back() == '{';
+		if (opensBlock) {
+			if (opcode == "PUSHCONT") {
+				item.instructions++;
+				frames.push_back(Frame{false, 0});
+			} else {
+				if (opcode != ".cell") {
+					int bits = instructionBitSize(opcode, "");
+					item.instructions++;
+					item.bits += bits;
+					frames.back().bits += bits;
+				}
+				item.refs++;
+				frames.push_back(Frame{true, 0});
+			}
+			continue;
+		}
+
+		if (opcode == ".blob") {
+			int bits = hexDataBitSize(args);
+			item.bits += bits;
+			frames.back().bits += bits;
+			continue;
+		}
+		if (opcode[0] == '.') {
+			// .type, .internal-alias, .loc and other directives
+			continue;
+		}
+
+		int bits = instructionBitSize(opcode, args);
+		item.instructions++;
+		item.bits += bits;
+		frames.back().bits += bits;
+	}
+	finishFunction();
+}
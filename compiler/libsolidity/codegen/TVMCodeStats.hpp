@@ -0,0 +1,54 @@
+/*
+ * Copyright 2018-2019 TON DEV SOLUTIONS LTD.
+ *
+ * Licensed under the  terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License.
+ *
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the  GNU General Public License for more details at: https://www.gnu.org/licenses/gpl-3.0.html
+ */
+/**
+ * @author TON Labs <connect@tonlabs.io>
+ * @date 2021
+ * Code size statistics of generated TVM assembly
+ */
+
+#pragma once
+
+#include "TVMPusher.hpp"
+
+namespace solidity::frontend {
+
+struct CodeStatsItem {
+	int instructions{};
+	int bits{};  // estimated size of instructions and inline data
+	int cells{}; // cells occupied by the function and all of its references
+	int refs{};  // continuations and data placed in references
+
+	void add(CodeStatsItem const& oth);
+	Json::Value toJson() const;
+};
+
+class TVMCodeStats {
+public:
+	explicit TVMCodeStats(CodeLines const& code);
+	std::map<std::string, CodeStatsItem> const& functions() const { return m_functions; }
+	CodeStatsItem total() const;
+	Json::Value toJson(std::string const& contractName) const;
+
+	// Estimated size in bits of the instruction in its shortest encoding, 24 bits for unknown opcodes
+	static int instructionBitSize(std::string const& opcode, std::string const& args);
+	// Splits assembly line into opcode and arguments. Comments are dropped.
+	static std::pair<std::string, std::string> splitLine(std::string const& line);
+	// Checks whether the line starts a function or macro and sets its name
+	static bool isFunctionHeader(std::string const& opcode, std::string const& args, std::string& name);
+private:
+	void collect(CodeLines const& code);
+private:
+	std::map<std::string, CodeStatsItem> m_functions;
+};
+
+}	// end solidity::frontend
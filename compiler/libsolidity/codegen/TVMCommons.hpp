@@ -62,41 +62,6 @@ bool ends_with(const string& str, const string& suffix);
 std::string functionName(FunctionDefinition const* _function);
 
 
-template <typename T>
-static bool doesAlways(const Statement* st) {
-	auto rec = [] (const Statement* s) {
-		return doesAlways<T>(s);
-	};
-	if (to<T>(st))
-		return true;
-
-	if (
-		to<Assignment>(st) ||
-		to<Break>(st) ||
-		to<Continue>(st) ||
-		to<EmitStatement>(st) ||
-		to<ExpressionStatement>(st) ||
-		to<ForEachStatement>(st) ||
-		to<ForStatement>(st) ||
-		to<PlaceholderStatement>(st) ||
-		to<Return>(st) ||
-		to<VariableDeclarationStatement>(st) ||
-		to<WhileStatement>(st)
-	)
-		return false;
-	if (auto block = to<Block>(st)) {
-		return std::any_of(block->statements().begin(), block->statements().end(), [&](const auto& s){
-			return rec(s.get());
-		});
-	}
-	if (auto ifStatement = to<IfStatement>(st)) {
-		if (!ifStatement->falseStatement())
-			return false;
-		return rec(&ifStatement->trueStatement()) && rec(ifStatement->falseStatement());
-	}
-	solUnimplemented( string("Unsupported statement type: ") + typeid(*st).name());
-}
-
 bool isAddressOrContractType(const Type* type);
 
 bool isUsualArray(const Type* type);
@@ -366,37 +331,13 @@ CallableDeclaration const * getFunctionDeclarationOrConstructor(Expression const
 
 bool isEmptyFunction(FunctionDefinition const* f);
 
-enum class LocationReturn {
-	noReturn,
-	Last,
-	Anywhere
-};
-
 struct ControlFlowInfo {
 	int stackSize {-1};
 	bool isLoop {false};
 	bool useJmp {false};
-};
-
-struct ContInfo {
-	static constexpr int CONTINUE_FLAG = 1;
-	static constexpr int BREAK_FLAG = 2;
-	static constexpr int RETURN_FLAG = 4;
-
-	bool canReturn{};
-	bool canBreak{};
-	bool canContinue{};
-	bool alwaysReturns{};
-	bool alwaysBreak{};
-	bool alwaysContinue{};
-
-	bool doThatAlways() const {
-		return alwaysReturns || alwaysBreak || alwaysContinue;
-	}
-
-	bool mayDoThat() const {
-		return canReturn || canBreak || canContinue;
-	}
+	// Loop body has only one kind of exits, it's done by RETALT without flag (see pushControlFlowFlag)
+	bool breakByRetAlt {false};
+	bool continueByRetAlt {false};
 };
 
 LocationReturn notNeedsPushContWhenInlining(Block const& _block);
@@ -0,0 +1,651 @@
+/*
+ * Copyright 2018-2019 TON DEV SOLUTIONS LTD.
+ *
+ * Licensed under the  terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License.
+ *
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the  GNU General Public License for more details at: https://www.gnu.org/licenses/gpl-3.0.html
+ */
+/**
+ * @author TON Labs <connect@tonlabs.io>
+ * @date 2021
+ * Compile-time evaluation of integer, boolean and string expressions including calls of pure functions
+ */
+
+#include <libsolutil/picosha2.h>
+
+#include "TVM.h"
+#include "TVMCommons.hpp"
+#include "TVMConstants.hpp"
+#include "TVMConstEvaluator.hpp"
+#include "TVMExpressionCompiler.hpp"
+
+using namespace solidity::frontend;
+
+static const int MaxEvaluationSteps = 10000;
+static const int MaxCallDepth = 32;
+static const int MaxShift = 1023;
+
+std::optional<bigint> TVMConstEvaluator::evaluate(Expression const& _e) {
+	if (std::optional<bigint> value = TVMExpressionCompiler::constValue(_e)) {
+		return value;
+	}
+	if (!GlobalParams::g_withOptimizations ||
+		!isEvaluatedType(_e.annotation().type) ||
+		!(to<FunctionCall>(&_e) || to<BinaryOperation>(&_e) || to<UnaryOperation>(&_e) || to<Conditional>(&_e)) ||
+		!isCandidate(_e)
+	) {
+		return {};
+	}
+	TVMConstEvaluator evaluator;
+	return evaluator.eval(_e);
+}
+
+std::optional<std::string> TVMConstEvaluator::evaluateString(Expression const& _e) {
+	if (!GlobalParams::g_withOptimizations || !to<BinaryOperation>(&_e)) {
+		return {};
+	}
+	return stringValue(_e);
+}
+
+std::optional<std::string> TVMConstEvaluator::stringValue(Expression const& _e) {
+	if (!isStringOrStringLiteralOrBytes(_e.annotation().type)) {
+		return {};
+	}
+	if (auto literal = to<Literal>(&_e)) {
+		return literal->value();
+	}
+	if (auto ident = to<Identifier>(&_e)) {
+		auto vd = to<VariableDeclaration>(ident->annotation().referencedDeclaration);
+		if (vd && vd->isConstant() && vd->value()) {
+			return stringValue(*vd->value());
+		}
+		return {};
+	}
+	if (auto tuple = to<TupleExpression>(&_e)) {
+		if (tuple->isInlineArray() || tuple->components().size() != 1 || !tuple->components().at(0)) {
+			return {};
+		}
+		return stringValue(*tuple->components().at(0));
+	}
+	if (auto binary = to<BinaryOperation>(&_e); binary && binary->getOperator() == Token::Add) {
+		std::optional<std::string> left = stringValue(binary->leftExpression());
+		if (!left) {
+			return {};
+		}
+		std::optional<std::string> right = stringValue(binary->rightExpression());
+		if (!right) {
+			return {};
+		}
+		return *left + *right;
+	}
+	if (auto call = to<FunctionCall>(&_e); call && call->annotation().kind == FunctionCallKind::TypeConversion &&
+		call->arguments().size() == 1) {
+		return stringValue(*call->arguments().at(0));
+	}
+	return {};
+}
+
+// SHA256U hashes data of the first cell of the string only, so the string must fit in one cell
+std::optional<bigint> TVMConstEvaluator::sha256(FunctionCall const& _call) {
+	auto ft = to<FunctionType>(_call.expression().annotation().type);
+	if (ft == nullptr || ft->kind() != FunctionType::Kind::SHA256 || _call.arguments().size() != 1) {
+		return {};
+	}
+	auto arrType = to<ArrayType>(ft->parameterTypes().at(0));
+	if (arrType == nullptr || !arrType->isByteArray()) {
+		return {};
+	}
+	std::optional<std::string> str = stringValue(*_call.arguments().at(0));
+	if (!str || str->size() > TvmConst::CellBitLength / 8) {
+		return {};
+	}
+	return fromBigEndian<bigint>(picosha2::hash256(*str));
+}
+
+// Quick check that the expression consists of constants and calls of pure functions with constant arguments
+bool TVMConstEvaluator::isCandidate(Expression const& _e) {
+	if (TVMExpressionCompiler::constValue(_e) || TVMExpressionCompiler::constBool(_e)) {
+		return true;
+	}
+	if (auto ident = to<Identifier>(&_e)) {
+		auto vd = to<VariableDeclaration>(ident->annotation().referencedDeclaration);
+		return vd && vd->isConstant() && vd->value() && isCandidate(*vd->value());
+	}
+	if (auto tuple = to<TupleExpression>(&_e)) {
+		return !tuple->isInlineArray() && tuple->components().size() == 1 && tuple->components().at(0) &&
+			isCandidate(*tuple->components().at(0));
+	}
+	if (auto unary = to<UnaryOperation>(&_e)) {
+		return !isIn(unary->getOperator(), Token::Inc, Token::Dec, Token::Delete) && isCandidate(unary->subExpression());
+	}
+	if (auto binary = to<BinaryOperation>(&_e)) {
+		return isCandidate(binary->leftExpression()) && isCandidate(binary->rightExpression());
+	}
+	if (auto conditional = to<Conditional>(&_e)) {
+		return isCandidate(conditional->condition()) &&
+			isCandidate(conditional->trueExpression()) &&
+			isCandidate(conditional->falseExpression());
+	}
+	if (auto call = to<FunctionCall>(&_e)) {
+		if (sha256(*call)) {
+			return true;
+		}
+		if (call->annotation().kind == FunctionCallKind::TypeConversion) {
+			if (call->arguments().size() != 1 || !isEvaluatedType(call->annotation().type)) {
+				return false;
+			}
+		} else if (pureFunction(*call) == nullptr) {
+			return false;
+		}
+		for (const ASTPointer<Expression const>& arg : call->arguments()) {
+			if (!isCandidate(*arg)) {
+				return false;
+			}
+		}
+		return true;
+	}
+	return false;
+}
+
+bool TVMConstEvaluator::isEvaluatedType(Type const* type) {
+	if (type == nullptr) {
+		return false;
+	}
+	switch (type->category()) {
+		case Type::Category::Integer:
+		case Type::Category::Bool:
+			return true;
+		case Type::Category::RationalNumber:
+			return !to<RationalNumberType>(type)->isFractional();
+		default:
+			return false;
+	}
+}
+
+bool TVMConstEvaluator::fits(Type const* type, bigint const& value) {
+	switch (type->category()) {
+		case Type::Category::Integer: {
+			auto intType = to<IntegerType>(type);
+			return intType->minValue() <= value && value <= intType->maxValue();
+		}
+		case Type::Category::Bool:
+			return value == 0 || value == 1;
+		case Type::Category::RationalNumber:
+			return true;
+		default:
+			return false;
+	}
+}
+
+// Returns the function if it's called directly and can be interpreted
+FunctionDefinition const* TVMConstEvaluator::pureFunction(FunctionCall const& _call) {
+	auto ft = to<FunctionType>(_call.expression().annotation().type);
+	if (ft == nullptr || ft->kind() != FunctionType::Kind::Internal || ft->bound() || !_call.names().empty()) {
+		return nullptr;
+	}
+	FunctionDefinition const* f{};
+	if (auto ident = to<Identifier>(&_call.expression())) {
+		f = to<FunctionDefinition>(ident->annotation().referencedDeclaration);
+	} else if (auto memberAccess = to<MemberAccess>(&_call.expression())) {
+		// LibName.function
+		f = to<FunctionDefinition>(memberAccess->annotation().referencedDeclaration);
+		auto contract = f ? dynamic_cast<ContractDefinition const*>(f->scope()) : nullptr;
+		if (contract == nullptr || !contract->isLibrary()) {
+			return nullptr;
+		}
+	}
+	if (f == nullptr ||
+		!f->isImplemented() ||
+		f->stateMutability() != StateMutability::Pure ||
+		f->virtualSemantics() ||
+		!f->modifiers().empty() ||
+		f->returnParameters().size() != 1 ||
+		!isEvaluatedType(f->returnParameters().at(0)->type())
+	) {
+		return nullptr;
+	}
+	for (const ASTPointer<VariableDeclaration>& param : f->parameters()) {
+		if (!isEvaluatedType(param->type())) {
+			return nullptr;
+		}
+	}
+	return f;
+}
+
+bool TVMConstEvaluator::step() {
+	return ++m_steps <= MaxEvaluationSteps;
+}
+
+std::optional<bigint> TVMConstEvaluator::eval(Expression const& _e) {
+	if (!step() || !isEvaluatedType(_e.annotation().type)) {
+		return {};
+	}
+	if (std::optional<bool> value = TVMExpressionCompiler::constBool(_e)) {
+		return *value ? 1 : 0;
+	}
+	if (auto ident = to<Identifier>(&_e)) {
+		auto vd = to<VariableDeclaration>(ident->annotation().referencedDeclaration);
+		if (vd == nullptr) {
+			return {};
+		}
+		if (!m_frames.empty()) {
+			auto it = m_frames.back().find(vd);
+			if (it != m_frames.back().end()) {
+				return it->second;
+			}
+		}
+		if (vd->isConstant() && vd->value()) {
+			std::optional<bigint> value = eval(*vd->value());
+			if (value && fits(vd->type(), *value)) {
+				return value;
+			}
+		}
+		return {};
+	}
+	if (std::optional<bigint> value = TVMExpressionCompiler::constValue(_e)) {
+		return value;
+	}
+	if (auto tuple = to<TupleExpression>(&_e)) {
+		if (tuple->isInlineArray() || tuple->components().size() != 1 || !tuple->components().at(0)) {
+			return {};
+		}
+		return eval(*tuple->components().at(0));
+	}
+	if (auto unary = to<UnaryOperation>(&_e)) {
+		return evalUnary(*unary);
+	}
+	if (auto binary = to<BinaryOperation>(&_e)) {
+		const Token op = binary->getOperator();
+		std::optional<bigint> left = eval(binary->leftExpression());
+		if (!left) {
+			return {};
+		}
+		if (op == Token::And || op == Token::Or) {
+			if ((op == Token::And) == (*left == 0)) {
+				return *left;
+			}
+			return eval(binary->rightExpression());
+		}
+		std::optional<bigint> right = eval(binary->rightExpression());
+		if (!right) {
+			return {};
+		}
+		return evalBinary(op, binary->annotation().commonType, *left, *right);
+	}
+	if (auto conditional = to<Conditional>(&_e)) {
+		std::optional<bigint> condition = eval(conditional->condition());
+		if (!condition) {
+			return {};
+		}
+		return eval(*condition != 0 ? conditional->trueExpression() : conditional->falseExpression());
+	}
+	if (auto assignment = to<Assignment>(&_e)) {
+		return evalAssignment(*assignment);
+	}
+	if (auto call = to<FunctionCall>(&_e)) {
+		return evalCall(*call);
+	}
+	return {};
+}
+
+// Result is the same as TVM gives for the operation, or nothing if TVM throws an exception or the result doesn't fit
+// the type
+std::optional<bigint> TVMConstEvaluator::evalBinary(Token op, Type const* commonType, bigint const& left, bigint const& right) {
+	if (!isEvaluatedType(commonType)) {
+		return {};
+	}
+	bigint result;
+	switch (op) {
+		case Token::Equal:
+			return bigint(left == right ? 1 : 0);
+		case Token::NotEqual:
+			return bigint(left != right ? 1 : 0);
+		case Token::LessThan:
+			return bigint(left < right ? 1 : 0);
+		case Token::LessThanOrEqual:
+			return bigint(left <= right ? 1 : 0);
+		case Token::GreaterThan:
+			return bigint(left > right ? 1 : 0);
+		case Token::GreaterThanOrEqual:
+			return bigint(left >= right ? 1 : 0);
+		case Token::Add:
+			result = left + right;
+			break;
+		case Token::Sub:
+			result = left - right;
+			break;
+		case Token::Mul:
+			result = left * right;
+			break;
+		case Token::Div:
+		case Token::Mod: {
+			if (right == 0) {
+				return {};
+			}
+			// DIV and MOD round to -inf
+			bigint quotient = left / right;
+			if (left % right != 0 && (left < 0) != (right < 0)) {
+				--quotient;
+			}
+			result = op == Token::Div ? quotient : left - quotient * right;
+			break;
+		}
+		case Token::Exp:
+			if (right < 0 || (left == 0 && right == 0) || (abs(left) > 1 && right > MaxShift)) {
+				return {};
+			}
+			result = boost::multiprecision::pow(left, static_cast<unsigned>(right));
+			break;
+		case Token::SHL:
+			if (right < 0 || right > MaxShift) {
+				return {};
+			}
+			result = left * boost::multiprecision::pow(bigint(2), static_cast<unsigned>(right));
+			break;
+		case Token::SAR: {
+			// like SHL, RSHIFT throws a range check error for such shifts at run time
+			if (right < 0 || right > MaxShift) {
+				return {};
+			}
+			return evalBinary(Token::Div, commonType, left, boost::multiprecision::pow(bigint(2), static_cast<unsigned>(right)));
+		}
+		case Token::BitAnd:
+		case Token::BitOr:
+		case Token::BitXor:
+			if (left < 0 || right < 0) {
+				return {};
+			}
+			if (op == Token::BitAnd) {
+				result = left & right;
+			} else if (op == Token::BitOr) {
+				result = left | right;
+			} else {
+				result = left ^ right;
+			}
+			break;
+		default:
+			return {};
+	}
+	if (!fits(commonType, result)) {
+		return {};
+	}
+	return result;
+}
+
+std::optional<bigint> TVMConstEvaluator::evalUnary(UnaryOperation const& _node) {
+	const Token op = _node.getOperator();
+	Type const* type = _node.annotation().type;
+	std::optional<bigint> value = eval(_node.subExpression());
+	if (!value) {
+		return {};
+	}
+	bigint result;
+	switch (op) {
+		case Token::Inc:
+		case Token::Dec: {
+			result = *value + (op == Token::Inc ? 1 : -1);
+			if (!fits(type, result) || !assign(_node.subExpression(), result)) {
+				return {};
+			}
+			return _node.isPrefixOperation() ? result : *value;
+		}
+		case Token::Not:
+			return bigint(*value == 0 ? 1 : 0);
+		case Token::Sub:
+			result = -*value;
+			break;
+		case Token::BitNot: {
+			auto intType = to<IntegerType>(type);
+			if (intType == nullptr) {
+				return {};
+			}
+			result = intType->isSigned() ? -*value - 1 : intType->maxValue() - *value;
+			break;
+		}
+		default:
+			return {};
+	}
+	if (!fits(type, result)) {
+		return {};
+	}
+	return result;
+}
+
+std::optional<bigint> TVMConstEvaluator::evalAssignment(Assignment const& _node) {
+	Type const* type = _node.leftHandSide().annotation().type;
+	std::optional<bigint> value = eval(_node.rightHandSide());
+	if (!value) {
+		return {};
+	}
+	const Token op = _node.assignmentOperator();
+	if (op != Token::Assign) {
+		std::optional<bigint> left = eval(_node.leftHandSide());
+		if (!left) {
+			return {};
+		}
+		value = evalBinary(TokenTraits::AssignmentToBinaryOp(op), type, *left, *value);
+	}
+	if (!value || !fits(type, *value) || !assign(_node.leftHandSide(), *value)) {
+		return {};
+	}
+	return value;
+}
+
+std::optional<bigint> TVMConstEvaluator::evalCall(FunctionCall const& _call) {
+	if (_call.annotation().kind == FunctionCallKind::TypeConversion) {
+		if (_call.arguments().size() != 1) {
+			return {};
+		}
+		std::optional<bigint> value = eval(*_call.arguments().at(0));
+		if (!value || !fits(_call.annotation().type, *value)) {
+			return {};
+		}
+		return value;
+	}
+	if (std::optional<bigint> hash = sha256(_call)) {
+		return hash;
+	}
+
+	FunctionDefinition const* f = pureFunction(_call);
+	if (f == nullptr) {
+		return {};
+	}
+	std::vector<bigint> args;
+	for (size_t i = 0; i < _call.arguments().size(); ++i) {
+		std::optional<bigint> value = eval(*_call.arguments().at(i));
+		if (!value || !fits(f->parameters().at(i)->type(), *value)) {
+			return {};
+		}
+		args.push_back(*value);
+	}
+	return call(*f, args);
+}
+
+std::optional<bigint> TVMConstEvaluator::call(FunctionDefinition const& _function, std::vector<bigint> const& args) {
+	if (m_frames.size() >= MaxCallDepth) {
+		return {};
+	}
+	m_frames.emplace_back();
+	for (size_t i = 0; i < args.size(); ++i) {
+		m_frames.back()[_function.parameters().at(i).get()] = args.at(i);
+	}
+	VariableDeclaration const* ret = _function.returnParameters().at(0).get();
+	m_frames.back()[ret] = 0;
+
+	std::optional<bigint> result;
+	Flow flow = Flow::Next;
+	if (exec(_function.body(), flow)) {
+		result = flow == Flow::Return ? m_returnValue : m_frames.back().at(ret);
+	}
+	m_frames.pop_back();
+	m_returnValue.reset();
+	if (!result || !fits(ret->type(), *result)) {
+		return {};
+	}
+	return result;
+}
+
+bool TVMConstEvaluator::exec(Statement const& _s, Flow& flow) {
+	if (!step()) {
+		return false;
+	}
+	if (auto block = to<Block>(&_s)) {
+		for (const ASTPointer<Statement>& s : block->statements()) {
+			if (!exec(*s, flow)) {
+				return false;
+			}
+			if (flow != Flow::Next) {
+				break;
+			}
+		}
+		return true;
+	}
+	if (auto vds = to<VariableDeclarationStatement>(&_s)) {
+		if (vds->declarations().size() != 1 || !vds->declarations().at(0)) {
+			return false;
+		}
+		VariableDeclaration const* decl = vds->declarations().at(0).get();
+		if (!isEvaluatedType(decl->type())) {
+			return false;
+		}
+		std::optional<bigint> value = vds->initialValue() ? eval(*vds->initialValue()) : bigint(0);
+		if (!value || !fits(decl->type(), *value)) {
+			return false;
+		}
+		m_frames.back()[decl] = *value;
+		return true;
+	}
+	if (auto es = to<ExpressionStatement>(&_s)) {
+		auto call = to<FunctionCall>(&es->expression());
+		auto ft = call ? to<FunctionType>(call->expression().annotation().type) : nullptr;
+		if (ft && ft->kind() == FunctionType::Kind::Require && !call->arguments().empty()) {
+			// we give up if require throws
+			std::optional<bigint> condition = eval(*call->arguments().at(0));
+			return condition && *condition != 0;
+		}
+		return eval(es->expression()).has_value();
+	}
+	if (auto ifStatement = to<IfStatement>(&_s)) {
+		std::optional<bigint> condition = eval(ifStatement->condition());
+		if (!condition) {
+			return false;
+		}
+		if (*condition != 0) {
+			return exec(ifStatement->trueStatement(), flow);
+		}
+		return ifStatement->falseStatement() == nullptr || exec(*ifStatement->falseStatement(), flow);
+	}
+	if (auto whileStatement = to<WhileStatement>(&_s)) {
+		if (whileStatement->loopType() == WhileStatement::LoopType::REPEAT) {
+			return false;
+		}
+		const bool isDoWhile = whileStatement->loopType() == WhileStatement::LoopType::DO_WHILE;
+		while (true) {
+			if (!isDoWhile) {
+				std::optional<bigint> condition = eval(whileStatement->condition());
+				if (!condition) {
+					return false;
+				}
+				if (*condition == 0) {
+					break;
+				}
+			}
+			if (!exec(whileStatement->body(), flow)) {
+				return false;
+			}
+			if (flow == Flow::Return) {
+				return true;
+			}
+			if (flow == Flow::Break) {
+				flow = Flow::Next;
+				break;
+			}
+			flow = Flow::Next;
+			if (isDoWhile) {
+				std::optional<bigint> condition = eval(whileStatement->condition());
+				if (!condition) {
+					return false;
+				}
+				if (*condition == 0) {
+					break;
+				}
+			}
+		}
+		return true;
+	}
+	if (auto forStatement = to<ForStatement>(&_s)) {
+		if (forStatement->initializationExpression() && !exec(*forStatement->initializationExpression(), flow)) {
+			return false;
+		}
+		while (true) {
+			if (forStatement->condition()) {
+				std::optional<bigint> condition = eval(*forStatement->condition());
+				if (!condition) {
+					return false;
+				}
+				if (*condition == 0) {
+					break;
+				}
+			}
+			if (!exec(forStatement->body(), flow)) {
+				return false;
+			}
+			if (flow == Flow::Return) {
+				return true;
+			}
+			if (flow == Flow::Break) {
+				flow = Flow::Next;
+				break;
+			}
+			flow = Flow::Next;
+			if (forStatement->loopExpression() && !exec(*forStatement->loopExpression(), flow)) {
+				return false;
+			}
+		}
+		return true;
+	}
+	if (to<Break>(&_s)) {
+		flow = Flow::Break;
+		return true;
+	}
+	if (to<Continue>(&_s)) {
+		flow = Flow::Continue;
+		return true;
+	}
+	if (auto ret = to<Return>(&_s)) {
+		if (!ret->options().empty()) {
+			return false;
+		}
+		if (ret->expression()) {
+			m_returnValue = eval(*ret->expression());
+		} else {
+			VariableDeclaration const* retParam = ret->annotation().functionReturnParameters->parameters().at(0).get();
+			m_returnValue = m_frames.back().at(retParam);
+		}
+		flow = Flow::Return;
+		return m_returnValue.has_value();
+	}
+	return false;
+}
+
+bool TVMConstEvaluator::assign(Expression const& lValue, bigint const& value) {
+	if (auto tuple = to<TupleExpression>(&lValue)) {
+		return !tuple->isInlineArray() && tuple->components().size() == 1 && tuple->components().at(0) &&
+			assign(*tuple->components().at(0), value);
+	}
+	auto ident = to<Identifier>(&lValue);
+	if (ident == nullptr || m_frames.empty()) {
+		return false;
+	}
+	auto it = m_frames.back().find(to<VariableDeclaration>(ident->annotation().referencedDeclaration));
+	if (it == m_frames.back().end()) {
+		return false;
+	}
+	it->second = value;
+	return true;
+}
@@ -0,0 +1,59 @@
+/*
+ * Copyright 2018-2019 TON DEV SOLUTIONS LTD.
+ *
+ * Licensed under the  terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License.
+ *
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the  GNU General Public License for more details at: https://www.gnu.org/licenses/gpl-3.0.html
+ */
+/**
+ * @author TON Labs <connect@tonlabs.io>
+ * @date 2021
+ * Compile-time evaluation of integer, boolean and string expressions including calls of pure functions
+ */
+
+#pragma once
+
+#include <libsolidity/ast/AST.h>
+
+namespace solidity::frontend {
+
+// Interprets the pure subset of the language. Evaluation gives up (returns nothing) if the expression depends on
+// runtime data, would throw an exception at runtime or takes too many steps. So the result is always equal to the
+// value the expression has at runtime.
+class TVMConstEvaluator {
+public:
+	static std::optional<bigint> evaluate(Expression const& _e);
+	// Concatenation of constant strings
+	static std::optional<std::string> evaluateString(Expression const& _e);
+
+private:
+	enum class Flow { Next, Break, Continue, Return };
+
+	static bool isCandidate(Expression const& _e);
+	static bool isEvaluatedType(Type const* type);
+	static bool fits(Type const* type, bigint const& value);
+	static FunctionDefinition const* pureFunction(FunctionCall const& _call);
+	static std::optional<std::string> stringValue(Expression const& _e);
+	static std::optional<bigint> sha256(FunctionCall const& _call);
+
+	bool step();
+	std::optional<bigint> eval(Expression const& _e);
+	std::optional<bigint> evalBinary(Token op, Type const* commonType, bigint const& left, bigint const& right);
+	std::optional<bigint> evalUnary(UnaryOperation const& _node);
+	std::optional<bigint> evalAssignment(Assignment const& _node);
+	std::optional<bigint> evalCall(FunctionCall const& _call);
+	std::optional<bigint> call(FunctionDefinition const& _function, std::vector<bigint> const& args);
+	bool exec(Statement const& _s, Flow& flow);
+	bool assign(Expression const& lValue, bigint const& value);
+
+	std::vector<std::map<VariableDeclaration const*, bigint>> m_frames;
+	std::optional<bigint> m_returnValue;
+	int m_steps{};
+};
+
+}	// end solidity::frontend
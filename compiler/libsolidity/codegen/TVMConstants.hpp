@@ -55,6 +55,8 @@ namespace TvmConst {
 	}
 	const int CellBitLength = 1023;
 	const int ArrayKeyLength = 32;
+	const int MaxTupleLength = 255;
+	const int MaxConstArrayLength = 64; // arrays up to this length with elements known at compile time are pushed as PUSHREF
 	const int MaxPushSliceBitLength = 8 * 31; // PUSHSLICE xSSSS;  SSSS.length() <= MaxPushSliceBitLength / 4
 	const int MaxSTSLICECONST = 7 * 8; // STSLICECONST xSSSS;    SSSS.length() <= MaxSTSLICECONST / 4
 	const int ExtInboundSrcLength = 72 + 9 + 2 + 3 + 33; // src field of external inbound message. Contains addr_extern with
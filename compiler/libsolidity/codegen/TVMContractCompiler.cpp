@@ -21,10 +21,18 @@
 #include <boost/algorithm/string/replace.hpp>
 #include <boost/range/adaptor/map.hpp>
 
+#include <unordered_map>
+
+#include <libsolutil/TimeReport.h>
+
 #include "TVMABI.hpp"
+#include "TVMAnalyzer.hpp"
+#include "TVMCodePlacement.hpp"
+#include "TVMCodeStats.hpp"
 #include "TVMContractCompiler.hpp"
 #include "TVMExpressionCompiler.hpp"
 #include "TVMFunctionCompiler.hpp"
+#include "TVMGasEstimator.hpp"
 #include "TVMInlineFunctionChecker.hpp"
 #include "TVMOptimizations.hpp"
 #include "TVMStructCompiler.hpp"
@@ -194,24 +202,85 @@ void TVMContractCompiler::generateABI(
 
 void TVMContractCompiler::proceedContract(
 	const std::string& fileName,
+	const std::string& statsFileName,
+	const std::string& gasFileName,
 	ContractDefinition const& contract,
 	PragmaDirectiveHelper const &pragmaHelper
 ) {
-	CodeLines code = generateContractCode(&contract, pragmaHelper);
-
-    ofstream ofile;
-    ofile.open(fileName);
-    if (!ofile)
-        fatal_error("Failed to open the output file: " + fileName);
-    ofile << code.str();
-    ofile.close();
-    cout << "Code was generated and saved to file " << fileName << endl;
+	CodeLines code;
+	{
+		TimeReport::ScopedTimer timer{"codegen"};
+		code = generateContractCode(&contract, pragmaHelper);
+	}
+
+	if (!fileName.empty()) {
+		ofstream ofile;
+		ofile.open(fileName);
+		if (!ofile)
+			fatal_error("Failed to open the output file: " + fileName);
+		ofile << code.str();
+		ofile.close();
+		cout << "Code was generated and saved to file " << fileName << endl;
+	}
+
+	if (!statsFileName.empty()) {
+		ofstream ofile;
+		ofile.open(statsFileName);
+		if (!ofile)
+			fatal_error("Failed to open the output file: " + statsFileName);
+		Json::StreamWriterBuilder builder;
+		builder["indentation"] = "\t";
+		ofile << Json::writeString(builder, TVMCodeStats{code}.toJson(contract.name())) << endl;
+		ofile.close();
+		cout << "Code statistics were generated and saved to file " << statsFileName << endl;
+	}
+
+	if (!gasFileName.empty()) {
+		ofstream ofile;
+		ofile.open(gasFileName);
+		if (!ofile)
+			fatal_error("Failed to open the output file: " + gasFileName);
+		Json::StreamWriterBuilder builder;
+		builder["indentation"] = "\t";
+		ofile << Json::writeString(builder, TVMGasEstimator{code}.toJson(contract.name())) << endl;
+		ofile.close();
+		cout << "Gas estimation was generated and saved to file " << gasFileName << endl;
+	}
+}
+
+// Optimized code of the functions compiled so far in this process, by their unoptimized code.
+// The unoptimized code reflects everything the function depends on (its body, inlined functions,
+// state variable layout, pragmas), so an entry can't become stale. On recompilation in a
+// long-lived process (libsolc) only the functions whose code changed are optimized again.
+static CodeLines const& optimize_code_cached(const CodeLines& code) {
+	// Limits memory used by the cache, it's flushed when full
+	static const size_t MaxCachedChars = 64 * 1024 * 1024;
+	static std::unordered_map<std::string, CodeLines> cache;
+	static size_t cachedChars = 0;
+
+	std::string key;
+	for (const std::string& line : code.lines) {
+		key += line;
+		key += '\n';
+	}
+	auto it = cache.find(key);
+	if (it != cache.end()) {
+		TimeReport::count("cache hits");
+		return it->second;
+	}
+	if (cachedChars + key.size() > MaxCachedChars) {
+		cache.clear();
+		cachedChars = 0;
+	}
+	cachedChars += key.size();
+	return cache.emplace(std::move(key), optimize_code(code)).first->second;
 }
 
 static void optimize_and_append_code(CodeLines& code, const StackPusherHelper& pusher) {
-	if (GlobalParams::g_withOptimizations)
-		code.append(optimize_code(pusher.code()));
-	else
+	if (GlobalParams::g_withOptimizations) {
+		TimeReport::ScopedTimer timer{"optimizer"};
+		code.append(optimize_code_cached(pusher.code()));
+	} else
 		code.append(pusher.code());
 }
 
@@ -228,7 +297,9 @@ TVMContractCompiler::generateContractCode(
 		code.push(" ");
 	}
 
+	// prologues of shared modifiers may call inline functions
 	fillInlineFunctions(ctx, contract);
+	fillSharedModifiers(ctx, contract, code);
 
 	// generate global constructor which inlines all contract constructors
 	if (!ctx.isStdlib()) {
@@ -246,6 +317,7 @@ TVMContractCompiler::generateContractCode(
 				continue;
 			}
 
+			TimeReport::ScopedTimer timer{[&]() { return "function " + c->name() + "." + _function->name(); }};
 			ctx.setCurrentFunction(_function);
 
 			if (_function->isOnBounce()) {
@@ -402,6 +474,11 @@ TVMContractCompiler::generateContractCode(
 		optimize_and_append_code(code, pusher);
 	}
 
+	if (GlobalParams::g_withOptimizations) {
+		TimeReport::ScopedTimer timer{"placement"};
+		code = optimize_placement(code);
+	}
+
 	if (ctx.getSaveMyCodeSelector()) {
 		CodeLines tmp;
 		tmp.push(".pragma selector-save-my-code");
@@ -438,3 +515,55 @@ void TVMContractCompiler::fillInlineFunctions(TVMCompilerContext &ctx, ContractD
 	}
 }
 
+// Modifier prologue is compiled as a function if it makes the code smaller at least by this number of bits
+static const int MinSharedModifierSavedBits = 256;
+
+void TVMContractCompiler::fillSharedModifiers(TVMCompilerContext& ctx, ContractDefinition const* contract, CodeLines& code) {
+	if (!GlobalParams::g_withOptimizations || ctx.isStdlib()) {
+		return;
+	}
+
+	std::vector<ModifierDefinition const*> modifiers;
+	std::map<ModifierDefinition const*, std::vector<FunctionDefinition const*>> users;
+	for (ContractDefinition const* c : contract->annotation().linearizedBaseContracts) {
+		for (FunctionDefinition const* function : c->definedFunctions()) {
+			// inline functions are already compiled with their modifiers
+			if (!function->isImplemented() || function->isInline()) {
+				continue;
+			}
+			for (const ASTPointer<ModifierInvocation>& invocation : function->modifiers()) {
+				auto modifier = to<ModifierDefinition>(invocation->name()->annotation().referencedDeclaration);
+				if (modifier == nullptr) {
+					continue;
+				}
+				if (users[modifier].empty()) {
+					modifiers.push_back(modifier);
+				}
+				users[modifier].push_back(function);
+			}
+		}
+	}
+
+	for (ModifierDefinition const* modifier : modifiers) {
+		const int useQty = users.at(modifier).size();
+		if (useQty < 2 || !ModifierPrologueScanner{*modifier}.isPrologueOnly) {
+			continue;
+		}
+		const std::string name = TVMCompilerContext::getSharedModifierName(modifier);
+		FunctionDefinition const* function = users.at(modifier).front();
+		ctx.setCurrentFunction(function);
+		StackPusherHelper pusher{&ctx};
+		TVMFunctionCompiler::generateModifierPrologue(pusher, modifier, function, name);
+		CodeLines prologue = optimize_code(pusher.code());
+
+		// Each inlined prologue is replaced by the call. Small prologues are left inlined because
+		// the call also costs gas for looking up the function in the dictionary.
+		const int bits = TVMCodeStats{prologue}.total().bits;
+		const int callBits = TVMCodeStats::instructionBitSize("CALL", "$" + name + "$");
+		if ((useQty - 1) * bits - useQty * callBits >= MinSharedModifierSavedBits) {
+			ctx.addSharedModifier(modifier);
+			code.append(prologue);
+		}
+	}
+	ctx.setCurrentFunction(nullptr);
+}
@@ -50,12 +50,15 @@ public:
 	);
 	static void proceedContract(
 		const std::string& fileName,
+		const std::string& statsFileName,
+		const std::string& gasFileName,
 		ContractDefinition const& contract,
 		PragmaDirectiveHelper const &pragmaHelper
 	);
 	static CodeLines generateContractCode(ContractDefinition const* contract, PragmaDirectiveHelper const& pragmaHelper);
 private:
 	static void fillInlineFunctions(TVMCompilerContext& ctx, ContractDefinition const* contract);
+	static void fillSharedModifiers(TVMCompilerContext& ctx, ContractDefinition const* contract, CodeLines& code);
 };
 
 }	// end solidity::frontend
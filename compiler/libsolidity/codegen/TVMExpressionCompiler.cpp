@@ -19,6 +19,9 @@
 #include  <boost/core/ignore_unused.hpp>
 
 #include "DictOperations.hpp"
+#include "TVM.h"
+#include "TVMAnalyzer.hpp"
+#include "TVMConstEvaluator.hpp"
 #include "TVMExpressionCompiler.hpp"
 #include "TVMFunctionCall.hpp"
 #include "TVMStructCompiler.hpp"
@@ -205,6 +208,10 @@ void TVMExpressionCompiler::visit2(Literal const &_node) {
 
 void TVMExpressionCompiler::visit2(TupleExpression const &_tupleExpression) {
 	if (_tupleExpression.isInlineArray()) {
+		if (std::optional<std::vector<std::string>> values = constArrayValues(_tupleExpression)) {
+			m_pusher.pushConstArray(*values);
+			return;
+		}
 		m_pusher.pushInt(_tupleExpression.components().size());
 		m_pusher.push(+1, "NEWDICT");
 		Type const* type = _tupleExpression.annotation().type;
@@ -226,6 +233,36 @@ void TVMExpressionCompiler::visit2(TupleExpression const &_tupleExpression) {
 	}
 }
 
+std::optional<std::vector<std::string>> TVMExpressionCompiler::constArrayValues(TupleExpression const& _tupleExpression) {
+	if (!GlobalParams::g_withOptimizations ||
+		_tupleExpression.components().size() > TvmConst::MaxConstArrayLength) {
+		return {};
+	}
+	Type const* arrayBaseType = to<ArrayType>(_tupleExpression.annotation().type)->baseType();
+	std::vector<std::string> values;
+	for (const ASTPointer<Expression>& e : _tupleExpression.components()) {
+		std::optional<bigint> value;
+		if (std::optional<bool> b = constBool(*e)) {
+			value = *b ? 1 : 0;
+		} else if (auto call = to<FunctionCall>(e.get());
+			call && call->annotation().kind == FunctionCallKind::TypeConversion && call->arguments().size() == 1
+		) {
+			value = constValue(*call->arguments().at(0));
+		} else {
+			value = constValue(*e);
+		}
+		if (!value) {
+			return {};
+		}
+		std::optional<std::string> bits = StackPusherHelper::constArrayElement(arrayBaseType, *value);
+		if (!bits) {
+			return {};
+		}
+		values.push_back(*bits);
+	}
+	return values;
+}
+
 bool TVMExpressionCompiler::tryPushConstant(Identifier const &_identifier) {
 	IdentifierAnnotation& identifierAnnotation = _identifier.annotation();
 	Declaration const* declaration = identifierAnnotation.referencedDeclaration;
@@ -248,6 +285,11 @@ bool TVMExpressionCompiler::pushLocalOrStateVariable(Identifier const &_identifi
 		return true;
 	} else if (auto variable = to<VariableDeclaration>(_identifier.annotation().referencedDeclaration)) {
 		solAssert(variable->isStateVariable() && !variable->isConstant(), "");
+		if (std::optional<int> stackIndex = m_pusher.ctx().loopInvariant(variable)) {
+			// the value is read before the loop
+			m_pusher.pushS(m_pusher.getStack().size() - *stackIndex);
+			return true;
+		}
 		m_pusher.getGlob(variable);
 		return true;
 	}
@@ -303,7 +345,10 @@ void TVMExpressionCompiler::compileUnaryOperation(
 		m_pusher.push(0, tvmUnaryOperation);
 	}
 
-	if (!isCheckFitUseless(resType, _node.getOperator()) && !m_pusher.ctx().ignoreIntegerOverflow()) {
+	std::optional<ValueRange> range = m_pusher.ctx().valueRanges().range(_node.subExpression());
+	const bigint delta = _node.getOperator() == Token::Inc ? 1 : -1;
+	const bool isResultInRange = range && ValueRangeScanner::fits({range->min + delta, range->max + delta}, resType);
+	if (!isCheckFitUseless(resType, _node.getOperator()) && !isResultInRange && !m_pusher.ctx().ignoreIntegerOverflow()) {
 		m_pusher.checkFit(resType);
 	}
 	collectLValue(lValueInfo, true, false);
@@ -620,7 +665,8 @@ void TVMExpressionCompiler::visit2(BinaryOperation const &_binaryOperation) {
 	std::optional<bigint> rightValue;
 	if (val.has_value())
 		rightValue = val;
-	visitMathBinaryOperation(op, commonType, acceptRight, rightValue);
+	visitMathBinaryOperation(op, commonType, acceptRight, rightValue,
+		isResultInRange(op, commonType, _binaryOperation.leftExpression(), _binaryOperation.rightExpression()));
 }
 
 bool TVMExpressionCompiler::isCheckFitUseless(Type const* commonType, Token op) {
@@ -633,13 +679,19 @@ bool TVMExpressionCompiler::isCheckFitUseless(Type const* commonType, Token op)
 
 }
 
+bool TVMExpressionCompiler::isResultInRange(Token op, Type const* commonType, Expression const& left, Expression const& right) {
+	std::optional<ValueRange> range = m_pusher.ctx().valueRanges().binaryRange(op, left, right);
+	return range && ValueRangeScanner::fits(*range, commonType);
+}
+
 // if pushRight is set we haven't value on stack
 // else right value is on stack
 void TVMExpressionCompiler::visitMathBinaryOperation(
 	const Token op,
 	Type const* commonType,
 	const std::function<void()>& pushRight,
-	const std::optional<bigint>& rightValue
+	const std::optional<bigint>& rightValue,
+	bool isResultInRange
 ) {
 	bool checkOverflow = false;
 	if (op == Token::Exp) {
@@ -719,7 +771,7 @@ void TVMExpressionCompiler::visitMathBinaryOperation(
 	}
 
 	if (checkOverflow && !m_pusher.ctx().ignoreIntegerOverflow()) {
-		if (!isCheckFitUseless(commonType, op)) {
+		if (!isCheckFitUseless(commonType, op) && !isResultInRange) {
 			m_pusher.checkFit(commonType);
 		}
 	}
@@ -928,6 +980,8 @@ void TVMExpressionCompiler::visitMemberAccessArray(MemberAccess const &_node) {
 		compileNewExpr(&_node.expression());
 		if (arrayType->isByteArray()) {
 			m_pusher.byteLengthOfCell();
+		} else if (TupleArrayScanner::isTupleArray(&_node.expression())) {
+			m_pusher.push(-1 + 1, "TLEN");
 		} else {
 			m_pusher.index(0);
 		}
@@ -952,8 +1006,32 @@ void TVMExpressionCompiler::indexTypeCheck(IndexAccess const &_node) {
 	}
 }
 
+void TVMExpressionCompiler::checkTupleArrayIndex(IndexAccess const& indexAccess) {
+	// stack: tuple index
+	if (m_pusher.ctx().valueRanges().isIndexInRange(indexAccess)) {
+		return;
+	}
+	m_pusher.pushS(1);
+	m_pusher.push(-1 + 1, "TLEN");
+	m_pusher.pushS(1); // tuple index length index
+	m_pusher.push(-2 + 1, "GREATER");
+	m_pusher.push(-1, "THROWIFNOT " + toString(TvmConst::RuntimeException::ArrayIndexOutOfRange));
+}
+
 void TVMExpressionCompiler::visit2(IndexAccess const &indexAccess) {
 	m_pusher.push(0, ";; index");
+	if (std::optional<int> stackIndex = m_pusher.ctx().loopInvariant(&indexAccess)) {
+		// the value is read before the loop
+		m_pusher.pushS(m_pusher.getStack().size() - *stackIndex);
+		return;
+	}
+	if (TupleArrayScanner::isTupleArray(&indexAccess.baseExpression())) {
+		acceptExpr(&indexAccess.baseExpression()); // tuple
+		compileNewExpr(indexAccess.indexExpression()); // tuple index
+		checkTupleArrayIndex(indexAccess);
+		m_pusher.push(-2 + 1, "INDEXVAR"); // value
+		return;
+	}
 	Type const *baseType = indexAccess.baseExpression().annotation().type;
 	if (baseType->category() == Type::Category::Array) {
 		auto baseArrayType = to<ArrayType>(baseType);
@@ -1112,14 +1190,25 @@ TVMExpressionCompiler::expandLValue(
 				                 *StackPusherHelper::parseValueType(*index),
 				                 GetDictOperation::GetFromMapping);
 				// index dict1 dict2
+			} else if (TupleArrayScanner::isTupleArray(&index->baseExpression())) {
+				// tuple
+				compileNewExpr(index->indexExpression()); // tuple index
+				checkTupleArrayIndex(*index);
+				if (isLast && !withExpandLastValue) {
+					break;
+				}
+				m_pusher.push(+2, "PUSH2 S1, S0"); // tuple index tuple index
+				m_pusher.push(-2 + 1, "INDEXVAR"); // tuple index value
 			} else if (index->baseExpression().annotation().type->category() == Type::Category::Array) {
 				// array
 				m_pusher.push(-1 + 2, "UNPAIR"); // size dict
 				compileNewExpr(index->indexExpression()); // size dict index
 				m_pusher.push(0, "SWAP"); // size index dict
-				m_pusher.push(+2, "PUSH2 s1,s2"); // size index dict index size
-				m_pusher.push(-2 + 1, "LESS"); // size index dict index<size
-				m_pusher.push(-1, "THROWIFNOT " + toString(TvmConst::RuntimeException::ArrayIndexOutOfRange));
+				if (!m_pusher.ctx().valueRanges().isIndexInRange(*index)) {
+					m_pusher.push(+2, "PUSH2 s1,s2"); // size index dict index size
+					m_pusher.push(-2 + 1, "LESS"); // size index dict index<size
+					m_pusher.push(-1, "THROWIFNOT " + toString(TvmConst::RuntimeException::ArrayIndexOutOfRange));
+				}
 				if (isLast && !withExpandLastValue) {
 					break;
 				}
@@ -1204,6 +1293,15 @@ TVMExpressionCompiler::collectLValue(
 					m_pusher.push(0, "ROTREV"); // value index dict
 					m_pusher.setDict(*keyType, *valueDictType, dataType); // dict'
 				}
+			} else if (TupleArrayScanner::isTupleArray(&indexAccess->baseExpression())) {
+				if (isLast && !haveValueOnStackTop) {
+					// tuple index
+					m_pusher.drop(1); // tuple
+				} else {
+					// tuple index value
+					m_pusher.exchange(0, 1); // tuple value index
+					m_pusher.push(-3 + 1, "SETINDEXVAR"); // tuple'
+				}
 			} else if (indexAccess->baseExpression().annotation().type->category() == Type::Category::Array) {
 				//					pushLog("colArrIndex");
 				if (isLast && !haveValueOnStackTop) {
@@ -1323,7 +1421,7 @@ bool TVMExpressionCompiler::tryAssignLValue(Assignment const &_assignment) {
 		if (isString(getType(&lhs)) && isString(getType(&rhs))) {
 			m_pusher.pushMacroCallInCallRef(-2 + 1, "concatenateStrings_macro");
 		} else {
-			visitMathBinaryOperation(binOp, commonType, nullptr, nullopt);
+			visitMathBinaryOperation(binOp, commonType, nullptr, nullopt, isResultInRange(binOp, commonType, lhs, rhs));
 		}
 
 		if (isCurrentResultNeeded()) {
@@ -1388,11 +1486,22 @@ void TVMExpressionCompiler::visit2(Assignment const &_assignment) {
 
 
 bool TVMExpressionCompiler::fold_constants(const Expression *expr) {
-	const auto& val = constValue(*expr);
+	const auto& val = TVMConstEvaluator::evaluate(*expr);
 	if (val.has_value()) {
-		m_pusher.push(+1, "PUSHINT " + val.value().str());
+		if (getType(expr)->category() == Type::Category::Bool) {
+			m_pusher.push(+1, val.value() != 0 ? "TRUE" : "FALSE");
+		} else {
+			m_pusher.push(+1, "PUSHINT " + val.value().str());
+		}
 		return true;
 	}
+	// string literals are pushed in other way in ABI v1
+	if (m_pusher.ctx().pragmaHelper().abiVersion() == 2) {
+		if (std::optional<std::string> str = TVMConstEvaluator::evaluateString(*expr)) {
+			m_pusher.pushString(*str, false);
+			return true;
+		}
+	}
 
 	return false;
 }
@@ -47,6 +47,7 @@ protected:
 	void visitStringLiteralAbiV2(Literal const& _node);
 	void visit2(Literal const& _node);
 	void visit2(TupleExpression const& _tupleExpression);
+	static std::optional<std::vector<std::string>> constArrayValues(TupleExpression const& _tupleExpression);
 	bool tryPushConstant(Identifier const& _identifier);
 	bool pushLocalOrStateVariable(Identifier const& _identifier);
 
@@ -71,11 +72,13 @@ protected:
 	void visitLogicalShortCircuiting(BinaryOperation const &_binaryOperation);
 	void visit2(BinaryOperation const& _node);
 	bool isCheckFitUseless(Type const* type, Token op);
+	bool isResultInRange(Token op, Type const* commonType, Expression const& left, Expression const& right);
 	void visitMathBinaryOperation(
 		Token op,
 		Type const* commonType,
 		const std::function<void()>& pushRight,
-		const std::optional<bigint>& rightValue
+		const std::optional<bigint>& rightValue,
+		bool isResultInRange = false
 	);
 	void visitMsgMagic(MemberAccess const& _node);
 	void visitMagic(MemberAccess const& _node);
@@ -84,6 +87,7 @@ protected:
 	void visitMemberAccessArray(MemberAccess const& _node);
 	void visitMemberAccessFixedBytes(MemberAccess const& _node, FixedBytesType const* fbt);
 	static void indexTypeCheck(IndexAccess const& _node);
+	void checkTupleArrayIndex(IndexAccess const& indexAccess);
 	void visit2(IndexAccess const& indexAccess);
 	bool visit2(FunctionCall const& _functionCall);
 	void visit2(Conditional const& _conditional);
@@ -17,6 +17,8 @@
  */
 
 #include "DictOperations.hpp"
+#include "TVM.h"
+#include "TVMAnalyzer.hpp"
 #include "TVMFunctionCall.hpp"
 #include "TVMExpressionCompiler.hpp"
 #include "TVMIntrinsics.hpp"
@@ -39,6 +41,33 @@ FunctionCallCompiler::FunctionCallCompiler(StackPusherHelper &m_pusher, TVMExpre
 {
 }
 
+void FunctionCallCompiler::compileMessageTemplate() {
+	m_isMessageTemplate = true;
+	auto ma = to<MemberAccess>(&m_functionCall.expression());
+	if (ma != nullptr && ma->memberName() == "transfer" &&
+		getType(&ma->expression())->category() == Type::Category::Address) {
+		addressMethod();
+	} else {
+		bool ok = checkRemoteMethodCall(m_functionCall);
+		solAssert(ok, "");
+	}
+}
+
+void FunctionCallCompiler::sendIntMsg(
+	const std::map<int, Expression const *> &exprs,
+	const std::map<int, std::string> &constParams,
+	const std::function<void(int)> &appendBody,
+	const std::function<void()> &pushSendrawmsgFlag
+) {
+	if (m_isMessageTemplate) {
+		m_pusher.prepareIntMsgTemplate(exprs, constParams, appendBody);
+	} else if (std::optional<int> index = m_pusher.ctx().messageTemplate(&m_functionCall)) {
+		m_pusher.sendIntMsgByTemplate(exprs, constParams, *index, pushSendrawmsgFlag);
+	} else {
+		m_pusher.sendIntMsg(exprs, constParams, appendBody, pushSendrawmsgFlag);
+	}
+}
+
 void FunctionCallCompiler::structConstructorCall() {
 	auto const& type = dynamic_cast<TypeType const&>(*m_functionCall.expression().annotation().type);
 	auto const& structType = dynamic_cast<StructType const&>(*type.actualType());
@@ -81,7 +110,7 @@ bool FunctionCallCompiler::compile() {
 	} else {
 		if (ma != nullptr) {
 			auto category = getType(&ma->expression())->category();
-			auto ident = to<Identifier>(&ma->expression());
+			auto magicType = to<MagicType>(getType(&ma->expression()));
 			if (category == Type::Category::Array) {
 				arrayMethods(*ma);
 			} else if (category == Type::Category::TvmSlice) {
@@ -92,7 +121,7 @@ bool FunctionCallCompiler::compile() {
 				checkForOptionalMethods(*ma))
 			{
 				// nothing
-			} else if (category == Type::Category::Magic && ident != nullptr && ident->name() == "tvm") {
+			} else if (magicType != nullptr && magicType->kind() == MagicType::Kind::TVM) {
 				if (m_funcType->kind() == FunctionType::Kind::TVMBuildIntMsg) {
 					tvmBuildIntMsg();
 				} else if (m_funcType->kind() == FunctionType::Kind::TVMBuildExtMsg) {
@@ -107,11 +136,11 @@ bool FunctionCallCompiler::compile() {
 				} else {
 					reportError();
 				}
-			} else if (category == Type::Category::Magic && ident != nullptr && ident->name() == "rnd") {
+			} else if (magicType != nullptr && magicType->kind() == MagicType::Kind::Rnd) {
 				rndFunction(*ma);
-			} else if (category == Type::Category::Magic && ident != nullptr && ident->name() == "msg") {
+			} else if (magicType != nullptr && magicType->kind() == MagicType::Kind::Message) {
 				msgFunction(*ma);
-			} else if (category == Type::Category::Magic && ident != nullptr && ident->name() == "math") {
+			} else if (magicType != nullptr && magicType->kind() == MagicType::Kind::Math) {
 				mathFunction(*ma);
 			} else if (category == Type::Category::Address) {
 				addressMethod();
@@ -576,7 +605,10 @@ bool FunctionCallCompiler::checkRemoteMethodCall(FunctionCall const &_functionCa
 		}
 	}
 
-	pushArgs(true);
+	// arguments are already stored in the message template
+	if (m_isMessageTemplate || !m_pusher.ctx().messageTemplate(&m_functionCall)) {
+		pushArgs(true);
+	}
 
 	appendBody = [&](int builderSize) {
 		ChainDataEncoder{&m_pusher}.createMsgBodyAndAppendToBuilder(
@@ -591,7 +623,7 @@ bool FunctionCallCompiler::checkRemoteMethodCall(FunctionCall const &_functionCa
 	if (m_isCurrentResultNeeded)
 		cast_error(_functionCall, "Calls to remote contract do not return result.");
 
-	m_pusher.sendIntMsg(exprs, constParams, appendBody, pushSendrawmsgFlag);
+	sendIntMsg(exprs, constParams, appendBody, pushSendrawmsgFlag);
 	return true;
 }
 
@@ -1352,6 +1384,35 @@ IFELSE
 }
 
 
+void FunctionCallCompiler::tupleArrayMethods(MemberAccess const &_node) {
+	// the array is a local variable, see TupleArrayScanner
+	auto arrayBaseType = to<ArrayType>(getType(&_node.expression()))->baseType();
+	if (_node.memberName() == "empty") {
+		acceptExpr(&_node.expression());
+		m_pusher.push(-1 + 1, "TLEN");
+		m_pusher.push(-1 + 1, "ISZERO");
+	} else if (_node.memberName() == "push") {
+		const LValueInfo lValueInfo = m_exprCompiler->expandLValue(&_node.expression(), true);
+		if (m_arguments.empty()) {
+			m_pusher.pushDefaultValue(arrayBaseType);
+		} else {
+			pushArgAndConvert(0);
+		}
+		m_pusher.push(-1, "TPUSH");
+		m_exprCompiler->collectLValue(lValueInfo, true, false);
+	} else if (_node.memberName() == "pop") {
+		const LValueInfo lValueInfo = m_exprCompiler->expandLValue(&_node.expression(), true);
+		m_pusher.pushS(0);
+		m_pusher.push(-1 + 1, "TLEN");
+		m_pusher.push(-1, "THROWIFNOT " + toString(TvmConst::RuntimeException::PopFromEmptyArray));
+		m_pusher.push(+1, "TPOP");
+		m_pusher.drop(1);
+		m_exprCompiler->collectLValue(lValueInfo, true, false);
+	} else {
+		solUnimplemented("");
+	}
+}
+
 bool FunctionCallCompiler::checkForTvmTupleMethods(MemberAccess const &_node, Type::Category category) {
 	if (category != Type::Category::TvmTuple)
 		return false;
@@ -1524,6 +1585,10 @@ bool FunctionCallCompiler::checkForTvmBuilderMethods(MemberAccess const &_node,
 
 void FunctionCallCompiler::arrayMethods(MemberAccess const &_node) {
 	Type const *type = _node.expression().annotation().type;
+	if (TupleArrayScanner::isTupleArray(&_node.expression())) {
+		tupleArrayMethods(_node);
+		return;
+	}
 	if (_node.memberName() == "empty") {
 		acceptExpr(&_node.expression());
 		if (isUsualArray(type)) {
@@ -1772,7 +1837,7 @@ void FunctionCallCompiler::addressMethod() {
 				};
 			}
 		}
-		m_pusher.sendIntMsg(exprs, constParams, appendBody, pushSendrawmsgFlag);
+		sendIntMsg(exprs, constParams, appendBody, pushSendrawmsgFlag);
 	} else if (_node->memberName() == "isStdZero") {
 		m_pusher.push(0, ";; address.isStdZero()");
 		acceptExpr(&_node->expression());
@@ -2024,20 +2089,26 @@ void FunctionCallCompiler::rndFunction(MemberAccess const &_node) {
 }
 
 bool FunctionCallCompiler::checkForTvmFunction(const MemberAccess &_node) {
-	if (_node.memberName() == "pubkey") { // tvm.pubkey
+	switch (str2int(_node.memberName().c_str())) {
+	case str2int("pubkey"): // tvm.pubkey
 		m_pusher.push(+1, "GETGLOB 2");
-	} else if (_node.memberName() == "setPubkey") { // tvm.setPubkey
+		break;
+	case str2int("setPubkey"): // tvm.setPubkey
 		pushArgs();
 		m_pusher.push(-1, "SETGLOB 2");
-	} else if (_node.memberName() == "accept") { // tvm.accept
+		break;
+	case str2int("accept"): // tvm.accept
 		m_pusher.push(0, "ACCEPT");
-	} else if (_node.memberName() == "hash") { // tvm.hash
+		break;
+	case str2int("hash"): // tvm.hash
 		pushArgs();
 		m_pusher.push(0, "HASHCU");
-    } else if (_node.memberName() == "vergrth16") { // tvm.vergrth16
-        pushArgs();
-        m_pusher.push(0, "VERGRTH16");
-	} else if (_node.memberName() == "checkSign") { // tvm.checkSign
+		break;
+	case str2int("vergrth16"): // tvm.vergrth16
+		pushArgs();
+		m_pusher.push(0, "VERGRTH16");
+		break;
+	case str2int("checkSign"): { // tvm.checkSign
 		size_t cnt = m_arguments.size();
 		if (getType(m_arguments[0].get())->category() == Type::Category::TvmSlice) {
 			pushArgs();
@@ -2058,22 +2129,27 @@ bool FunctionCallCompiler::checkForTvmFunction(const MemberAccess &_node) {
 			pushArgAndConvert(cnt - 1);
 			m_pusher.push(-3+1, "CHKSIGNU");
 		}
-	} else if (_node.memberName() == "setcode") { // tvm.setcode
+		break;
+	}
+	case str2int("setcode"): // tvm.setcode
 		pushArgs();
 		m_pusher.push(-1, "SETCODE");
-	} else if (_node.memberName() == "bindump") { // tvm.bindump
+		break;
+	case str2int("bindump"): // tvm.bindump
 		pushArgs();
 		if (getType(m_arguments[0].get())->category() == Type::Category::TvmCell)
 			m_pusher.push(-1+1, "CTOS");
 		m_pusher.push(0, "BINDUMP");
 		m_pusher.drop(1);
-	} else if (_node.memberName() == "hexdump") { // tvm.hexdump
+		break;
+	case str2int("hexdump"): // tvm.hexdump
 		pushArgs();
 		if (getType(m_arguments[0].get())->category() == Type::Category::TvmCell)
 		m_pusher.push(-1+1, "CTOS");
 		m_pusher.push(0, "HEXDUMP");
 		m_pusher.drop(1);
-	} else if (_node.memberName() == "setCurrentCode") { // tvm.setCurrentCode
+		break;
+	case str2int("setCurrentCode"): { // tvm.setCurrentCode
 		pushArgs();
 		string code = R"(
 CTOS
@@ -2093,19 +2169,26 @@ POP c3
 		boost::replace_all(code, "SelectorRootCodeCell", TvmConst::Selector::RootCodeCell());
 		m_pusher.pushLines(code);
 		m_pusher.push(-1, "");
-	} else if (_node.memberName() == "setData") { // tvm.setData
+		break;
+	}
+	case str2int("setData"): // tvm.setData
 		pushArgs();
 		m_pusher.push(-1, "POP C4");
-	} else if (_node.memberName() == "rawCommit") { // tvm.rawCommit
+		break;
+	case str2int("rawCommit"): // tvm.rawCommit
 		m_pusher.push(0, "COMMIT");
-	} else if (_node.memberName() == "commit") { // tvm.commit
+		break;
+	case str2int("commit"): // tvm.commit
 		m_pusher.pushMacroCallInCallRef(0, "c7_to_c4");
 		m_pusher.push(0, "COMMIT");
-	} else if (_node.memberName() == "log") { // tvm.log
+		break;
+	case str2int("log"): // tvm.log
 		compileLog();
-	} else if (_node.memberName() == "resetStorage") { //tvm.resetStorage
+		break;
+	case str2int("resetStorage"): //tvm.resetStorage
 		m_pusher.resetAllStateVars();
-	} else if (_node.memberName() == "functionId") { // tvm.functionId
+		break;
+	case str2int("functionId"): { // tvm.functionId
 		auto callDef = getFunctionDeclarationOrConstructor(m_arguments.at(0).get());
 		ChainDataEncoder encoder(&m_pusher);
 		uint32_t funcID;
@@ -2119,7 +2202,9 @@ POP c3
 			}
 		}
 		m_pusher.pushInt(funcID);
-	} else if (_node.memberName() == "encodeBody") { // tvm.encodeBody
+		break;
+	}
+	case str2int("encodeBody"): { // tvm.encodeBody
 		CallableDeclaration const* callDef = getFunctionDeclarationOrConstructor(m_arguments.at(0).get());
 		if (callDef == nullptr) { // if no constructor (default constructor)
 			m_pusher.push(+1, "NEWC");
@@ -2148,12 +2233,17 @@ POP c3
 			);
 		}
 		m_pusher.push(-1 + 1, "ENDC");
-	} else if (_node.memberName() == "rawReserve") {
+		break;
+	}
+	case str2int("rawReserve"): {
 		pushArgs();
 		int n = m_arguments.size();
 		solAssert(isIn(n, 2, 3), "");
 		m_pusher.push(-n, n == 2? "RAWRESERVE" : "RAWRESERVEX");
-	} else if (isIn(_node.memberName(), "exit", "exit1")) {
+		break;
+	}
+	case str2int("exit"):
+	case str2int("exit1"):
 		m_pusher.was_c4_to_c7_called();
 		m_pusher.push(-1, ""); // fix stack
 
@@ -2165,7 +2255,8 @@ POP c3
 			m_pusher.push(0, "THROW 0");
 		else
 			m_pusher.push(0, "THROW 1");
-	} else if (_node.memberName() == "code") {
+		break;
+	case str2int("code"):
 		m_pusher.getGlob(TvmConst::C7::MyCode);
 
 		m_pusher.push(0, "PUSHREF {");
@@ -2182,7 +2273,8 @@ POP c3
 		m_pusher.push(-1, "STSLICE"); // main selector + salt
 		m_pusher.push(-1 + 1, "ENDC");
 		m_pusher.ctx().setSaveMyCodeSelector();
-	} else if (_node.memberName() == "codeSalt") {
+		break;
+	case str2int("codeSalt"): {
 		pushArgs();
 		string getSaltFromUsualSelector = R"(
 			PLDREF
@@ -2236,7 +2328,9 @@ CALLREF {
 		boost::replace_all(code, "PrivateOpcode0", TvmConst::Selector::PrivateOpcode0());
 		boost::replace_all(code, "PrivateOpcode1", TvmConst::Selector::PrivateOpcode1());
 		m_pusher.pushLines(code);
-	} else if (_node.memberName() == "setCodeSalt") {
+		break;
+	}
+	case str2int("setCodeSalt"): {
 		pushArgAndConvert(0);
 		m_pusher.push(-1 + 1, "CTOS"); // sliceCode
 		pushArgAndConvert(1); // sliceCode salt
@@ -2317,8 +2411,9 @@ CALLREF {
 		boost::replace_all(code, "PrivateOpcode1", TvmConst::Selector::PrivateOpcode1());
 		m_pusher.pushLines(code);
 		m_pusher.push(-2 + 1, ""); // fix stack
-
-	} else {
+		break;
+	}
+	default:
 		return false;
 	}
 	return true;
@@ -2326,18 +2421,23 @@ CALLREF {
 
 void FunctionCallCompiler::mathFunction(const MemberAccess &_node) {
 	auto retTuple = to<TupleType>(m_retType);
-	if (_node.memberName() == "max") {
+	switch (str2int(_node.memberName().c_str())) {
+	case str2int("max"):
 		pushArgs();
 		for (int i = 0; i + 1 < static_cast<int>(m_arguments.size()); ++i)
 			m_pusher.push(-2 + 1, "MAX");
-	} else if (_node.memberName() == "min") {
+		break;
+	case str2int("min"):
 		pushArgs();
 		for (int i = 0; i + 1 < static_cast<int>(m_arguments.size()); ++i)
 			m_pusher.push(-2 + 1, "MIN");
-	} else if (_node.memberName() == "minmax") {
+		break;
+	case str2int("minmax"):
 		pushArgs();
 		m_pusher.push(-2 + 2, "MINMAX");
-	} else if (isIn(_node.memberName(), "divr", "divc")) {
+		break;
+	case str2int("divr"):
+	case str2int("divc"):
 		pushArgs();
 		if (m_retType->category() == Type::Category::FixedPoint) {
 			int power = to<FixedPointType>(m_retType)->fractionalDigits();
@@ -2347,16 +2447,21 @@ void FunctionCallCompiler::mathFunction(const MemberAccess &_node) {
 		} else {
 			m_pusher.push(-2 + 1, boost::to_upper_copy<std::string>(_node.memberName()));
 		}
-	} else if (isIn(_node.memberName(), "muldiv", "muldivr", "muldivc")) {
+		break;
+	case str2int("muldiv"):
+	case str2int("muldivr"):
+	case str2int("muldivc"):
 		pushArgs();
 		m_pusher.push(-3 + 1, boost::to_upper_copy<std::string>(_node.memberName()));
 		if (!m_pusher.ctx().ignoreIntegerOverflow()) {
 			m_pusher.checkFit(m_retType);
 		}
-	} else if (_node.memberName() == "divmod") {
+		break;
+	case str2int("divmod"):
 		pushArgs();
 		m_pusher.push(-2 + 2, "DIVMOD");
-	} else if (_node.memberName() == "muldivmod") {
+		break;
+	case str2int("muldivmod"):
 		pushArgs();
 		m_pusher.push(-3 + 2, "MULDIVMOD");
 		if (!m_pusher.ctx().ignoreIntegerOverflow()) {
@@ -2364,13 +2469,15 @@ void FunctionCallCompiler::mathFunction(const MemberAccess &_node) {
 			m_pusher.checkFit(retTuple->components().at(0));
 			m_pusher.push(0, "SWAP");
 		}
-	} else if (_node.memberName() == "abs") {
+		break;
+	case str2int("abs"):
 		pushArgs();
 		m_pusher.push(-1 + 1, "ABS");
 		if (!m_pusher.ctx().ignoreIntegerOverflow()) {
 			m_pusher.checkFit(m_retType);
 		}
-	} else if (_node.memberName() == "modpow2") {
+		break;
+	case str2int("modpow2"): {
 		pushExprAndConvert(m_arguments[0].get(), m_retType);
 		const Expression * expression = m_arguments[1].get();
 		const auto& value = TVMExpressionCompiler::constValue(*expression);
@@ -2382,10 +2489,13 @@ void FunctionCallCompiler::mathFunction(const MemberAccess &_node) {
 		} else {
 			cast_error(m_functionCall, "Second argument must be a constant integer.");
 		}
-	} else if (_node.memberName() == "sign") {
+		break;
+	}
+	case str2int("sign"):
 		pushArgs();
 		m_pusher.push(-1 + 1, "SGN");
-	} else {
+		break;
+	default:
 		cast_error(m_functionCall, "Unsupported function call");
 	}
 }
@@ -2522,7 +2632,8 @@ bool FunctionCallCompiler::checkLocalFunctionOrLibCall(const Identifier *identif
 		} else {
 			name = m_pusher.ctx().getFunctionInternalName(functionDefinition, false);
 		}
-		m_pusher.pushCallOrCallRef(name, functionType);
+		// the function is called by name, so its override may be executed
+		m_pusher.pushCallOrCallRef(name, functionType, nullopt, true);
 	}
 	return true;
 }
@@ -3050,31 +3161,38 @@ bool FunctionCallCompiler::checkNewExpression() {
 	int size = m_pusher.getStack().size();
 
 	m_pusher.push(0, ";; new " + resultType->toString(true));
-	m_pusher.push(+1, "NEWDICT"); // dict
-	pushArgAndConvert(0); // dict size
-	m_pusher.push(+1, "DUP"); // dict size sizeIter
-
 
 	auto arrayType = to<ArrayType>(resultType);
 	const IntegerType key = getKeyTypeOfArray();
 	Type const* arrayBaseType = arrayType->baseType();
 
-	// TODO optimize if size is constant and size == 0 or size == 1
+	const std::optional<bigint> arraySize = TVMExpressionCompiler::constValue(*m_arguments.at(0));
+	if (GlobalParams::g_withOptimizations && arraySize.has_value() && 0 <= *arraySize && *arraySize <= TvmConst::MaxConstArrayLength) {
+		if (std::optional<std::string> value = StackPusherHelper::constArrayElement(arrayBaseType, 0)) {
+			m_pusher.pushConstArray(std::vector<std::string>(static_cast<int>(*arraySize), *value));
+			solAssert(size + 1 == m_pusher.getStack().size(), "");
+			return true;
+		}
+	}
+
+	m_pusher.push(+1, "NEWDICT"); // dict
+	pushArgAndConvert(0); // dict size
+	m_pusher.pushDefaultValue(arrayBaseType, true); // dict size value
+	const DataType& dataType = m_pusher.prepareValueForDictOperations(&key, arrayBaseType, true); // dict size value'
+	m_pusher.pushS(1); // dict size value' sizeIter
+
 	m_pusher.pushS(0);
 	{
 		StackPusherHelper pusherHelper(&m_pusher.ctx(), 1);
-		pusherHelper.push(0, "DEC"); // dict size sizeIter'
-		pusherHelper.pushDefaultValue(arrayBaseType, true); // dict size sizeIter' value
-		// TODO optimize. Locate default value on stack (don't create default value in each iteration)
-		const DataType& dataType = pusherHelper.prepareValueForDictOperations(&key, arrayBaseType, true); // arr value'
-		pusherHelper.push(2, "PUSH2 S1,S3"); // dict size sizeIter' value sizeIter' dict
-		pusherHelper.setDict(key, *arrayType->baseType(), dataType); // dict size sizeIter' dict'
-		pusherHelper.push(0, "POP S3"); // dict' size sizeIter'
+		pusherHelper.push(0, "DEC"); // dict size value' sizeIter'
+		pusherHelper.push(3, "PUSH3 S1,S0,S3"); // dict size value' sizeIter' value' sizeIter' dict
+		pusherHelper.setDict(key, *arrayBaseType, dataType); // dict size value' sizeIter' dict'
+		pusherHelper.push(-1, "POP S4"); // dict' size value' sizeIter'
 		m_pusher.pushCont(pusherHelper.code());
 	}
 	m_pusher.push(-2, "REPEAT");
-	// dict size 0
-	m_pusher.drop(1);  // dict size
+	// dict size value' 0
+	m_pusher.drop(2);  // dict size
 
 	m_pusher.push(0, "SWAP");
 	m_pusher.push(-2 + 1, "PAIR");
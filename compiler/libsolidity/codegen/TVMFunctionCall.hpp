@@ -34,6 +34,8 @@ public:
 	);
 	void structConstructorCall();
 	bool compile();
+	// Builds the part of the message after destination address and leaves the builder on the stack
+	void compileMessageTemplate();
 
 protected:
 	bool checkForMappingOrCurrenciesMethods();
@@ -51,6 +53,7 @@ protected:
 	void tvmBuildMsgMethod();
 	void sliceMethods(MemberAccess const& _node);
 	void arrayMethods(MemberAccess const& _node);
+	void tupleArrayMethods(MemberAccess const& _node);
 	bool checkForOptionalMethods(MemberAccess const& _node);
 	bool checkForTvmBuilderMethods(MemberAccess const& _node, Type::Category category);
 	bool checkForTvmTupleMethods(MemberAccess const& _node, Type::Category category);
@@ -116,6 +119,12 @@ protected:
 	);
 
 
+	void sendIntMsg(
+		const std::map<int, Expression const *> &exprs,
+		const std::map<int, std::string> &constParams,
+		const std::function<void(int)> &appendBody,
+		const std::function<void()> &pushSendrawmsgFlag
+	);
 	void pushArgs(bool reversed = false);
 	void pushArgAndConvert(int index, const std::string& name = "");
 	void pushExprAndConvert(const Expression* expr, Type const* targetType);
@@ -129,6 +138,7 @@ private:
 	FunctionType const* m_funcType{};
 	Type const* m_retType{};
 	bool m_isCurrentResultNeeded{};
+	bool m_isMessageTemplate{};
 };
 
 }	// solidity
@@ -24,8 +24,11 @@
 #include "TVM.h"
 #include "TVMABI.hpp"
 #include "TVMAnalyzer.hpp"
+#include "TVMConstEvaluator.hpp"
 #include "TVMExpressionCompiler.hpp"
+#include "TVMFunctionCall.hpp"
 #include "TVMFunctionCompiler.hpp"
+#include "TVMProfile.hpp"
 #include "TVMStructCompiler.hpp"
 
 using namespace solidity::frontend;
@@ -33,12 +36,7 @@ using namespace solidity::frontend;
 
 
 ContInfo getInfo(const Statement &statement) {
-	LoopScanner scanner(statement);
-	ContInfo info = scanner.m_info;
-	info.alwaysReturns = doesAlways<Return>(&statement);
-	info.alwaysContinue = doesAlways<Continue>(&statement);
-	info.alwaysBreak = doesAlways<Break>(&statement);
-	return info;
+	return ControlFlowScanner::info(statement);
 }
 
 TVMFunctionCompiler::TVMFunctionCompiler(StackPusherHelper &pusher, ContractDefinition const *contract) :
@@ -152,13 +150,23 @@ PUSHCONT {
 )");
 		pusher.addTabs();
 		int shift = 0;
+		// Initializers evaluated at compile time are set here instead of the default value. It's done only until the
+		// first initializer which is evaluated at runtime because it may read the following variables.
+		std::set<VariableDeclaration const*> initedVariables;
+		bool isInitOrderKept = true;
 		for (VariableDeclaration const* v : pusher.ctx().notConstantStateVariables()) {
 			pusher.push(0, "; init " + v->name());
 			if (v->isStatic()) {
 				pusher.pushInt(TvmConst::C4::PersistenceMembersStartIndex + shift++); // index
 				pusher.pushS(1); // index dict
 				pusher.getDict(getKeyTypeOfC4(), *v->type(), GetDictOperation::GetFromMapping);
+			} else if (Expression const* value = v->value().get(); value && isInitOrderKept &&
+				(TVMConstEvaluator::evaluate(*value) || TVMConstEvaluator::evaluateString(*value))
+			) {
+				funCompiler.acceptExpr(value);
+				initedVariables.insert(v);
 			} else {
+				isInitOrderKept &= value == nullptr;
 				pusher.pushDefaultValue(v->type());
 			}
 			pusher.setGlob(v);
@@ -186,7 +194,7 @@ PUSHCONT {
 
 		pusher.addTabs();
 		for (VariableDeclaration const *variable: pusher.ctx().notConstantStateVariables()) {
-			if (auto value = variable->value().get()) {
+			if (auto value = variable->value().get(); value && initedVariables.count(variable) == 0) {
 				pusher.push(0, ";; init state var: " + variable->name());
 				funCompiler.acceptExpr(value);
 				pusher.setGlob(variable);
@@ -328,6 +336,27 @@ void TVMFunctionCompiler::generateFunctionWithModifiers(
 	compiler.visitFunctionWithModifiers();
 }
 
+void TVMFunctionCompiler::generateModifierPrologue(
+	StackPusherHelper& pusher,
+	ModifierDefinition const* modifier,
+	FunctionDefinition const* function,
+	const std::string& name
+) {
+	// stack: modifier params
+	pusher.generateGlobl(name);
+	for (const ASTPointer<VariableDeclaration>& param : modifier->parameters()) {
+		pusher.push(0, string(";; param: ") + param->name());
+		pusher.getStack().add(param.get(), true);
+	}
+	TVMFunctionCompiler funCompiler{pusher, 0, function, false, false, pusher.getStack().size()};
+	const std::vector<ASTPointer<Statement>>& statements = modifier->body().statements();
+	for (size_t i = 0; i + 1 < statements.size(); ++i) { // the last one is placeholder
+		statements[i]->accept(funCompiler);
+	}
+	pusher.drop(pusher.getStack().size());
+	pusher.push(0, " ");
+}
+
 void
 TVMFunctionCompiler::generateGetter(StackPusherHelper &pusher, VariableDeclaration const* vd) {
 	TVMFunctionCompiler funCompiler{pusher, nullptr};
@@ -365,8 +394,20 @@ TVMFunctionCompiler::generateGetter(StackPusherHelper &pusher, VariableDeclarati
 
 void TVMFunctionCompiler::generatePublicFunctionSelector(StackPusherHelper& pusher, ContractDefinition const *contract) {
 	pusher.generateMacro("public_function_selector");
-	const std::vector<std::pair<uint32_t, std::string>>& functions = pusher.ctx().getPublicFunctions();
+	std::vector<std::pair<uint32_t, std::string>> functions = pusher.ctx().getPublicFunctions();
 	TVMFunctionCompiler compiler{pusher, contract};
+	if (GlobalParams::g_profile) {
+		// hot functions are checked before the search tree
+		int levels = 0;
+		for (size_t blockSize = 1; 4 * blockSize < functions.size(); blockSize *= 4)
+			++levels;
+		if (functions.size() > 4)
+			++levels;
+		for (const auto& [functionId, name] : GlobalParams::g_profile->hotPublicFunctions(functions, levels)) {
+			compiler.pushPublicFunctionCheck(functionId, name);
+			functions.erase(std::find(functions.begin(), functions.end(), std::make_pair(functionId, name)));
+		}
+	}
 	compiler.buildPublicFunctionSelector(functions, 0, functions.size());
 }
 
@@ -631,10 +672,17 @@ void TVMFunctionCompiler::visitFunctionWithModifiers() {
 				m_pusher.getStack().add(modifierDefinition->parameters()[i].get(), false);
 			}
 		}
-		const int nextStartStack = m_pusher.getStack().size();
-		TVMFunctionCompiler funCompiler{m_pusher, m_currentModifier, m_function, m_isLibraryWithObj, m_pushArgs, nextStartStack};
-		funCompiler.visitModifierOrFunctionBlock(modifierDefinition->body(), false);
-		m_pusher.drop(modParamQty);
+		if (m_pusher.ctx().isSharedModifier(modifierDefinition)) {
+			// prologue is compiled once, see TVMContractCompiler::fillSharedModifiers
+			m_pusher.pushCall(-modParamQty, TVMCompilerContext::getSharedModifierName(modifierDefinition));
+			TVMFunctionCompiler funCompiler{m_pusher, m_currentModifier + 1, m_function, m_isLibraryWithObj, m_pushArgs, m_pusher.getStack().size()};
+			funCompiler.visitFunctionWithModifiers();
+		} else {
+			const int nextStartStack = m_pusher.getStack().size();
+			TVMFunctionCompiler funCompiler{m_pusher, m_currentModifier, m_function, m_isLibraryWithObj, m_pushArgs, nextStartStack};
+			funCompiler.visitModifierOrFunctionBlock(modifierDefinition->body(), false);
+			m_pusher.drop(modParamQty);
+		}
 		m_pusher.push(0, "; end modifier " + invocation->name()->name());
 		solAssert(ss == m_pusher.getStack().size(), "");
 	}
@@ -677,7 +725,9 @@ bool TVMFunctionCompiler::visit(VariableDeclarationStatement const &_variableDec
 	const int saveStackSize = m_pusher.getStack().size();
 
 	ast_vec<VariableDeclaration> decls = _variableDeclarationStatement.declarations();
-	if (auto init = _variableDeclarationStatement.initialValue()) {
+	if (decls.size() == 1 && decls.at(0) != nullptr && TupleArrayScanner::isTupleArray(*decls.at(0))) {
+		pushTupleArray(*decls.at(0), _variableDeclarationStatement.initialValue());
+	} else if (auto init = _variableDeclarationStatement.initialValue()) {
 		auto tupleExpression = to<TupleExpression>(init);
 		if (tupleExpression && !tupleExpression->isInlineArray()) {
 			ast_vec<Expression> const&  tuple = tupleExpression->components();
@@ -721,6 +771,32 @@ bool TVMFunctionCompiler::visit(VariableDeclarationStatement const &_variableDec
 	return false;
 }
 
+void TVMFunctionCompiler::pushTupleArray(VariableDeclaration const& var, Expression const* init) {
+	Type const* baseType = to<ArrayType>(var.type())->baseType();
+	const int length = *TupleArrayScanner::initialLength(init);
+	if (auto tuple = to<TupleExpression>(init)) {
+		for (ASTPointer<Expression> const& component : tuple->components()) {
+			acceptExpr(component.get());
+			m_pusher.hardConvert(baseType, component->annotation().type);
+		}
+		m_pusher.tuple(length);
+	} else if (length <= 15) {
+		// the length of `new T[](length)` is constant
+		for (int i = 0; i < length; ++i) {
+			m_pusher.pushDefaultValue(baseType);
+		}
+		m_pusher.tuple(length);
+	} else {
+		m_pusher.tuple(0);
+		m_pusher.pushInt(length);
+		m_pusher.startContinuation();
+		m_pusher.pushDefaultValue(baseType);
+		m_pusher.push(-1, "TPUSH");
+		m_pusher.endContinuation();
+		m_pusher.push(-1, "REPEAT");
+	}
+}
+
 bool TVMFunctionCompiler::visit(Block const & _block) {
 	const int startStackSize = m_pusher.getStack().size();
 	for (const ASTPointer<Statement>& s : _block.statements()) {
@@ -757,7 +833,7 @@ bool TVMFunctionCompiler::visit(IfStatement const &_ifStatement) {
 
 
 	// header
-	ContInfo ci = getInfo(_ifStatement);
+	ContInfo ci = exitsByFlag(getInfo(_ifStatement));
 	bool canUseJmp = _ifStatement.falseStatement() != nullptr ?
 	                 getInfo(_ifStatement.trueStatement()).doThatAlways() &&
 	                 getInfo(*_ifStatement.falseStatement()).doThatAlways() :
@@ -857,15 +933,20 @@ void TVMFunctionCompiler::doWhile(WhileStatement const &_whileStatement) {
 
 	// header
 	m_pusher.push(0, "; do-while");
+	LoopPrologue prologue;
+	pushLoopPrologue(_whileStatement, prologue);
 	ContInfo ci;
 	ControlFlowInfo info;
 	std::tie(ci, info) = pushControlFlowFlag(_whileStatement.body());
 
 	// body
 	m_pusher.startContinuation();
-	if (ci.canReturn || ci.canBreak || ci.canContinue) {
+	if (ci.canReturn || ci.canBreak || ci.canContinue || info.continueByRetAlt) {
 		int ss = m_pusher.getStack().size();
 		m_pusher.startContinuation();
+		if (info.continueByRetAlt) {
+			m_pusher.push(0, "SAMEALTSAVE");
+		}
 		_whileStatement.body().accept(*this);
 		m_pusher.drop(m_pusher.getStack().size() - ss);
 		m_pusher.endContinuation();
@@ -903,7 +984,8 @@ void TVMFunctionCompiler::doWhile(WhileStatement const &_whileStatement) {
 	m_controlFlowInfo.pop_back();
 
 	// bottom
-	afterLoopCheck(ci, 0);
+	afterLoopCheck(ci, info, prologue.stackSize);
+	removeLoopPrologue(prologue);
 	m_pusher.push(0, "; end do-while");
 
 	m_pusher.getStack().ensureSize(saveStackSize, "");
@@ -944,7 +1026,12 @@ TVMFunctionCompiler::visitForOrWhileCondition(
 	m_pusher.getStack().ensureSize(stackSize, "visitForOrWhileCondition");
 }
 
-void TVMFunctionCompiler::afterLoopCheck(const ContInfo& ci, const int& loopVarQty) {
+void TVMFunctionCompiler::afterLoopCheck(const ContInfo& ci, const ControlFlowInfo& info, const int& loopVarQty) {
+	if (info.breakByRetAlt) {
+		m_pusher.endContinuation();
+		m_pusher.push(0, "CALLX");
+	}
+
 	int cntDrop = 0;
 	cntDrop += loopVarQty;
 	if (ci.canReturn || ci.canBreak || ci.canContinue) ++cntDrop;
@@ -979,6 +1066,8 @@ bool TVMFunctionCompiler::visit(WhileStatement const &_whileStatement) {
 
 	// header
 	m_pusher.push(0, "; while");
+	LoopPrologue prologue;
+	pushLoopPrologue(_whileStatement, prologue);
 	ContInfo ci;
 	ControlFlowInfo info;
 	std::tie(ci, info) = pushControlFlowFlag(_whileStatement.body());
@@ -1003,6 +1092,9 @@ bool TVMFunctionCompiler::visit(WhileStatement const &_whileStatement) {
 
 	// body
 	m_pusher.startContinuation();
+	if (info.continueByRetAlt) {
+		m_pusher.push(0, "SAMEALTSAVE");
+	}
 	_whileStatement.body().accept(*this);
 	m_pusher.drop(m_pusher.getStack().size() - saveStackSize);
 	m_pusher.endContinuation();
@@ -1015,7 +1107,8 @@ bool TVMFunctionCompiler::visit(WhileStatement const &_whileStatement) {
 	m_controlFlowInfo.pop_back();
 
 	// bottom
-	afterLoopCheck(ci, 0);
+	afterLoopCheck(ci, info, prologue.stackSize);
+	removeLoopPrologue(prologue);
 	m_pusher.push(0, "; end while");
 
 	m_pusher.getStack().ensureSize(saveStackSizeForWhile, "");
@@ -1052,6 +1145,7 @@ bool TVMFunctionCompiler::visit(ForEachStatement const& _forStatement) {
 	auto arrayType = to<ArrayType>(_forStatement.rangeExpression()->annotation().type);
 	auto mappingType = to<MappingType>(_forStatement.rangeExpression()->annotation().type);
 	auto vds = to<VariableDeclarationStatement>(_forStatement.rangeDeclaration().get());
+	const bool isTupleArray = arrayType && TupleArrayScanner::isTupleArray(_forStatement.rangeExpression().get());
 	int loopVarQty{};
 	if (arrayType) {
 		solAssert(vds->declarations().size() == 1, "");
@@ -1060,6 +1154,11 @@ bool TVMFunctionCompiler::visit(ForEachStatement const& _forStatement) {
 			m_pusher.push(0, "CTOS");
 			m_pusher.pushNull(); // stack: dict value
 			loopVarQty = 2;
+		} else if (isTupleArray) {
+			m_pusher.pushInt(0); // stack: tuple 0
+			m_pusher.pushNull(); // stack: tuple 0 value
+			m_pusher.push(0, string(";; decl: ") + iterVar->name());
+			loopVarQty = 3;
 		} else {
 			m_pusher.index(1); // stack: {length, dict} -> dict
 			m_pusher.pushInt(0); // stack: dict 0
@@ -1096,6 +1195,8 @@ bool TVMFunctionCompiler::visit(ForEachStatement const& _forStatement) {
 	m_pusher.getStack().ensureSize(saveStackSize + loopVarQty, "for");
 
 	// header
+	LoopPrologue prologue;
+	pushLoopPrologue(_forStatement, prologue);
 	ContInfo ci;
 	ControlFlowInfo info;
 	std::tie(ci, info) = pushControlFlowFlag(_forStatement.body());
@@ -1108,6 +1209,12 @@ bool TVMFunctionCompiler::visit(ForEachStatement const& _forStatement) {
 				m_pusher.pushS(m_pusher.getStack().size() - saveStackSize - 1); // stack: cell value [flag] cell
 				m_pusher.push(-1 + 1, "SEMPTY");
 				m_pusher.push(-1 + 1, "NOT");
+			} else if (isTupleArray) {
+				// stack: tuple index value [flag]
+				m_pusher.pushS(m_pusher.getStack().size() - saveStackSize - 2); // stack: tuple index value [flag] index
+				m_pusher.pushS(m_pusher.getStack().size() - saveStackSize - 1); // stack: tuple index value [flag] index tuple
+				m_pusher.push(-1 + 1, "TLEN");
+				m_pusher.push(-2 + 1, "LESS");
 			} else {
 				// stack: dict index value [flag]
 				m_pusher.pushS(m_pusher.getStack().size() - saveStackSize - 2); // stack: dict index value [flag] index
@@ -1158,6 +1265,13 @@ bool TVMFunctionCompiler::visit(ForEachStatement const& _forStatement) {
 				m_pusher.popS(m_pusher.getStack().size() - saveStackSize - 2);
 
 				solAssert(ss == m_pusher.getStack().size(), "");
+			} else if (isTupleArray) {
+				// stack: tuple index value [flag]
+				m_pusher.pushS(m_pusher.getStack().size() - saveStackSize - 1);
+				m_pusher.pushS(m_pusher.getStack().size() - saveStackSize - 2);
+				m_pusher.push(-2 + 1, "INDEXVAR");
+				// stack: tuple index value [flag] newValue
+				m_pusher.popS(m_pusher.getStack().size() - saveStackSize - 3);
 			}
 		}
 	};
@@ -1193,7 +1307,8 @@ bool TVMFunctionCompiler::visit(ForEachStatement const& _forStatement) {
 	visitBodyOfForLoop(ci, pushStartBody, _forStatement.body(), pushLoopExpression);
 
 	// bottom
-	afterLoopCheck(ci, loopVarQty);
+	afterLoopCheck(ci, info, loopVarQty + prologue.stackSize);
+	removeLoopPrologue(prologue);
 	m_pusher.push(0, "; end for");
 	m_pusher.getStack().ensureSize(saveStackSize, "for");
 
@@ -1202,11 +1317,122 @@ bool TVMFunctionCompiler::visit(ForEachStatement const& _forStatement) {
 
 std::pair<ContInfo, ControlFlowInfo> TVMFunctionCompiler::pushControlFlowFlag(Statement const& body) {
 	ContInfo ci = getInfo(body);
-	ControlFlowInfo info = pushControlFlowFlagAndReturnControlFlowInfo(ci, true);
+	ControlFlowInfo info{};
+	if (!ci.canReturn && ci.canBreak != ci.canContinue) {
+		// There is only `break` or only `continue` in the body. It's done by RETALT to c1, that is set
+		// by SAMEALTSAVE to the end of the loop (for `break`) or to the end of the body (for `continue`).
+		// So no flag is checked after nested statements and on each iteration.
+		info.isLoop = true;
+		info.breakByRetAlt = ci.canBreak;
+		info.continueByRetAlt = ci.canContinue;
+		ci.canBreak = false;
+		ci.canContinue = false;
+		if (info.breakByRetAlt) {
+			// closed in afterLoopCheck
+			m_pusher.startContinuation();
+			m_pusher.push(0, "SAMEALTSAVE");
+		}
+		info.stackSize = m_pusher.getStack().size();
+	} else {
+		info = pushControlFlowFlagAndReturnControlFlowInfo(ci, true);
+	}
 	m_controlFlowInfo.push_back(info);
 	return {ci, info};
 }
 
+static const int MaxLoopInvariants = 4;
+
+void TVMFunctionCompiler::pushLoopPrologue(BreakableStatement const& loop, LoopPrologue& prologue, bool beforeLoopVariables) {
+	if (!GlobalParams::g_withOptimizations)
+		return;
+	const int saveStackSize = m_pusher.getStack().size();
+	// State variables and mapping elements that aren't changed in the loop are read once. The number
+	// of such values is limited because each of them makes the stack in the loop deeper.
+	LoopInvariantScanner scanner{loop};
+	std::vector<std::vector<IndexAccess const*>> mappingReads;
+	for (std::vector<IndexAccess const*> const& group : scanner.mappingReads()) {
+		// the value is already read before an outer loop
+		if (static_cast<int>(mappingReads.size()) < MaxLoopInvariants && !m_pusher.ctx().loopInvariant(group.front()))
+			mappingReads.push_back(group);
+	}
+	const int stateVariableQty = MaxLoopInvariants - mappingReads.size();
+	if (beforeLoopVariables) {
+		// mapping keys and message templates can depend on the loop variables, they are pushed later
+		pushStateVariableInvariants(scanner, stateVariableQty, false, prologue);
+	} else {
+		pushMappingReadInvariants(mappingReads, prologue);
+		if (!prologue.haveStateVariables)
+			pushStateVariableInvariants(scanner, stateVariableQty, true, prologue);
+		// message templates can use the loop invariants
+		if (!m_pusher.ctx().ignoreIntegerOverflow())
+			pushMessageTemplates(loop, prologue);
+	}
+	prologue.stackSize += m_pusher.getStack().size() - saveStackSize;
+}
+
+void TVMFunctionCompiler::pushMappingReadInvariants(
+	std::vector<std::vector<IndexAccess const*>> const& mappingReads,
+	LoopPrologue& prologue
+) {
+	for (std::vector<IndexAccess const*> const& group : mappingReads) {
+		m_pusher.push(0, ";; loop invariant");
+		TVMExpressionCompiler{m_pusher}.compileNewExpr(group.front());
+		for (IndexAccess const* indexAccess : group)
+			m_pusher.ctx().addLoopInvariant(indexAccess, m_pusher.getStack().size());
+		prologue.mappingReads.push_back(group);
+	}
+}
+
+void TVMFunctionCompiler::pushStateVariableInvariants(
+	LoopInvariantScanner const& scanner,
+	int maxQty,
+	bool onTopOfLoopVariables,
+	LoopPrologue& prologue
+) {
+	prologue.haveStateVariables = true;
+	// PUSH is cheaper than GETGLOB only by a few units of gas. If the variable on the top of the
+	// stack is changed in the loop, its updates in place would turn into PUSH and POP, that costs more.
+	if (onTopOfLoopVariables)
+		if (auto top = to<VariableDeclaration>(m_pusher.getStack().top()); top && scanner.isChanged(top))
+			return;
+	int qty = 0;
+	for (VariableDeclaration const* var : scanner.stateVariables()) {
+		if (qty >= maxQty || m_pusher.ctx().loopInvariant(var))
+			continue;
+		m_pusher.push(0, ";; loop invariant " + var->name());
+		m_pusher.getGlob(var);
+		m_pusher.ctx().addLoopInvariant(var, m_pusher.getStack().size());
+		prologue.stateVariables.push_back(var);
+		++qty;
+	}
+}
+
+void TVMFunctionCompiler::pushMessageTemplates(BreakableStatement const& loop, LoopPrologue& prologue) {
+	// The part of message after the value is built before the loop and kept on the stack, the send
+	// in the loop only stores the header, the destination and the value and appends the template by STBR.
+	for (FunctionCall const* call : MessageTemplateScanner{loop}.calls()) {
+		// the template is already built before an outer loop
+		if (m_pusher.ctx().messageTemplate(call))
+			continue;
+		m_pusher.push(0, ";; message template");
+		TVMExpressionCompiler ec{m_pusher};
+		FunctionCallCompiler{m_pusher, &ec, *call, false}.compileMessageTemplate();
+		m_pusher.ctx().addMessageTemplate(call, m_pusher.getStack().size());
+		prologue.messageTemplates.push_back(call);
+	}
+}
+
+void TVMFunctionCompiler::removeLoopPrologue(LoopPrologue const& prologue) {
+	for (std::vector<IndexAccess const*> const& group : prologue.mappingReads) {
+		for (IndexAccess const* indexAccess : group)
+			m_pusher.ctx().removeLoopInvariant(indexAccess);
+	}
+	for (VariableDeclaration const* var : prologue.stateVariables)
+		m_pusher.ctx().removeLoopInvariant(var);
+	for (FunctionCall const* call : prologue.messageTemplates)
+		m_pusher.ctx().removeMessageTemplate(call);
+}
+
 void TVMFunctionCompiler::visitBodyOfForLoop(
 	const ContInfo& ci,
 	const std::function<void()>& pushStartBody,
@@ -1218,9 +1444,13 @@ void TVMFunctionCompiler::visitBodyOfForLoop(
 	if (pushStartBody) {
 		pushStartBody();
 	}
-	if (ci.canReturn || ci.canBreak || ci.canContinue) { // TODO and have loopExpression
+	const bool continueByRetAlt = m_controlFlowInfo.back().continueByRetAlt;
+	if (ci.canReturn || ci.canBreak || ci.canContinue || (continueByRetAlt && loopExpression)) { // TODO and have loopExpression
 		int ss = m_pusher.getStack().size();
 		m_pusher.startContinuation();
+		if (continueByRetAlt) {
+			m_pusher.push(0, "SAMEALTSAVE");
+		}
 		body.accept(*this);
 		m_pusher.drop(m_pusher.getStack().size() - ss);
 		m_pusher.endContinuation();
@@ -1233,6 +1463,9 @@ void TVMFunctionCompiler::visitBodyOfForLoop(
 		}
 	} else {
 		int ss = m_pusher.getStack().size();
+		if (continueByRetAlt) {
+			m_pusher.push(0, "SAMEALTSAVE");
+		}
 		body.accept(*this);
 		m_pusher.drop(m_pusher.getStack().size() - ss);
 	}
@@ -1250,6 +1483,7 @@ bool TVMFunctionCompiler::visit(ForStatement const &_forStatement) {
 	// if in loop body there is at least one 'return', 'break' or `continue`:
 	//
 	// decl loop var - optional
+	// loop invariants and message templates - optional, see pushLoopPrologue
 	// return, break or continue flag  - optional
 	// PUSHCONT {
 	//     condition
@@ -1274,9 +1508,35 @@ bool TVMFunctionCompiler::visit(ForStatement const &_forStatement) {
 	//     loopExpression
 	// }
 
+	// if there is only 'break' or only 'continue' (see pushControlFlowFlag):
+	//
+	// decl loop var - optional
+	// PUSHCONT {                  - for 'break'
+	//     SAMEALTSAVE
+	//     PUSHCONT {
+	//         condition
+	//     }
+	//     PUSHCONT {
+	//         PUSHCONT {          - for 'continue'
+	//             SAMEALTSAVE
+	//             body
+	//         }
+	//         CALLX
+	//         loopExpression
+	//     }
+	//     WHILE
+	// }
+	// CALLX
+
 	int saveStackSize = m_pusher.getStack().size();
 	m_pusher.push(0, "; for");
 
+	// State variables are read before the loop variable is declared. So the loop variable stays on
+	// the top of the stack and is changed in place.
+	LoopPrologue prologue;
+	if (to<VariableDeclarationStatement>(_forStatement.initializationExpression()))
+		pushLoopPrologue(_forStatement, prologue, true);
+
 	// init
 	bool haveDeclLoopVar = false;
 	if (_forStatement.initializationExpression() != nullptr) {
@@ -1286,6 +1546,7 @@ bool TVMFunctionCompiler::visit(ForStatement const &_forStatement) {
 	}
 
 	// header
+	pushLoopPrologue(_forStatement, prologue);
 	ContInfo ci;
 	ControlFlowInfo info;
 	std::tie(ci, info) = pushControlFlowFlag(_forStatement.body());
@@ -1309,7 +1570,8 @@ bool TVMFunctionCompiler::visit(ForStatement const &_forStatement) {
 	visitBodyOfForLoop(ci, {}, _forStatement.body(), pushLoopExpression);
 
 	// bottom
-	afterLoopCheck(ci, haveDeclLoopVar);
+	afterLoopCheck(ci, info, haveDeclLoopVar + prologue.stackSize);
+	removeLoopPrologue(prologue);
 	m_pusher.push(0, "; end for");
 	m_pusher.getStack().ensureSize(saveStackSize, "for");
 
@@ -1401,12 +1663,31 @@ void TVMFunctionCompiler::breakOrContinue(int code) {
 	}
 
 	const int sizeDelta = m_pusher.getStack().size() - controlFlowInfo.stackSize;
-	m_pusher.drop(sizeDelta + 1);
-	m_pusher.pushInt(code);
-	m_pusher.push(0, "RET");
+	if (code == ContInfo::BREAK_FLAG ? controlFlowInfo.breakByRetAlt : controlFlowInfo.continueByRetAlt) {
+		m_pusher.drop(sizeDelta);
+		m_pusher.push(0, "RETALT");
+	} else {
+		m_pusher.drop(sizeDelta + 1);
+		m_pusher.pushInt(code);
+		m_pusher.push(0, "RET");
+	}
 	m_pusher.push(sizeDelta, ""); // fix stack
 }
 
+ContInfo TVMFunctionCompiler::exitsByFlag(ContInfo ci) const {
+	// exits of the innermost loop that are done by RETALT don't need the flag
+	for (auto it = m_controlFlowInfo.rbegin(); it != m_controlFlowInfo.rend(); ++it) {
+		if (it->isLoop) {
+			if (it->breakByRetAlt)
+				ci.canBreak = false;
+			if (it->continueByRetAlt)
+				ci.canContinue = false;
+			break;
+		}
+	}
+	return ci;
+}
+
 bool TVMFunctionCompiler::visit(Break const &) {
 	breakOrContinue(ContInfo::BREAK_FLAG);
 	return false;
@@ -1912,6 +2193,16 @@ IFNOTRET
 	return code;
 }
 
+void TVMFunctionCompiler::pushPublicFunctionCheck(uint32_t functionId, const std::string& name) {
+	m_pusher.pushS(0);
+	m_pusher.pushInt(functionId);
+	m_pusher.push(-2 + 1, "EQUAL");
+	m_pusher.push(-1, ""); // fix stack
+	m_pusher.startIfJmpRef();
+	m_pusher.pushCall(0, name);
+	m_pusher.endContinuation();
+}
+
 void TVMFunctionCompiler::buildPublicFunctionSelector(
 	const std::vector<std::pair<uint32_t, std::string>>& functions,
 	int left,
@@ -1924,28 +2215,18 @@ void TVMFunctionCompiler::buildPublicFunctionSelector(
 	}
 	solAssert(4 * blockSize >= qty, "");
 
-	auto pushOne = [&](uint32_t functionId, const std::string& name) {
-		m_pusher.pushS(0);
-		m_pusher.pushInt(functionId);
-		m_pusher.push(-2 + 1, "EQUAL");
-		m_pusher.push(-1, ""); // fix stack
-		m_pusher.startIfJmpRef();
-		m_pusher.pushCall(0, name);
-		m_pusher.endContinuation();
-	};
-
 	// stack: functionID
 	if (right - left <= 4) {
 		for (int i = left; i < right; ++i) {
 			const auto& [functionId, name] = functions.at(i);
-			pushOne(functionId, name);
+			pushPublicFunctionCheck(functionId, name);
 		}
 	} else {
 		for (int i = left; i < right; i += blockSize) {
 			int j = std::min(i + blockSize, right);
 			const auto& [functionId, name] = functions.at(j - 1);
 			if (j - i == 1) {
-				pushOne(functionId, name);
+				pushPublicFunctionCheck(functionId, name);
 			} else {
 				m_pusher.pushS(0);
 				m_pusher.pushInt(functionId);
@@ -1959,11 +2240,14 @@ void TVMFunctionCompiler::buildPublicFunctionSelector(
 }
 
 void TVMFunctionCompiler::pushLocation(const ASTNode& node, bool reset) {
-    if (!GlobalParams::g_withDebugInfo)
+    // locations are also used to find branches in the profile
+    if (!GlobalParams::g_withDebugInfo && !GlobalParams::g_profile)
         return;
 
     SourceLocation const &loc = node.location();
     SourceReference sr = SourceReferenceExtractor::extract(&loc);
     const int line = reset ? 0 : sr.position.line + 1;
-    m_pusher.push(0, ".loc " + sr.sourceName + ", " + toString(line));
+    // without debug info locations are kept as comments, so they don't prevent optimizations
+    const std::string prefix = GlobalParams::g_withDebugInfo ? "" : ";; ";
+    m_pusher.push(0, prefix + ".loc " + sr.sourceName + ", " + toString(line));
 }
\ No newline at end of file
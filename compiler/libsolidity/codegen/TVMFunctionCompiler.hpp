@@ -22,7 +22,7 @@
 
 namespace solidity::frontend {
 
-
+class LoopInvariantScanner;
 
 class TVMFunctionCompiler: public ASTConstVisitor, private boost::noncopyable
 {
@@ -53,6 +53,12 @@ public:
 	static void generateOnBounce(StackPusherHelper& pusher, FunctionDefinition const* function);
 	static void generatePublicFunction(StackPusherHelper& pusher, FunctionDefinition const* function);
 	static void generateFunctionWithModifiers(StackPusherHelper& pusher, FunctionDefinition const* function, bool pushArgs);
+	static void generateModifierPrologue(
+		StackPusherHelper& pusher,
+		ModifierDefinition const* modifier,
+		FunctionDefinition const* function,
+		const std::string& name
+	);
 	static void generateGetter(StackPusherHelper& pusher, VariableDeclaration const* vd);
 	static void generatePublicFunctionSelector(StackPusherHelper& pusher, ContractDefinition const *contract);
 	void decodeFunctionParamsAndLocateVars(bool hasCallback);
@@ -76,16 +82,36 @@ public:
 	void visitFunctionWithModifiers();
 private:
 	void visitForOrWhileCondition(const ContInfo& ci, const ControlFlowInfo& info, const std::function<void()>& pushCondition);
-	void afterLoopCheck(const ContInfo& ci, const int& loopVarQty);
+	void afterLoopCheck(const ContInfo& ci, const ControlFlowInfo& info, const int& loopVarQty);
 	bool visitNode(ASTNode const&) override { solUnimplemented("Internal error: unreachable"); }
 
 	bool visit(VariableDeclarationStatement const& _variableDeclarationStatement) override;
+	void pushTupleArray(VariableDeclaration const& var, Expression const* init);
 	bool visit(Block const& _block) override;
 	bool visit(ExpressionStatement const& _expressionStatement) override;
 	bool visit(IfStatement const& _ifStatement) override;
 	bool visit(WhileStatement const& _whileStatement) override;
 	bool visit(ForEachStatement const& _forStatement) override;
 	std::pair<ContInfo, ControlFlowInfo> pushControlFlowFlag(Statement const& body);
+	// Values that are computed before the loop and kept on the stack until its end
+	struct LoopPrologue {
+		std::vector<std::vector<IndexAccess const*>> mappingReads;
+		std::vector<VariableDeclaration const*> stateVariables;
+		bool haveStateVariables{}; // state variables are already considered
+		std::vector<FunctionCall const*> messageTemplates;
+		int stackSize{};
+	};
+	// @a beforeLoopVariables: only state variables are read, the loop variables are declared after them
+	void pushLoopPrologue(BreakableStatement const& loop, LoopPrologue& prologue, bool beforeLoopVariables = false);
+	void pushMappingReadInvariants(std::vector<std::vector<IndexAccess const*>> const& mappingReads, LoopPrologue& prologue);
+	void pushStateVariableInvariants(
+		LoopInvariantScanner const& scanner,
+		int maxQty,
+		bool onTopOfLoopVariables,
+		LoopPrologue& prologue
+	);
+	void pushMessageTemplates(BreakableStatement const& loop, LoopPrologue& prologue);
+	void removeLoopPrologue(LoopPrologue const& prologue);
 	void visitBodyOfForLoop(
 		const ContInfo& ci,
 		const std::function<void()>& pushStartBody,
@@ -102,6 +128,7 @@ private:
 	ControlFlowInfo pushControlFlowFlagAndReturnControlFlowInfo(ContInfo &ci, bool isLoop);
 	void doWhile(WhileStatement const& _whileStatement);
 	void breakOrContinue(int code);
+	ContInfo exitsByFlag(ContInfo ci) const;
 	bool tryOptimizeReturn(Expression const* expr);
 	static bool isConstNumberOrConstTuple(Expression const* expr);
 
@@ -118,6 +145,7 @@ private:
 	void pushC7ToC4IfNeed();
 	std::string pushReceiveOrFallback();
 
+	void pushPublicFunctionCheck(uint32_t functionId, const std::string& name);
 	void buildPublicFunctionSelector(const std::vector<std::pair<uint32_t, std::string>>& functions, int left, int right);
     void pushLocation(const ASTNode& node, bool reset = false);
 
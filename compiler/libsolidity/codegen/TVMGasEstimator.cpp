@@ -0,0 +1,333 @@
+/*
+ * Copyright 2018-2019 TON DEV SOLUTIONS LTD.
+ *
+ * Licensed under the  terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License.
+ *
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the  GNU General Public License for more details at: https://www.gnu.org/licenses/gpl-3.0.html
+ */
+/**
+ * @author TON Labs <connect@tonlabs.io>
+ * @date 2021
+ * Static gas estimation of generated TVM assembly
+ */
+
+#include <boost/algorithm/string/trim.hpp>
+
+#include "TVMCodeStats.hpp"
+#include "TVMGasEstimator.hpp"
+
+using namespace solidity::frontend;
+
+namespace {
+	// Gas prices of TVM, see "Telegram Open Network Virtual Machine", appendix A
+	const int64_t BasicGasPrice = 10; // plus one unit per bit of instruction
+	const int64_t RefGasPrice = 5; // per reference in instruction
+	const int64_t CellLoadGasPrice = 100;
+	const int64_t CellCreateGasPrice = 500;
+	const int64_t ExceptionGasPrice = 50;
+	const int64_t ImplicitRetGasPrice = 5;
+
+	// Dictionary operations load (and modify) cells on the path from the root to the leaf.
+	// The depth of the path depends on the dictionary content, so only a rough range is used.
+	const GasRange DictReadGas{CellLoadGasPrice, 3 * CellLoadGasPrice, 10 * CellLoadGasPrice};
+	const GasRange DictWriteGas{
+		CellLoadGasPrice + CellCreateGasPrice,
+		3 * (CellLoadGasPrice + CellCreateGasPrice),
+		10 * (CellLoadGasPrice + CellCreateGasPrice)
+	};
+
+	bool isDictOpcode(std::string const& opcode) {
+		return boost::starts_with(opcode, "DICT") && opcode != "DICTEMPTY" && opcode != "DICTPUSHCONST";
+	}
+
+	bool isDictWriteOpcode(std::string const& opcode) {
+		for (const char* op : {"SET", "ADD", "REPLACE", "DEL"}) {
+			if (opcode.find(op) != std::string::npos)
+				return true;
+		}
+		return false;
+	}
+
+	std::string calleeName(std::string const& args) {
+		// CALL $name$
+		if (args.size() >= 2 && args.front() == '$' && args.back() == '$')
+			return args.substr(1, args.size() - 2);
+		return args;
+	}
+}
+
+GasRange& GasRange::operator+=(GasRange const& oth) {
+	min += oth.min;
+	typical += oth.typical;
+	max += oth.max;
+	unbounded |= oth.unbounded;
+	cold |= oth.cold;
+	return *this;
+}
+
+GasRange GasRange::times(int64_t n) const {
+	GasRange res = *this;
+	res.min *= n;
+	res.typical *= n;
+	res.max *= n;
+	return res;
+}
+
+GasRange GasRange::conditional() const {
+	GasRange res = *this;
+	res.min = 0;
+	if (cold)
+		res.typical = 0;
+	res.cold = false;
+	return res;
+}
+
+GasRange GasRange::oneOf(std::vector<GasRange> const& alternatives) {
+	solAssert(!alternatives.empty(), "");
+	// min and typical gas are calculated for paths finished without exceptions
+	std::vector<GasRange> paths;
+	for (GasRange const& alt : alternatives) {
+		if (!alt.cold)
+			paths.push_back(alt);
+	}
+	bool allCold = paths.empty();
+	if (allCold)
+		paths = alternatives;
+
+	GasRange res = paths.front();
+	int64_t typicalSum = 0;
+	for (GasRange const& p : paths) {
+		res.min = std::min(res.min, p.min);
+		typicalSum += p.typical;
+	}
+	res.typical = typicalSum / static_cast<int64_t>(paths.size());
+	res.max = 0;
+	res.unbounded = false;
+	for (GasRange const& alt : alternatives) {
+		res.max = std::max(res.max, alt.max);
+		res.unbounded |= alt.unbounded;
+	}
+	res.cold = allCold;
+	return res;
+}
+
+Json::Value GasRange::toJson() const {
+	Json::Value root(Json::objectValue);
+	root["min"] = Json::Int64(min);
+	root["typical"] = Json::Int64(typical);
+	if (unbounded)
+		root["max"] = "unbounded";
+	else
+		root["max"] = Json::Int64(max);
+	return root;
+}
+
+TVMGasEstimator::TVMGasEstimator(CodeLines const& code) {
+	parse(code);
+}
+
+void TVMGasEstimator::parse(CodeLines const& code) {
+	std::vector<std::vector<Node>*> blocks;
+	for (std::string const& line : code.lines) {
+		auto [opcode, args] = TVMCodeStats::splitLine(line);
+		if (opcode.empty()) {
+			continue;
+		}
+		std::string name;
+		if (TVMCodeStats::isFunctionHeader(opcode, args, name)) {
+			blocks = {&m_functions[name]};
+			continue;
+		}
+		if (blocks.empty() || (opcode[0] == '.' && opcode != ".cell")) {
+			continue;
+		}
+		if (opcode == "}") {
+			solAssert(blocks.size() >= 2, "");
+			blocks.pop_back();
+			continue;
+		}
+		Node node;
+		node.opcode = opcode;
+		node.args = args;
+		node.hasBody = !args.empty() && args.back() == '{';
+		if (node.hasBody) {
+			node.args.pop_back();
+			boost::algorithm::trim(node.args);
+		}
+		blocks.back()->push_back(node);
+		if (node.hasBody) {
+			blocks.push_back(&blocks.back()->back().body);
+		}
+	}
+
+	// public functions are called from the selector
+	std::function<void(std::vector<Node> const&)> collectCalls = [&](std::vector<Node> const& block) {
+		for (Node const& node : block) {
+			if (node.opcode == "CALL")
+				m_publicFunctions.push_back(calleeName(node.args));
+			collectCalls(node.body);
+		}
+	};
+	if (m_functions.count("public_function_selector"))
+		collectCalls(m_functions.at("public_function_selector"));
+}
+
+int TVMGasEstimator::blockBitSize(std::vector<Node> const& block) {
+	int bits = 0;
+	for (Node const& node : block) {
+		bits += TVMCodeStats::instructionBitSize(node.opcode, node.hasBody ? "" : node.args);
+		if (node.opcode == "PUSHCONT")
+			bits += blockBitSize(node.body);
+	}
+	return bits;
+}
+
+int64_t TVMGasEstimator::instructionGas(Node const& node) {
+	int64_t bits = TVMCodeStats::instructionBitSize(node.opcode, node.hasBody ? "" : node.args);
+	if (node.opcode == "PUSHCONT") {
+		int bodyBits = blockBitSize(node.body);
+		bits = (bodyBits <= 15 * 8 ? 8 : 16) + bodyBits;
+	}
+	int64_t gas = BasicGasPrice + bits;
+	if (node.hasBody && node.opcode != "PUSHCONT")
+		gas += RefGasPrice;
+	if (isIn(node.opcode, "CTOS", "LDREFRTOS"))
+		gas += CellLoadGasPrice;
+	if (isIn(node.opcode, "ENDC", "STBREF", "STBREFR"))
+		gas += CellCreateGasPrice;
+	return gas;
+}
+
+GasRange TVMGasEstimator::estimate(std::string const& function) {
+	if (m_estimated.count(function))
+		return m_estimated.at(function);
+	if (!m_functions.count(function))
+		return GasRange{};
+	if (m_inProgress.count(function)) {
+		// recursive call
+		GasRange res;
+		res.unbounded = true;
+		return res;
+	}
+	m_inProgress.insert(function);
+	GasRange res = estimateBlock(m_functions.at(function));
+	m_inProgress.erase(function);
+	m_estimated[function] = res;
+	return res;
+}
+
+GasRange TVMGasEstimator::estimateBlock(std::vector<Node> const& block) {
+	GasRange cur; // path without jumps out of the block
+	std::vector<GasRange> exits; // paths leaving the block before its end
+	std::vector<GasRange> conts; // continuations pushed onto the stack
+	std::optional<int64_t> lastInt;
+
+	auto popCont = [&]() {
+		if (conts.empty())
+			return GasRange{};
+		GasRange c = conts.back();
+		conts.pop_back();
+		return c;
+	};
+
+	for (Node const& node : block) {
+		std::string const& op = node.opcode;
+		cur += GasRange{instructionGas(node)};
+
+		if (node.hasBody) {
+			if (op == "PUSHCONT") {
+				conts.push_back(estimateBlock(node.body) + GasRange{ImplicitRetGasPrice});
+			} else if (op == "PUSHREFCONT") {
+				conts.push_back(GasRange{CellLoadGasPrice} + estimateBlock(node.body) + GasRange{ImplicitRetGasPrice});
+			} else if (op == "CALLREF") {
+				cur += GasRange{CellLoadGasPrice} + estimateBlock(node.body) + GasRange{ImplicitRetGasPrice};
+			} else if (isIn(op, "IFREF", "IFNOTREF")) {
+				cur += (GasRange{CellLoadGasPrice} + estimateBlock(node.body) + GasRange{ImplicitRetGasPrice}).conditional();
+			} else if (isIn(op, "IFJMPREF", "IFNOTJMPREF")) {
+				exits.push_back(cur + GasRange{CellLoadGasPrice} + estimateBlock(node.body));
+			}
+			lastInt.reset();
+			continue;
+		}
+
+		if (isIn(op, "IF", "IFNOT")) {
+			cur += popCont().conditional();
+		} else if (isIn(op, "IFJMP", "IFNOTJMP")) {
+			exits.push_back(cur + popCont());
+		} else if (op == "IFELSE") {
+			GasRange elseBranch = popCont();
+			GasRange thenBranch = popCont();
+			cur += GasRange::oneOf({thenBranch, elseBranch});
+		} else if (isIn(op, "CALLX", "EXECUTE")) {
+			cur += popCont();
+		} else if (op == "JMPX") {
+			cur += popCont();
+			break;
+		} else if (isIn(op, "IFRET", "IFNOTRET")) {
+			exits.push_back(cur);
+		} else if (isIn(op, "RET", "RETALT")) {
+			break;
+		} else if (op == "WHILE") {
+			GasRange body = popCont();
+			GasRange cond = popCont();
+			// typical case is one iteration
+			GasRange loop{cond.min, 2 * cond.typical + body.typical, 0};
+			loop.unbounded = true;
+			cur += loop;
+		} else if (isIn(op, "UNTIL", "AGAIN")) {
+			GasRange body = popCont();
+			body.unbounded = true;
+			cur += body;
+		} else if (op == "REPEAT") {
+			GasRange body = popCont();
+			if (lastInt.has_value()) {
+				cur += body.times(std::max<int64_t>(0, *lastInt));
+			} else {
+				GasRange loop{0, body.typical, 0};
+				loop.unbounded = true;
+				cur += loop;
+			}
+		} else if (isIn(op, "THROW", "THROWANY", "THROWARG", "THROWARGANY")) {
+			cur += GasRange{ExceptionGasPrice};
+			cur.cold = true;
+			break;
+		} else if (boost::starts_with(op, "THROW") && op.find("IF") != std::string::npos) {
+			GasRange exception = cur + GasRange{ExceptionGasPrice};
+			exception.cold = true;
+			exits.push_back(exception);
+		} else if (op == "CALL") {
+			cur += estimate(calleeName(node.args));
+		} else if (isDictOpcode(op)) {
+			cur += isDictWriteOpcode(op) ? DictWriteGas : DictReadGas;
+		}
+
+		if (op == "PUSHINT" && !node.args.empty() && node.args.size() < 10 &&
+			std::all_of(node.args.begin(), node.args.end(), [](char c) { return std::isdigit(c); })) {
+			lastInt = std::stoll(node.args);
+		} else {
+			lastInt.reset();
+		}
+	}
+
+	exits.push_back(cur);
+	return GasRange::oneOf(exits);
+}
+
+Json::Value TVMGasEstimator::toJson(std::string const& contractName) {
+	Json::Value root(Json::objectValue);
+	root["contract"] = contractName;
+	Json::Value publicFunctions(Json::objectValue);
+	for (std::string const& name : m_publicFunctions)
+		publicFunctions[name] = estimate(name).toJson();
+	root["public"] = publicFunctions;
+	Json::Value functions(Json::objectValue);
+	for (auto const& [name, block] : m_functions)
+		functions[name] = estimate(name).toJson();
+	root["functions"] = functions;
+	return root;
+}
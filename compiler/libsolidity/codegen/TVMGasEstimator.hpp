@@ -0,0 +1,69 @@
+/*
+ * Copyright 2018-2019 TON DEV SOLUTIONS LTD.
+ *
+ * Licensed under the  terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License.
+ *
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the  GNU General Public License for more details at: https://www.gnu.org/licenses/gpl-3.0.html
+ */
+/**
+ * @author TON Labs <connect@tonlabs.io>
+ * @date 2021
+ * Static gas estimation of generated TVM assembly
+ */
+
+#pragma once
+
+#include "TVMPusher.hpp"
+
+namespace solidity::frontend {
+
+struct GasRange {
+	int64_t min{};
+	int64_t typical{};
+	int64_t max{};
+	bool unbounded{}; // max is unknown, e.g. for loops with non constant number of iterations
+	bool cold{};      // the path ends with an exception
+
+	GasRange() = default;
+	explicit GasRange(int64_t gas) : min{gas}, typical{gas}, max{gas} {}
+	GasRange(int64_t min, int64_t typical, int64_t max) : min{min}, typical{typical}, max{max} {}
+
+	GasRange& operator+=(GasRange const& oth);
+	GasRange operator+(GasRange const& oth) const { GasRange res = *this; return res += oth; }
+	GasRange times(int64_t n) const;
+	// Path which is executed or not depending on a condition
+	GasRange conditional() const;
+	// One of alternative paths is executed
+	static GasRange oneOf(std::vector<GasRange> const& alternatives);
+	Json::Value toJson() const;
+};
+
+class TVMGasEstimator {
+public:
+	explicit TVMGasEstimator(CodeLines const& code);
+	GasRange estimate(std::string const& function);
+	Json::Value toJson(std::string const& contractName);
+private:
+	struct Node {
+		std::string opcode;
+		std::string args;
+		bool hasBody{};
+		std::vector<Node> body;
+	};
+	void parse(CodeLines const& code);
+	GasRange estimateBlock(std::vector<Node> const& block);
+	static int64_t instructionGas(Node const& node);
+	static int blockBitSize(std::vector<Node> const& block);
+private:
+	std::map<std::string, std::vector<Node>> m_functions;
+	std::vector<std::string> m_publicFunctions;
+	std::map<std::string, GasRange> m_estimated;
+	std::set<std::string> m_inProgress;
+};
+
+}	// end solidity::frontend
@@ -17,9 +17,12 @@
  */
 
 #include "TVMOptimizations.hpp"
+#include "TVMPeepholeRules.hpp"
 #include <boost/algorithm/string/trim.hpp>
 #include <boost/format.hpp>
 
+#include <libsolutil/TimeReport.h>
+
 namespace solidity::frontend {
 
 struct TVMOptimizer {
@@ -163,11 +166,6 @@ struct TVMOptimizer {
 			return strToInt(s);
 		}
 
-		bool is_commutative() const {
-			return is_ADD() || is_MUL() || is("AND") || is("OR") || is("XOR") ||
-					is("EQUAL") || is("NEQ");
-		}
-
 		bool is_add_or_sub() const {
 			return is_ADD() || is_SUB();
 		}
@@ -222,100 +220,9 @@ struct TVMOptimizer {
 			outputs_count_ = outp;
 		}
 
-		bool try_simple_command(const set<string>& s, int inp, int outp) {
-			if (s.count(cmd_)) {
-				set_simple_command(inp, outp);
-				return true;
-			}
-			return false;
-		}
-
 		void analyze() {
-			static const set<string> s01 {
-				"GETGLOB",
-				"NEWC",
-				"NEWDICT",
-				"NOW",
-				"PUSHINT",
-				"PUSHSLICE",
-				"TRUE",
-				"FALSE",
-				"ZERO",
-			};
-			static const set<string> s10 {
-				"DROP",
-				"ENDS",
-				"SETGLOB",
-				"THROWANY",
-				"THROWIF",
-				"THROWIFNOT",
-			};
-			static const set<string> s11 {
-				"CTOS",
-				"DEC",
-				"ENDC",
-				"EQINT",
-				"FIRST",
-				"FITS",
-				"HASHCU",
-				"HASHSU",
-                "VERGRTH16",
-				"INC",
-				"INDEX",
-				"NOT",
-				"PARSEMSGADDR",
-				"SBITS",
-				"SECOND",
-				"SHA256U",
-				"STSLICECONST",
-				"THIRD",
-				"UFITS",
-			};
-			static const set<string> s21 {
-				"ADD",
-				"AND",
-				"EQ",
-				"GREATER",
-				"INDEXVAR",
-				"LESS",
-				"MUL",
-				"NEQ",
-				"OR",
-				"PAIR",
-				"PLDUX",
-				"SETINDEX",
-				"STI",
-				"STSLICE",
-				"STU",
-				"SUB",
-		   		"DIV",
-		   		"MOD",
-		   		"SUBR",
-			};
-			static const set<string> s32 {
-				"DICTDEL",
-				"DICTIDEL",
-				"DICTUDEL",
-			};
-
-			if (try_simple_command(s01, 0, 1)) return;
-			if (try_simple_command(s10, 1, 0)) return;
-			if (try_simple_command(s11, 1, 1)) return;
-			if (try_simple_command(s21, 2, 1)) return;
-			if (try_simple_command(s32, 3, 2)) return;
-
-			if (is("SWAP"))
-				return set_simple_command(2, 2);
-			if (is("ROT") || is("ROTREV"))
-				return set_simple_command(3, 3);
-			if (is("TUPLE"))
-				return set_simple_command(fetch_int(), 1);
-			if (is("UNTUPLE"))
-				return set_simple_command(1, fetch_int());
-			if (is("UNPAIR"))
-				return set_simple_command(1, 2);
-			if (is("SETINDEXVAR"))
-				return set_simple_command(3, 1);
+			if (auto effect = simple_command_stack_effect(cmd_, rest_))
+				set_simple_command(effect->first, effect->second);
 		}
 
 	};
@@ -393,12 +300,20 @@ struct TVMOptimizer {
 		Cmd cmd5 = cmd(idx5);
 		Cmd cmd6 = cmd(idx6);
 		// TODO: INC + UFITS256...
-		if (cmd1.is_SWAP()) {
-			if (cmd2.is_SUB())		return Result::Replace(2, "SUBR");
-			if (cmd2.is("SUBR"))	return Result::Replace(2, "SUB");
-			if (cmd2.is_SWAP())		return Result::Replace(2);
-			if (cmd2.is_NIP())		return Result::Replace(2, "DROP");
-			if (cmd2.is_commutative())	return Result::Replace(1);
+		{
+			std::array<PeepholeCommand, 6> const window{{
+				{cmd1.cmd_, cmd1.rest_},
+				{cmd2.cmd_, cmd2.rest_},
+				{cmd3.cmd_, cmd3.rest_},
+				{cmd4.cmd_, cmd4.rest_},
+				{cmd5.cmd_, cmd5.rest_},
+				{cmd6.cmd_, cmd6.rest_},
+			}};
+			if (std::optional<PeepholeMatch> match = PeepholeRules::match(window.data(), window.size())) {
+				if (TimeReport::isEnabled())
+					TimeReport::count(match->rule->name);
+				return Result(true, match->rule->replaced, std::move(match->commands));
+			}
 		}
 		if (cmd1.is_PUSHINT() && cmd3.is_PUSHINT()) {
 			// TODO: consider INC/DEC as well
@@ -423,7 +338,7 @@ struct TVMOptimizer {
 				if (cmd2.is_SUB()) return Result::Replace(2, "ADDCONST " + toString(-value));
 			}
 		}
-		if (cmd1.is("RET") || cmd1.is("THROWANY") || cmd1.is("THROW")) {
+		if (cmd1.is("RET") || cmd1.is("RETALT") || cmd1.is("THROWANY") || cmd1.is("THROW")) {
 			// delete commands after noreturn opcode
 			if (cmd2.prefix_.length() >= cmd1.prefix_.length() &&  !cmd2.cmd_.empty())
 				return Result::Replace(2, cmd1.without_prefix());
@@ -589,60 +504,18 @@ struct TVMOptimizer {
 		}
 		if (cmd1.is("NEWC") && cmd2.is_simple_command(0, 1) &&
 			isIn(cmd3.cmd_, "STUR", "STIR", "STBR", "STBREFR", "STSLICER", "STREFR")) {
+			const std::string store = cmd3.cmd_.substr(0, cmd3.cmd_.size() - 1);
 			return Result::Replace(3,
 					cmd2.without_prefix(),
 					"NEWC",
-					cmd3.cmd_.substr(0, cmd3.cmd_.size() - 1) + " " + cmd3.rest());
-		}
-		if (cmd1.is("PUSHCONT") && cmd2.is("}") && (cmd3.is("IF") || cmd3.is("IFNOT"))) {
-			return Result::Replace(3, "DROP");
-		}
-		if (cmd1.is("PUSHCONT") && cmd2.is("}") && cmd3.is("IFJMP")) {
-			return Result::Replace(3, "IFRET");
-		}
-		if (cmd1.is("PUSHCONT") && cmd2.is("}") && cmd3.is("IFNOTJMP")) {
-			return Result::Replace(3, "IFNOTRET");
-		}
-		if (cmd1.is("PUSHCONT") &&
-			cmd2.is("THROW") &&
-			cmd3.is("}") &&
-			(cmd4.is("IF") || cmd4.is("IFJMP"))) {
-			return Result::Replace(4, "THROWIF " + cmd2.rest());
-		}
-		if (cmd1.is("PUSHCONT") &&
-			cmd2.is("THROW") &&
-			cmd3.is("}") &&
-			(cmd4.is("IFNOT") || cmd4.is("IFNOTJMP"))) {
-			return Result::Replace(4, "THROWIFNOT " + cmd2.rest());
-		}
-		if (cmd1.is("PUSHCONT") &&
-			cmd2.is("}") &&
-			(cmd3.is("IF") || cmd3.is("IFNOT"))) {
-			return Result::Replace(3, "DROP");
-		}
-		if (cmd1.is("GETGLOB") &&
-			cmd2.is("ISNULL") &&
-			cmd3.is("DROP")) {
-			return Result::Replace(3, "");
-		}
-		if ((cmd1.is("NOT") || (cmd1.is("EQINT") && cmd1.fetch_int() == 0)) &&
-			cmd2.is("THROWIFNOT")) {
-			return Result::Replace(2, "THROWIF " + cmd2.rest());
-		}
-		if (cmd1.is("NEQINT") && cmd1.fetch_int() == 0 &&
-			cmd2.is("THROWIFNOT")) {
-			return Result::Replace(2, "THROWIFNOT " + cmd2.rest());
-		}
-		if (cmd1.is("NOT") &&
-			cmd2.is("THROWIF")) {
-			return Result::Replace(2, "THROWIFNOT " + cmd2.rest());
+					cmd3.rest().empty() ? store : store + " " + cmd3.rest());
 		}
 		if (cmd1.is_PUSH()) {
 			// PUSH Sx
 			// XCHG n
 			// BLKDROP n
 			int pushIndex = cmd1.fetchStackIndex();
-			if (cmd2.is("XCHG")) {
+			if (cmd2.is("XCHG") && cmd2.rest().find(',') == string::npos) {
 				int xghIndex = cmd2.fetchStackIndex();
 				if (cmd3.is_drop_kind()) {
 					int dropedQty = cmd3.get_drop_index();
@@ -663,12 +536,6 @@ struct TVMOptimizer {
 				}
 			}
 		}
-		if (cmd1.is("ROT") && cmd2.is("ROTREV")) {
-			return Result::Replace(2);
-		}
-		if (cmd1.is("ROTREV") && cmd2.is("ROT")) {
-			return Result::Replace(2);
-		}
 		if (cmd1.is_PUSHINT() && cmd2.is("STZEROES") && cmd3.is("STSLICECONST") && cmd3.rest() == "0") {
 			return Result::Replace(3, "PUSHINT " + toString(cmd1.fetch_bigint() + 1), "STZEROES");
 		}
@@ -737,18 +604,11 @@ struct TVMOptimizer {
 			cmd1.fetch_int() == cmd2.fetch_int()) {
 			return Result(true, 2, {});
 		}
-		if (cmd1.is("PAIR") &&
-			cmd2.is("UNPAIR")) {
-			return Result(true, 2, {});
-		}
 		if (cmd1.is("ROT") &&
-			(cmd2.is("SETGLOB") || (cmd2.is("POP") && cmd2.fetchStackIndex() >= 3)) &&
+			cmd2.is("POP") && cmd2.fetchStackIndex() >= 3 &&
 			cmd3.is("SWAP")) {
 			return Result(true, 3, {"XCHG s2", cmd2.without_prefix()});
 		}
-		if (cmd1.is("SETGLOB") && cmd2.is("GETGLOB") && cmd1.rest() == cmd2.rest()) {
-			return Result(true, 2, {"DUP", "SETGLOB " + cmd2.rest()});
-		}
 		if (cmd1.is_const_add() && cmd2.is_const_add()) {
 			int final_add = cmd1.get_add_num() + cmd2.get_add_num();
 			if (-128 <= final_add && final_add <= 127)
@@ -775,7 +635,7 @@ struct TVMOptimizer {
 			return Result(true, 2, {"THROW " + cmd1.rest()});
 		}
 		if (cmd1.is_PUSHINT() && 1 <= cmd1.fetch_bigint() && cmd1.fetch_bigint() <= 256 &&
-			(cmd2.is("RSHIFT") || cmd2.is("LSHIFT"))) {
+			(cmd2.is("RSHIFT") || cmd2.is("LSHIFT")) && cmd2.rest().empty()) {
 			return Result(true, 2, {cmd2.cmd_ + " " + cmd1.rest()});
 		}
 
@@ -814,10 +674,6 @@ struct TVMOptimizer {
 			}
 		}
 
-		if (cmd1.is("ROTREV") && cmd2.is("ROTREV") && cmd3.is("ROTREV")) {
-			return Result(true, 3, {});
-		}
-
 		if (cmd1.is("BLKSWAP")) {
 			int n = cmd1.fetch_first_int();
 			bool ok = true;
@@ -906,11 +762,6 @@ struct TVMOptimizer {
 			}
 		}
 
-        if (cmd1.is("MUL") && cmd2.is("RSHIFT")) {
-            // RSHIFT can have parameter or can omit it
-            return Result(true, 2, {"MULRSHIFT " + cmd2.rest_});
-        }
-
         if (cmd1.is("NEWC") && cmd2.is("ENDC")) {
             return Result(true, 2, {"PUSHREF {", "}"});
         }
@@ -925,13 +776,6 @@ struct TVMOptimizer {
 			return Result(true, 3, {"BLKDROP2 3, 3"});
 		}
 
-		if (cmd1.is("ISNULL") &&
-			cmd2.is("NOT") &&
-			cmd3.is("NOT")
-		) {
-			return Result(true, 3, {"ISNULL"});
-		}
-
 		if (cmd1.is_PUSHINT() && cmd1.is_PUSHINT() && cmd1.fetch_bigint() == 0 &&
 			cmd2.is("STUR") &&
 			cmd3.is_PUSHINT() && cmd3.is_PUSHINT() && cmd3.fetch_bigint() == 0 &&
@@ -950,7 +794,8 @@ struct TVMOptimizer {
 		if (cmd1.is_PUSHINT() &&
 			cmd2.is("NEWC") &&
 			cmd3.is("STSLICECONST") &&
-			cmd4.is("STU")) {
+			cmd4.is("STU") &&
+			fitsUnsigned(cmd1.fetch_bigint(), cmd4.fetch_int())) {
 			std::string bitStr = toBitString(cmd3.rest());
 			StackPusherHelper::addBinaryNumberToString(bitStr, cmd1.fetch_bigint(), cmd4.fetch_int());
 			std::vector<std::string> slices = unitBitString(bitStr, "");
@@ -967,7 +812,8 @@ struct TVMOptimizer {
 			cmd2.is("PUSHSLICE") &&
 			cmd3.is("NEWC") &&
 			cmd4.is("STSLICE") &&
-			cmd5.is("STU")
+			cmd5.is("STU") &&
+			fitsUnsigned(cmd1.fetch_bigint(), cmd5.fetch_int())
 		) {
 			std::string bitStr = toBitString(cmd2.rest());
 			StackPusherHelper::addBinaryNumberToString(bitStr, cmd1.fetch_bigint(), cmd5.fetch_int());
@@ -1041,14 +887,6 @@ struct TVMOptimizer {
 			}
 		}
 
-		if ((cmd1.is("TRUE") || cmd1.is("FALSE")) &&
-			cmd2.is("STIR") && cmd2.fetch_int() == 1
-		) {
-			if (cmd1.is("FALSE"))
-				return Result(true, 2, {"STZERO"});
-			return Result(true, 2, {"STONE"});
-		}
-
 		if ((cmd1.is("STONE") || cmd1.is("STZERO"))) {
 			int qty = 0;
 			int i = idx1;
@@ -1137,13 +975,6 @@ struct TVMOptimizer {
 //			return Result(true, 2, {"STSLICECONST x" + s});
 //		}
 
-		if (
-			cmd1.is("ABS") &&
-			cmd2.is("UFITS") && cmd2.fetch_int() == 256
-		) {
-			return Result(true, 2, {"ABS"});
-		}
-
 		if (
 			cmd1.is_PUSHINT() && cmd1.fetch_bigint() == 1 &&
 			cmd2.is("STZEROES")
@@ -1151,13 +982,6 @@ struct TVMOptimizer {
 			return Result(true, 2, {"STZERO"});
 		}
 
-		if (
-			cmd1.is("REVERSE") && cmd1.fetch_first_int() == 2 && cmd1.fetch_second_int() == 1 &&
-			cmd2.is("ROTREV")
-		) {
-			return Result(true, 2, {"XCHG S2"});
-		}
-
 		// REVERSE M, 0
 		// BLKSWAP 1, M
 		// =>
@@ -1173,6 +997,11 @@ struct TVMOptimizer {
 		return Result(false);
 	}
 
+	// Otherwise STU throws and the value can't be folded into a slice
+	static bool fitsUnsigned(const bigint& value, int bitLen) {
+		return 0 <= value && value < (bigint(1) << bitLen);
+	}
+
 	// TODO move to common file. See also binaryStringToSlice
 	static std::string toBitString(const std::string& slice) {
 		std::string bitString;
@@ -1459,6 +1288,9 @@ struct TVMOptimizer {
 		int idx1 = 0;
 		while (valid(idx1)) {
 			Result res = f(idx1);
+			if (res.remove_ > 0) {
+				TimeReport::count("rewrites");
+			}
 			if (updateLines(idx1, res)) {
 				continue;
 			}
@@ -1467,12 +1299,104 @@ struct TVMOptimizer {
 	}
 };
 
+std::optional<std::pair<int, int>> simple_command_stack_effect(const string& cmd, const string& operand) {
+	static const set<string> s01 {
+		"GETGLOB",
+		"NEWC",
+		"NEWDICT",
+		"NOW",
+		"PUSHINT",
+		"PUSHSLICE",
+		"TRUE",
+		"FALSE",
+		"ZERO",
+	};
+	static const set<string> s10 {
+		"DROP",
+		"ENDS",
+		"SETGLOB",
+		"THROWANY",
+		"THROWIF",
+		"THROWIFNOT",
+	};
+	static const set<string> s11 {
+		"CTOS",
+		"DEC",
+		"ENDC",
+		"EQINT",
+		"FIRST",
+		"FITS",
+		"HASHCU",
+		"HASHSU",
+                "VERGRTH16",
+		"INC",
+		"INDEX",
+		"NOT",
+		"PARSEMSGADDR",
+		"SBITS",
+		"SECOND",
+		"SHA256U",
+		"STSLICECONST",
+		"THIRD",
+		"UFITS",
+	};
+	static const set<string> s21 {
+		"ADD",
+		"AND",
+		"EQ",
+		"GREATER",
+		"INDEXVAR",
+		"LESS",
+		"MUL",
+		"NEQ",
+		"OR",
+		"PAIR",
+		"PLDUX",
+		"SETINDEX",
+		"STI",
+		"STSLICE",
+		"STU",
+		"SUB",
+	   		"DIV",
+	   		"MOD",
+	   		"SUBR",
+	};
+	static const set<string> s32 {
+		"DICTDEL",
+		"DICTIDEL",
+		"DICTUDEL",
+	};
+
+	if (s01.count(cmd)) return std::make_pair(0, 1);
+	if (s10.count(cmd)) return std::make_pair(1, 0);
+	if (s11.count(cmd)) return std::make_pair(1, 1);
+	if (s21.count(cmd)) return std::make_pair(2, 1);
+	if (s32.count(cmd)) return std::make_pair(3, 2);
+
+	if (cmd == "SWAP")
+		return std::make_pair(2, 2);
+	if (cmd == "ROT" || cmd == "ROTREV")
+		return std::make_pair(3, 3);
+	if (cmd == "TUPLE")
+		return std::make_pair(TVMOptimizer::strToInt(operand), 1);
+	if (cmd == "UNTUPLE")
+		return std::make_pair(1, TVMOptimizer::strToInt(operand));
+	if (cmd == "UNPAIR")
+		return std::make_pair(1, 2);
+	if (cmd == "SETINDEXVAR")
+		return std::make_pair(3, 1);
+	return std::nullopt;
+}
+
 CodeLines optimize_code(const CodeLines& code0) {
 	auto code = code0;
 	TVMOptimizer optimizer{code.lines};
+	TimeReport::ScopedTimer timer{"unsquash_push"};
 	optimizer.optimize([&optimizer](int index){ return optimizer.unsquash_push(index);});
+	timer.next("optimize_at");
 	optimizer.optimize([&optimizer](int index){ return optimizer.optimize_at(index);});
 	optimizer.optimize([&optimizer](int index){ return optimizer.optimize_at(index);});
+	timer.next("squash_push");
 	optimizer.optimize([&optimizer](int index){ return optimizer.squash_push(index);});
 	code.lines = optimizer.lines_;
 	return code;
@@ -1494,25 +1418,3 @@ void run_peephole_pass(const string& filename) {
 }
 
 } // end solidity::frontend
-
-
-// SWAP
-// NEWC
-// SWAP
-// => NEWC ROTREV
-
-//SWAP
-// ROT
-//SWAP
-
-// SWAP
-// ROT
-
-// ROT
-// SWAP
-
-// XCHG s2
-// SWAP
-
-// XCHG s2
-// ROTREV
\ No newline at end of file
@@ -23,6 +23,10 @@
 namespace solidity::frontend {
 
 	CodeLines optimize_code(const CodeLines&);
+
+	// Number of stack values taken and pushed by a command that only works with the top of the stack,
+	// or nullopt if the optimizer does not know the command.
+	std::optional<std::pair<int, int>> simple_command_stack_effect(const string& cmd, const string& operand);
 	
 	void run_peephole_pass(const string& filename);
 
@@ -0,0 +1,909 @@
+/*
+ * Copyright 2018-2019 TON DEV SOLUTIONS LTD.
+ *
+ * Licensed under the  terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License.
+ *
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the  GNU General Public License for more details at: https://www.gnu.org/licenses/gpl-3.0.html
+ */
+/**
+ * @author TON Labs <connect@tonlabs.io>
+ * @date 2021
+ * Declarative peephole rules of the TVM optimizer
+ */
+
+#include <array>
+#include <cctype>
+#include <map>
+
+#include "TVMPeepholeRules.hpp"
+
+using namespace solidity::frontend;
+
+namespace {
+
+// The optimizer tries these rules before its hand-written ones, so a rule may only be added here
+// if none of the hand-written rules in TVMOptimizer::optimize_at can apply to the same commands.
+// The exceptions are the rules found by the superoptimizer: their replacements are proven to be
+// equivalent and shorter, which is at least as good as what a hand-written rule would do.
+std::vector<PeepholeRule> const peepholeRules = {
+	{"swap-sub",           {"SWAP", "SUB"},                            2, {"SUBR"}},
+	{"swap-subr",          {"SWAP", "SUBR"},                           2, {"SUB"}},
+	{"swap-swap",          {"SWAP", "SWAP"},                           2, {}},
+	{"swap-nip",           {"SWAP", "NIP"},                            2, {"DROP"}},
+	{"swap-commutative",   {"SWAP", "ADD"},                            1, {}},
+	{"swap-commutative",   {"SWAP", "MUL"},                            1, {}},
+	{"swap-commutative",   {"SWAP", "AND"},                            1, {}},
+	{"swap-commutative",   {"SWAP", "OR"},                             1, {}},
+	{"swap-commutative",   {"SWAP", "XOR"},                            1, {}},
+	{"swap-commutative",   {"SWAP", "EQUAL"},                          1, {}},
+	{"swap-commutative",   {"SWAP", "NEQ"},                            1, {}},
+	{"empty-if",           {"PUSHCONT", "}", "IF"},                    3, {"DROP"}},
+	{"empty-if",           {"PUSHCONT", "}", "IFNOT"},                 3, {"DROP"}},
+	{"empty-ifjmp",        {"PUSHCONT", "}", "IFJMP"},                 3, {"IFRET"}},
+	{"empty-ifnotjmp",     {"PUSHCONT", "}", "IFNOTJMP"},              3, {"IFNOTRET"}},
+	{"throw-if",           {"PUSHCONT", "THROW $1", "}", "IF"},        4, {"THROWIF $1"}},
+	{"throw-if",           {"PUSHCONT", "THROW $1", "}", "IFJMP"},     4, {"THROWIF $1"}},
+	{"throw-ifnot",        {"PUSHCONT", "THROW $1", "}", "IFNOT"},     4, {"THROWIFNOT $1"}},
+	{"throw-ifnot",        {"PUSHCONT", "THROW $1", "}", "IFNOTJMP"},  4, {"THROWIFNOT $1"}},
+	{"unused-isnull",      {"GETGLOB", "ISNULL", "DROP"},              3, {}},
+	{"not-throwifnot",     {"NOT", "THROWIFNOT $1"},                   2, {"THROWIF $1"}},
+	{"not-throwifnot",     {"EQINT 0", "THROWIFNOT $1"},               2, {"THROWIF $1"}},
+	{"neqint-throwifnot",  {"NEQINT 0", "THROWIFNOT $1"},              2, {"THROWIFNOT $1"}},
+	{"not-throwif",        {"NOT", "THROWIF $1"},                      2, {"THROWIFNOT $1"}},
+	{"rot-rotrev",         {"ROT", "ROTREV"},                          2, {}},
+	{"rot-rotrev",         {"ROTREV", "ROT"},                          2, {}},
+	{"pair-unpair",        {"PAIR", "UNPAIR"},                         2, {}},
+	{"rot-setglob-swap",   {"ROT", "SETGLOB $1", "SWAP"},              3, {"XCHG s2", "SETGLOB $1"}},
+	{"setglob-getglob",    {"SETGLOB $1", "GETGLOB $1"},               2, {"DUP", "SETGLOB $1"}},
+	{"rotrev-3",           {"ROTREV", "ROTREV", "ROTREV"},             3, {}},
+	{"mul-rshift",         {"MUL", "RSHIFT $1"},                       2, {"MULRSHIFT $1"}},
+	{"isnull-not-not",     {"ISNULL", "NOT", "NOT"},                   3, {"ISNULL"}},
+	{"abs-ufits",          {"ABS", "UFITS 256"},                       2, {"ABS"}},
+	{"bool-stir",          {"TRUE", "STIR 1"},                         2, {"STONE"}},
+	{"bool-stir",          {"FALSE", "STIR 1"},                        2, {"STZERO"}},
+	{"reverse-rotrev",     {"REVERSE 2, 1", "ROTREV"},                 2, {"XCHG S2"}},
+
+	// Stack manipulations with shorter equivalents, found by `solc --tvm-superoptimize 3`
+	{"superopt",           {"SWAP", "ROT"},                            2, {"XCHG S2"}},
+	{"superopt",           {"SWAP", "ROTREV"},                         2, {"XCHG S1, S2"}},
+	{"superopt",           {"SWAP", "DROP"},                           2, {"NIP"}},
+	{"superopt",           {"SWAP", "DROP2"},                          2, {"DROP2"}},
+	{"superopt",           {"SWAP", "XCHG S2"},                        2, {"ROT"}},
+	{"superopt",           {"SWAP", "XCHG S1, S2"},                    2, {"ROTREV"}},
+	{"superopt",           {"ROT", "SWAP"},                            2, {"XCHG S1, S2"}},
+	{"superopt",           {"ROT", "ROT"},                             2, {"ROTREV"}},
+	{"superopt",           {"ROT", "POP S2"},                          2, {"NIP"}},
+	{"superopt",           {"ROT", "XCHG S2"},                         2, {"SWAP"}},
+	{"superopt",           {"ROT", "XCHG S1, S2"},                     2, {"XCHG S2"}},
+	{"superopt",           {"ROTREV", "SWAP"},                         2, {"XCHG S2"}},
+	{"superopt",           {"ROTREV", "ROTREV"},                       2, {"ROT"}},
+	{"superopt",           {"ROTREV", "NIP"},                          2, {"POP S2"}},
+	{"superopt",           {"ROTREV", "XCHG S2"},                      2, {"XCHG S1, S2"}},
+	{"superopt",           {"ROTREV", "XCHG S1, S2"},                  2, {"SWAP"}},
+	{"superopt",           {"DUP", "SWAP"},                            2, {"DUP"}},
+	{"superopt",           {"DUP", "DROP"},                            2, {}},
+	{"superopt",           {"DUP", "DROP2"},                           2, {"DROP"}},
+	{"superopt",           {"DUP", "NIP"},                             2, {}},
+	{"superopt",           {"PUSH S1", "PUSH S1"},                     2, {"DUP2"}},
+	{"superopt",           {"PUSH S1", "DROP"},                        2, {}},
+	{"superopt",           {"PUSH S1", "DROP2"},                       2, {"DROP"}},
+	{"superopt",           {"PUSH S1", "POP S2"},                      2, {}},
+	{"superopt",           {"PUSH S1", "XCHG S2"},                     2, {"PUSH S1"}},
+	{"superopt",           {"PUSH S2", "DROP"},                        2, {}},
+	{"superopt",           {"PUSH S2", "DROP2"},                       2, {"DROP"}},
+	{"superopt",           {"PUSH S2", "POP S3"},                      2, {}},
+	{"superopt",           {"PUSH S2", "XCHG S3"},                     2, {"PUSH S2"}},
+	{"superopt",           {"PUSH S3", "DROP"},                        2, {}},
+	{"superopt",           {"PUSH S3", "DROP2"},                       2, {"DROP"}},
+	{"superopt",           {"DUP2", "DROP"},                           2, {"PUSH S1"}},
+	{"superopt",           {"DUP2", "DROP2"},                          2, {}},
+	{"superopt",           {"DUP2", "NIP"},                            2, {"DUP"}},
+	{"superopt",           {"DUP2", "POP S2"},                         2, {"PUSH S1"}},
+	{"superopt",           {"DUP2", "XCHG S2"},                        2, {"DUP2"}},
+	{"superopt",           {"DROP", "DROP"},                           2, {"DROP2"}},
+	{"superopt",           {"NIP", "DROP"},                            2, {"DROP2"}},
+	{"superopt",           {"XCHG S2", "SWAP"},                        2, {"ROTREV"}},
+	{"superopt",           {"XCHG S2", "ROT"},                         2, {"XCHG S1, S2"}},
+	{"superopt",           {"XCHG S2", "ROTREV"},                      2, {"SWAP"}},
+	{"superopt",           {"XCHG S2", "DROP"},                        2, {"POP S2"}},
+	{"superopt",           {"XCHG S2", "POP S2"},                      2, {"DROP"}},
+	{"superopt",           {"XCHG S2", "XCHG S2"},                     2, {}},
+	{"superopt",           {"XCHG S2", "XCHG S1, S2"},                 2, {"ROT"}},
+	{"superopt",           {"XCHG S3", "DROP"},                        2, {"POP S3"}},
+	{"superopt",           {"XCHG S3", "POP S3"},                      2, {"DROP"}},
+	{"superopt",           {"XCHG S3", "XCHG S3"},                     2, {}},
+	{"superopt",           {"XCHG S1, S2", "SWAP"},                    2, {"ROT"}},
+	{"superopt",           {"XCHG S1, S2", "ROT"},                     2, {"SWAP"}},
+	{"superopt",           {"XCHG S1, S2", "ROTREV"},                  2, {"XCHG S2"}},
+	{"superopt",           {"XCHG S1, S2", "XCHG S2"},                 2, {"ROTREV"}},
+	{"superopt",           {"XCHG S1, S2", "XCHG S1, S2"},             2, {}},
+	{"superopt",           {"SWAP", "DUP", "ROT"},                     3, {"PUSH S1", "SWAP"}},
+	{"superopt",           {"SWAP", "DUP", "ROTREV"},                  3, {"PUSH S1"}},
+	{"superopt",           {"SWAP", "DUP", "POP S2"},                  3, {"PUSH S1", "NIP"}},
+	{"superopt",           {"SWAP", "DUP", "XCHG S2"},                 3, {"PUSH S1", "SWAP"}},
+	{"superopt",           {"SWAP", "DUP", "XCHG S1, S2"},             3, {"PUSH S1"}},
+	{"superopt",           {"SWAP", "PUSH S1", "SWAP"},                3, {"DUP", "ROT"}},
+	{"superopt",           {"SWAP", "PUSH S1", "ROT"},                 3, {"DUP"}},
+	{"superopt",           {"SWAP", "PUSH S1", "ROTREV"},              3, {"DUP", "ROT"}},
+	{"superopt",           {"SWAP", "PUSH S1", "NIP"},                 3, {"DUP", "POP S2"}},
+	{"superopt",           {"SWAP", "PUSH S1", "XCHG S1, S2"},         3, {"DUP"}},
+	{"superopt",           {"SWAP", "PUSH S2", "SWAP"},                3, {"PUSH S2", "ROT"}},
+	{"superopt",           {"SWAP", "PUSH S2", "ROT"},                 3, {"PUSH S2", "SWAP"}},
+	{"superopt",           {"SWAP", "PUSH S2", "ROTREV"},              3, {"PUSH S2", "XCHG S2"}},
+	{"superopt",           {"SWAP", "PUSH S2", "NIP"},                 3, {"NIP", "PUSH S1"}},
+	{"superopt",           {"SWAP", "PUSH S2", "XCHG S2"},             3, {"PUSH S2", "ROTREV"}},
+	{"superopt",           {"SWAP", "PUSH S2", "XCHG S1, S2"},         3, {"PUSH S2"}},
+	{"superopt",           {"SWAP", "PUSH S3", "SWAP"},                3, {"PUSH S3", "ROT"}},
+	{"superopt",           {"SWAP", "PUSH S3", "ROT"},                 3, {"PUSH S3", "SWAP"}},
+	{"superopt",           {"SWAP", "PUSH S3", "ROTREV"},              3, {"PUSH S3", "XCHG S2"}},
+	{"superopt",           {"SWAP", "PUSH S3", "NIP"},                 3, {"NIP", "PUSH S2"}},
+	{"superopt",           {"SWAP", "PUSH S3", "XCHG S2"},             3, {"PUSH S3", "ROTREV"}},
+	{"superopt",           {"SWAP", "PUSH S3", "XCHG S1, S2"},         3, {"PUSH S3"}},
+	{"superopt",           {"SWAP", "DUP2", "ROT"},                    3, {"DUP2", "XCHG S3"}},
+	{"superopt",           {"SWAP", "DUP2", "POP S3"},                 3, {"PUSH S1", "SWAP"}},
+	{"superopt",           {"SWAP", "DUP2", "XCHG S3"},                3, {"DUP2", "ROT"}},
+	{"superopt",           {"SWAP", "DUP2", "XCHG S1, S2"},            3, {"DUP2", "XCHG S3"}},
+	{"superopt",           {"SWAP", "POP S2", "SWAP"},                 3, {"POP S2"}},
+	{"superopt",           {"SWAP", "POP S2", "ROT"},                  3, {"POP S2", "XCHG S2"}},
+	{"superopt",           {"SWAP", "POP S2", "ROTREV"},               3, {"POP S2", "XCHG S1, S2"}},
+	{"superopt",           {"SWAP", "POP S2", "DROP"},                 3, {"ROT", "DROP2"}},
+	{"superopt",           {"SWAP", "POP S2", "DROP2"},                3, {"DROP", "DROP2"}},
+	{"superopt",           {"SWAP", "POP S2", "NIP"},                  3, {"ROTREV", "DROP2"}},
+	{"superopt",           {"SWAP", "POP S2", "POP S2"},               3, {"POP S3", "NIP"}},
+	{"superopt",           {"SWAP", "POP S2", "XCHG S2"},              3, {"POP S2", "ROT"}},
+	{"superopt",           {"SWAP", "POP S2", "XCHG S1, S2"},          3, {"POP S2", "ROTREV"}},
+	{"superopt",           {"SWAP", "POP S2", "SETGLOB $1"},           3, {"SETGLOB $1", "NIP"}},
+	{"superopt",           {"SWAP", "POP S2", "STU $1"},               3, {"STU $1", "NIP"}},
+	{"superopt",           {"SWAP", "POP S3", "SWAP"},                 3, {"ROTREV", "POP S3"}},
+	{"superopt",           {"SWAP", "POP S3", "ROT"},                  3, {"POP S3", "XCHG S1, S2"}},
+	{"superopt",           {"SWAP", "POP S3", "ROTREV"},               3, {"POP S3", "SWAP"}},
+	{"superopt",           {"SWAP", "POP S3", "DROP"},                 3, {"DROP", "POP S2"}},
+	{"superopt",           {"SWAP", "POP S3", "NIP"},                  3, {"POP S2", "POP S2"}},
+	{"superopt",           {"SWAP", "POP S3", "POP S2"},               3, {"NIP", "POP S2"}},
+	{"superopt",           {"SWAP", "POP S3", "XCHG S2"},              3, {"POP S3"}},
+	{"superopt",           {"SWAP", "POP S3", "XCHG S1, S2"},          3, {"ROT", "POP S3"}},
+	{"superopt",           {"SWAP", "POP S3", "SETGLOB $1"},           3, {"SETGLOB $1", "POP S2"}},
+	{"superopt",           {"SWAP", "XCHG S3", "DROP2"},               3, {"DROP", "POP S2"}},
+	{"superopt",           {"SWAP", "XCHG S3", "NIP"},                 3, {"DROP", "XCHG S2"}},
+	{"superopt",           {"SWAP", "XCHG S3", "POP S2"},              3, {"POP S2", "ROTREV"}},
+	{"superopt",           {"SWAP", "XCHG S3", "XCHG S1, S2"},         3, {"ROTREV", "XCHG S3"}},
+	{"superopt",           {"SWAP", "NEWC", "SWAP"},                   3, {"NEWC", "ROT"}},
+	{"superopt",           {"SWAP", "NEWC", "ROT"},                    3, {"NEWC", "SWAP"}},
+	{"superopt",           {"SWAP", "NEWC", "ROTREV"},                 3, {"NEWC", "XCHG S2"}},
+	{"superopt",           {"SWAP", "NEWC", "NIP"},                    3, {"NIP", "NEWC"}},
+	{"superopt",           {"SWAP", "NEWC", "XCHG S2"},                3, {"NEWC", "ROTREV"}},
+	{"superopt",           {"SWAP", "NEWC", "XCHG S1, S2"},            3, {"NEWC"}},
+	{"superopt",           {"SWAP", "GETGLOB $1", "SWAP"},             3, {"GETGLOB $1", "ROT"}},
+	{"superopt",           {"SWAP", "GETGLOB $1", "ROT"},              3, {"GETGLOB $1", "SWAP"}},
+	{"superopt",           {"SWAP", "GETGLOB $1", "ROTREV"},           3, {"GETGLOB $1", "XCHG S2"}},
+	{"superopt",           {"SWAP", "GETGLOB $1", "NIP"},              3, {"NIP", "GETGLOB $1"}},
+	{"superopt",           {"SWAP", "GETGLOB $1", "XCHG S2"},          3, {"GETGLOB $1", "ROTREV"}},
+	{"superopt",           {"SWAP", "GETGLOB $1", "XCHG S1, S2"},      3, {"GETGLOB $1"}},
+	{"superopt",           {"SWAP", "SETGLOB $1", "SWAP"},             3, {"ROTREV", "SETGLOB $1"}},
+	{"superopt",           {"SWAP", "SETGLOB $1", "DROP"},             3, {"DROP", "SETGLOB $1"}},
+	{"superopt",           {"SWAP", "SETGLOB $1", "NIP"},              3, {"POP S2", "SETGLOB $1"}},
+	{"superopt",           {"SWAP", "SETGLOB $1", "POP S2"},           3, {"POP S3", "SETGLOB $1"}},
+	{"superopt",           {"SWAP", "STU $1", "NIP"},                  3, {"POP S2", "STU $1"}},
+	{"superopt",           {"ROT", "DUP", "ROTREV"},                   3, {"XCHG S1, S2", "PUSH S1"}},
+	{"superopt",           {"ROT", "DUP", "POP S3"},                   3, {"NIP", "PUSH S1"}},
+	{"superopt",           {"ROT", "DUP", "XCHG S3"},                  3, {"PUSH S2", "ROT"}},
+	{"superopt",           {"ROT", "DUP", "XCHG S1, S2"},              3, {"XCHG S1, S2", "PUSH S1"}},
+	{"superopt",           {"ROT", "PUSH S1", "ROT"},                  3, {"XCHG S1, S2", "DUP"}},
+	{"superopt",           {"ROT", "PUSH S1", "XCHG S1, S2"},          3, {"XCHG S1, S2", "DUP"}},
+	{"superopt",           {"ROT", "PUSH S2", "ROTREV"},               3, {"PUSH S1", "XCHG S3"}},
+	{"superopt",           {"ROT", "PUSH S2", "XCHG S1, S2"},          3, {"XCHG S1, S2", "PUSH S2"}},
+	{"superopt",           {"ROT", "PUSH S3", "XCHG S1, S2"},          3, {"XCHG S1, S2", "PUSH S3"}},
+	{"superopt",           {"ROT", "DROP", "SWAP"},                    3, {"POP S2"}},
+	{"superopt",           {"ROT", "DROP", "ROT"},                     3, {"POP S2", "XCHG S2"}},
+	{"superopt",           {"ROT", "DROP", "ROTREV"},                  3, {"POP S2", "XCHG S1, S2"}},
+	{"superopt",           {"ROT", "DROP", "DROP2"},                   3, {"DROP", "DROP2"}},
+	{"superopt",           {"ROT", "DROP", "NIP"},                     3, {"ROTREV", "DROP2"}},
+	{"superopt",           {"ROT", "DROP", "POP S2"},                  3, {"POP S3", "NIP"}},
+	{"superopt",           {"ROT", "DROP", "XCHG S2"},                 3, {"POP S2", "ROT"}},
+	{"superopt",           {"ROT", "DROP", "XCHG S1, S2"},             3, {"POP S2", "ROTREV"}},
+	{"superopt",           {"ROT", "DROP", "SETGLOB $1"},              3, {"SETGLOB $1", "NIP"}},
+	{"superopt",           {"ROT", "DROP", "STU $1"},                  3, {"STU $1", "NIP"}},
+	{"superopt",           {"ROT", "DROP2", "DROP"},                   3, {"DROP", "DROP2"}},
+	{"superopt",           {"ROT", "DROP2", "DROP2"},                  3, {"DROP2", "DROP2"}},
+	{"superopt",           {"ROT", "NIP", "SWAP"},                     3, {"DROP"}},
+	{"superopt",           {"ROT", "NIP", "ROT"},                      3, {"DROP", "XCHG S2"}},
+	{"superopt",           {"ROT", "NIP", "ROTREV"},                   3, {"DROP", "XCHG S1, S2"}},
+	{"superopt",           {"ROT", "NIP", "DROP2"},                    3, {"DROP", "DROP2"}},
+	{"superopt",           {"ROT", "NIP", "NIP"},                      3, {"DROP2"}},
+	{"superopt",           {"ROT", "NIP", "XCHG S2"},                  3, {"DROP", "ROT"}},
+	{"superopt",           {"ROT", "NIP", "XCHG S1, S2"},              3, {"DROP", "ROTREV"}},
+	{"superopt",           {"ROT", "POP S3", "SWAP"},                  3, {"POP S3", "XCHG S1, S2"}},
+	{"superopt",           {"ROT", "POP S3", "ROT"},                   3, {"ROTREV", "POP S3"}},
+	{"superopt",           {"ROT", "POP S3", "ROTREV"},                3, {"POP S3"}},
+	{"superopt",           {"ROT", "POP S3", "DROP2"},                 3, {"DROP2", "NIP"}},
+	{"superopt",           {"ROT", "POP S3", "POP S2"},                3, {"POP S3", "NIP"}},
+	{"superopt",           {"ROT", "POP S3", "XCHG S2"},               3, {"POP S3", "SWAP"}},
+	{"superopt",           {"ROT", "POP S3", "XCHG S1, S2"},           3, {"SWAP", "POP S3"}},
+	{"superopt",           {"ROT", "XCHG S3", "NIP"},                  3, {"DROP", "ROT"}},
+	{"superopt",           {"ROT", "XCHG S3", "POP S2"},               3, {"NIP", "XCHG S1, S2"}},
+	{"superopt",           {"ROT", "XCHG S3", "XCHG S1, S2"},          3, {"XCHG S2", "XCHG S3"}},
+	{"superopt",           {"ROT", "NEWC", "XCHG S1, S2"},             3, {"XCHG S1, S2", "NEWC"}},
+	{"superopt",           {"ROT", "GETGLOB $1", "XCHG S1, S2"},       3, {"XCHG S1, S2", "GETGLOB $1"}},
+	{"superopt",           {"ROT", "SETGLOB $1", "DROP2"},             3, {"DROP2", "SETGLOB $1"}},
+	{"superopt",           {"ROTREV", "DUP", "ROTREV"},                3, {"XCHG S2", "PUSH S1"}},
+	{"superopt",           {"ROTREV", "DUP", "POP S2"},                3, {"POP S2", "DUP"}},
+	{"superopt",           {"ROTREV", "DUP", "XCHG S1, S2"},           3, {"XCHG S2", "PUSH S1"}},
+	{"superopt",           {"ROTREV", "PUSH S1", "ROT"},               3, {"XCHG S2", "DUP"}},
+	{"superopt",           {"ROTREV", "PUSH S1", "XCHG S3"},           3, {"PUSH S2", "ROTREV"}},
+	{"superopt",           {"ROTREV", "PUSH S1", "XCHG S1, S2"},       3, {"XCHG S2", "DUP"}},
+	{"superopt",           {"ROTREV", "PUSH S2", "ROT"},               3, {"DUP", "XCHG S3"}},
+	{"superopt",           {"ROTREV", "PUSH S2", "XCHG S1, S2"},       3, {"XCHG S2", "PUSH S2"}},
+	{"superopt",           {"ROTREV", "PUSH S3", "XCHG S1, S2"},       3, {"XCHG S2", "PUSH S3"}},
+	{"superopt",           {"ROTREV", "DROP", "SWAP"},                 3, {"NIP"}},
+	{"superopt",           {"ROTREV", "DROP", "ROT"},                  3, {"NIP", "XCHG S2"}},
+	{"superopt",           {"ROTREV", "DROP", "ROTREV"},               3, {"NIP", "XCHG S1, S2"}},
+	{"superopt",           {"ROTREV", "DROP", "DROP2"},                3, {"DROP", "DROP2"}},
+	{"superopt",           {"ROTREV", "DROP", "NIP"},                  3, {"DROP2"}},
+	{"superopt",           {"ROTREV", "DROP", "XCHG S2"},              3, {"NIP", "ROT"}},
+	{"superopt",           {"ROTREV", "DROP", "XCHG S1, S2"},          3, {"NIP", "ROTREV"}},
+	{"superopt",           {"ROTREV", "DROP2", "DROP"},                3, {"DROP", "DROP2"}},
+	{"superopt",           {"ROTREV", "DROP2", "DROP2"},               3, {"DROP2", "DROP2"}},
+	{"superopt",           {"ROTREV", "DROP2", "NIP"},                 3, {"POP S3", "DROP2"}},
+	{"superopt",           {"ROTREV", "DROP2", "SETGLOB $1"},          3, {"SETGLOB $1", "DROP2"}},
+	{"superopt",           {"ROTREV", "POP S2", "SWAP"},               3, {"DROP"}},
+	{"superopt",           {"ROTREV", "POP S2", "ROT"},                3, {"DROP", "XCHG S2"}},
+	{"superopt",           {"ROTREV", "POP S2", "ROTREV"},             3, {"DROP", "XCHG S1, S2"}},
+	{"superopt",           {"ROTREV", "POP S2", "DROP"},               3, {"ROT", "DROP2"}},
+	{"superopt",           {"ROTREV", "POP S2", "DROP2"},              3, {"DROP", "DROP2"}},
+	{"superopt",           {"ROTREV", "POP S2", "NIP"},                3, {"DROP2"}},
+	{"superopt",           {"ROTREV", "POP S2", "XCHG S2"},            3, {"DROP", "ROT"}},
+	{"superopt",           {"ROTREV", "POP S2", "XCHG S1, S2"},        3, {"DROP", "ROTREV"}},
+	{"superopt",           {"ROTREV", "POP S3", "SWAP"},               3, {"SWAP", "POP S3"}},
+	{"superopt",           {"ROTREV", "POP S3", "ROT"},                3, {"POP S3"}},
+	{"superopt",           {"ROTREV", "POP S3", "ROTREV"},             3, {"ROT", "POP S3"}},
+	{"superopt",           {"ROTREV", "POP S3", "DROP"},               3, {"POP S2", "POP S2"}},
+	{"superopt",           {"ROTREV", "POP S3", "NIP"},                3, {"DROP", "POP S2"}},
+	{"superopt",           {"ROTREV", "POP S3", "XCHG S2"},            3, {"POP S3", "XCHG S1, S2"}},
+	{"superopt",           {"ROTREV", "POP S3", "XCHG S1, S2"},        3, {"POP S3", "SWAP"}},
+	{"superopt",           {"ROTREV", "XCHG S3", "DROP2"},             3, {"POP S2", "POP S2"}},
+	{"superopt",           {"ROTREV", "XCHG S3", "NIP"},               3, {"POP S2", "XCHG S2"}},
+	{"superopt",           {"ROTREV", "XCHG S3", "POP S2"},            3, {"DROP", "ROTREV"}},
+	{"superopt",           {"ROTREV", "XCHG S3", "XCHG S1, S2"},       3, {"SWAP", "XCHG S3"}},
+	{"superopt",           {"ROTREV", "NEWC", "XCHG S1, S2"},          3, {"XCHG S2", "NEWC"}},
+	{"superopt",           {"ROTREV", "GETGLOB $1", "XCHG S1, S2"},    3, {"XCHG S2", "GETGLOB $1"}},
+	{"superopt",           {"ROTREV", "SETGLOB $1", "SWAP"},           3, {"SWAP", "SETGLOB $1"}},
+	{"superopt",           {"ROTREV", "SETGLOB $1", "DROP"},           3, {"POP S2", "SETGLOB $1"}},
+	{"superopt",           {"ROTREV", "SETGLOB $1", "NIP"},            3, {"DROP", "SETGLOB $1"}},
+	{"superopt",           {"ROTREV", "STU $1", "NIP"},                3, {"DROP", "STU $1"}},
+	{"superopt",           {"DUP", "ROT", "DUP"},                      3, {"DUP2", "XCHG S3"}},
+	{"superopt",           {"DUP", "ROT", "DROP"},                     3, {"DUP", "POP S2"}},
+	{"superopt",           {"DUP", "ROT", "DROP2"},                    3, {"NIP"}},
+	{"superopt",           {"DUP", "ROT", "NIP"},                      3, {"SWAP"}},
+	{"superopt",           {"DUP", "ROTREV", "PUSH S1"},               3, {"SWAP", "DUP2"}},
+	{"superopt",           {"DUP", "ROTREV", "DROP"},                  3, {"SWAP"}},
+	{"superopt",           {"DUP", "ROTREV", "DROP2"},                 3, {"NIP"}},
+	{"superopt",           {"DUP", "ROTREV", "POP S2"},                3, {"SWAP"}},
+	{"superopt",           {"DUP", "DUP", "ROT"},                      3, {"DUP", "DUP"}},
+	{"superopt",           {"DUP", "DUP", "ROTREV"},                   3, {"DUP", "DUP"}},
+	{"superopt",           {"DUP", "DUP", "DUP"},                      3, {"DUP", "DUP2"}},
+	{"superopt",           {"DUP", "DUP", "PUSH S1"},                  3, {"DUP", "DUP2"}},
+	{"superopt",           {"DUP", "DUP", "PUSH S2"},                  3, {"DUP", "DUP2"}},
+	{"superopt",           {"DUP", "DUP", "POP S2"},                   3, {"DUP"}},
+	{"superopt",           {"DUP", "DUP", "XCHG S2"},                  3, {"DUP", "DUP"}},
+	{"superopt",           {"DUP", "DUP", "XCHG S1, S2"},              3, {"DUP", "DUP"}},
+	{"superopt",           {"DUP", "PUSH S1", "SWAP"},                 3, {"DUP", "DUP"}},
+	{"superopt",           {"DUP", "PUSH S1", "ROT"},                  3, {"DUP", "DUP"}},
+	{"superopt",           {"DUP", "PUSH S1", "ROTREV"},               3, {"DUP", "DUP"}},
+	{"superopt",           {"DUP", "PUSH S1", "DUP"},                  3, {"DUP", "DUP2"}},
+	{"superopt",           {"DUP", "PUSH S1", "PUSH S2"},              3, {"DUP", "DUP2"}},
+	{"superopt",           {"DUP", "PUSH S1", "NIP"},                  3, {"DUP"}},
+	{"superopt",           {"DUP", "PUSH S1", "XCHG S1, S2"},          3, {"DUP", "DUP"}},
+	{"superopt",           {"DUP", "PUSH S2", "SWAP"},                 3, {"DUP2"}},
+	{"superopt",           {"DUP", "PUSH S2", "ROT"},                  3, {"DUP2"}},
+	{"superopt",           {"DUP", "PUSH S2", "ROTREV"},               3, {"DUP2", "ROT"}},
+	{"superopt",           {"DUP", "PUSH S2", "NIP"},                  3, {"PUSH S1"}},
+	{"superopt",           {"DUP", "PUSH S2", "POP S2"},               3, {"PUSH S1", "SWAP"}},
+	{"superopt",           {"DUP", "PUSH S2", "XCHG S2"},              3, {"DUP2", "ROT"}},
+	{"superopt",           {"DUP", "PUSH S2", "XCHG S1, S2"},          3, {"DUP", "PUSH S2"}},
+	{"superopt",           {"DUP", "PUSH S3", "SWAP"},                 3, {"PUSH S2", "PUSH S1"}},
+	{"superopt",           {"DUP", "PUSH S3", "ROT"},                  3, {"PUSH S2", "PUSH S1"}},
+	{"superopt",           {"DUP", "PUSH S3", "NIP"},                  3, {"PUSH S2"}},
+	{"superopt",           {"DUP", "PUSH S3", "POP S2"},               3, {"PUSH S2", "SWAP"}},
+	{"superopt",           {"DUP", "PUSH S3", "XCHG S1, S2"},          3, {"DUP", "PUSH S3"}},
+	{"superopt",           {"DUP", "DUP2", "SWAP"},                    3, {"DUP", "DUP2"}},
+	{"superopt",           {"DUP", "DUP2", "ROT"},                     3, {"DUP", "DUP2"}},
+	{"superopt",           {"DUP", "DUP2", "ROTREV"},                  3, {"DUP", "DUP2"}},
+	{"superopt",           {"DUP", "DUP2", "POP S3"},                  3, {"DUP", "DUP"}},
+	{"superopt",           {"DUP", "DUP2", "XCHG S3"},                 3, {"DUP", "DUP2"}},
+	{"superopt",           {"DUP", "DUP2", "XCHG S1, S2"},             3, {"DUP", "DUP2"}},
+	{"superopt",           {"DUP", "POP S2", "SWAP"},                  3, {"DUP", "POP S2"}},
+	{"superopt",           {"DUP", "POP S2", "DROP"},                  3, {"NIP"}},
+	{"superopt",           {"DUP", "POP S2", "DROP2"},                 3, {"DROP2"}},
+	{"superopt",           {"DUP", "POP S2", "NIP"},                   3, {"NIP"}},
+	{"superopt",           {"DUP", "POP S3", "PUSH S1"},               3, {"POP S2", "DUP2"}},
+	{"superopt",           {"DUP", "POP S3", "DROP"},                  3, {"POP S2"}},
+	{"superopt",           {"DUP", "POP S3", "DROP2"},                 3, {"ROTREV", "DROP2"}},
+	{"superopt",           {"DUP", "POP S3", "POP S2"},                3, {"POP S2"}},
+	{"superopt",           {"DUP", "POP S3", "XCHG S2"},               3, {"DUP", "POP S3"}},
+	{"superopt",           {"DUP", "XCHG S2", "DUP"},                  3, {"DUP2", "XCHG S3"}},
+	{"superopt",           {"DUP", "XCHG S2", "DROP2"},                3, {"NIP"}},
+	{"superopt",           {"DUP", "XCHG S2", "NIP"},                  3, {"SWAP"}},
+	{"superopt",           {"DUP", "XCHG S3", "SWAP"},                 3, {"XCHG S2", "PUSH S2"}},
+	{"superopt",           {"DUP", "XCHG S3", "ROTREV"},               3, {"ROTREV", "PUSH S2"}},
+	{"superopt",           {"DUP", "XCHG S3", "DROP2"},                3, {"POP S2"}},
+	{"superopt",           {"DUP", "XCHG S3", "NIP"},                  3, {"XCHG S2"}},
+	{"superopt",           {"DUP", "XCHG S1, S2", "PUSH S1"},          3, {"SWAP", "DUP2"}},
+	{"superopt",           {"DUP", "XCHG S1, S2", "DROP"},             3, {"SWAP"}},
+	{"superopt",           {"DUP", "XCHG S1, S2", "DROP2"},            3, {"NIP"}},
+	{"superopt",           {"DUP", "XCHG S1, S2", "NIP"},              3, {"DUP", "POP S2"}},
+	{"superopt",           {"DUP", "XCHG S1, S2", "POP S2"},           3, {"SWAP"}},
+	{"superopt",           {"DUP", "NEWC", "SWAP"},                    3, {"NEWC", "PUSH S1"}},
+	{"superopt",           {"DUP", "NEWC", "ROT"},                     3, {"NEWC", "PUSH S1"}},
+	{"superopt",           {"DUP", "NEWC", "DROP2"},                   3, {"NEWC", "DROP"}},
+	{"superopt",           {"DUP", "NEWC", "NIP"},                     3, {"NEWC"}},
+	{"superopt",           {"DUP", "NEWC", "POP S2"},                  3, {"NEWC", "SWAP"}},
+	{"superopt",           {"DUP", "NEWC", "XCHG S1, S2"},             3, {"DUP", "NEWC"}},
+	{"superopt",           {"DUP", "GETGLOB $1", "SWAP"},              3, {"GETGLOB $1", "PUSH S1"}},
+	{"superopt",           {"DUP", "GETGLOB $1", "ROT"},               3, {"GETGLOB $1", "PUSH S1"}},
+	{"superopt",           {"DUP", "GETGLOB $1", "DROP2"},             3, {"GETGLOB $1", "DROP"}},
+	{"superopt",           {"DUP", "GETGLOB $1", "NIP"},               3, {"GETGLOB $1"}},
+	{"superopt",           {"DUP", "GETGLOB $1", "POP S2"},            3, {"GETGLOB $1", "SWAP"}},
+	{"superopt",           {"DUP", "GETGLOB $1", "XCHG S1, S2"},       3, {"DUP", "GETGLOB $1"}},
+	{"superopt",           {"DUP", "SETGLOB $1", "PUSH S1"},           3, {"DUP2", "SETGLOB $1"}},
+	{"superopt",           {"DUP", "SETGLOB $1", "DROP"},              3, {"SETGLOB $1"}},
+	{"superopt",           {"DUP", "SETGLOB $1", "DROP2"},             3, {"NIP", "SETGLOB $1"}},
+	{"superopt",           {"PUSH S1", "SWAP", "DUP"},                 3, {"DUP2", "ROT"}},
+	{"superopt",           {"PUSH S1", "SWAP", "POP S2"},              3, {"SWAP"}},
+	{"superopt",           {"PUSH S1", "SWAP", "POP S3"},              3, {"POP S2", "DUP"}},
+	{"superopt",           {"PUSH S1", "SWAP", "SETGLOB $1"},          3, {"SETGLOB $1", "DUP"}},
+	{"superopt",           {"PUSH S1", "ROT", "DROP"},                 3, {"SWAP"}},
+	{"superopt",           {"PUSH S1", "ROT", "DROP2"},                3, {"NIP"}},
+	{"superopt",           {"PUSH S1", "ROT", "NIP"},                  3, {"SWAP"}},
+	{"superopt",           {"PUSH S1", "ROTREV", "DUP"},               3, {"DUP2", "ROT"}},
+	{"superopt",           {"PUSH S1", "ROTREV", "DROP"},              3, {"PUSH S1", "NIP"}},
+	{"superopt",           {"PUSH S1", "ROTREV", "DROP2"},             3, {"DROP"}},
+	{"superopt",           {"PUSH S1", "ROTREV", "POP S2"},            3, {"SWAP"}},
+	{"superopt",           {"PUSH S1", "ROTREV", "POP S3"},            3, {"POP S2", "DUP"}},
+	{"superopt",           {"PUSH S1", "ROTREV", "SETGLOB $1"},        3, {"SETGLOB $1", "DUP"}},
+	{"superopt",           {"PUSH S1", "DUP", "POP S3"},               3, {"PUSH S1"}},
+	{"superopt",           {"PUSH S1", "DUP", "XCHG S3"},              3, {"PUSH S1", "DUP"}},
+	{"superopt",           {"PUSH S1", "PUSH S2", "SWAP"},             3, {"PUSH S1", "DUP"}},
+	{"superopt",           {"PUSH S1", "PUSH S2", "NIP"},              3, {"PUSH S1"}},
+	{"superopt",           {"PUSH S1", "PUSH S3", "SWAP"},             3, {"PUSH S2", "PUSH S2"}},
+	{"superopt",           {"PUSH S1", "PUSH S3", "NIP"},              3, {"PUSH S2"}},
+	{"superopt",           {"PUSH S1", "PUSH S3", "POP S2"},           3, {"DROP", "DUP2"}},
+	{"superopt",           {"PUSH S1", "PUSH S3", "POP S3"},           3, {"PUSH S2", "XCHG S2"}},
+	{"superopt",           {"PUSH S1", "DUP2", "PUSH S1"},             3, {"DUP2", "DUP2"}},
+	{"superopt",           {"PUSH S1", "DUP2", "PUSH S3"},             3, {"DUP2", "DUP2"}},
+	{"superopt",           {"PUSH S1", "NIP", "SWAP"},                 3, {"PUSH S1", "NIP"}},
+	{"superopt",           {"PUSH S1", "NIP", "DROP2"},                3, {"DROP2"}},
+	{"superopt",           {"PUSH S1", "NIP", "NIP"},                  3, {"DROP"}},
+	{"superopt",           {"PUSH S1", "POP S3", "ROTREV"},            3, {"POP S2", "DUP"}},
+	{"superopt",           {"PUSH S1", "POP S3", "DROP2"},             3, {"ROT", "DROP2"}},
+	{"superopt",           {"PUSH S1", "POP S3", "NIP"},               3, {"SWAP", "POP S2"}},
+	{"superopt",           {"PUSH S1", "POP S3", "POP S2"},            3, {"POP S2"}},
+	{"superopt",           {"PUSH S1", "POP S3", "XCHG S2"},           3, {"POP S2", "DUP"}},
+	{"superopt",           {"PUSH S1", "POP S3", "XCHG S1, S2"},       3, {"PUSH S1", "POP S3"}},
+	{"superopt",           {"PUSH S1", "XCHG S3", "ROT"},              3, {"ROT", "PUSH S2"}},
+	{"superopt",           {"PUSH S1", "XCHG S3", "POP S2"},           3, {"XCHG S1, S2"}},
+	{"superopt",           {"PUSH S1", "XCHG S3", "XCHG S2"},          3, {"XCHG S1, S2", "PUSH S2"}},
+	{"superopt",           {"PUSH S1", "XCHG S1, S2", "DROP"},         3, {"SWAP"}},
+	{"superopt",           {"PUSH S1", "XCHG S1, S2", "DROP2"},        3, {"NIP"}},
+	{"superopt",           {"PUSH S1", "XCHG S1, S2", "NIP"},          3, {"SWAP"}},
+	{"superopt",           {"PUSH S1", "XCHG S1, S2", "POP S2"},       3, {"PUSH S1", "NIP"}},
+	{"superopt",           {"PUSH S1", "NEWC", "SWAP"},                3, {"NEWC", "PUSH S2"}},
+	{"superopt",           {"PUSH S1", "NEWC", "DROP2"},               3, {"NEWC", "DROP"}},
+	{"superopt",           {"PUSH S1", "NEWC", "NIP"},                 3, {"NEWC"}},
+	{"superopt",           {"PUSH S1", "NEWC", "POP S3"},              3, {"NEWC", "XCHG S2"}},
+	{"superopt",           {"PUSH S1", "GETGLOB $1", "SWAP"},          3, {"GETGLOB $1", "PUSH S2"}},
+	{"superopt",           {"PUSH S1", "GETGLOB $1", "DROP2"},         3, {"GETGLOB $1", "DROP"}},
+	{"superopt",           {"PUSH S1", "GETGLOB $1", "NIP"},           3, {"GETGLOB $1"}},
+	{"superopt",           {"PUSH S1", "GETGLOB $1", "POP S3"},        3, {"GETGLOB $1", "XCHG S2"}},
+	{"superopt",           {"PUSH S1", "SETGLOB $1", "DROP2"},         3, {"DROP", "SETGLOB $1"}},
+	{"superopt",           {"PUSH S1", "SETGLOB $1", "NIP"},           3, {"SWAP", "SETGLOB $1"}},
+	{"superopt",           {"PUSH S1", "STU $1", "NIP"},               3, {"SWAP", "STU $1"}},
+	{"superopt",           {"PUSH S2", "SWAP", "POP S2"},              3, {"NIP", "PUSH S1"}},
+	{"superopt",           {"PUSH S2", "SWAP", "POP S3"},              3, {"XCHG S2"}},
+	{"superopt",           {"PUSH S2", "SWAP", "XCHG S3"},             3, {"XCHG S2", "DUP"}},
+	{"superopt",           {"PUSH S2", "SWAP", "SETGLOB $1"},          3, {"SETGLOB $1", "PUSH S1"}},
+	{"superopt",           {"PUSH S2", "ROT", "DROP"},                 3, {"NIP", "PUSH S1"}},
+	{"superopt",           {"PUSH S2", "ROT", "DROP2"},                3, {"NIP"}},
+	{"superopt",           {"PUSH S2", "ROT", "NIP"},                  3, {"SWAP"}},
+	{"superopt",           {"PUSH S2", "ROT", "POP S3"},               3, {"ROT"}},
+	{"superopt",           {"PUSH S2", "ROT", "XCHG S3"},              3, {"ROT", "DUP"}},
+	{"superopt",           {"PUSH S2", "ROTREV", "DROP2"},             3, {"DROP2", "DUP"}},
+	{"superopt",           {"PUSH S2", "ROTREV", "POP S2"},            3, {"SWAP"}},
+	{"superopt",           {"PUSH S2", "ROTREV", "POP S3"},            3, {"ROTREV"}},
+	{"superopt",           {"PUSH S2", "ROTREV", "XCHG S3"},           3, {"ROTREV", "PUSH S1"}},
+	{"superopt",           {"PUSH S2", "PUSH S1", "SWAP"},             3, {"DUP", "PUSH S3"}},
+	{"superopt",           {"PUSH S2", "PUSH S1", "ROTREV"},           3, {"DUP", "PUSH S3"}},
+	{"superopt",           {"PUSH S2", "PUSH S1", "NIP"},              3, {"DUP"}},
+	{"superopt",           {"PUSH S2", "PUSH S2", "SWAP"},             3, {"PUSH S1", "PUSH S3"}},
+	{"superopt",           {"PUSH S2", "PUSH S2", "NIP"},              3, {"PUSH S1"}},
+	{"superopt",           {"PUSH S2", "PUSH S3", "SWAP"},             3, {"PUSH S2", "DUP"}},
+	{"superopt",           {"PUSH S2", "PUSH S3", "NIP"},              3, {"PUSH S2"}},
+	{"superopt",           {"PUSH S2", "NIP", "PUSH S1"},              3, {"DROP", "DUP2"}},
+	{"superopt",           {"PUSH S2", "NIP", "DROP2"},                3, {"DROP2"}},
+	{"superopt",           {"PUSH S2", "NIP", "NIP"},                  3, {"DROP2", "DUP"}},
+	{"superopt",           {"PUSH S2", "NIP", "POP S2"},               3, {"DROP"}},
+	{"superopt",           {"PUSH S2", "NIP", "XCHG S2"},              3, {"PUSH S2", "NIP"}},
+	{"superopt",           {"PUSH S2", "POP S2", "SWAP"},              3, {"NIP", "PUSH S1"}},
+	{"superopt",           {"PUSH S2", "POP S2", "ROT"},               3, {"NIP", "PUSH S1"}},
+	{"superopt",           {"PUSH S2", "POP S2", "DROP"},              3, {"DROP2", "DUP"}},
+	{"superopt",           {"PUSH S2", "POP S2", "DROP2"},             3, {"DROP2"}},
+	{"superopt",           {"PUSH S2", "POP S2", "NIP"},               3, {"NIP"}},
+	{"superopt",           {"PUSH S2", "POP S2", "POP S2"},            3, {"ROTREV", "DROP"}},
+	{"superopt",           {"PUSH S2", "POP S2", "XCHG S1, S2"},       3, {"PUSH S2", "POP S2"}},
+	{"superopt",           {"PUSH S2", "XCHG S2", "DROP2"},            3, {"DROP2", "DUP"}},
+	{"superopt",           {"PUSH S2", "XCHG S2", "POP S3"},           3, {"XCHG S1, S2"}},
+	{"superopt",           {"PUSH S2", "XCHG S2", "XCHG S3"},          3, {"XCHG S1, S2", "PUSH S1"}},
+	{"superopt",           {"PUSH S2", "XCHG S1, S2", "DROP"},         3, {"SWAP"}},
+	{"superopt",           {"PUSH S2", "XCHG S1, S2", "DROP2"},        3, {"NIP"}},
+	{"superopt",           {"PUSH S2", "XCHG S1, S2", "NIP"},          3, {"NIP", "PUSH S1"}},
+	{"superopt",           {"PUSH S2", "XCHG S1, S2", "POP S3"},       3, {"SWAP"}},
+	{"superopt",           {"PUSH S2", "XCHG S1, S2", "XCHG S3"},      3, {"SWAP", "PUSH S2"}},
+	{"superopt",           {"PUSH S2", "NEWC", "SWAP"},                3, {"NEWC", "PUSH S3"}},
+	{"superopt",           {"PUSH S2", "NEWC", "DROP2"},               3, {"NEWC", "DROP"}},
+	{"superopt",           {"PUSH S2", "NEWC", "NIP"},                 3, {"NEWC"}},
+	{"superopt",           {"PUSH S2", "GETGLOB $1", "SWAP"},          3, {"GETGLOB $1", "PUSH S3"}},
+	{"superopt",           {"PUSH S2", "GETGLOB $1", "DROP2"},         3, {"GETGLOB $1", "DROP"}},
+	{"superopt",           {"PUSH S2", "GETGLOB $1", "NIP"},           3, {"GETGLOB $1"}},
+	{"superopt",           {"PUSH S2", "SETGLOB $1", "POP S2"},        3, {"XCHG S2", "SETGLOB $1"}},
+	{"superopt",           {"PUSH S3", "SWAP", "POP S2"},              3, {"NIP", "PUSH S2"}},
+	{"superopt",           {"PUSH S3", "SWAP", "POP S3"},              3, {"POP S2", "PUSH S2"}},
+	{"superopt",           {"PUSH S3", "SWAP", "SETGLOB $1"},          3, {"SETGLOB $1", "PUSH S2"}},
+	{"superopt",           {"PUSH S3", "ROT", "DROP"},                 3, {"NIP", "PUSH S2"}},
+	{"superopt",           {"PUSH S3", "ROT", "DROP2"},                3, {"NIP"}},
+	{"superopt",           {"PUSH S3", "ROT", "NIP"},                  3, {"SWAP"}},
+	{"superopt",           {"PUSH S3", "ROTREV", "DROP2"},             3, {"DROP2", "PUSH S1"}},
+	{"superopt",           {"PUSH S3", "ROTREV", "POP S2"},            3, {"SWAP"}},
+	{"superopt",           {"PUSH S3", "PUSH S1", "NIP"},              3, {"DUP"}},
+	{"superopt",           {"PUSH S3", "PUSH S2", "NIP"},              3, {"PUSH S1"}},
+	{"superopt",           {"PUSH S3", "PUSH S3", "NIP"},              3, {"PUSH S2"}},
+	{"superopt",           {"PUSH S3", "NIP", "DROP2"},                3, {"DROP2"}},
+	{"superopt",           {"PUSH S3", "NIP", "NIP"},                  3, {"DROP2", "PUSH S1"}},
+	{"superopt",           {"PUSH S3", "NIP", "POP S3"},               3, {"DROP"}},
+	{"superopt",           {"PUSH S3", "NIP", "XCHG S3"},              3, {"PUSH S3", "NIP"}},
+	{"superopt",           {"PUSH S3", "POP S2", "SWAP"},              3, {"NIP", "PUSH S2"}},
+	{"superopt",           {"PUSH S3", "POP S2", "DROP"},              3, {"DROP2", "PUSH S1"}},
+	{"superopt",           {"PUSH S3", "POP S2", "DROP2"},             3, {"DROP2"}},
+	{"superopt",           {"PUSH S3", "POP S2", "NIP"},               3, {"NIP"}},
+	{"superopt",           {"PUSH S3", "POP S2", "POP S3"},            3, {"NIP", "XCHG S2"}},
+	{"superopt",           {"PUSH S3", "POP S3", "POP S2"},            3, {"POP S2"}},
+	{"superopt",           {"PUSH S3", "POP S3", "POP S3"},            3, {"POP S2", "XCHG S1, S2"}},
+	{"superopt",           {"PUSH S3", "POP S3", "XCHG S2"},           3, {"POP S2", "PUSH S2"}},
+	{"superopt",           {"PUSH S3", "XCHG S2", "DROP2"},            3, {"DROP2", "PUSH S1"}},
+	{"superopt",           {"PUSH S3", "XCHG S1, S2", "DROP"},         3, {"SWAP"}},
+	{"superopt",           {"PUSH S3", "XCHG S1, S2", "DROP2"},        3, {"NIP"}},
+	{"superopt",           {"PUSH S3", "XCHG S1, S2", "NIP"},          3, {"NIP", "PUSH S2"}},
+	{"superopt",           {"PUSH S3", "NEWC", "DROP2"},               3, {"NEWC", "DROP"}},
+	{"superopt",           {"PUSH S3", "NEWC", "NIP"},                 3, {"NEWC"}},
+	{"superopt",           {"PUSH S3", "GETGLOB $1", "DROP2"},         3, {"GETGLOB $1", "DROP"}},
+	{"superopt",           {"PUSH S3", "GETGLOB $1", "NIP"},           3, {"GETGLOB $1"}},
+	{"superopt",           {"PUSH S3", "SETGLOB $1", "POP S3"},        3, {"XCHG S3", "SETGLOB $1"}},
+	{"superopt",           {"DUP2", "SWAP", "POP S2"},                 3, {"PUSH S1", "SWAP"}},
+	{"superopt",           {"DUP2", "SWAP", "POP S3"},                 3, {"DUP"}},
+	{"superopt",           {"DUP2", "SWAP", "XCHG S3"},                3, {"DUP", "PUSH S2"}},
+	{"superopt",           {"DUP2", "ROT", "DROP"},                    3, {"PUSH S1", "SWAP"}},
+	{"superopt",           {"DUP2", "ROT", "DROP2"},                   3, {"PUSH S1", "NIP"}},
+	{"superopt",           {"DUP2", "ROT", "NIP"},                     3, {"PUSH S1", "SWAP"}},
+	{"superopt",           {"DUP2", "ROT", "POP S3"},                  3, {"SWAP", "PUSH S1"}},
+	{"superopt",           {"DUP2", "ROT", "XCHG S3"},                 3, {"SWAP", "DUP2"}},
+	{"superopt",           {"DUP2", "ROTREV", "DROP"},                 3, {"DUP"}},
+	{"superopt",           {"DUP2", "ROTREV", "DROP2"},                3, {}},
+	{"superopt",           {"DUP2", "ROTREV", "POP S2"},               3, {"PUSH S1", "SWAP"}},
+	{"superopt",           {"DUP2", "ROTREV", "POP S3"},               3, {"DUP"}},
+	{"superopt",           {"DUP2", "ROTREV", "XCHG S3"},              3, {"DUP", "PUSH S2"}},
+	{"superopt",           {"DUP2", "DUP", "POP S2"},                  3, {"DUP", "DUP"}},
+	{"superopt",           {"DUP2", "DUP", "POP S3"},                  3, {"DUP2"}},
+	{"superopt",           {"DUP2", "DUP", "XCHG S3"},                 3, {"DUP2", "DUP"}},
+	{"superopt",           {"DUP2", "PUSH S1", "PUSH S3"},             3, {"DUP2", "DUP2"}},
+	{"superopt",           {"DUP2", "PUSH S1", "NIP"},                 3, {"PUSH S1", "DUP"}},
+	{"superopt",           {"DUP2", "PUSH S2", "SWAP"},                3, {"DUP2", "DUP"}},
+	{"superopt",           {"DUP2", "PUSH S2", "NIP"},                 3, {"DUP2"}},
+	{"superopt",           {"DUP2", "PUSH S2", "POP S2"},              3, {"DUP", "DUP"}},
+	{"superopt",           {"DUP2", "PUSH S3", "PUSH S1"},             3, {"DUP2", "DUP2"}},
+	{"superopt",           {"DUP2", "PUSH S3", "PUSH S3"},             3, {"DUP2", "DUP2"}},
+	{"superopt",           {"DUP2", "PUSH S3", "NIP"},                 3, {"PUSH S1", "DUP"}},
+	{"superopt",           {"DUP2", "PUSH S3", "POP S2"},              3, {"DUP2"}},
+	{"superopt",           {"DUP2", "PUSH S3", "XCHG S2"},             3, {"PUSH S1", "DUP2"}},
+	{"superopt",           {"DUP2", "POP S3", "SWAP"},                 3, {"SWAP", "PUSH S1"}},
+	{"superopt",           {"DUP2", "POP S3", "ROT"},                  3, {"SWAP", "PUSH S1"}},
+	{"superopt",           {"DUP2", "POP S3", "ROTREV"},               3, {"DUP"}},
+	{"superopt",           {"DUP2", "POP S3", "DUP"},                  3, {"DUP2", "XCHG S3"}},
+	{"superopt",           {"DUP2", "POP S3", "DROP"},                 3, {"DUP", "POP S2"}},
+	{"superopt",           {"DUP2", "POP S3", "DROP2"},                3, {"NIP"}},
+	{"superopt",           {"DUP2", "POP S3", "NIP"},                  3, {"SWAP"}},
+	{"superopt",           {"DUP2", "POP S3", "POP S2"},               3, {}},
+	{"superopt",           {"DUP2", "POP S3", "XCHG S2"},              3, {"DUP"}},
+	{"superopt",           {"DUP2", "POP S3", "XCHG S1, S2"},          3, {"DUP", "ROT"}},
+	{"superopt",           {"DUP2", "XCHG S3", "SWAP"},                3, {"DUP2", "XCHG S3"}},
+	{"superopt",           {"DUP2", "XCHG S3", "ROTREV"},              3, {"SWAP", "DUP2"}},
+	{"superopt",           {"DUP2", "XCHG S3", "DROP2"},               3, {"DUP", "POP S2"}},
+	{"superopt",           {"DUP2", "XCHG S3", "NIP"},                 3, {"DUP", "ROT"}},
+	{"superopt",           {"DUP2", "XCHG S3", "POP S2"},              3, {"SWAP", "DUP"}},
+	{"superopt",           {"DUP2", "XCHG S3", "XCHG S1, S2"},         3, {"SWAP", "DUP2"}},
+	{"superopt",           {"DUP2", "XCHG S1, S2", "DROP"},            3, {"PUSH S1", "SWAP"}},
+	{"superopt",           {"DUP2", "XCHG S1, S2", "DROP2"},           3, {"PUSH S1", "NIP"}},
+	{"superopt",           {"DUP2", "XCHG S1, S2", "NIP"},             3, {"PUSH S1", "SWAP"}},
+	{"superopt",           {"DUP2", "XCHG S1, S2", "POP S2"},          3, {"DUP"}},
+	{"superopt",           {"DUP2", "XCHG S1, S2", "POP S3"},          3, {"SWAP", "PUSH S1"}},
+	{"superopt",           {"DUP2", "XCHG S1, S2", "XCHG S3"},         3, {"SWAP", "DUP2"}},
+	{"superopt",           {"DUP2", "NEWC", "NIP"},                    3, {"PUSH S1", "NEWC"}},
+	{"superopt",           {"DUP2", "NEWC", "POP S2"},                 3, {"NEWC", "PUSH S1"}},
+	{"superopt",           {"DUP2", "GETGLOB $1", "NIP"},              3, {"PUSH S1", "GETGLOB $1"}},
+	{"superopt",           {"DUP2", "GETGLOB $1", "POP S2"},           3, {"GETGLOB $1", "PUSH S1"}},
+	{"superopt",           {"DUP2", "SETGLOB $1", "DROP"},             3, {"DUP", "SETGLOB $1"}},
+	{"superopt",           {"DUP2", "SETGLOB $1", "DROP2"},            3, {"SETGLOB $1"}},
+	{"superopt",           {"DUP2", "SETGLOB $1", "NIP"},              3, {"SETGLOB $1", "DUP"}},
+	{"superopt",           {"DUP2", "SETGLOB $1", "POP S2"},           3, {"DUP", "SETGLOB $1"}},
+	{"superopt",           {"DUP2", "SETGLOB $1", "XCHG S2"},          3, {"DUP2", "SETGLOB $1"}},
+	{"superopt",           {"DROP", "ROT", "DROP2"},                   3, {"DROP2", "NIP"}},
+	{"superopt",           {"DROP", "ROT", "NIP"},                     3, {"DROP2", "SWAP"}},
+	{"superopt",           {"DROP", "ROTREV", "POP S2"},               3, {"DROP2", "SWAP"}},
+	{"superopt",           {"DROP", "PUSH S1", "NIP"},                 3, {"DROP2", "DUP"}},
+	{"superopt",           {"DROP", "PUSH S2", "NIP"},                 3, {"DROP2", "PUSH S1"}},
+	{"superopt",           {"DROP", "PUSH S3", "NIP"},                 3, {"DROP2", "PUSH S2"}},
+	{"superopt",           {"DROP", "DROP2", "DROP"},                  3, {"DROP2", "DROP2"}},
+	{"superopt",           {"DROP", "NIP", "DROP2"},                   3, {"DROP2", "DROP2"}},
+	{"superopt",           {"DROP", "POP S2", "DROP2"},                3, {"DROP2", "DROP2"}},
+	{"superopt",           {"DROP", "POP S2", "NIP"},                  3, {"DROP2", "NIP"}},
+	{"superopt",           {"DROP", "POP S3", "POP S2"},               3, {"DROP2", "POP S2"}},
+	{"superopt",           {"DROP", "XCHG S1, S2", "DROP"},            3, {"DROP2", "SWAP"}},
+	{"superopt",           {"DROP", "XCHG S1, S2", "DROP2"},           3, {"DROP2", "NIP"}},
+	{"superopt",           {"DROP", "NEWC", "DROP"},                   3, {"NEWC", "DROP2"}},
+	{"superopt",           {"DROP", "NEWC", "NIP"},                    3, {"DROP2", "NEWC"}},
+	{"superopt",           {"DROP", "GETGLOB $1", "DROP"},             3, {"GETGLOB $1", "DROP2"}},
+	{"superopt",           {"DROP", "GETGLOB $1", "NIP"},              3, {"DROP2", "GETGLOB $1"}},
+	{"superopt",           {"NIP", "ROT", "DROP2"},                    3, {"DROP2", "NIP"}},
+	{"superopt",           {"NIP", "ROT", "NIP"},                      3, {"DROP2", "SWAP"}},
+	{"superopt",           {"NIP", "ROTREV", "DROP2"},                 3, {"POP S3", "DROP2"}},
+	{"superopt",           {"NIP", "ROTREV", "POP S2"},                3, {"DROP2", "SWAP"}},
+	{"superopt",           {"NIP", "PUSH S1", "SWAP"},                 3, {"PUSH S2", "POP S2"}},
+	{"superopt",           {"NIP", "PUSH S1", "ROTREV"},               3, {"PUSH S2", "POP S2"}},
+	{"superopt",           {"NIP", "PUSH S1", "NIP"},                  3, {"DROP2", "DUP"}},
+	{"superopt",           {"NIP", "PUSH S2", "SWAP"},                 3, {"PUSH S3", "POP S2"}},
+	{"superopt",           {"NIP", "PUSH S2", "NIP"},                  3, {"DROP2", "PUSH S1"}},
+	{"superopt",           {"NIP", "PUSH S3", "NIP"},                  3, {"DROP2", "PUSH S2"}},
+	{"superopt",           {"NIP", "DROP2", "DROP"},                   3, {"DROP2", "DROP2"}},
+	{"superopt",           {"NIP", "NIP", "DROP2"},                    3, {"DROP2", "DROP2"}},
+	{"superopt",           {"NIP", "NIP", "NIP"},                      3, {"POP S3", "DROP2"}},
+	{"superopt",           {"NIP", "NIP", "SETGLOB $1"},               3, {"SETGLOB $1", "DROP2"}},
+	{"superopt",           {"NIP", "POP S2", "DROP"},                  3, {"POP S3", "DROP2"}},
+	{"superopt",           {"NIP", "POP S2", "DROP2"},                 3, {"DROP2", "DROP2"}},
+	{"superopt",           {"NIP", "POP S2", "NIP"},                   3, {"DROP2", "NIP"}},
+	{"superopt",           {"NIP", "POP S3", "POP S2"},                3, {"DROP2", "POP S2"}},
+	{"superopt",           {"NIP", "XCHG S2", "DROP2"},                3, {"POP S3", "DROP2"}},
+	{"superopt",           {"NIP", "XCHG S1, S2", "DROP"},             3, {"DROP2", "SWAP"}},
+	{"superopt",           {"NIP", "XCHG S1, S2", "DROP2"},            3, {"DROP2", "NIP"}},
+	{"superopt",           {"NIP", "NEWC", "SWAP"},                    3, {"NEWC", "POP S2"}},
+	{"superopt",           {"NIP", "NEWC", "NIP"},                     3, {"DROP2", "NEWC"}},
+	{"superopt",           {"NIP", "GETGLOB $1", "SWAP"},              3, {"GETGLOB $1", "POP S2"}},
+	{"superopt",           {"NIP", "GETGLOB $1", "NIP"},               3, {"DROP2", "GETGLOB $1"}},
+	{"superopt",           {"NIP", "SETGLOB $1", "DROP"},              3, {"SETGLOB $1", "DROP2"}},
+	{"superopt",           {"POP S2", "SWAP", "POP S2"},               3, {"POP S3", "NIP"}},
+	{"superopt",           {"POP S2", "SWAP", "SETGLOB $1"},           3, {"SETGLOB $1", "NIP"}},
+	{"superopt",           {"POP S2", "SWAP", "STU $1"},               3, {"STU $1", "NIP"}},
+	{"superopt",           {"POP S2", "ROT", "DROP"},                  3, {"POP S3", "NIP"}},
+	{"superopt",           {"POP S2", "ROT", "DROP2"},                 3, {"POP S3", "DROP2"}},
+	{"superopt",           {"POP S2", "DUP", "ROT"},                   3, {"PUSH S1", "POP S3"}},
+	{"superopt",           {"POP S2", "DUP", "XCHG S2"},               3, {"PUSH S1", "POP S3"}},
+	{"superopt",           {"POP S2", "PUSH S2", "XCHG S2"},           3, {"PUSH S3", "POP S3"}},
+	{"superopt",           {"POP S2", "DUP2", "POP S3"},               3, {"PUSH S1", "POP S3"}},
+	{"superopt",           {"POP S2", "DROP", "DROP2"},                3, {"DROP2", "DROP2"}},
+	{"superopt",           {"POP S2", "DROP", "NIP"},                  3, {"POP S3", "DROP2"}},
+	{"superopt",           {"POP S2", "DROP", "SETGLOB $1"},           3, {"SETGLOB $1", "DROP2"}},
+	{"superopt",           {"POP S2", "DROP2", "DROP"},                3, {"DROP2", "DROP2"}},
+	{"superopt",           {"POP S2", "NIP", "DROP2"},                 3, {"DROP2", "DROP2"}},
+	{"superopt",           {"POP S2", "POP S2", "SWAP"},               3, {"POP S3", "NIP"}},
+	{"superopt",           {"POP S2", "POP S2", "DROP2"},              3, {"DROP2", "DROP2"}},
+	{"superopt",           {"POP S2", "POP S2", "NIP"},                3, {"POP S3", "DROP2"}},
+	{"superopt",           {"POP S2", "XCHG S1, S2", "DROP2"},         3, {"POP S3", "DROP2"}},
+	{"superopt",           {"POP S2", "XCHG S1, S2", "NIP"},           3, {"POP S3", "NIP"}},
+	{"superopt",           {"POP S2", "NEWC", "XCHG S2"},              3, {"NEWC", "POP S3"}},
+	{"superopt",           {"POP S2", "GETGLOB $1", "XCHG S2"},        3, {"GETGLOB $1", "POP S3"}},
+	{"superopt",           {"POP S3", "ROT", "DROP2"},                 3, {"DROP2", "NIP"}},
+	{"superopt",           {"POP S3", "ROTREV", "DROP"},               3, {"POP S2", "POP S2"}},
+	{"superopt",           {"POP S3", "DROP", "DROP2"},                3, {"DROP2", "DROP2"}},
+	{"superopt",           {"POP S3", "DROP", "NIP"},                  3, {"DROP2", "NIP"}},
+	{"superopt",           {"POP S3", "DROP2", "DROP"},                3, {"DROP2", "DROP2"}},
+	{"superopt",           {"POP S3", "NIP", "SWAP"},                  3, {"POP S2", "POP S2"}},
+	{"superopt",           {"POP S3", "NIP", "DROP2"},                 3, {"DROP2", "DROP2"}},
+	{"superopt",           {"POP S3", "POP S2", "DROP2"},              3, {"DROP2", "DROP2"}},
+	{"superopt",           {"POP S3", "POP S2", "NIP"},                3, {"DROP2", "NIP"}},
+	{"superopt",           {"POP S3", "XCHG S2", "NIP"},               3, {"POP S2", "POP S2"}},
+	{"superopt",           {"POP S3", "XCHG S2", "SETGLOB $1"},        3, {"SETGLOB $1", "POP S2"}},
+	{"superopt",           {"POP S3", "XCHG S1, S2", "DROP2"},         3, {"DROP2", "NIP"}},
+	{"superopt",           {"POP S3", "XCHG S1, S2", "POP S2"},        3, {"POP S2", "POP S2"}},
+	{"superopt",           {"XCHG S2", "DUP", "ROTREV"},               3, {"ROTREV", "PUSH S1"}},
+	{"superopt",           {"XCHG S2", "DUP", "POP S3"},               3, {"PUSH S2", "NIP"}},
+	{"superopt",           {"XCHG S2", "DUP", "XCHG S3"},              3, {"PUSH S2", "SWAP"}},
+	{"superopt",           {"XCHG S2", "DUP", "XCHG S1, S2"},          3, {"ROTREV", "PUSH S1"}},
+	{"superopt",           {"XCHG S2", "PUSH S1", "ROT"},              3, {"ROTREV", "DUP"}},
+	{"superopt",           {"XCHG S2", "PUSH S1", "NIP"},              3, {"POP S2", "DUP"}},
+	{"superopt",           {"XCHG S2", "PUSH S1", "XCHG S1, S2"},      3, {"ROTREV", "DUP"}},
+	{"superopt",           {"XCHG S2", "PUSH S2", "SWAP"},             3, {"DUP", "XCHG S3"}},
+	{"superopt",           {"XCHG S2", "PUSH S2", "NIP"},              3, {"DUP", "POP S3"}},
+	{"superopt",           {"XCHG S2", "PUSH S2", "XCHG S1, S2"},      3, {"ROTREV", "PUSH S2"}},
+	{"superopt",           {"XCHG S2", "PUSH S3", "NIP"},              3, {"POP S2", "PUSH S2"}},
+	{"superopt",           {"XCHG S2", "PUSH S3", "XCHG S1, S2"},      3, {"ROTREV", "PUSH S3"}},
+	{"superopt",           {"XCHG S2", "DROP2", "DROP"},               3, {"DROP", "DROP2"}},
+	{"superopt",           {"XCHG S2", "DROP2", "DROP2"},              3, {"DROP2", "DROP2"}},
+	{"superopt",           {"XCHG S2", "DROP2", "NIP"},                3, {"POP S3", "DROP2"}},
+	{"superopt",           {"XCHG S2", "DROP2", "SETGLOB $1"},         3, {"SETGLOB $1", "DROP2"}},
+	{"superopt",           {"XCHG S2", "NIP", "SWAP"},                 3, {"NIP"}},
+	{"superopt",           {"XCHG S2", "NIP", "ROT"},                  3, {"NIP", "XCHG S2"}},
+	{"superopt",           {"XCHG S2", "NIP", "ROTREV"},               3, {"NIP", "XCHG S1, S2"}},
+	{"superopt",           {"XCHG S2", "NIP", "DROP2"},                3, {"DROP", "DROP2"}},
+	{"superopt",           {"XCHG S2", "NIP", "NIP"},                  3, {"DROP2"}},
+	{"superopt",           {"XCHG S2", "NIP", "XCHG S2"},              3, {"NIP", "ROT"}},
+	{"superopt",           {"XCHG S2", "NIP", "XCHG S1, S2"},          3, {"NIP", "ROTREV"}},
+	{"superopt",           {"XCHG S2", "POP S3", "SWAP"},              3, {"ROT", "POP S3"}},
+	{"superopt",           {"XCHG S2", "POP S3", "ROT"},               3, {"POP S3", "SWAP"}},
+	{"superopt",           {"XCHG S2", "POP S3", "ROTREV"},            3, {"SWAP", "POP S3"}},
+	{"superopt",           {"XCHG S2", "POP S3", "DROP2"},             3, {"DROP2", "NIP"}},
+	{"superopt",           {"XCHG S2", "POP S3", "POP S2"},            3, {"POP S2", "POP S2"}},
+	{"superopt",           {"XCHG S2", "POP S3", "XCHG S2"},           3, {"ROTREV", "POP S3"}},
+	{"superopt",           {"XCHG S2", "POP S3", "XCHG S1, S2"},       3, {"POP S3"}},
+	{"superopt",           {"XCHG S2", "XCHG S3", "NIP"},              3, {"NIP", "ROT"}},
+	{"superopt",           {"XCHG S2", "XCHG S3", "POP S2"},           3, {"DROP", "XCHG S1, S2"}},
+	{"superopt",           {"XCHG S2", "XCHG S3", "XCHG S1, S2"},      3, {"ROT", "XCHG S3"}},
+	{"superopt",           {"XCHG S2", "NEWC", "NIP"},                 3, {"POP S2", "NEWC"}},
+	{"superopt",           {"XCHG S2", "NEWC", "XCHG S1, S2"},         3, {"ROTREV", "NEWC"}},
+	{"superopt",           {"XCHG S2", "GETGLOB $1", "NIP"},           3, {"POP S2", "GETGLOB $1"}},
+	{"superopt",           {"XCHG S2", "GETGLOB $1", "XCHG S1, S2"},   3, {"ROTREV", "GETGLOB $1"}},
+	{"superopt",           {"XCHG S2", "SETGLOB $1", "SWAP"},          3, {"ROT", "SETGLOB $1"}},
+	{"superopt",           {"XCHG S2", "SETGLOB $1", "DROP2"},         3, {"DROP2", "SETGLOB $1"}},
+	{"superopt",           {"XCHG S3", "SWAP", "POP S2"},              3, {"POP S2", "ROT"}},
+	{"superopt",           {"XCHG S3", "SWAP", "POP S3"},              3, {"DROP", "XCHG S2"}},
+	{"superopt",           {"XCHG S3", "ROT", "DROP"},                 3, {"POP S2", "ROT"}},
+	{"superopt",           {"XCHG S3", "ROT", "DROP2"},                3, {"POP S3", "NIP"}},
+	{"superopt",           {"XCHG S3", "ROT", "NIP"},                  3, {"POP S3", "SWAP"}},
+	{"superopt",           {"XCHG S3", "ROT", "POP S3"},               3, {"DROP", "ROT"}},
+	{"superopt",           {"XCHG S3", "ROTREV", "DROP"},              3, {"NIP", "ROTREV"}},
+	{"superopt",           {"XCHG S3", "ROTREV", "POP S2"},            3, {"POP S3", "SWAP"}},
+	{"superopt",           {"XCHG S3", "ROTREV", "POP S3"},            3, {"DROP", "ROTREV"}},
+	{"superopt",           {"XCHG S3", "PUSH S1", "NIP"},              3, {"POP S3", "DUP"}},
+	{"superopt",           {"XCHG S3", "PUSH S2", "NIP"},              3, {"POP S3", "PUSH S1"}},
+	{"superopt",           {"XCHG S3", "PUSH S3", "NIP"},              3, {"POP S3", "PUSH S2"}},
+	{"superopt",           {"XCHG S3", "DROP2", "DROP"},               3, {"POP S3", "DROP2"}},
+	{"superopt",           {"XCHG S3", "DROP2", "DROP2"},              3, {"DROP2", "DROP2"}},
+	{"superopt",           {"XCHG S3", "DROP2", "NIP"},                3, {"DROP2", "NIP"}},
+	{"superopt",           {"XCHG S3", "NIP", "SWAP"},                 3, {"NIP", "ROTREV"}},
+	{"superopt",           {"XCHG S3", "NIP", "ROT"},                  3, {"NIP", "XCHG S1, S2"}},
+	{"superopt",           {"XCHG S3", "NIP", "ROTREV"},               3, {"ROTREV", "DROP"}},
+	{"superopt",           {"XCHG S3", "NIP", "DROP2"},                3, {"POP S3", "DROP2"}},
+	{"superopt",           {"XCHG S3", "NIP", "POP S2"},               3, {"DROP2"}},
+	{"superopt",           {"XCHG S3", "NIP", "XCHG S2"},              3, {"NIP"}},
+	{"superopt",           {"XCHG S3", "NIP", "XCHG S1, S2"},          3, {"NIP", "ROT"}},
+	{"superopt",           {"XCHG S3", "POP S2", "SWAP"},              3, {"POP S2", "ROT"}},
+	{"superopt",           {"XCHG S3", "POP S2", "ROT"},               3, {"SWAP", "POP S2"}},
+	{"superopt",           {"XCHG S3", "POP S2", "ROTREV"},            3, {"POP S2", "XCHG S2"}},
+	{"superopt",           {"XCHG S3", "POP S2", "DROP2"},             3, {"POP S3", "DROP2"}},
+	{"superopt",           {"XCHG S3", "POP S2", "NIP"},               3, {"POP S3", "NIP"}},
+	{"superopt",           {"XCHG S3", "POP S2", "XCHG S2"},           3, {"POP S2", "ROTREV"}},
+	{"superopt",           {"XCHG S3", "POP S2", "XCHG S1, S2"},       3, {"POP S2"}},
+	{"superopt",           {"XCHG S3", "XCHG S2", "NIP"},              3, {"NIP", "ROTREV"}},
+	{"superopt",           {"XCHG S3", "XCHG S2", "POP S3"},           3, {"DROP", "XCHG S1, S2"}},
+	{"superopt",           {"XCHG S3", "XCHG S1, S2", "DROP"},         3, {"POP S3", "SWAP"}},
+	{"superopt",           {"XCHG S3", "XCHG S1, S2", "DROP2"},        3, {"POP S3", "NIP"}},
+	{"superopt",           {"XCHG S3", "XCHG S1, S2", "NIP"},          3, {"POP S2", "ROT"}},
+	{"superopt",           {"XCHG S3", "XCHG S1, S2", "POP S2"},       3, {"NIP", "ROTREV"}},
+	{"superopt",           {"XCHG S3", "XCHG S1, S2", "POP S3"},       3, {"ROT", "NIP"}},
+	{"superopt",           {"XCHG S3", "XCHG S1, S2", "XCHG S3"},      3, {"XCHG S1, S2"}},
+	{"superopt",           {"XCHG S3", "NEWC", "NIP"},                 3, {"POP S3", "NEWC"}},
+	{"superopt",           {"XCHG S3", "GETGLOB $1", "NIP"},           3, {"POP S3", "GETGLOB $1"}},
+	{"superopt",           {"XCHG S1, S2", "DUP", "ROTREV"},           3, {"ROT", "PUSH S1"}},
+	{"superopt",           {"XCHG S1, S2", "DUP", "XCHG S1, S2"},      3, {"ROT", "PUSH S1"}},
+	{"superopt",           {"XCHG S1, S2", "PUSH S1", "ROT"},          3, {"ROT", "DUP"}},
+	{"superopt",           {"XCHG S1, S2", "PUSH S1", "POP S3"},       3, {"PUSH S2", "POP S2"}},
+	{"superopt",           {"XCHG S1, S2", "PUSH S1", "XCHG S3"},      3, {"PUSH S2", "XCHG S2"}},
+	{"superopt",           {"XCHG S1, S2", "PUSH S1", "XCHG S1, S2"},  3, {"ROT", "DUP"}},
+	{"superopt",           {"XCHG S1, S2", "PUSH S2", "POP S2"},       3, {"PUSH S1", "POP S3"}},
+	{"superopt",           {"XCHG S1, S2", "PUSH S2", "XCHG S2"},      3, {"PUSH S1", "XCHG S3"}},
+	{"superopt",           {"XCHG S1, S2", "PUSH S2", "XCHG S1, S2"},  3, {"ROT", "PUSH S2"}},
+	{"superopt",           {"XCHG S1, S2", "PUSH S3", "XCHG S1, S2"},  3, {"ROT", "PUSH S3"}},
+	{"superopt",           {"XCHG S1, S2", "DROP", "SWAP"},            3, {"DROP"}},
+	{"superopt",           {"XCHG S1, S2", "DROP", "ROT"},             3, {"DROP", "XCHG S2"}},
+	{"superopt",           {"XCHG S1, S2", "DROP", "ROTREV"},          3, {"DROP", "XCHG S1, S2"}},
+	{"superopt",           {"XCHG S1, S2", "DROP", "DROP2"},           3, {"DROP", "DROP2"}},
+	{"superopt",           {"XCHG S1, S2", "DROP", "NIP"},             3, {"DROP2"}},
+	{"superopt",           {"XCHG S1, S2", "DROP", "XCHG S2"},         3, {"DROP", "ROT"}},
+	{"superopt",           {"XCHG S1, S2", "DROP", "XCHG S1, S2"},     3, {"DROP", "ROTREV"}},
+	{"superopt",           {"XCHG S1, S2", "DROP2", "DROP"},           3, {"DROP", "DROP2"}},
+	{"superopt",           {"XCHG S1, S2", "DROP2", "DROP2"},          3, {"DROP2", "DROP2"}},
+	{"superopt",           {"XCHG S1, S2", "NIP", "SWAP"},             3, {"POP S2"}},
+	{"superopt",           {"XCHG S1, S2", "NIP", "ROT"},              3, {"POP S2", "XCHG S2"}},
+	{"superopt",           {"XCHG S1, S2", "NIP", "ROTREV"},           3, {"POP S2", "XCHG S1, S2"}},
+	{"superopt",           {"XCHG S1, S2", "NIP", "DROP2"},            3, {"DROP", "DROP2"}},
+	{"superopt",           {"XCHG S1, S2", "NIP", "NIP"},              3, {"ROTREV", "DROP2"}},
+	{"superopt",           {"XCHG S1, S2", "NIP", "POP S2"},           3, {"POP S3", "NIP"}},
+	{"superopt",           {"XCHG S1, S2", "NIP", "XCHG S2"},          3, {"POP S2", "ROT"}},
+	{"superopt",           {"XCHG S1, S2", "NIP", "XCHG S1, S2"},      3, {"POP S2", "ROTREV"}},
+	{"superopt",           {"XCHG S1, S2", "NIP", "SETGLOB $1"},       3, {"SETGLOB $1", "NIP"}},
+	{"superopt",           {"XCHG S1, S2", "NIP", "STU $1"},           3, {"STU $1", "NIP"}},
+	{"superopt",           {"XCHG S1, S2", "POP S2", "SWAP"},          3, {"NIP"}},
+	{"superopt",           {"XCHG S1, S2", "POP S2", "ROT"},           3, {"NIP", "XCHG S2"}},
+	{"superopt",           {"XCHG S1, S2", "POP S2", "ROTREV"},        3, {"NIP", "XCHG S1, S2"}},
+	{"superopt",           {"XCHG S1, S2", "POP S2", "DROP"},          3, {"ROTREV", "DROP2"}},
+	{"superopt",           {"XCHG S1, S2", "POP S2", "DROP2"},         3, {"DROP", "DROP2"}},
+	{"superopt",           {"XCHG S1, S2", "POP S2", "NIP"},           3, {"DROP2"}},
+	{"superopt",           {"XCHG S1, S2", "POP S2", "XCHG S2"},       3, {"NIP", "ROT"}},
+	{"superopt",           {"XCHG S1, S2", "POP S2", "XCHG S1, S2"},   3, {"NIP", "ROTREV"}},
+	{"superopt",           {"XCHG S1, S2", "POP S3", "SWAP"},          3, {"POP S3"}},
+	{"superopt",           {"XCHG S1, S2", "POP S3", "ROT"},           3, {"SWAP", "POP S3"}},
+	{"superopt",           {"XCHG S1, S2", "POP S3", "ROTREV"},        3, {"POP S3", "XCHG S1, S2"}},
+	{"superopt",           {"XCHG S1, S2", "POP S3", "DROP"},          3, {"POP S3", "NIP"}},
+	{"superopt",           {"XCHG S1, S2", "POP S3", "DROP2"},         3, {"POP S3", "DROP2"}},
+	{"superopt",           {"XCHG S1, S2", "POP S3", "NIP"},           3, {"NIP", "POP S2"}},
+	{"superopt",           {"XCHG S1, S2", "POP S3", "XCHG S2"},       3, {"ROT", "POP S3"}},
+	{"superopt",           {"XCHG S1, S2", "POP S3", "XCHG S1, S2"},   3, {"ROTREV", "POP S3"}},
+	{"superopt",           {"XCHG S1, S2", "XCHG S3", "SWAP"},         3, {"XCHG S3", "ROT"}},
+	{"superopt",           {"XCHG S1, S2", "XCHG S3", "ROT"},          3, {"XCHG S3", "SWAP"}},
+	{"superopt",           {"XCHG S1, S2", "XCHG S3", "ROTREV"},       3, {"XCHG S3", "XCHG S2"}},
+	{"superopt",           {"XCHG S1, S2", "XCHG S3", "DROP2"},        3, {"POP S3", "NIP"}},
+	{"superopt",           {"XCHG S1, S2", "XCHG S3", "NIP"},          3, {"POP S2", "ROT"}},
+	{"superopt",           {"XCHG S1, S2", "XCHG S3", "POP S2"},       3, {"NIP", "ROTREV"}},
+	{"superopt",           {"XCHG S1, S2", "XCHG S3", "XCHG S2"},      3, {"XCHG S3", "ROTREV"}},
+	{"superopt",           {"XCHG S1, S2", "XCHG S3", "XCHG S1, S2"},  3, {"XCHG S3"}},
+	{"superopt",           {"XCHG S1, S2", "NEWC", "XCHG S1, S2"},     3, {"ROT", "NEWC"}},
+	{"superopt",           {"XCHG S1, S2", "GETGLOB $1", "XCHG S1, S2"}, 3, {"ROT", "GETGLOB $1"}},
+	{"superopt",           {"XCHG S1, S2", "SETGLOB $1", "SWAP"},      3, {"SETGLOB $1"}},
+	{"superopt",           {"XCHG S1, S2", "SETGLOB $1", "ROT"},       3, {"SETGLOB $1", "XCHG S2"}},
+	{"superopt",           {"XCHG S1, S2", "SETGLOB $1", "ROTREV"},    3, {"SETGLOB $1", "XCHG S1, S2"}},
+	{"superopt",           {"XCHG S1, S2", "SETGLOB $1", "DROP"},      3, {"SETGLOB $1", "NIP"}},
+	{"superopt",           {"XCHG S1, S2", "SETGLOB $1", "DROP2"},     3, {"SETGLOB $1", "DROP2"}},
+	{"superopt",           {"XCHG S1, S2", "SETGLOB $1", "NIP"},       3, {"NIP", "SETGLOB $1"}},
+	{"superopt",           {"XCHG S1, S2", "SETGLOB $1", "XCHG S2"},   3, {"SETGLOB $1", "ROT"}},
+	{"superopt",           {"XCHG S1, S2", "SETGLOB $1", "XCHG S1, S2"}, 3, {"SETGLOB $1", "ROTREV"}},
+	{"superopt",           {"XCHG S1, S2", "STU $1", "NIP"},           3, {"NIP", "STU $1"}},
+	{"superopt",           {"NEWC", "SWAP", "POP S2"},                 3, {"NIP", "NEWC"}},
+	{"superopt",           {"NEWC", "SWAP", "POP S3"},                 3, {"POP S2", "NEWC"}},
+	{"superopt",           {"NEWC", "ROT", "DROP"},                    3, {"NIP", "NEWC"}},
+	{"superopt",           {"NEWC", "ROTREV", "DROP2"},                3, {"DROP2", "NEWC"}},
+	{"superopt",           {"NEWC", "PUSH S1", "SWAP"},                3, {"DUP", "NEWC"}},
+	{"superopt",           {"NEWC", "PUSH S1", "ROTREV"},              3, {"DUP", "NEWC"}},
+	{"superopt",           {"NEWC", "PUSH S2", "SWAP"},                3, {"PUSH S1", "NEWC"}},
+	{"superopt",           {"NEWC", "PUSH S3", "SWAP"},                3, {"PUSH S2", "NEWC"}},
+	{"superopt",           {"NEWC", "NIP", "NIP"},                     3, {"DROP2", "NEWC"}},
+	{"superopt",           {"NEWC", "POP S2", "SWAP"},                 3, {"NIP", "NEWC"}},
+	{"superopt",           {"NEWC", "POP S2", "DROP"},                 3, {"DROP2", "NEWC"}},
+	{"superopt",           {"NEWC", "POP S3", "XCHG S2"},              3, {"POP S2", "NEWC"}},
+	{"superopt",           {"NEWC", "XCHG S2", "DROP2"},               3, {"DROP2", "NEWC"}},
+	{"superopt",           {"NEWC", "XCHG S1, S2", "NIP"},             3, {"NIP", "NEWC"}},
+	{"superopt",           {"GETGLOB $1", "SWAP", "POP S2"},           3, {"NIP", "GETGLOB $1"}},
+	{"superopt",           {"GETGLOB $1", "SWAP", "POP S3"},           3, {"POP S2", "GETGLOB $1"}},
+	{"superopt",           {"GETGLOB $1", "ROT", "DROP"},              3, {"NIP", "GETGLOB $1"}},
+	{"superopt",           {"GETGLOB $1", "ROTREV", "DROP2"},          3, {"DROP2", "GETGLOB $1"}},
+	{"superopt",           {"GETGLOB $1", "PUSH S1", "SWAP"},          3, {"DUP", "GETGLOB $1"}},
+	{"superopt",           {"GETGLOB $1", "PUSH S1", "ROTREV"},        3, {"DUP", "GETGLOB $1"}},
+	{"superopt",           {"GETGLOB $1", "PUSH S2", "SWAP"},          3, {"PUSH S1", "GETGLOB $1"}},
+	{"superopt",           {"GETGLOB $1", "PUSH S3", "SWAP"},          3, {"PUSH S2", "GETGLOB $1"}},
+	{"superopt",           {"GETGLOB $1", "NIP", "NIP"},               3, {"DROP2", "GETGLOB $1"}},
+	{"superopt",           {"GETGLOB $1", "POP S2", "SWAP"},           3, {"NIP", "GETGLOB $1"}},
+	{"superopt",           {"GETGLOB $1", "POP S2", "DROP"},           3, {"DROP2", "GETGLOB $1"}},
+	{"superopt",           {"GETGLOB $1", "POP S3", "XCHG S2"},        3, {"POP S2", "GETGLOB $1"}},
+	{"superopt",           {"GETGLOB $1", "XCHG S2", "DROP2"},         3, {"DROP2", "GETGLOB $1"}},
+	{"superopt",           {"GETGLOB $1", "XCHG S1, S2", "NIP"},       3, {"NIP", "GETGLOB $1"}},
+};
+
+// Operands are compared without spaces and case, so that "s1,s2" matches "S1, S2".
+std::string normalized(std::string_view _s) {
+	std::string res;
+	for (char ch : _s)
+		if (ch != ' ' && ch != '\t')
+			res.push_back(static_cast<char>(std::toupper(static_cast<unsigned char>(ch))));
+	return res;
+}
+
+class Matcher {
+public:
+	Matcher() {
+		m_nodes.emplace_back();
+		for (size_t r = 0; r < peepholeRules.size(); ++r) {
+			std::vector<PatternCommand> pattern;
+			size_t node = 0;
+			for (std::string_view command : peepholeRules[r].pattern) {
+				PatternCommand& cmd = pattern.emplace_back();
+				size_t const space = command.find(' ');
+				cmd.opcode = command.substr(0, space);
+				if (space != std::string_view::npos) {
+					std::string_view const operand = command.substr(space + 1);
+					if (operand[0] == '$')
+						cmd.capture = operand[1] - '0';
+					else
+						cmd.operand = normalized(operand);
+				}
+
+				auto it = m_nodes[node].children.find(cmd.opcode);
+				if (it == m_nodes[node].children.end()) {
+					it = m_nodes[node].children.emplace(cmd.opcode, m_nodes.size()).first;
+					m_nodes.emplace_back();
+				}
+				node = it->second;
+			}
+			m_nodes[node].rules.push_back(r);
+			m_patterns.push_back(std::move(pattern));
+		}
+	}
+
+	std::optional<PeepholeMatch> match(PeepholeCommand const* _window, size_t _size) const {
+		size_t best = peepholeRules.size();
+		Captures captures;
+		size_t node = 0;
+		for (size_t i = 0; i < _size && !_window[i].opcode.empty(); ++i) {
+			auto it = m_nodes[node].children.find(_window[i].opcode);
+			if (it == m_nodes[node].children.end())
+				break;
+			node = it->second;
+			for (size_t r : m_nodes[node].rules)
+				if (r < best && operandsMatch(m_patterns[r], _window, captures))
+					best = r;
+		}
+		if (best == peepholeRules.size())
+			return std::nullopt;
+
+		operandsMatch(m_patterns[best], _window, captures);
+		PeepholeMatch res{&peepholeRules[best], {}};
+		for (std::string_view command : peepholeRules[best].replacement) {
+			std::string& out = res.commands.emplace_back();
+			for (size_t i = 0; i < command.size(); ++i) {
+				if (command[i] == '$' && i + 1 < command.size()) {
+					out += captures[command[++i] - '0'];
+				} else {
+					out.push_back(command[i]);
+				}
+			}
+		}
+		return res;
+	}
+
+private:
+	struct PatternCommand {
+		std::string opcode;
+		std::string operand; // required operand, normalized, empty if any operand is allowed
+		int capture{};       // number of the captured operand, 0 if the operand is not captured
+	};
+	struct Node {
+		std::map<std::string, size_t, std::less<>> children;
+		std::vector<size_t> rules; // rules whose pattern ends at the node
+	};
+	using Captures = std::array<std::string_view, 10>;
+
+	static bool operandsMatch(std::vector<PatternCommand> const& _pattern, PeepholeCommand const* _window, Captures& _captures) {
+		std::array<bool, 10> bound{};
+		for (size_t i = 0; i < _pattern.size(); ++i) {
+			PatternCommand const& cmd = _pattern[i];
+			std::string_view const operand = _window[i].operand;
+			if (cmd.capture != 0) {
+				if (operand.empty()) {
+					// e.g. RSHIFT without an operand takes the shift from the stack
+					return false;
+				}
+				if (!bound[cmd.capture]) {
+					bound[cmd.capture] = true;
+					_captures[cmd.capture] = operand;
+				} else if (_captures[cmd.capture] != operand) {
+					return false;
+				}
+			} else if (!cmd.operand.empty() && normalized(operand) != cmd.operand) {
+				return false;
+			}
+		}
+		return true;
+	}
+
+	std::vector<std::vector<PatternCommand>> m_patterns;
+	std::vector<Node> m_nodes;
+};
+
+} // end anonymous namespace
+
+std::vector<PeepholeRule> const& PeepholeRules::rules() {
+	return peepholeRules;
+}
+
+std::optional<PeepholeMatch> PeepholeRules::match(PeepholeCommand const* _window, size_t _size) {
+	static Matcher const matcher;
+	return matcher.match(_window, _size);
+}
@@ -0,0 +1,63 @@
+/*
+ * Copyright 2018-2019 TON DEV SOLUTIONS LTD.
+ *
+ * Licensed under the  terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License.
+ *
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the  GNU General Public License for more details at: https://www.gnu.org/licenses/gpl-3.0.html
+ */
+/**
+ * @author TON Labs <connect@tonlabs.io>
+ * @date 2021
+ * Declarative peephole rules of the TVM optimizer
+ */
+
+#pragma once
+
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace solidity::frontend {
+
+// Rewrites a fixed sequence of commands.
+//
+// Each pattern command is an opcode, optionally followed by its operand:
+//   "SWAP"        - the opcode with any operand
+//   "UFITS 256"   - the opcode with the given operand (spaces and case are ignored)
+//   "SETGLOB $1"  - the opcode with a non-empty operand, which is captured as $1;
+//                   further uses of $1 in the pattern require the same operand
+// The first `replaced` commands of the pattern are replaced with `replacement`, where $n is substituted
+// by the captured operand. The rest of the pattern is context that is required but kept.
+struct PeepholeRule {
+	char const* name;
+	std::vector<char const*> pattern;
+	int replaced;
+	std::vector<char const*> replacement;
+};
+
+struct PeepholeCommand {
+	std::string_view opcode;
+	std::string_view operand;
+};
+
+struct PeepholeMatch {
+	PeepholeRule const* rule;
+	std::vector<std::string> commands;
+};
+
+class PeepholeRules {
+public:
+	// Rules in priority order. When several rules match at one position the first of them is applied.
+	static std::vector<PeepholeRule> const& rules();
+	// Finds the first rule matching the commands starting at @a _window. An empty opcode ends the window.
+	// All rules are tried in one walk over the trie of patterns, independently of their number.
+	static std::optional<PeepholeMatch> match(PeepholeCommand const* _window, size_t _size);
+};
+
+}	// end solidity::frontend
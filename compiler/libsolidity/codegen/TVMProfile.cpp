@@ -0,0 +1,146 @@
+/*
+ * Copyright 2018-2019 TON DEV SOLUTIONS LTD.
+ *
+ * Licensed under the  terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License.
+ *
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the  GNU General Public License for more details at: https://www.gnu.org/licenses/gpl-3.0.html
+ */
+/**
+ * @author TON Labs <connect@tonlabs.io>
+ * @date 2021
+ * Execution profile of contract used for profile-guided optimizations
+ */
+
+#include <boost/filesystem.hpp>
+
+#include <libsolutil/CommonIO.h>
+#include <libsolutil/JSON.h>
+
+#include "TVMCommons.hpp"
+#include "TVMProfile.hpp"
+
+using namespace solidity::frontend;
+
+namespace {
+	// Branch is cold if its body is executed less often than once per ColdBranchRatio executions
+	const uint64_t ColdBranchRatio = 20;
+	// Max number of functions checked in the selector before the search tree
+	const size_t MaxHotPublicFunctions = 4;
+
+	uint64_t readCount(const Json::Value& value, const std::string& what) {
+		if (!value.isUInt64())
+			fatal_error("Bad profile: " + what + " should be a non-negative integer.");
+		return value.asUInt64();
+	}
+}
+
+std::unique_ptr<TVMProfile> TVMProfile::load(const std::string& fileName) {
+	if (!boost::filesystem::exists(fileName))
+		fatal_error("Profile file is not found: " + fileName);
+	Json::Value root;
+	std::string errors;
+	if (!util::jsonParseStrict(util::readFileAsString(fileName), root, &errors) || !root.isObject())
+		fatal_error("Failed to parse profile " + fileName + ": " + errors);
+
+	auto profile = std::make_unique<TVMProfile>();
+	const Json::Value& functions = root["functions"];
+	if (!functions.isNull() && !functions.isObject())
+		fatal_error("Bad profile: \"functions\" should be an object.");
+	for (const std::string& name : functions.getMemberNames()) {
+		uint64_t count = readCount(functions[name], "count of function " + name);
+		if (boost::starts_with(name, "0x")) {
+			try {
+				profile->m_functionIds[std::stoul(name, nullptr, 16)] += count;
+			} catch (const std::exception&) {
+				fatal_error("Bad profile: bad function id " + name);
+			}
+		} else {
+			profile->m_functions[name] += count;
+		}
+	}
+
+	const Json::Value& branches = root["branches"];
+	if (!branches.isNull() && !branches.isObject())
+		fatal_error("Bad profile: \"branches\" should be an object.");
+	for (const std::string& location : branches.getMemberNames()) {
+		const Json::Value& branch = branches[location];
+		size_t colon = location.rfind(':');
+		if (colon == std::string::npos || !branch.isObject())
+			fatal_error("Bad profile: branch should be set as \"file:line\": { \"taken\": N, \"total\": M }, got " + location);
+		int line{};
+		try {
+			line = std::stoi(location.substr(colon + 1));
+		} catch (const std::exception&) {
+			fatal_error("Bad profile: bad line number in " + location);
+		}
+		uint64_t taken = readCount(branch["taken"], "\"taken\" of branch " + location);
+		uint64_t total = readCount(branch["total"], "\"total\" of branch " + location);
+		auto& counts = profile->m_branches[branchKey(location.substr(0, colon), line)];
+		counts.first += taken;
+		counts.second += total;
+	}
+	return profile;
+}
+
+uint64_t TVMProfile::functionCount(const std::string& name) const {
+	auto it = m_functions.find(name);
+	return it == m_functions.end() ? 0 : it->second;
+}
+
+uint64_t TVMProfile::functionCount(uint32_t functionId, const std::string& name) const {
+	auto it = m_functionIds.find(functionId);
+	return functionCount(name) + (it == m_functionIds.end() ? 0 : it->second);
+}
+
+std::optional<bool> TVMProfile::isColdBranch(const std::string& sourceName, int line) const {
+	auto it = m_branches.find(branchKey(sourceName, line));
+	if (it == m_branches.end() || it->second.second == 0)
+		return std::nullopt;
+	const auto& [taken, total] = it->second;
+	return taken * ColdBranchRatio < total;
+}
+
+std::vector<std::pair<uint32_t, std::string>> TVMProfile::hotPublicFunctions(
+	const std::vector<std::pair<uint32_t, std::string>>& functions,
+	int searchTreeLevels
+) const {
+	std::vector<std::pair<uint64_t, size_t>> counts; // count, index
+	uint64_t total = 0;
+	for (size_t i = 0; i < functions.size(); ++i) {
+		uint64_t count = functionCount(functions[i].first, functions[i].second);
+		counts.emplace_back(count, i);
+		total += count;
+	}
+	std::stable_sort(counts.begin(), counts.end(), [](const auto& a, const auto& b) {
+		return a.first > b.first;
+	});
+
+	std::vector<std::pair<uint32_t, std::string>> res;
+	if (searchTreeLevels == 0) {
+		// no search tree, all functions are checked one by one
+		for (const auto& [count, index] : counts)
+			res.push_back(functions[index]);
+		return res;
+	}
+
+	// One extra check before the tree costs each other call one comparison and saves
+	// about 2.5 comparisons per tree level for the hot function.
+	const uint64_t treeChecks = 5 * searchTreeLevels / 2;
+	for (const auto& [count, index] : counts) {
+		if (res.size() == MaxHotPublicFunctions || count == 0 || count * (treeChecks + 1) <= total)
+			break;
+		res.push_back(functions[index]);
+		total -= count;
+	}
+	return res;
+}
+
+std::string TVMProfile::branchKey(const std::string& sourceName, int line) {
+	// Paths in the profile and in the compiler command line can differ, so only file names are compared
+	return boost::filesystem::path{sourceName}.filename().string() + ":" + std::to_string(line);
+}
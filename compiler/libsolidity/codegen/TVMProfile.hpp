@@ -0,0 +1,58 @@
+/*
+ * Copyright 2018-2019 TON DEV SOLUTIONS LTD.
+ *
+ * Licensed under the  terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License.
+ *
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the  GNU General Public License for more details at: https://www.gnu.org/licenses/gpl-3.0.html
+ */
+/**
+ * @author TON Labs <connect@tonlabs.io>
+ * @date 2021
+ * Execution profile of contract used for profile-guided optimizations
+ */
+
+#pragma once
+
+#include <map>
+#include <memory>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace solidity::frontend {
+
+// Profile is a JSON file collected from transactions of deployed contract:
+// {
+//     "functions": { "transfer": 1500, "0x4b1c2a3d": 20 },
+//     "branches": { "Wallet.sol:42": { "taken": 3, "total": 1500 } }
+// }
+// Functions are set by name or by function id. Branches are set by source location
+// (as in ".loc" of debug info) of "if" statement: how many times its body was executed
+// ("taken") and how many times the statement was executed ("total").
+class TVMProfile {
+public:
+	static std::unique_ptr<TVMProfile> load(const std::string& fileName);
+
+	uint64_t functionCount(const std::string& name) const;
+	uint64_t functionCount(uint32_t functionId, const std::string& name) const;
+	// Returns nullopt if there is no data for the branch, otherwise whether the branch is cold
+	std::optional<bool> isColdBranch(const std::string& sourceName, int line) const;
+	// Public functions that are checked in the selector before the search tree, hottest first
+	std::vector<std::pair<uint32_t, std::string>> hotPublicFunctions(
+		const std::vector<std::pair<uint32_t, std::string>>& functions,
+		int searchTreeLevels
+	) const;
+private:
+	static std::string branchKey(const std::string& sourceName, int line);
+private:
+	std::map<std::string, uint64_t> m_functions;
+	std::map<uint32_t, uint64_t> m_functionIds;
+	std::map<std::string, std::pair<uint64_t, uint64_t>> m_branches; // taken, total
+};
+
+}	// end solidity::frontend
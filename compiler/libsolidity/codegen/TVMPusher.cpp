@@ -21,6 +21,7 @@
 #include "TVMExpressionCompiler.hpp"
 #include "TVMStructCompiler.hpp"
 
+#include <boost/algorithm/string.hpp>
 #include <boost/range/adaptor/map.hpp>
 
 using namespace solidity::frontend;
@@ -68,6 +69,104 @@ void StackPusherHelper::pushString(const std::string& _str, bool toSlice) {
     getStack().ensureSize(saveStackSize + 1, "");
 }
 
+// Pushes array {length, dict} which elements are known at compile time. Dict is built here in canonical form, so
+// it's equal to the dict created by DICTUSET operations at runtime. `values` are bit strings of the elements.
+void StackPusherHelper::pushConstArray(const std::vector<std::string>& values) {
+	const int n = values.size();
+	pushInt(n);
+	if (n == 0) {
+		push(+1, "NEWDICT");
+	} else {
+		std::vector<std::string> keys;
+		for (int i = 0; i < n; ++i) {
+			std::string key;
+			addBinaryNumberToString(key, i, TvmConst::ArrayKeyLength);
+			keys.push_back(key);
+		}
+		const int saveStackSize = getStack().size();
+		push(+1, "PUSHREF {");
+		addTabs();
+		pushConstDictNode(keys, values, 0, n, 0);
+		endContinuation();
+		getStack().ensureSize(saveStackSize + 1, "");
+	}
+	push(-2 + 1, "PAIR");
+}
+
+std::optional<std::string> StackPusherHelper::constArrayElement(Type const* type, const bigint& value) {
+	std::string bits;
+	switch (type->category()) {
+		case Type::Category::Integer: {
+			auto intType = to<IntegerType>(type);
+			if (value < intType->minValue() || intType->maxValue() < value) {
+				return {};
+			}
+			bigint v = value;
+			if (v < 0) {
+				v += bigint(1) << intType->numBits();
+			}
+			addBinaryNumberToString(bits, v, intType->numBits());
+			return bits;
+		}
+		case Type::Category::Bool:
+			return value == 0 ? "0" : "1";
+		default:
+			return {};
+	}
+}
+
+// Label of the edge, see hml_short, hml_long and hml_same in TL-B scheme of Hashmap
+std::string StackPusherHelper::dictLabel(const std::string& label, int maxLength) {
+	const int len = label.size();
+	int k = 0;
+	while ((1 << k) <= maxLength) {
+		++k;
+	}
+	std::string lenBits;
+	addBinaryNumberToString(lenBits, len, k);
+	const bool isSame = len > 0 && label.find(label[0] == '0' ? '1' : '0') == std::string::npos;
+	if (isSame && len > 1 && k < 2 * len - 1) {
+		return "11" + label.substr(0, 1) + lenBits;
+	}
+	if (k < len) {
+		return "10" + lenBits + label;
+	}
+	return "0" + std::string(len, '1') + "0" + label;
+}
+
+void StackPusherHelper::pushConstDictNode(const std::vector<std::string>& keys, const std::vector<std::string>& values,
+										  int begin, int end, int keyOffset) {
+	// keys are sorted and have the same prefix of length `keyOffset`
+	const int keyLength = keys.at(begin).size();
+	int prefixLength = keyLength - keyOffset;
+	if (end - begin > 1) {
+		const std::string& first = keys.at(begin);
+		const std::string& last = keys.at(end - 1);
+		prefixLength = 0;
+		while (first[keyOffset + prefixLength] == last[keyOffset + prefixLength]) {
+			++prefixLength;
+		}
+	}
+	std::string bits = dictLabel(keys.at(begin).substr(keyOffset, prefixLength), keyLength - keyOffset);
+	if (end - begin == 1) {
+		bits += values.at(begin);
+		solAssert(static_cast<int>(bits.size()) <= TvmConst::CellBitLength, "");
+		push(0, ".blob x" + binaryStringToSlice(bits));
+		return;
+	}
+	push(0, ".blob x" + binaryStringToSlice(bits));
+	const int bitIndex = keyOffset + prefixLength;
+	int middle = begin;
+	while (keys.at(middle)[bitIndex] == '0') {
+		++middle;
+	}
+	for (auto [childBegin, childEnd] : {std::make_pair(begin, middle), std::make_pair(middle, end)}) {
+		startCell();
+		pushConstDictNode(keys, values, childBegin, childEnd, bitIndex + 1);
+		endContinuation();
+	}
+}
+
 void StackPusherHelper::pushLog() {
 	push(0, "CTOS");
 	push(0, "STRDUMP");
@@ -471,50 +570,60 @@ void StackPusherHelper::setDict(Type const &keyType, Type const &valueType, cons
 
 
 void StackPusherHelper::pollLastRetOpcode() {
-	int offset = 0;
-	int size = m_code.lines.size();
-	while (offset < size && cmpLastCmd("\\.loc .*", offset))
-	    ++offset;
-	solAssert(cmpLastCmd("RET", offset), "");
-	int begPos = size - 1 - offset;
-    m_code.lines.erase(m_code.lines.begin() + begPos);
+	solAssert(cmpLastCmd("RET"), "");
+	eraseLastCmd();
 }
 
 bool StackPusherHelper::tryPollConvertBuilderToSlice() {
-	int n = m_code.lines.size();
-	if (n >= 2 &&
-		cmpLastCmd("CTOS") &&
+	if (cmpLastCmd("CTOS") &&
 		cmpLastCmd("ENDC", 1)
 	)
 	{
-		m_code.lines.pop_back();
-		m_code.lines.pop_back();
+		eraseLastCmd();
+		eraseLastCmd();
 		return true;
 	}
 	return false;
 }
 
 bool StackPusherHelper::tryPollEmptyPushCont() {
-	int n = m_code.lines.size();
-	if (n >= 2 &&
-		(cmpLastCmd("PUSHCONT \\{", 1) || cmpLastCmd("PUSHREFCONT \\{", 1)) &&
+	if ((cmpLastCmd("PUSHCONT \\{", 1) || cmpLastCmd("PUSHREFCONT \\{", 1)) &&
 		cmpLastCmd("\\}")
 	) {
-		m_code.lines.pop_back();
-		m_code.lines.pop_back();
+		eraseLastCmd();
+		eraseLastCmd();
 		return true;
 	}
 	return false;
 }
 
 bool StackPusherHelper::cmpLastCmd(const std::string& cmd, int offset) {
-	int n = m_code.lines.size() - 1 - offset;
+	int n = lastCmdIndex(offset);
 	return n >= 0 &&
 		std::regex_match(m_code.lines.at(n), std::regex("(\t*)" + cmd));
 }
 
 void StackPusherHelper::pollLastOpcode() {
-	m_code.lines.pop_back();
+	eraseLastCmd();
+}
+
+// Index of the offset-th line from the end skipping source locations and comments,
+// e.g. ";; .loc" lines that are pushed for the profile without debug info
+int StackPusherHelper::lastCmdIndex(int offset) const {
+	for (int n = int(m_code.lines.size()) - 1; n >= 0; --n) {
+		std::string line = boost::algorithm::trim_copy(m_code.lines[n]);
+		if (boost::starts_with(line, ".loc ") || boost::starts_with(line, ";;"))
+			continue;
+		if (offset-- == 0)
+			return n;
+	}
+	return -1;
+}
+
+void StackPusherHelper::eraseLastCmd() {
+	int n = lastCmdIndex();
+	solAssert(n >= 0, "");
+	m_code.lines.erase(m_code.lines.begin() + n);
 }
 
 bool StackPusherHelper::optimizeIf() {
@@ -1444,7 +1553,8 @@ void StackPusherHelper::pushMacroCallInCallRef(int stackDelta, const string& fun
 void StackPusherHelper::pushCallOrCallRef(
 	const string &functionName,
 	const FunctionType *ft,
-	const std::optional<int>& deltaStack
+	const std::optional<int>& deltaStack,
+	bool isVirtualCall
 ) {
     // TODO simplify
 	int delta{};
@@ -1462,9 +1572,10 @@ void StackPusherHelper::pushCallOrCallRef(
 	}
 
 	auto _to = to<FunctionDefinition>(&ft->declaration());
+	if (isVirtualCall && _to)
+		_to = m_ctx->callGraph().resolveVirtual(_to);
 	FunctionDefinition const* v = m_ctx->getCurrentFunction();
-	bool hasLoop = m_ctx->addAndDoesHaveLoop(v, _to);
-	if (hasLoop) {
+	if (m_ctx->callGraph().isRecursiveCall(v, _to)) {
 		pushCall(delta, functionName);
 	} else {
 		pushMacroCallInCallRef(delta, functionName + "_macro");
@@ -1636,7 +1747,11 @@ void StackPusherHelper::prepareKeyForDictOperations(Type const *key, bool doIgno
 	}
 }
 
-int StackPusherHelper::int_msg_info(const std::set<int> &isParamOnStack, const std::map<int, std::string> &constParams) {
+int StackPusherHelper::int_msg_info(
+	const std::set<int> &isParamOnStack,
+	const std::map<int, std::string> &constParams,
+	MsgInfoPart part
+) {
 	// int_msg_info$0  ihr_disabled:Bool  bounce:Bool(#1)  bounced:Bool
 	//                 src:MsgAddress  dest:MsgAddressInt(#4)
 	//                 value:CurrencyCollection(#5,#6)  ihr_fee:Grams  fwd_fee:Grams
@@ -1649,38 +1764,49 @@ int StackPusherHelper::int_msg_info(const std::set<int> &isParamOnStack, const s
 									2, 2,
 									4, 1, 4, 4,
 									64, 32};
-	std::string bitString = "0";
+	// size of the whole message info is returned for any part
+	std::string bitString = part == MsgInfoPart::AfterValue ? "" : "0";
 	int maxBitStringSize = 0;
 	push(+1, "NEWC");
 	for (int param = 0; param < static_cast<int>(zeroes.size()); ++param) {
 		solAssert(constParams.count(param) == 0 || isParamOnStack.count(param) == 0, "");
+		const bool skip = part == (param <= TvmConst::int_msg_info::tons ? MsgInfoPart::AfterValue : MsgInfoPart::UpToValue);
 
 		if (constParams.count(param) != 0) {
-			bitString += constParams.at(param);
+			if (!skip)
+				bitString += constParams.at(param);
 			maxBitStringSize += constParams.at(param).length();
 		} else if (isParamOnStack.count(param) == 0) {
-			bitString += std::string(zeroes.at(param), '0');
+			if (!skip)
+				bitString += std::string(zeroes.at(param), '0');
 			maxBitStringSize += zeroes.at(param);
 			solAssert(param != TvmConst::int_msg_info::dest, "");
 		} else {
-			appendToBuilder(bitString);
-			bitString = "";
+			if (!skip) {
+				appendToBuilder(bitString);
+				bitString = "";
+			}
 			switch (param) {
 				case TvmConst::int_msg_info::bounce:
-					push(-1, "STI 1");
+					if (!skip)
+						push(-1, "STI 1");
 					++maxBitStringSize;
 					break;
 				case TvmConst::int_msg_info::dest:
-					push(-1, "STSLICE");
+					if (!skip)
+						push(-1, "STSLICE");
 					maxBitStringSize += AddressInfo::maxBitLength();
 					break;
 				case TvmConst::int_msg_info::tons:
-					exchange(0, 1);
-					push(-1, "STGRAMS");
+					if (!skip) {
+						exchange(0, 1);
+						push(-1, "STGRAMS");
+					}
 					maxBitStringSize += VarUIntegerInfo::maxTonBitLength();
 					break;
 				case TvmConst::int_msg_info::currency:
-					push(-1, "STDICT");
+					if (!skip)
+						push(-1, "STDICT");
 					++maxBitStringSize;
 					break;
 				default:
@@ -1802,6 +1928,52 @@ void StackPusherHelper::sendIntMsg(const std::map<int, Expression const *> &expr
 
 
 
+void StackPusherHelper::prepareIntMsgTemplate(const std::map<int, Expression const *> &exprs,
+											  const std::map<int, std::string> &constParams,
+											  const std::function<void(int)> &appendBody) {
+	// stack: body params
+	std::set<int> isParamOnStack;
+	for (auto &[param, expr] : exprs | boost::adaptors::reversed) {
+		isParamOnStack.insert(param);
+		if (param > TvmConst::int_msg_info::tons) {
+			TVMExpressionCompiler{*this}.compileNewExpr(expr);
+		}
+	}
+	int msgInfoSize = int_msg_info(isParamOnStack, constParams, MsgInfoPart::AfterValue);
+	appendToBuilder("0"); // there is no StateInit
+	++msgInfoSize;
+	if (appendBody) {
+		appendBody(msgInfoSize);
+	} else {
+		appendToBuilder("0"); // there is no body
+	}
+	// stack: builder
+}
+
+void StackPusherHelper::sendIntMsgByTemplate(const std::map<int, Expression const *> &exprs,
+											 const std::map<int, std::string> &constParams,
+											 int templateStackIndex,
+											 const std::function<void()> &pushSendrawmsgFlag) {
+	std::set<int> isParamOnStack;
+	for (auto &[param, expr] : exprs | boost::adaptors::reversed) {
+		isParamOnStack.insert(param);
+		if (param <= TvmConst::int_msg_info::tons) {
+			TVMExpressionCompiler{*this}.compileNewExpr(expr);
+		}
+	}
+	[[maybe_unused]] int msgInfoSize = int_msg_info(isParamOnStack, constParams, MsgInfoPart::UpToValue);
+	// stack: builder
+	pushS(getStack().size() - templateStackIndex);
+	push(-1, "STBR");
+	push(0, "ENDC");
+	if (pushSendrawmsgFlag) {
+		pushSendrawmsgFlag();
+	} else {
+		pushInt(TvmConst::SENDRAWMSG::DefaultFlag);
+	}
+	sendrawmsg();
+}
+
 void StackPusherHelper::prepareMsg(const std::set<int>& isParamOnStack,
 								const std::map<int, std::string> &constParams,
 								const std::function<void(int)> &appendBody,
@@ -1905,6 +2077,12 @@ int TVMStack::getStackSize(Declaration const *name) const {
     return -1;
 }
 
+Declaration const* TVMStack::top() const {
+	if (m_size == 0 || m_size > static_cast<int>(m_stackSize.size()))
+		return nullptr;
+	return m_stackSize.at(m_size - 1);
+}
+
 void TVMStack::ensureSize(int savedStackSize, const string &location, const ASTNode* node) const {
 	if (node != nullptr && savedStackSize != m_size) {
 		cast_error(*node, string{} + "Stake size error: expected: " + toString(savedStackSize)
@@ -2080,6 +2258,24 @@ string TVMCompilerContext::getFunctionInternalName(FunctionDefinition const* _fu
 	return functionName;
 }
 
+std::optional<int> TVMCompilerContext::messageTemplate(FunctionCall const* call) const {
+	auto it = m_messageTemplates.find(call);
+	if (it == m_messageTemplates.end())
+		return std::nullopt;
+	return it->second;
+}
+
+std::optional<int> TVMCompilerContext::loopInvariant(ASTNode const* node) const {
+	auto it = m_loopInvariants.find(node);
+	if (it == m_loopInvariants.end())
+		return std::nullopt;
+	return it->second;
+}
+
+string TVMCompilerContext::getSharedModifierName(ModifierDefinition const* m) {
+	return m->annotation().contract->name() + "_" + m->name() + "_modifier";
+}
+
 string TVMCompilerContext::getLibFunctionName(FunctionDefinition const* _function, bool withObject) {
 	std::string name = _function->annotation().contract->name() +
 			(withObject ? "_with_obj_" : "_no_obj_") +
@@ -2160,23 +2356,16 @@ const std::vector<std::pair<uint32_t, std::string>>& TVMCompilerContext::getPubl
 	return m_publicFunctions;
 }
 
-bool TVMCompilerContext::addAndDoesHaveLoop(FunctionDefinition const* _v, FunctionDefinition const* _to) {
-//	cerr << _v->name() << " -> " << _to->name() << "\n";
-	graph[_v].insert(_to);
-	graph[_to]; // creates default value if there is no such key
-	for (const auto& k : graph | boost::adaptors::map_keys) {
-		color[k] = Color::White;
-	}
-	bool hasLoop{};
-	for (const auto& k : graph | boost::adaptors::map_keys) {
-		if (dfs(k)) {
-			hasLoop = true;
-			graph[_v].erase(_to);
-			break;
-		}
-	}
-//	cerr << "hasLoop: " << hasLoop << "\n";
-	return hasLoop;
+TVMCallGraph const& TVMCompilerContext::callGraph() {
+	if (!m_callGraph)
+		m_callGraph = std::make_unique<TVMCallGraph>(m_contract);
+	return *m_callGraph;
+}
+
+ValueRangeScanner const& TVMCompilerContext::valueRanges() {
+	if (!m_valueRanges)
+		m_valueRanges = std::make_unique<ValueRangeScanner>(m_contract);
+	return *m_valueRanges;
 }
 
 bool TVMCompilerContext::isBaseFunction(CallableDeclaration const* d) const {
@@ -2191,24 +2380,6 @@ bool TVMCompilerContext::getSaveMyCodeSelector() {
 	return saveMyCodeSelector;
 }
 
-bool TVMCompilerContext::dfs(FunctionDefinition const* v) {
-	if (color.at(v) == Color::Black) {
-		return false;
-	}
-	if (color.at(v) == Color::Red) {
-		return true;
-	}
-	// It's white
-	color.at(v) = Color::Red;
-	for (FunctionDefinition const* _to : graph.at(v)) {
-		if (dfs(_to)) {
-			return true;
-		}
-	}
-	color.at(v) = Color::Black;
-	return false;
-}
-
 void StackPusherHelper::pushNull() {
 	push(+1, "NULL");
 }
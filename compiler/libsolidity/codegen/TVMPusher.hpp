@@ -25,6 +25,8 @@
 #include <libsolidity/ast/AST.h>
 #include <libsolidity/ast/ASTVisitor.h>
 
+#include "TVMAnalyzer.hpp"
+#include "TVMCallGraph.hpp"
 #include "TVMCommons.hpp"
 #include "TVMConstants.hpp"
 #include "TVMABI.hpp"
@@ -53,6 +55,8 @@ public:
 	int getOffset(Declaration const* name) const;
 	int getOffset(int stackPos) const;
 	int getStackSize(Declaration const* name) const;
+	// The variable on the top of the stack or nullptr
+	Declaration const* top() const;
 	void ensureSize(int savedStackSize, const string& location = "", const ASTNode* node = nullptr) const;
 };
 
@@ -103,8 +107,8 @@ public:
 	void addPublicFunction(uint32_t functionId, const std::string& functionName);
 	const std::vector<std::pair<uint32_t, std::string>>& getPublicFunctions();
 
-	bool addAndDoesHaveLoop(FunctionDefinition const* _v, FunctionDefinition const* _to);
-	bool dfs(FunctionDefinition const* v);
+	TVMCallGraph const& callGraph();
+	ValueRangeScanner const& valueRanges();
 	bool isFallBackGenerated() const { return m_isFallBackGenerated; }
 	void setIsFallBackGenerated() { m_isFallBackGenerated = true; }
 	bool isReceiveGenerated() const { return m_isReceiveGenerated; }
@@ -112,6 +116,18 @@ public:
 	bool isOnBounceGenerated() const { return m_isOnBounceGenerated; }
 	void setIsOnBounce() { m_isOnBounceGenerated = true; }
 	bool isBaseFunction(CallableDeclaration const* d) const;
+	void addSharedModifier(ModifierDefinition const* m) { m_sharedModifiers.insert(m); }
+	bool isSharedModifier(ModifierDefinition const* m) const { return m_sharedModifiers.count(m) != 0; }
+	static string getSharedModifierName(ModifierDefinition const* m);
+	// Message templates are built before loops, their index in the stack is saved
+	void addMessageTemplate(FunctionCall const* call, int stackIndex) { m_messageTemplates[call] = stackIndex; }
+	void removeMessageTemplate(FunctionCall const* call) { m_messageTemplates.erase(call); }
+	std::optional<int> messageTemplate(FunctionCall const* call) const;
+	// Values of loop invariant expressions and state variables are read before loops, their index
+	// in the stack is saved
+	void addLoopInvariant(ASTNode const* node, int stackIndex) { m_loopInvariants[node] = stackIndex; }
+	void removeLoopInvariant(ASTNode const* node) { m_loopInvariants.erase(node); }
+	std::optional<int> loopInvariant(ASTNode const* node) const;
 	void setSaveMyCodeSelector();
 	bool getSaveMyCodeSelector();
 
@@ -123,16 +139,16 @@ private:
 	std::set<FunctionDefinition const*> m_libFunctions;
 	FunctionDefinition const* m_currentFunction{};
 	std::map<std::string, CodeLines> m_inlinedFunctions;
-	std::map<FunctionDefinition const*, std::set<FunctionDefinition const*>> graph;
-	enum class Color {
-		White, Red, Black
-	};
-	std::map<FunctionDefinition const*, Color> color;
+	std::unique_ptr<TVMCallGraph> m_callGraph;
+	std::unique_ptr<ValueRangeScanner> m_valueRanges;
 	std::vector<std::pair<uint32_t, std::string>> m_publicFunctions;
 	bool m_isFallBackGenerated{};
 	bool m_isReceiveGenerated{};
 	bool m_isOnBounceGenerated{};
     std::set<CallableDeclaration const*> m_baseFunctions;
+	std::set<ModifierDefinition const*> m_sharedModifiers;
+	std::map<FunctionCall const*, int> m_messageTemplates;
+	std::map<ASTNode const*, int> m_loopInvariants;
     bool saveMyCodeSelector{};
 };
 
@@ -178,6 +194,8 @@ public:
 	StructCompiler& structCompiler();
 	TVMStack& getStack();
     void pushString(const std::string& str, bool toSlice);
+	void pushConstArray(const std::vector<std::string>& values);
+	static std::optional<std::string> constArrayElement(Type const* type, const bigint& value);
 	void pushLog();
 	void pushLines(const std::string& lines);
 	void untuple(int n);
@@ -220,7 +238,12 @@ public:
 	void push(const CodeLines& codeLines);
 	void pushParameter(std::vector<ASTPointer<VariableDeclaration>> const& params);
 	void pushMacroCallInCallRef(int stackDelta, const string& fname);
-	void pushCallOrCallRef(const string& functionName, FunctionType const* ft, const std::optional<int>& deltaStack = nullopt);
+	void pushCallOrCallRef(
+		const string& functionName,
+		FunctionType const* ft,
+		const std::optional<int>& deltaStack = nullopt,
+		bool isVirtualCall = false
+	);
 	void pushCall(int delta, const std::string& functionName);
 	void drop(int cnt = 1);
 	void blockSwap(int m, int n);
@@ -228,8 +251,19 @@ public:
 	void dropUnder(int leftCount, int droppedCount);
 	void exchange(int i, int j);
 	void prepareKeyForDictOperations(Type const* key, bool doIgnoreBytes);
+	// Parts of int_msg_info, the message template contains the part after the value. The value is
+	// stored by the send itself because STGRAMS throws on values out of range.
+	enum class MsgInfoPart {
+		Whole,
+		UpToValue,
+		AfterValue
+	};
 	[[nodiscard]]
-	int int_msg_info(const std::set<int> &isParamOnStack, const std::map<int, std::string> &constParams);
+	int int_msg_info(
+		const std::set<int> &isParamOnStack,
+		const std::map<int, std::string> &constParams,
+		MsgInfoPart part = MsgInfoPart::Whole
+	);
 	[[nodiscard]]
 	int ext_msg_info(const std::set<int> &isParamOnStack, bool isOut);
 	void appendToBuilder(const std::string& bitString);
@@ -281,6 +315,13 @@ public:
 					const std::map<int, std::string> &constParams,
 					const std::function<void(int)> &appendBody,
 					const std::function<void()> &pushSendrawmsgFlag);
+	void prepareIntMsgTemplate(const std::map<int, const Expression *> &exprs,
+							   const std::map<int, std::string> &constParams,
+							   const std::function<void(int)> &appendBody);
+	void sendIntMsgByTemplate(const std::map<int, const Expression *> &exprs,
+							  const std::map<int, std::string> &constParams,
+							  int templateStackIndex,
+							  const std::function<void()> &pushSendrawmsgFlag);
 
 	enum class MsgType{
 		Internal,
@@ -304,6 +345,13 @@ public:
 	void byteLengthOfCell();
 
 	void was_c4_to_c7_called();
+
+private:
+	int lastCmdIndex(int offset = 0) const;
+	void eraseLastCmd();
+	static std::string dictLabel(const std::string& label, int maxLength);
+	void pushConstDictNode(const std::vector<std::string>& keys, const std::vector<std::string>& values,
+						   int begin, int end, int keyOffset);
 };
 
 
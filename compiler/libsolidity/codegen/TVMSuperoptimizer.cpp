@@ -0,0 +1,225 @@
+/*
+ * Copyright 2018-2019 TON DEV SOLUTIONS LTD.
+ *
+ * Licensed under the  terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License.
+ *
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the  GNU General Public License for more details at: https://www.gnu.org/licenses/gpl-3.0.html
+ */
+/**
+ * @author TON Labs <connect@tonlabs.io>
+ * @date 2021
+ * Search for shorter equivalents of stack manipulation sequences
+ */
+
+#include <iostream>
+#include <map>
+#include <numeric>
+#include <set>
+
+#include "TVMOptimizations.hpp"
+#include "TVMPeepholeRules.hpp"
+#include "TVMSuperoptimizer.hpp"
+
+namespace solidity::frontend {
+
+namespace {
+
+// A command the search builds sequences from.
+// A stack manipulation is described by the permutation it applies to the top `inputs` values:
+// `outputs` lists, from the bottom up, which of the inputs (counted from the bottom too) are left on
+// the stack. Other commands are opaque: they replace their inputs with `results` new values.
+struct Command {
+	std::string opcode;
+	std::string operand;
+	bool opaque{};
+	bool hasOperand{}; // the operand of an opaque command is captured by the rule
+	int inputs{};
+	std::vector<int> outputs;
+	int results{};
+};
+
+std::vector<Command> alphabet() {
+	std::vector<Command> res;
+	auto stackOp = [&](std::string opcode, std::string operand, int inputs, std::vector<int> outputs) {
+		res.push_back({std::move(opcode), std::move(operand), false, false, inputs, std::move(outputs), 0});
+	};
+	// Only the forms the code generator emits, so that the other optimizations still recognize them.
+	stackOp("SWAP",    "",       2, {1, 0});
+	stackOp("ROT",     "",       3, {1, 2, 0});
+	stackOp("ROTREV",  "",       3, {2, 0, 1});
+	stackOp("DUP",     "",       1, {0, 0});
+	stackOp("PUSH",    "S1",     2, {0, 1, 0});
+	stackOp("PUSH",    "S2",     3, {0, 1, 2, 0});
+	stackOp("PUSH",    "S3",     4, {0, 1, 2, 3, 0});
+	stackOp("DUP2",    "",       2, {0, 1, 0, 1});
+	stackOp("DROP",    "",       1, {});
+	stackOp("DROP2",   "",       2, {});
+	stackOp("NIP",     "",       2, {1});
+	stackOp("POP",     "S2",     3, {2, 1});
+	stackOp("POP",     "S3",     4, {3, 1, 2});
+	stackOp("XCHG",    "S2",     3, {2, 1, 0});
+	stackOp("XCHG",    "S3",     4, {3, 1, 2, 0});
+	stackOp("XCHG",    "S1, S2", 3, {1, 0, 2});
+
+	// Representatives of commands that create, transform and consume values, with the stack effect
+	// the optimizer assumes for them.
+	for (auto [opcode, hasOperand] : {std::pair{"NEWC", false}, {"GETGLOB", true}, {"SETGLOB", true}, {"STU", true}}) {
+		std::optional<std::pair<int, int>> effect = simple_command_stack_effect(opcode, "");
+		solAssert(effect.has_value(), "");
+		res.push_back({opcode, "", true, hasOperand, effect->first, {}, effect->second});
+	}
+	return res;
+}
+
+// Enough unknown values for any sequence the search can build.
+int const c_stackDepth = 32;
+
+struct Effect {
+	// The stack after the sequence followed by the opaque commands (as negative numbers) with their
+	// inputs in execution order. Values are numbered from the bottom of the initial stack, new values
+	// get the following numbers in order of creation. Sequences with equal keys are interchangeable.
+	std::vector<int> key;
+	int depth{}; // number of values of the initial stack the sequence touches
+};
+
+std::optional<Effect> execute(std::vector<Command> const& _alphabet, std::vector<size_t> const& _sequence) {
+	std::vector<int> stack(c_stackDepth);
+	std::iota(stack.begin(), stack.end(), 0);
+	std::vector<int> trace;
+	int nextValue = c_stackDepth;
+	size_t lowest = stack.size();
+	for (size_t index : _sequence) {
+		Command const& command = _alphabet[index];
+		if (stack.size() < size_t(command.inputs))
+			return std::nullopt;
+		size_t const base = stack.size() - command.inputs;
+		lowest = std::min(lowest, base);
+		std::vector<int> const inputs(stack.begin() + base, stack.end());
+		stack.resize(base);
+		if (command.opaque) {
+			trace.push_back(-1 - int(index));
+			trace.insert(trace.end(), inputs.begin(), inputs.end());
+			for (int i = 0; i < command.results; ++i)
+				stack.push_back(nextValue++);
+		} else {
+			for (int i : command.outputs)
+				stack.push_back(inputs[i]);
+		}
+	}
+	Effect res;
+	res.key = std::move(stack);
+	res.key.insert(res.key.end(), trace.begin(), trace.end());
+	res.depth = c_stackDepth - int(lowest);
+	return res;
+}
+
+// Opaque commands with an operand get $1, $2, ... in order, so a pattern and its replacement, which
+// have the same opaque commands in the same order, agree on the captures.
+std::vector<std::string> toText(std::vector<Command> const& _alphabet, std::vector<size_t> const& _sequence) {
+	std::vector<std::string> res;
+	int captures = 0;
+	for (size_t index : _sequence) {
+		Command const& command = _alphabet[index];
+		if (command.hasOperand)
+			res.push_back(command.opcode + " $" + std::to_string(++captures));
+		else if (!command.operand.empty())
+			res.push_back(command.opcode + " " + command.operand);
+		else
+			res.push_back(command.opcode);
+	}
+	return res;
+}
+
+bool handledByRules(std::vector<std::string> const& _pattern) {
+	std::vector<PeepholeCommand> window;
+	for (std::string const& command : _pattern) {
+		std::string_view const text = command;
+		size_t const space = text.find(' ');
+		if (space == std::string_view::npos)
+			window.push_back({text, {}});
+		else
+			window.push_back({text.substr(0, space), text.substr(space + 1)});
+	}
+	return PeepholeRules::match(window.data(), window.size()).has_value();
+}
+
+std::string quoted(std::vector<std::string> const& _commands) {
+	std::string res = "{";
+	for (size_t i = 0; i < _commands.size(); ++i)
+		res += (i == 0 ? "\"" : ", \"") + _commands[i] + "\"";
+	return res + "}";
+}
+
+std::string padded(std::string _s, size_t _width) {
+	_s.resize(std::max(_s.size() + 1, _width), ' ');
+	return _s;
+}
+
+} // end anonymous namespace
+
+void run_superoptimizer(int maxLength) {
+	if (maxLength < 1 || maxLength > 6) {
+		cerr << "Sequence length must be between 1 and 6." << endl;
+		return;
+	}
+
+	std::vector<Command> const commands = alphabet();
+	struct Shortest {
+		std::vector<size_t> sequence;
+		int depth;
+	};
+	// The shortest known sequence for each effect. Sequences are enumerated by length, so an entry
+	// is final once the search moves on to longer sequences.
+	std::map<std::vector<int>, Shortest> shortest;
+	shortest.emplace(execute(commands, {})->key, Shortest{{}, 0});
+	// Sequences of the current length that have no shorter equivalent. Only they are extended:
+	// a sequence containing a reducible window is shortened by the rule for that window.
+	std::set<std::vector<size_t>> irreducible{{}};
+	for (int length = 1; length <= maxLength; ++length) {
+		std::set<std::vector<size_t>> next;
+		for (std::vector<size_t> const& prefix : irreducible) {
+			for (size_t index = 0; index < commands.size(); ++index) {
+				std::vector<size_t> sequence = prefix;
+				sequence.push_back(index);
+				if (!irreducible.count(std::vector<size_t>(sequence.begin() + 1, sequence.end())))
+					continue;
+				std::optional<Effect> effect = execute(commands, sequence);
+				if (!effect)
+					continue;
+
+				auto it = shortest.find(effect->key);
+				if (it == shortest.end()) {
+					shortest.emplace(effect->key, Shortest{sequence, effect->depth});
+					next.insert(sequence);
+					continue;
+				}
+				Shortest& best = it->second;
+				if (best.sequence.size() == sequence.size()) {
+					if (effect->depth < best.depth)
+						best = Shortest{sequence, effect->depth};
+					next.insert(sequence);
+					continue;
+				}
+				if (best.depth > effect->depth) {
+					// The replacement would touch values the original code doesn't know to exist
+					next.insert(sequence);
+					continue;
+				}
+
+				std::vector<std::string> const pattern = toText(commands, sequence);
+				if (handledByRules(pattern))
+					continue;
+				std::cout << "\t{" << padded("\"superopt\",", 22) << padded(quoted(pattern) + ",", 44)
+					<< pattern.size() << ", " << quoted(toText(commands, best.sequence)) << "}," << std::endl;
+			}
+		}
+		irreducible = std::move(next);
+	}
+}
+
+} // end solidity::frontend
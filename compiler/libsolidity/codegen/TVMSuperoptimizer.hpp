@@ -0,0 +1,29 @@
+/*
+ * Copyright 2018-2019 TON DEV SOLUTIONS LTD.
+ *
+ * Licensed under the  terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License.
+ *
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the  GNU General Public License for more details at: https://www.gnu.org/licenses/gpl-3.0.html
+ */
+/**
+ * @author TON Labs <connect@tonlabs.io>
+ * @date 2021
+ * Search for shorter equivalents of stack manipulation sequences
+ */
+
+#pragma once
+
+namespace solidity::frontend {
+
+	// Enumerates sequences of up to @a maxLength stack manipulations and simple commands, finds
+	// the shortest equivalent of each one by symbolic execution and prints the sequences that can be
+	// shortened as rows of the rule table in TVMPeepholeRules.cpp. Sequences already handled by the
+	// table are skipped, so the output only contains new rules.
+	void run_superoptimizer(int maxLength);
+
+} // end solidity::frontend
@@ -50,6 +50,7 @@
 #include <libsolutil/IpfsHash.h>
 #include <libsolutil/JSON.h>
 #include <libsolutil/Keccak256.h>
+#include <libsolutil/TimeReport.h>
 
 #include <json/json.h>
 #include <boost/algorithm/string.hpp>
@@ -201,7 +202,7 @@ void CompilerStack::setSources(StringMap _sources)
 		BOOST_THROW_EXCEPTION(CompilerError() << errinfo_comment("Cannot change sources once set."));
 	if (m_stackState != Empty)
 		BOOST_THROW_EXCEPTION(CompilerError() << errinfo_comment("Must set sources before parsing."));
-	for (auto source: _sources)
+	for (auto& source: _sources)
 		m_sources[source.first].scanner = make_shared<Scanner>(CharStream(/*content*/std::move(source.second), /*name*/source.first));
 	m_stackState = SourcesSet;
 }
@@ -211,6 +212,7 @@ bool CompilerStack::parse()
 	if (m_stackState != SourcesSet)
 		BOOST_THROW_EXCEPTION(CompilerError() << errinfo_comment("Must call parse only after the SourcesSet state."));
 	m_errorReporter.clear();
+	util::TimeReport::ScopedTimer timer{"parse"};
 
 	Parser parser{m_errorReporter, m_evmVersion, m_parserErrorRecovery};
 	vector<string> sourcesToParse;
@@ -228,15 +230,14 @@ bool CompilerStack::parse()
 		{
 			source.ast->annotation().path = path;
 			std::string absPath;
-			if (boost::filesystem::path(path).is_absolute())
+			if (m_sourcesInMemory || boost::filesystem::path(path).is_absolute())
 				absPath = path;
 			else
 				absPath = boost::filesystem::canonical(path).string();
-			for (auto const& newSource: loadMissingSources(*source.ast, absPath))
+			for (auto& newSource: loadMissingSources(*source.ast, absPath))
 			{
 				string const& newPath = newSource.first;
-				string const& newContents = newSource.second;
-				m_sources[newPath].scanner = make_shared<Scanner>(CharStream(newContents, newPath));
+				m_sources[newPath].scanner = make_shared<Scanner>(CharStream(std::move(newSource.second), newPath));
 				sourcesToParse.push_back(newPath);
 			}
 		}
@@ -260,7 +261,7 @@ void CompilerStack::importASTs(map<string, Json::Value> const& _sources)
 		Source source;
 		source.ast = src.second;
 		string srcString = util::jsonCompactPrint(m_sourceJsons[src.first]);
-		ASTPointer<Scanner> scanner = make_shared<Scanner>(langutil::CharStream(srcString, src.first));
+		ASTPointer<Scanner> scanner = make_shared<Scanner>(langutil::CharStream(std::move(srcString), src.first));
 		source.scanner = scanner;
 		m_sources[path] = source;
 	}
@@ -272,22 +273,26 @@ bool CompilerStack::analyze()
 {
 	if (m_stackState != ParsingPerformed || m_stackState >= AnalysisPerformed)
 		BOOST_THROW_EXCEPTION(CompilerError() << errinfo_comment("Must call analyze only after parsing was performed."));
+	util::TimeReport::ScopedTimer timer{"analyze"};
 	resolveImports();
 
 	bool noErrors = true;
 
 	try
 	{
+		util::TimeReport::ScopedTimer phaseTimer{"SyntaxChecker"};
 		SyntaxChecker syntaxChecker(m_errorReporter);
 		for (Source const* source: m_sourceOrder)
 			if (source->ast && !syntaxChecker.checkSyntax(*source->ast))
 				noErrors = false;
 
+		phaseTimer.next("DocStringAnalyser");
 		DocStringAnalyser docStringAnalyser(m_errorReporter);
 		for (Source const* source: m_sourceOrder)
 			if (source->ast && !docStringAnalyser.analyseDocStrings(*source->ast))
 				noErrors = false;
 
+		phaseTimer.next("NameAndTypeResolver");
 		m_globalContext = make_shared<GlobalContext>();
 		NameAndTypeResolver resolver(*m_globalContext, m_evmVersion, m_scopes, m_errorReporter);
 		for (Source const* source: m_sourceOrder)
@@ -329,6 +334,7 @@ bool CompilerStack::analyze()
 		// contract or function level.
 		// This also calculates whether a contract is abstract, which is needed by the
 		// type checker.
+		phaseTimer.next("ContractLevelChecker");
 		ContractLevelChecker contractLevelChecker(m_errorReporter);
 		for (Source const* source: m_sourceOrder)
 			if (source->ast)
@@ -344,6 +350,7 @@ bool CompilerStack::analyze()
 		//
 		// Note: this does not resolve overloaded functions. In order to do that, types of arguments are needed,
 		// which is only done one step later.
+		phaseTimer.next("TypeChecker");
 		TypeChecker typeChecker(m_evmVersion, m_errorReporter);
 		for (Source const* source: m_sourceOrder)
 			if (source->ast)
@@ -355,6 +362,7 @@ bool CompilerStack::analyze()
 		if (noErrors)
 		{
 			// Checks that can only be done when all types of all AST nodes are known.
+			phaseTimer.next("PostTypeChecker");
 			PostTypeChecker postTypeChecker(m_errorReporter);
 			for (Source const* source: m_sourceOrder)
 				if (source->ast && !postTypeChecker.check(*source->ast))
@@ -365,6 +373,7 @@ bool CompilerStack::analyze()
 		{
 			// Control flow graph generator and analyzer. It can check for issues such as
 			// variable is used before it is assigned to.
+			phaseTimer.next("ControlFlowAnalyzer");
 			CFG cfg(m_errorReporter);
 			for (Source const* source: m_sourceOrder)
 				if (source->ast && !cfg.constructFlow(*source->ast))
@@ -382,6 +391,7 @@ bool CompilerStack::analyze()
 		if (noErrors)
 		{
 			// Checks for common mistakes. Only generates warnings.
+			phaseTimer.next("StaticAnalyzer");
 			StaticAnalyzer staticAnalyzer(m_errorReporter);
 			for (Source const* source: m_sourceOrder)
 				if (source->ast && !staticAnalyzer.analyze(*source->ast))
@@ -396,12 +406,14 @@ bool CompilerStack::analyze()
 				if (source->ast)
 					ast.push_back(source->ast);
 
+			phaseTimer.next("ViewPureChecker");
 			if (!ViewPureChecker(ast, m_errorReporter).check())
 				noErrors = false;
 		}
 
 		if (noErrors) {
 			//Checks for TVM specific issues.
+			phaseTimer.next("TVMAnalyzer");
 			TVMAnalyzer tvmAnalyzer(m_errorReporter, m_structWarning);
 			for (Source const* source: m_sourceOrder)
 				if (source->ast && !tvmAnalyzer.analyze(*source->ast))
@@ -410,7 +422,7 @@ bool CompilerStack::analyze()
 
 		if (noErrors)
 		{
-
+			phaseTimer.next("TVMTypeChecker");
 			for (Source const* source: m_sourceOrder) {
 
 				std::vector<PragmaDirective const *> pragmaDirectives = getPragmaDirectives(source);
@@ -570,11 +582,14 @@ std::pair<bool, bool> CompilerStack::compile()
 				&targetPragmaDirectives,
 				m_generateAbi,
 				m_generateCode,
+				m_generateCodeStats,
+				m_generateGasEstimate,
 				m_withOptimizations,
 				m_withDebugInfo,
 				m_inputFile,
 				m_folder,
 				m_file_prefix,
+				m_profileFileName,
 				m_doPrintFunctionIds
 			);
 			didCompileSomething = true;
@@ -770,6 +785,40 @@ Json::Value CompilerStack::methodIdentifiers(string const& _contractName) const
 	return methodIdentifiers;
 }
 
+Json::Value CompilerStack::tvmOutputs(string const& _contractName, set<string> const& _outputs)
+{
+	if (m_stackState < AnalysisPerformed || m_hasError)
+		BOOST_THROW_EXCEPTION(CompilerError() << errinfo_comment("Analysis was not successful."));
+
+	ContractDefinition const& contract = contractDefinition(_contractName);
+	if (contract.isLibrary())
+		return Json::nullValue;
+
+	std::vector<PragmaDirective const *> pragmaDirectives = getPragmaDirectives(&source(contract.sourceUnitName()));
+	for (auto pragma: pragmaDirectives)
+		if (pragma->parameter())
+		{
+			TypeChecker typeChecker(m_evmVersion, m_errorReporter);
+			typeChecker.checkTypeRequirements(*pragma->parameter().get());
+		}
+
+	try
+	{
+		return TVMCompilerContractOutputs(
+			&m_errorReporter,
+			contract,
+			pragmaDirectives,
+			_outputs,
+			m_withOptimizations,
+			m_withDebugInfo
+		);
+	}
+	catch (FatalError const&)
+	{
+		return Json::nullValue;
+	}
+}
+
 string const& CompilerStack::metadata(string const& _contractName) const
 {
 	if (m_stackState < AnalysisPerformed)
@@ -907,6 +956,17 @@ StringMap CompilerStack::loadMissingSources(SourceUnit const& _ast, std::string
 				imp_path = boost::filesystem::path(_sourcePath).remove_filename() / imp_path;
 			}
 
+			if (m_sourcesInMemory) {
+				string sourceName = imp_path.lexically_normal().generic_string();
+				// lexically_normal() keeps the leading "./" of a relative path
+				if (boost::starts_with(sourceName, "./"))
+					sourceName = sourceName.substr(2);
+				if (m_sources.count(sourceName)) {
+					import->annotation().absolutePath = sourceName;
+					continue;
+				}
+			}
+
 			if (!boost::filesystem::exists(imp_path)) {
 				m_errorReporter.parserError(
 					import->location(),
@@ -932,7 +992,7 @@ StringMap CompilerStack::loadMissingSources(SourceUnit const& _ast, std::string
 				result = m_readFile(ReadCallback::kindString(ReadCallback::Kind::ReadFile), importPath);
 			}
 			if (result.success)
-				newSources[importPath] = result.responseOrErrorMessage;
+				newSources[importPath] = std::move(result.responseOrErrorMessage);
 			else
 			{
 				m_errorReporter.parserError(
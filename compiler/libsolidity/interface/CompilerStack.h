@@ -171,6 +171,12 @@ public:
 		m_forceUpdate = _forceUpdate;
 	}
 
+	/// Sources are given in memory (e.g. by Standard JSON) rather than read from files.
+	/// Their names are then used as they are and imports are resolved by name among them first.
+	void setSourcesInMemory(bool _sourcesInMemory) {
+		m_sourcesInMemory = _sourcesInMemory;
+	}
+
 	void setMainContract(std::string mainContract) {
 		m_mainContract = mainContract;
 	}
@@ -183,6 +189,14 @@ public:
 		m_generateCode = true;
 	}
 
+	void generateCodeStats() {
+		m_generateCodeStats = true;
+	}
+
+	void generateGasEstimate() {
+		m_generateGasEstimate = true;
+	}
+
 	void withOptimizations() {
 		m_withOptimizations = true;
 	}
@@ -200,6 +214,10 @@ public:
 		m_file_prefix = file_prefix;
 	}
 
+	void setProfileFile(const std::string& profileFileName) {
+		m_profileFileName = profileFileName;
+	}
+
 	void setInputFile(const std::string& inputFile) {
 		m_inputFile = inputFile;
 	}
@@ -328,12 +346,15 @@ public:
 	/// @returns a JSON representing a map of method identifiers (hashes) to function names.
 	Json::Value methodIdentifiers(std::string const& _contractName) const;
 
+	/// Generates the TVM outputs of the contract in memory. @a _outputs are the names of members of
+	/// the result ("assembly", "abi", "functionIds", "codeStats", "gasEstimates", "debugMap").
+	/// @returns null and adds the error to the error list if code generation fails.
+	/// Prerequisite: Successful call to parse or compile.
+	Json::Value tvmOutputs(std::string const& _contractName, std::set<std::string> const& _outputs);
+
 	/// @returns the Contract Metadata
 	std::string const& metadata(std::string const& _contractName) const;
 
-	/// @returns a JSON representing the estimated gas usage for contract creation, internal and external functions
-	Json::Value gasEstimates(std::string const& _contractName) const;
-
 	/// Overwrites the release/prerelease flag. Should only be used for testing.
 	void overwriteReleaseFlag(bool release) { m_release = release; }
 private:
@@ -485,12 +506,16 @@ private:
 	std::string m_mainContract;
 	bool m_generateAbi{};
 	bool m_generateCode{};
+	bool m_generateCodeStats{};
+	bool m_generateGasEstimate{};
 	bool m_withOptimizations{};
 	bool m_withDebugInfo{};
 	std::string m_folder;
 	std::string m_file_prefix;
 	std::string m_inputFile;
+	std::string m_profileFileName;
 	bool m_forceUpdate = false;
+	bool m_sourcesInMemory = false;
 	bool m_doPrintFunctionIds = false;
 };
 
@@ -23,6 +23,7 @@
 #include <libsolidity/interface/StandardCompiler.h>
 
 #include <libsolidity/ast/ASTJsonConverter.h>
+#include <libsolidity/codegen/TVM.h>
 #include <liblangutil/SourceReferenceFormatter.h>
 #include <libsolutil/JSON.h>
 #include <libsolutil/Keccak256.h>
@@ -42,6 +43,32 @@ using namespace solidity::langutil;
 namespace
 {
 
+/// Code generation keeps its settings in GlobalParams. They are restored when the compilation
+/// is over, so one call does not leak its settings (or its error reporter) into the next one.
+class GlobalParamsGuard
+{
+public:
+	GlobalParamsGuard():
+		m_errorReporter(GlobalParams::g_errorReporter),
+		m_withOptimizations(GlobalParams::g_withOptimizations),
+		m_withDebugInfo(GlobalParams::g_withDebugInfo),
+		m_profile(GlobalParams::g_profile)
+	{}
+	~GlobalParamsGuard()
+	{
+		GlobalParams::g_errorReporter = m_errorReporter;
+		GlobalParams::g_withOptimizations = m_withOptimizations;
+		GlobalParams::g_withDebugInfo = m_withDebugInfo;
+		GlobalParams::g_profile = m_profile;
+	}
+
+private:
+	ErrorReporter* m_errorReporter;
+	bool m_withOptimizations;
+	bool m_withDebugInfo;
+	TVMProfile const* m_profile;
+};
+
 Json::Value formatError(
 	bool _warning,
 	string const& _type,
@@ -158,7 +185,8 @@ bool hashMatchesContent(string const& _hash, string const& _content)
 
 bool isArtifactRequested(Json::Value const& _outputSelection, string const& _artifact, bool _wildcardMatchesExperimental)
 {
-	static set<string> experimental{"ir", "irOptimized", "wast", "ewasm", "ewasm.wast"};
+	// "tvm.debugMap" switches on debug info in "tvm.assembly", so it has to be requested explicitly too.
+	static set<string> experimental{"ir", "irOptimized", "wast", "ewasm", "ewasm.wast", "tvm.debugMap"};
 	for (auto const& artifact: _outputSelection)
 		/// @TODO support sub-matching, e.g "evm" matches "evm.assembly"
 		if (artifact == _artifact)
@@ -279,6 +307,24 @@ bool isIRRequested(Json::Value const& _outputSelection)
 	return false;
 }
 
+/// @returns the TVM outputs requested for the contract, named as the members of CompilerStack::tvmOutputs.
+set<string> requestedTvmOutputs(Json::Value const& _outputSelection, string const& _file, string const& _contract)
+{
+	static vector<pair<string, string>> const artifacts{
+		{"abi", "abi"},
+		{"tvm.assembly", "assembly"},
+		{"tvm.functionIds", "functionIds"},
+		{"tvm.codeStats", "codeStats"},
+		{"tvm.gasEstimates", "gasEstimates"},
+		{"tvm.debugMap", "debugMap"}
+	};
+	set<string> outputs;
+	for (auto const& [artifact, output]: artifacts)
+		if (isArtifactRequested(_outputSelection, _file, _contract, artifact, false))
+			outputs.insert(output);
+	return outputs;
+}
+
 std::optional<Json::Value> checkKeys(Json::Value const& _input, set<string> const& _keys, string const& _name)
 {
 	if (!!_input && !_input.isObject())
@@ -722,9 +768,11 @@ boost::variant<StandardCompiler::InputsAndSettings, Json::Value> StandardCompile
 
 Json::Value StandardCompiler::compileSolidity(StandardCompiler::InputsAndSettings _inputsAndSettings)
 {
+	GlobalParamsGuard globalParamsGuard;
 	CompilerStack compilerStack(m_readFile);
 
 	StringMap sourceList = std::move(_inputsAndSettings.sources);
+	compilerStack.setSourcesInMemory(true);
 	compilerStack.setSources(sourceList);
 	// TODO: do we need EVMVersion and other stuff?
 	compilerStack.setEVMVersion(_inputsAndSettings.evmVersion);
@@ -741,9 +789,13 @@ Json::Value StandardCompiler::compileSolidity(StandardCompiler::InputsAndSetting
 
 	compilerStack.enableEwasmGeneration(isEwasmRequested(_inputsAndSettings.outputSelection));
 
+	// The command line compiler always optimizes TVM code too.
+	compilerStack.withOptimizations();
+
 	Json::Value errors = std::move(_inputsAndSettings.errors);
 
 	bool const binariesRequested = isBinaryRequested(_inputsAndSettings.outputSelection);
+	map<string, Json::Value> tvmOutputs;
 
 	try
 	{
@@ -752,6 +804,20 @@ Json::Value StandardCompiler::compileSolidity(StandardCompiler::InputsAndSetting
 		else
 			compilerStack.parseAndAnalyze();
 
+		if (compilerStack.state() >= CompilerStack::State::AnalysisPerformed && !compilerStack.hasError())
+			for (string const& contractName: compilerStack.contractNames())
+			{
+				size_t colon = contractName.rfind(':');
+				solAssert(colon != string::npos, "");
+				set<string> outputs = requestedTvmOutputs(
+					_inputsAndSettings.outputSelection,
+					contractName.substr(0, colon),
+					contractName.substr(colon + 1)
+				);
+				if (!outputs.empty())
+					tvmOutputs[contractName] = compilerStack.tvmOutputs(contractName, outputs);
+			}
+
 		for (auto const& error: compilerStack.errors())
 		{
 			Error const& err = dynamic_cast<Error const&>(*error);
@@ -897,6 +963,19 @@ Json::Value StandardCompiler::compileSolidity(StandardCompiler::InputsAndSetting
 		if (compilationSuccess && isArtifactRequested(_inputsAndSettings.outputSelection, file, name, "irOptimized", wildcardMatchesExperimental))
 			contractData["irOptimized"] = compilerStack.yulIROptimized(contractName);
 
+		// TVM
+		if (tvmOutputs.count(contractName))
+		{
+			Json::Value& tvm = tvmOutputs[contractName];
+			if (tvm.isMember("abi"))
+			{
+				contractData["abi"] = std::move(tvm["abi"]);
+				tvm.removeMember("abi");
+			}
+			if (!tvm.empty())
+				contractData["tvm"] = std::move(tvm);
+		}
+
 		// TODO: do we need EVM?
 		// EVM
 		Json::Value evmData(Json::objectValue);
@@ -906,8 +985,6 @@ Json::Value StandardCompiler::compileSolidity(StandardCompiler::InputsAndSetting
 			evmData["legacyAssembly"] = compilerStack.assemblyJSON(contractName, sourceList);
 		if (isArtifactRequested(_inputsAndSettings.outputSelection, file, name, "evm.methodIdentifiers", wildcardMatchesExperimental))
 			evmData["methodIdentifiers"] = compilerStack.methodIdentifiers(contractName);
-		if (compilationSuccess && isArtifactRequested(_inputsAndSettings.outputSelection, file, name, "evm.gasEstimates", wildcardMatchesExperimental))
-			evmData["gasEstimates"] = compilerStack.gasEstimates(contractName);
 
 		if (compilationSuccess && isArtifactRequested(
 			_inputsAndSettings.outputSelection,
@@ -63,6 +63,73 @@ public:
 	}
 };
 
+/// Output buffer that forwards everything to another stream except for spaces right before a newline.
+/// jsoncpp puts such a space after the colon of each member with a non-empty object or array value.
+class TrailingSpaceFilter: public streambuf
+{
+public:
+	explicit TrailingSpaceFilter(ostream& _output): m_output(_output) {}
+
+	/// Writes a space that was held back because the input ended with it.
+	void finish()
+	{
+		if (m_pendingSpace)
+			m_output.put(' ');
+		m_pendingSpace = false;
+	}
+
+protected:
+	int_type overflow(int_type _c) override
+	{
+		if (traits_type::eq_int_type(_c, traits_type::eof()))
+			return traits_type::not_eof(_c);
+		char const c = traits_type::to_char_type(_c);
+		xsputn(&c, 1);
+		return _c;
+	}
+
+	streamsize xsputn(char const* _s, streamsize _n) override
+	{
+		char const* const end = _s + _n;
+		char const* it = _s;
+		if (m_pendingSpace && it != end)
+		{
+			m_pendingSpace = false;
+			if (*it != '\n')
+				m_output.put(' ');
+		}
+		char const* segment = it;
+		for (; it != end; ++it)
+			if (*it == ' ')
+			{
+				if (it + 1 == end)
+				{
+					m_output.write(segment, it - segment);
+					m_pendingSpace = true;
+					return _n;
+				}
+				if (it[1] == '\n')
+				{
+					m_output.write(segment, it - segment);
+					segment = it + 1;
+				}
+			}
+		m_output.write(segment, end - segment);
+		return _n;
+	}
+
+private:
+	ostream& m_output;
+	bool m_pendingSpace = false;
+};
+
+/// Serialise the JSON object (@a _input) with specific builder (@a _builder) into @a _output
+void print(Json::Value const& _input, Json::StreamWriterBuilder const& _builder, ostream& _output)
+{
+	unique_ptr<Json::StreamWriter> writer(_builder.newStreamWriter());
+	writer->write(_input, &_output);
+}
+
 /// Serialise the JSON object (@a _input) with specific builder (@a _builder)
 /// \param _input JSON input string
 /// \param _builder StreamWriterBuilder that is used to create new Json::StreamWriter
@@ -70,11 +137,24 @@ public:
 string print(Json::Value const& _input, Json::StreamWriterBuilder const& _builder)
 {
 	stringstream stream;
-	unique_ptr<Json::StreamWriter> writer(_builder.newStreamWriter());
-	writer->write(_input, &stream);
+	print(_input, _builder, stream);
 	return stream.str();
 }
 
+StreamWriterBuilder const& prettyWriterBuilder()
+{
+	static map<string, Json::Value> settings{{"indentation", "  "}, {"enableYAMLCompatibility", true}};
+	static StreamWriterBuilder writerBuilder(settings);
+	return writerBuilder;
+}
+
+StreamWriterBuilder const& compactWriterBuilder()
+{
+	static map<string, Json::Value> settings{{"indentation", ""}};
+	static StreamWriterBuilder writerBuilder(settings);
+	return writerBuilder;
+}
+
 /// Parse a JSON string (@a _input) with specified builder (@ _builder) and writes resulting JSON object to (@a _json)
 /// \param _builder CharReaderBuilder that is used to create new Json::CharReaders
 /// \param _input JSON input string
@@ -91,18 +171,27 @@ bool parse(Json::CharReaderBuilder& _builder, string const& _input, Json::Value&
 
 string jsonPrettyPrint(Json::Value const& _input)
 {
-	static map<string, Json::Value> settings{{"indentation", "  "}, {"enableYAMLCompatibility", true}};
-	static StreamWriterBuilder writerBuilder(settings);
-	string result = print(_input, writerBuilder);
+	string result = print(_input, prettyWriterBuilder());
 	boost::replace_all(result, " \n", "\n");
 	return result;
 }
 
+void jsonPrettyPrint(Json::Value const& _input, ostream& _output)
+{
+	TrailingSpaceFilter filter(_output);
+	ostream filteredOutput(&filter);
+	print(_input, prettyWriterBuilder(), filteredOutput);
+	filter.finish();
+}
+
 string jsonCompactPrint(Json::Value const& _input)
 {
-	static map<string, Json::Value> settings{{"indentation", ""}};
-	static StreamWriterBuilder writerBuilder(settings);
-	return print(_input, writerBuilder);
+	return print(_input, compactWriterBuilder());
+}
+
+void jsonCompactPrint(Json::Value const& _input, ostream& _output)
+{
+	print(_input, compactWriterBuilder(), _output);
 }
 
 bool jsonParseStrict(string const& _input, Json::Value& _json, string* _errs /* = nullptr */)
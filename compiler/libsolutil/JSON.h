@@ -24,6 +24,7 @@
 
 #include <json/json.h>
 
+#include <ostream>
 #include <string>
 
 namespace solidity::util {
@@ -31,9 +32,15 @@ namespace solidity::util {
 /// Serialise the JSON object (@a _input) with indentation
 std::string jsonPrettyPrint(Json::Value const& _input);
 
+/// Serialise the JSON object (@a _input) with indentation directly into @a _output
+void jsonPrettyPrint(Json::Value const& _input, std::ostream& _output);
+
 /// Serialise the JSON object (@a _input) without indentation
 std::string jsonCompactPrint(Json::Value const& _input);
 
+/// Serialise the JSON object (@a _input) without indentation directly into @a _output
+void jsonCompactPrint(Json::Value const& _input, std::ostream& _output);
+
 /// Parse a JSON string (@a _input) with enabled strict-mode and writes resulting JSON object to (@a _json)
 /// \param _input JSON input string
 /// \param _json [out] resulting JSON object
@@ -0,0 +1,114 @@
+/*
+	This file is part of solidity.
+
+	solidity is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	solidity is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with solidity.  If not, see <http://www.gnu.org/licenses/>.
+*/
+/**
+ * @date 2021
+ * Hierarchical report of time spent in compilation phases.
+ */
+
+#include <libsolutil/TimeReport.h>
+#include <libsolutil/Assertions.h>
+#include <libsolutil/Exceptions.h>
+
+#include <boost/format.hpp>
+
+#include <chrono>
+#include <ctime>
+
+using namespace std;
+using namespace solidity::util;
+
+bool TimeReport::s_enabled = false;
+uint64_t TimeReport::s_allocations = 0;
+vector<TimeReport::Phase> TimeReport::s_phases;
+vector<TimeReport::RunningPhase> TimeReport::s_running;
+
+namespace
+{
+
+double wallClockMs()
+{
+	using namespace std::chrono;
+	return duration<double, milli>(steady_clock::now().time_since_epoch()).count();
+}
+
+double cpuClockMs()
+{
+	return 1000.0 * static_cast<double>(clock()) / CLOCKS_PER_SEC;
+}
+
+}
+
+void TimeReport::count(string const& _name, uint64_t _value)
+{
+	if (!s_enabled || s_running.empty())
+		return;
+	s_phases[s_running.back().index].counters[_name] += _value;
+}
+
+void TimeReport::start(string const& _name)
+{
+	if (s_phases.empty())
+		s_phases.emplace_back(); // root
+	size_t parent = s_running.empty() ? 0 : s_running.back().index;
+	size_t index = s_phases.size();
+	for (size_t child: s_phases[parent].children)
+		if (s_phases[child].name == _name)
+		{
+			index = child;
+			break;
+		}
+	if (index == s_phases.size())
+	{
+		s_phases.emplace_back();
+		s_phases.back().name = _name;
+		s_phases[parent].children.push_back(index);
+	}
+	s_running.push_back({index, wallClockMs(), cpuClockMs(), s_allocations});
+}
+
+void TimeReport::stop()
+{
+	assertThrow(!s_running.empty(), Exception, "No running phase.");
+	RunningPhase running = s_running.back();
+	s_running.pop_back();
+	Phase& phase = s_phases[running.index];
+	phase.wallTime += wallClockMs() - running.wallStart;
+	phase.cpuTime += cpuClockMs() - running.cpuStart;
+	phase.allocations += s_allocations - running.allocationsStart;
+	++phase.calls;
+}
+
+string TimeReport::format()
+{
+	string out = (boost::format("%-60s %12s %12s %12s %8s\n") % "Phase" % "wall, ms" % "cpu, ms" % "allocations" % "calls").str();
+	if (!s_phases.empty())
+		for (size_t child: s_phases.front().children)
+			format(out, child, 0);
+	return out;
+}
+
+void TimeReport::format(string& _out, size_t _phase, size_t _depth)
+{
+	Phase const& phase = s_phases[_phase];
+	string name = string(2 * _depth, ' ') + phase.name;
+	_out += (boost::format("%-60s %12.3f %12.3f %12d %8d") % name % phase.wallTime % phase.cpuTime % phase.allocations % phase.calls).str();
+	for (auto const& [counter, value]: phase.counters)
+		_out += " " + counter + "=" + to_string(value);
+	_out += "\n";
+	for (size_t child: phase.children)
+		format(_out, child, _depth + 1);
+}
@@ -0,0 +1,130 @@
+/*
+	This file is part of solidity.
+
+	solidity is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	solidity is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with solidity.  If not, see <http://www.gnu.org/licenses/>.
+*/
+/**
+ * @date 2021
+ * Hierarchical report of time spent in compilation phases.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <map>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+namespace solidity::util
+{
+
+/**
+ * Collects wall clock time, CPU time and number of heap allocations (see
+ * registerAllocation()) of nested compilation phases. Phases with the same name
+ * and the same parent are merged. Collection is disabled by default, in which
+ * case timers do nothing.
+ *
+ * Usage:
+ *   TimeReport::ScopedTimer timer{"analyze"};
+ *   ...
+ *   timer.next("codegen"); // finishes "analyze" and starts sibling phase "codegen"
+ */
+class TimeReport
+{
+public:
+	class ScopedTimer
+	{
+	public:
+		explicit ScopedTimer(std::string const& _name): m_active(s_enabled)
+		{
+			if (m_active)
+				start(_name);
+		}
+		/// Takes a function that builds the name, so that it's only built if the report is enabled.
+		template <typename NameBuilder, typename = std::enable_if_t<std::is_invocable_r_v<std::string, NameBuilder const&>>>
+		explicit ScopedTimer(NameBuilder const& _name): m_active(s_enabled)
+		{
+			if (m_active)
+				start(_name());
+		}
+		~ScopedTimer()
+		{
+			if (m_active)
+				stop();
+		}
+		/// Finishes the current phase and starts the next one on the same level.
+		void next(std::string const& _name)
+		{
+			if (m_active)
+			{
+				stop();
+				start(_name);
+			}
+		}
+
+		ScopedTimer(ScopedTimer const&) = delete;
+		ScopedTimer& operator=(ScopedTimer const&) = delete;
+	private:
+		bool m_active;
+	};
+
+	static void enable() { s_enabled = true; }
+	static bool isEnabled() { return s_enabled; }
+
+	/// Adds @a _value to the counter @a _name of the innermost running phase.
+	static void count(std::string const& _name, uint64_t _value = 1);
+
+	/// @returns the report formatted as an indented table.
+	static std::string format();
+
+	/// Counts a heap allocation. The library doesn't hook allocations itself: a program that wants
+	/// them in the report calls this from its own replacement of the global operator new, as solc does.
+	/// Otherwise the allocation column stays zero.
+	static void registerAllocation()
+	{
+		if (s_enabled)
+			++s_allocations;
+	}
+
+private:
+	struct Phase
+	{
+		std::string name;
+		std::vector<size_t> children;
+		std::map<std::string, uint64_t> counters;
+		double wallTime = 0; // milliseconds
+		double cpuTime = 0; // milliseconds
+		uint64_t allocations = 0;
+		uint64_t calls = 0;
+	};
+	struct RunningPhase
+	{
+		size_t index;
+		double wallStart;
+		double cpuStart;
+		uint64_t allocationsStart;
+	};
+
+	static void start(std::string const& _name);
+	static void stop();
+	static void format(std::string& _out, size_t _phase, size_t _depth);
+
+	static bool s_enabled;
+	static uint64_t s_allocations;
+	static std::vector<Phase> s_phases;
+	static std::vector<RunningPhase> s_running;
+};
+
+}
@@ -62,6 +62,13 @@ else
     log_directory=""
 fi
 
+printTask "Running TVM commandline tests..."
+if ! "$REPO_ROOT/test/tvmCmdlineTests.sh" "$REPO_ROOT/$SOLIDITY_BUILD_DIR/solc/solc"
+then
+    printError "TVM commandline tests FAILED"
+    exit 1
+fi
+
 printTask "Running commandline tests..."
 # Only run in parallel if this is run on CI infrastructure
 if [[ -n "$CI" ]]
@@ -0,0 +1,129 @@
+#!/usr/bin/env python3
+
+"""
+Collects code size statistics of TVM assembly generated for the benchmark
+corpus and compares them against a baseline.
+
+Usage:
+    tvm_benchmark.py run --solc build/solc/solc -o current.json
+    tvm_benchmark.py compare baseline.json current.json --threshold 1.0
+
+"run" compiles every *.sol file of the corpus (test/tvmBenchmarks by default)
+with --tvm-code-stats and stores collected statistics in one JSON file.
+"compare" prints the difference between two such files and returns a non-zero
+exit code if some metric grew by more than the threshold (in percent).
+"""
+
+from argparse import ArgumentParser
+import glob
+import json
+import os
+import subprocess
+import sys
+import tempfile
+
+METRICS = ["instructions", "bits", "cells", "refs"]
+
+
+def run(args):
+    corpus = sorted(glob.glob(os.path.join(args.corpus, "*.sol")))
+    if not corpus:
+        print("No *.sol files in " + args.corpus, file=sys.stderr)
+        return 1
+
+    results = {}
+    failed = False
+    with tempfile.TemporaryDirectory() as outdir:
+        for sol in corpus:
+            name = os.path.splitext(os.path.basename(sol))[0]
+            proc = subprocess.run(
+                [args.solc, "--tvm-code-stats", "-o", outdir, "-f", name, sol],
+                stdout=subprocess.PIPE, stderr=subprocess.STDOUT, universal_newlines=True
+            )
+            statsFile = os.path.join(outdir, name + ".stats.json")
+            if proc.returncode != 0 or not os.path.exists(statsFile):
+                print("Failed to compile " + sol + ":\n" + proc.stdout, file=sys.stderr)
+                failed = True
+                continue
+            with open(statsFile) as f:
+                results[name] = json.load(f)
+
+    with open(args.output, "w") as f:
+        json.dump(results, f, indent=2, sort_keys=True)
+    print("Statistics of {} contracts were saved to file {}".format(len(results), args.output))
+    return 1 if failed else 0
+
+
+def percent(old, new):
+    if old == 0:
+        return 0.0 if new == 0 else 100.0
+    return 100.0 * (new - old) / old
+
+
+def compare(args):
+    with open(args.baseline) as f:
+        baseline = json.load(f)
+    with open(args.current) as f:
+        current = json.load(f)
+
+    regressions = []
+    print("{:<40} {:>12} {:>10} {:>10} {:>9}".format("contract/function", "metric", "baseline", "current", "diff %"))
+    for contract in sorted(set(baseline) | set(current)):
+        if contract not in baseline or contract not in current:
+            print("{:<40} {}".format(contract, "only in baseline" if contract in baseline else "new contract"))
+            continue
+        rows = [(contract, baseline[contract]["total"], current[contract]["total"])]
+        if args.functions:
+            oldFunctions = baseline[contract]["functions"]
+            newFunctions = current[contract]["functions"]
+            for function in sorted(set(oldFunctions) & set(newFunctions)):
+                rows.append(("  " + function, oldFunctions[function], newFunctions[function]))
+        for name, old, new in rows:
+            for metric in METRICS:
+                diff = percent(old[metric], new[metric])
+                if old[metric] == new[metric] and not args.verbose:
+                    continue
+                print("{:<40} {:>12} {:>10} {:>10} {:>+9.2f}".format(name, metric, old[metric], new[metric], diff))
+                if diff > args.threshold and name == contract:
+                    regressions.append((contract, metric, diff))
+
+    if regressions:
+        print("\nRegressions above {}%:".format(args.threshold))
+        for contract, metric, diff in regressions:
+            print("  {}: {} {:+.2f}%".format(contract, metric, diff))
+        return 1
+    print("\nNo regressions above {}%.".format(args.threshold))
+    return 0
+
+
+def main():
+    repoRoot = os.path.dirname(os.path.dirname(os.path.realpath(__file__)))
+    parser = ArgumentParser(description="Code size benchmark of the TVM backend.")
+    subparsers = parser.add_subparsers(dest="command")
+
+    runParser = subparsers.add_parser("run", help="Collect statistics for the corpus")
+    runParser.add_argument("--solc", default=os.path.join(repoRoot, "build", "solc", "solc"),
+                           help="Path to the solc binary")
+    runParser.add_argument("--corpus", default=os.path.join(repoRoot, "test", "tvmBenchmarks"),
+                           help="Directory with *.sol files")
+    runParser.add_argument("-o", "--output", required=True, help="Output JSON file")
+
+    compareParser = subparsers.add_parser("compare", help="Compare two results of 'run'")
+    compareParser.add_argument("baseline", help="Statistics of the baseline compiler")
+    compareParser.add_argument("current", help="Statistics of the current compiler")
+    compareParser.add_argument("--threshold", type=float, default=0.0,
+                               help="Allowed growth of a metric of a contract, in percent")
+    compareParser.add_argument("--functions", action="store_true", help="Print difference for each function")
+    compareParser.add_argument("-v", "--verbose", action="store_true", help="Print unchanged metrics too")
+
+    args = parser.parse_args()
+    if args.command == "run":
+        return run(args)
+    if args.command == "compare":
+        return compare(args)
+    parser.print_help()
+    return 1
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -27,6 +27,7 @@
 
 #include <libsolidity/interface/Version.h>
 #include <libsolidity/parsing/Parser.h>
+#include <libsolidity/ast/ASTBinary.h>
 #include <libsolidity/ast/ASTJsonConverter.h>
 #include <libsolidity/ast/ASTJsonImporter.h>
 #include <libsolidity/analysis/NameAndTypeResolver.h>
@@ -43,6 +44,7 @@
 #include <libsolutil/CommonData.h>
 #include <libsolutil/CommonIO.h>
 #include <libsolutil/JSON.h>
+#include <libsolutil/TimeReport.h>
 
 #include <memory>
 
@@ -63,6 +65,7 @@
 #include <fstream>
 
 #include <libsolidity/codegen/TVMOptimizations.hpp>
+#include <libsolidity/codegen/TVMSuperoptimizer.hpp>
 
 #if !defined(STDERR_FILENO)
 	#define STDERR_FILENO 2
@@ -109,6 +112,8 @@ static string const g_strFile = "file";
 static string const g_strVersion = "version";
 static string const g_argAstCompactJson = g_strAstCompactJson;
 static string const g_argAstJson = g_strAstJson;
+static string const g_argAstBinary = "ast-binary";
+static string const g_argAstBinaryToJson = "ast-binary-to-json";
 static string const g_argHelp = g_strHelp;
 static string const g_argInputFile = g_strInputFile;
 static string const g_argNatspecDev = g_strNatspecDev;
@@ -116,16 +121,22 @@ static string const g_argNatspecUser = g_strNatspecUser;
 static string const g_argOutputDir = g_strOutputDir;
 static string const g_argFile = g_strFile;
 static string const g_argVersion = g_strVersion;
+static string const g_argStandardJSON = "standard-json";
 
 static string const g_argDebug = "debug";
 static string const g_argSetContract = "contract";
 static string const g_argTvm = "tvm";
 static string const g_argTvmABI = "tvm-abi";
+static string const g_argTvmCodeStats = "tvm-code-stats";
+static string const g_argTvmGasEstimate = "tvm-gas-estimate";
 static string const g_argTvmOptimize = "tvm-optimize";
 static string const g_argTvmPeephole = "tvm-peephole";
+static string const g_argTvmProfile = "tvm-profile";
+static string const g_argTvmSuperoptimize = "tvm-superoptimize";
 static string const g_argRefreshRemote = "tvm-refresh-remote";
 static string const g_argTvmUnsavedStructs = "tvm-unsaved-structs";
 static string const g_argFunctionIds = "function-ids";
+static string const g_argTimeReport = "time-report";
 
 
 static void version()
@@ -271,6 +282,12 @@ Allowed options)",
 		(g_argHelp.c_str(), "Show help message and exit.")
 		(g_argVersion.c_str(), "Show version and exit.")
 		(g_strLicense.c_str(), "Show licensing information and exit.")
+		(
+			g_argStandardJSON.c_str(),
+			"Switch to Standard JSON input / output mode, ignoring all options. "
+			"It reads from standard input, if no input file was given, otherwise it reads from the provided input file. "
+			"The result will be written to standard output."
+		)
 		(
 			(g_argOutputDir + ",o").c_str(),
 			po::value<string>()->value_name("path/to/dir"),
@@ -286,6 +303,27 @@ Allowed options)",
 			po::value<string>()->value_name("prefixName"),
 			"Set prefix of names of output files (*.code and *abi.json)."
 		)
+		(
+			g_argTvmProfile.c_str(),
+			po::value<string>()->value_name("path/to/profile.json"),
+			"Use profile of contract execution (call counts of functions and branches) to optimize code placement."
+		)
+		(
+			g_argTvmSuperoptimize.c_str(),
+			po::value<int>()->value_name("length"),
+			"Find stack manipulation sequences up to the given length that have shorter equivalents "
+			"and print them as peephole optimizer rules."
+		)
+		(
+			g_argAstBinary.c_str(),
+			po::value<string>()->value_name("path/to/file.ast"),
+			"Save AST of all source files in a compact binary format."
+		)
+		(
+			g_argAstBinaryToJson.c_str(),
+			po::value<string>()->value_name("path/to/file.ast"),
+			"Print AST saved by --ast-binary in the compact JSON format."
+		)
 		;
 	po::options_description outputComponents("Output Components");
 	outputComponents.add_options()
@@ -295,11 +333,14 @@ Allowed options)",
 		(g_argNatspecDev.c_str(), "Natspec developer documentation of all contracts.")
 		(g_argTvm.c_str(), "Produce TVM assembly (deprecated).")
 		(g_argTvmABI.c_str(), "Produce JSON ABI for contract.")
+		(g_argTvmCodeStats.c_str(), "Produce JSON with estimated code size of each function of contract.")
+		(g_argTvmGasEstimate.c_str(), "Produce JSON with static estimation of gas (min, typical, max) of each function of contract.")
 		(g_argFunctionIds.c_str(), "Print name and id for each public function.")
 		(g_argTvmPeephole.c_str(), "Run peephole optimization pass")
 		(g_argTvmOptimize.c_str(), "Optimize produced TVM assembly code (deprecated)")
 		(g_argTvmUnsavedStructs.c_str(), "Enable struct usage analyzer")
 		(g_argDebug.c_str(), "Generate debug info")
+		(g_argTimeReport.c_str(), "Print time spent in compilation phases, contracts, functions and optimizer passes.")
 		(g_argRefreshRemote.c_str(), "Force download and rewrite remote import files");
 	desc.add(outputComponents);
 
@@ -344,6 +385,11 @@ Allowed options)",
 		return false;
 	}
 
+	if (m_args.count(g_argTvmSuperoptimize)) {
+		run_superoptimizer(m_args[g_argTvmSuperoptimize].as<int>());
+		return false;
+	}
+
 	m_coloredOutput = isatty(STDERR_FILENO);//!m_args.count(g_argNoColor) && (isatty(STDERR_FILENO) || m_args.count(g_argColor));
 
 	if (m_args.count(g_argHelp) || (isatty(fileno(stdin)) && _argc == 1))
@@ -371,6 +417,15 @@ Allowed options)",
 
 bool CommandLineInterface::processInput()
 {
+	if (m_args.count(g_argTimeReport))
+		TimeReport::enable();
+
+	if (m_args.count(g_argAstBinaryToJson))
+	{
+		m_onlyPrintAstBinary = true;
+		return true;
+	}
+
 	ReadCallback::Callback fileReader = [this](string const& _kind, string const& _path)
 	{
 		try
@@ -389,9 +444,7 @@ bool CommandLineInterface::processInput()
 			if (!boost::filesystem::is_regular_file(canonicalPath))
 				return ReadCallback::Result{false, "Not a valid file."};
 
-			auto contents = readFileAsString(canonicalPath.string());
-			m_sourceCodes[path.generic_string()] = contents;
-			return ReadCallback::Result{true, contents};
+			return ReadCallback::Result{true, readFileAsString(canonicalPath.string())};
 		}
 		catch (Exception const& _exception)
 		{
@@ -403,8 +456,22 @@ bool CommandLineInterface::processInput()
 		}
 	};
 
-	if (!readInputFilesAndConfigureRemappings())
-		return false;
+	if (m_args.count(g_argStandardJSON))
+	{
+		string jsonFile;
+		if (m_args.count(g_argInputFile))
+			jsonFile = m_args[g_argInputFile].as<string>();
+		string input = jsonFile.empty() ? readStandardInput() : readFileAsString(jsonFile);
+		StandardCompiler compiler(fileReader);
+		sout() << compiler.compile(std::move(input)) << endl;
+		return true;
+	}
+
+	{
+		TimeReport::ScopedTimer timer{"read input"};
+		if (!readInputFilesAndConfigureRemappings())
+			return false;
+	}
 
 	m_compiler = make_unique<CompilerStack>(fileReader);
 
@@ -415,7 +482,8 @@ bool CommandLineInterface::processInput()
 	{
 		if (m_args.count(g_argInputFile))
 			m_compiler->setRemappings(m_remappings);
-		m_compiler->setSources(m_sourceCodes);
+		// The compiler stack owns the sources from now on, names are taken from it.
+		m_compiler->setSources(std::move(m_sourceCodes));
 
 		if (m_args.count(g_argTvmUnsavedStructs))
 			m_compiler->setStructWarning(true);
@@ -432,6 +500,9 @@ bool CommandLineInterface::processInput()
 		if (m_args.count(g_argFile))
 			m_compiler->setFileNamePrefix(m_args[g_argFile].as<string>());
 
+		if (m_args.count(g_argTvmProfile))
+			m_compiler->setProfileFile(m_args[g_argTvmProfile].as<string>());
+
 		if (m_args.count(g_argTvmABI))
 			m_compiler->generateAbi();
 		if (m_args.count(g_argTvm))
@@ -440,6 +511,10 @@ bool CommandLineInterface::processInput()
 			m_compiler->generateCode();
 			m_compiler->generateAbi();
         }
+		if (m_args.count(g_argTvmCodeStats))
+			m_compiler->generateCodeStats();
+		if (m_args.count(g_argTvmGasEstimate))
+			m_compiler->generateGasEstimate();
         m_compiler->withOptimizations();
         if (m_args.count(g_argTvmOptimize))
             serr() << "Flag '--tvm-optimize' is deprecated. Code is optimized by default." << endl;
@@ -454,9 +529,18 @@ bool CommandLineInterface::processInput()
 
 		bool successful{};
 		bool didCompileSomething{};
-		std::tie(successful, didCompileSomething) = m_compiler->compile();
+		{
+			TimeReport::ScopedTimer timer{"compile"};
+			std::tie(successful, didCompileSomething) = m_compiler->compile();
+		}
 		g_hasOutput |= didCompileSomething;
 
+		if (TimeReport::isEnabled())
+		{
+			g_hasOutput = true;
+			sout() << TimeReport::format();
+		}
+
 		for (auto const& error: m_compiler->errors())
 		{
 			g_hasOutput = true;
@@ -538,23 +622,69 @@ void CommandLineInterface::handleAst(string const& _argStr)
 	if (m_args.count(_argStr))
 	{
 		vector<ASTNode const*> asts;
-		for (auto const& sourceCode: m_sourceCodes)
-			asts.push_back(&m_compiler->ast(sourceCode.first));
+		for (string const& sourceName: m_compiler->sourceNames())
+			asts.push_back(&m_compiler->ast(sourceName));
 
 		bool legacyFormat = !m_args.count(g_argAstCompactJson);
 
 		sout() << title << endl << endl;
-		for (auto const& sourceCode: m_sourceCodes)
+		for (string const& sourceName: m_compiler->sourceNames())
 		{
-			sout() << endl << "======= " << sourceCode.first << " =======" << endl;
-			ASTJsonConverter(legacyFormat, m_compiler->sourceIndices()).print(sout(), m_compiler->ast(sourceCode.first));
+			sout() << endl << "======= " << sourceName << " =======" << endl;
+			ASTJsonConverter(legacyFormat, m_compiler->sourceIndices()).print(sout(), m_compiler->ast(sourceName));
 		}
 	}
 }
 
+void CommandLineInterface::handleAstBinary()
+{
+	if (!m_args.count(g_argAstBinary))
+		return;
+
+	map<string, Json::Value> asts;
+	for (string const& sourceName: m_compiler->sourceNames())
+		asts[sourceName] = ASTJsonConverter(false, m_compiler->sourceIndices()).toJson(m_compiler->ast(sourceName));
+
+	string const fileName = m_args[g_argAstBinary].as<string>();
+	ofstream ofile(fileName, ios::binary);
+	if (!ofile)
+	{
+		serr() << "Failed to open the output file: " << fileName << endl;
+		m_error = true;
+		return;
+	}
+	ASTBinary::write(asts, ofile);
+}
+
+void CommandLineInterface::printAstBinary()
+{
+	string const fileName = m_args[g_argAstBinaryToJson].as<string>();
+	optional<map<string, Json::Value>> asts = ASTBinary::read(readFileAsString(fileName));
+	if (!asts)
+	{
+		serr() << "Failed to read the binary AST: " << fileName << endl;
+		m_error = true;
+		return;
+	}
+
+	sout() << "JSON AST (compact format):" << endl << endl;
+	for (auto const& [sourceName, ast]: *asts)
+	{
+		sout() << endl << "======= " << sourceName << " =======" << endl;
+		util::jsonPrettyPrint(ast, sout());
+	}
+}
+
 bool CommandLineInterface::actOnInput()
 {
-	outputCompilationResults();
+	if (m_args.count(g_argStandardJSON))
+		// Already done in "processInput" phase.
+		return true;
+
+	if (m_onlyPrintAstBinary)
+		printAstBinary();
+	else
+		outputCompilationResults();
 	return !m_error;
 }
 
@@ -563,6 +693,7 @@ void CommandLineInterface::outputCompilationResults()
 	// do we need AST output?
 	handleAst(g_argAstJson);
 	handleAst(g_argAstCompactJson);
+	handleAstBinary();
 
 	if (!m_compiler->compilationSuccessful())
 	{
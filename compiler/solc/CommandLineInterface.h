@@ -61,6 +61,9 @@ private:
 
 //	void handleCombinedJSON();
 	void handleAst(std::string const& _argStr);
+	void handleAstBinary();
+	/// Prints the ASTs from the file given to --ast-binary-to-json like --ast-compact-json does.
+	void printAstBinary();
 //	void handleBinary(std::string const& _contract);
 //	void handleOpcode(std::string const& _contract);
 //	void handleIR(std::string const& _contract);
@@ -101,9 +104,11 @@ private:
 
 	bool m_onlyLink = false;
 
+	bool m_onlyPrintAstBinary = false;
+
 	/// Compiler arguments variable map
 	boost::program_options::variables_map m_args;
-	/// map of input files to source code strings
+	/// map of input files to source code strings, handed over to the compiler stack before parsing
 	std::map<std::string, std::string> m_sourceCodes;
 	/// list of remappings
 	std::vector<frontend::CompilerStack::Remapping> m_remappings;
@@ -21,9 +21,12 @@
  */
 
 #include <solc/CommandLineInterface.h>
+#include <libsolutil/TimeReport.h>
 #include <boost/exception/all.hpp>
 #include <clocale>
+#include <cstdlib>
 #include <iostream>
+#include <new>
 
 using namespace std;
 
@@ -50,6 +53,34 @@ static void setDefaultOrCLocale()
 #endif
 }
 
+// Replaced global allocation functions, so that --time-report can show the number of allocations.
+// Memory is managed by malloc and free as in the default implementation.
+void* operator new(size_t _size)
+{
+	solidity::util::TimeReport::registerAllocation();
+	if (_size == 0)
+		_size = 1;
+	while (true)
+	{
+		if (void* p = malloc(_size))
+			return p;
+		new_handler handler = get_new_handler();
+		if (!handler)
+			throw bad_alloc();
+		handler();
+	}
+}
+
+void operator delete(void* _p) noexcept
+{
+	free(_p);
+}
+
+void operator delete(void* _p, size_t) noexcept
+{
+	free(_p);
+}
+
 int main(int argc, char** argv)
 {
 	setDefaultOrCLocale();
@@ -0,0 +1,567 @@
+/*
+ * Copyright 2018-2019 TON DEV SOLUTIONS LTD.
+ *
+ * Licensed under the  terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License.
+ *
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the  GNU General Public License for more details at: https://www.gnu.org/licenses/gpl-3.0.html
+ */
+/**
+ * @author TON Labs <connect@tonlabs.io>
+ * @date 2021
+ * Model of the TVM commands the peephole optimizer works with
+ */
+
+#include <test/tools/ossfuzz/tvmStackModel.h>
+
+#include <boost/algorithm/string/trim.hpp>
+
+#include <algorithm>
+
+using namespace std;
+using namespace solidity;
+using namespace solidity::frontend::test::tvm_fuzzer;
+
+namespace {
+
+struct Exception {
+	int code;
+};
+
+bigint const c_intLimit = bigint(1) << 256;
+int const c_maxCellBits = 1023;
+
+bigint floorDiv(bigint const& _a, bigint const& _b) {
+	bigint q = _a / _b;
+	if (q * _b != _a && ((_a < 0) != (_b < 0)))
+		--q;
+	return q;
+}
+
+bool fitsSigned(bigint const& _x, int _bits) {
+	bigint const limit = bigint(1) << (_bits - 1);
+	return -limit <= _x && _x < limit;
+}
+
+bool fitsUnsigned(bigint const& _x, int _bits) {
+	return 0 <= _x && _x < (bigint(1) << _bits);
+}
+
+string toBits(bigint _x, int _bits) {
+	if (_x < 0)
+		_x += bigint(1) << _bits;
+	string res(_bits, '0');
+	for (int i = _bits - 1; i >= 0; --i, _x >>= 1)
+		if ((_x & 1) != 0)
+			res[i] = '1';
+	return res;
+}
+
+// Parses "0", "1" and hex slice literals ("x4", "xA_") the way the assembler does.
+string parseSlice(string const& _literal) {
+	if (_literal == "0" || _literal == "1")
+		return _literal;
+	if (_literal.size() < 2 || _literal[0] != 'x')
+		throw UnsupportedCommand{"slice literal " + _literal};
+	string bits;
+	bool completionTag = false;
+	for (size_t i = 1; i < _literal.size(); ++i) {
+		char const ch = _literal[i];
+		if (ch == '_' && i + 1 == _literal.size()) {
+			completionTag = true;
+			break;
+		}
+		if (!isxdigit(ch))
+			throw UnsupportedCommand{"slice literal " + _literal};
+		int const digit = isdigit(ch) ? ch - '0' : tolower(ch) - 'a' + 10;
+		bits += toBits(digit, 4);
+	}
+	if (completionTag) {
+		size_t const last = bits.find_last_of('1');
+		if (last == string::npos)
+			throw UnsupportedCommand{"slice literal " + _literal};
+		bits.resize(last);
+	}
+	return bits;
+}
+
+class Machine {
+public:
+	Machine(State& _state, bool _booleanNot) : m_state{_state}, m_booleanNot{_booleanNot} {}
+
+	// @returns number of lines the command takes
+	size_t step(vector<string> const& _lines, size_t _index) {
+		string line = _lines[_index];
+		line = line.substr(0, line.find(';'));
+		boost::algorithm::trim(line);
+		if (line.empty())
+			return 1;
+		size_t const space = line.find(' ');
+		string const opcode = line.substr(0, space);
+		vector<string> args;
+		if (space != string::npos) {
+			string operand = line.substr(space + 1);
+			size_t begin = 0;
+			while (true) {
+				size_t const comma = operand.find(',', begin);
+				args.push_back(boost::algorithm::trim_copy(operand.substr(begin, comma - begin)));
+				if (comma == string::npos)
+					break;
+				begin = comma + 1;
+			}
+		}
+
+		if (opcode == "PUSHREF") {
+			// Only an empty cell, as the optimizer writes NEWC ENDC
+			if (args != vector<string>{"{"} || _index + 1 == _lines.size() || boost::algorithm::trim_copy(_lines[_index + 1]) != "}")
+				throw UnsupportedCommand{line};
+			push(cell(""));
+			return 2;
+		}
+		execute(opcode, args, line);
+		return 1;
+	}
+
+private:
+	void execute(string const& op, vector<string> const& args, string const& line) {
+		auto arg = [&](size_t i) -> string const& {
+			if (i >= args.size())
+				throw UnsupportedCommand{line};
+			return args[i];
+		};
+		auto reg = [&](size_t i) {
+			string const& a = arg(i);
+			if (a.size() < 2 || (a[0] != 's' && a[0] != 'S'))
+				throw UnsupportedCommand{line};
+			return stoi(a.substr(1));
+		};
+		auto num = [&](size_t i) {
+			return stoi(arg(i));
+		};
+		auto bignum = [&](size_t i) {
+			return bigint(arg(i));
+		};
+
+		// Stack manipulations
+		if (op == "SWAP") return exchange(0, 1);
+		if (op == "XCHG") return args.size() == 1 ? exchange(0, reg(0)) : exchange(reg(0), reg(1));
+		if (op == "ROT") return blockSwap(1, 2);
+		if (op == "ROTREV") return blockSwap(2, 1);
+		if (op == "SWAP2") return blockSwap(2, 2);
+		if (op == "BLKSWAP") return blockSwap(num(0), num(1));
+		if (op == "REVERSE") {
+			int const n = num(0), j = num(1);
+			need(n + j);
+			auto end = m_state.stack.end() - j;
+			reverse(end - n, end);
+			return;
+		}
+		if (op == "DUP") return push(at(0));
+		if (op == "OVER") return push(at(1));
+		if (op == "PUSH") return push(at(reg(0)));
+		if (op == "PUSH2") {
+			int const i = reg(0), j = reg(1);
+			push(at(i));
+			return push(at(j + 1));
+		}
+		if (op == "PUSH3") {
+			int const i = reg(0), j = reg(1), k = reg(2);
+			push(at(i));
+			push(at(j + 1));
+			return push(at(k + 2));
+		}
+		if (op == "DUP2") {
+			push(at(1));
+			return push(at(1));
+		}
+		if (op == "OVER2") {
+			push(at(3));
+			return push(at(3));
+		}
+		if (op == "TUCK") {
+			exchange(0, 1);
+			return push(at(1));
+		}
+		if (op == "BLKPUSH") {
+			int const n = num(0), i = num(1);
+			for (int k = 0; k < n; ++k)
+				push(at(i));
+			return;
+		}
+		if (op == "DROP") return drop(1);
+		if (op == "DROP2") return drop(2);
+		if (op == "BLKDROP") return drop(num(0));
+		if (op == "DROPX") {
+			bigint const n = popInt();
+			if (n < 0 || n > 255)
+				throw Exception{TVMStackModel::rangeCheck};
+			return drop(int(n));
+		}
+		if (op == "NIP") return dropUnder(1, 1);
+		if (op == "BLKDROP2") return dropUnder(num(0), num(1));
+		if (op == "POP") {
+			int const i = reg(0);
+			need(i + 1);
+			Value v = pop();
+			if (i > 0)
+				at(i - 1) = move(v);
+			return;
+		}
+
+		// Integers
+		if (op == "PUSHINT") return pushInt(bignum(0));
+		if (op == "ZERO" || op == "FALSE") return pushInt(0);
+		if (op == "TRUE") return pushInt(-1);
+		if (op == "ADD") return binary([](bigint const& x, bigint const& y) { return x + y; });
+		if (op == "SUB") return binary([](bigint const& x, bigint const& y) { return x - y; });
+		if (op == "SUBR") return binary([](bigint const& x, bigint const& y) { return y - x; });
+		if (op == "MUL") return binary([](bigint const& x, bigint const& y) { return x * y; });
+		if (op == "AND") return binary([](bigint const& x, bigint const& y) { return x & y; });
+		if (op == "OR") return binary([](bigint const& x, bigint const& y) { return x | y; });
+		if (op == "XOR") return binary([](bigint const& x, bigint const& y) { return x ^ y; });
+		if (op == "DIV" || op == "MOD") {
+			bigint const y = popInt(), x = popInt();
+			if (y == 0)
+				throw Exception{TVMStackModel::intOverflow};
+			bigint const q = floorDiv(x, y);
+			return pushInt(op == "DIV" ? q : x - q * y);
+		}
+		if (op == "LSHIFT" || op == "RSHIFT") {
+			bigint shift;
+			if (args.empty()) {
+				shift = popInt();
+				if (shift < 0 || shift > 1023)
+					throw Exception{TVMStackModel::rangeCheck};
+			} else {
+				shift = bignum(0);
+			}
+			bigint const x = popInt();
+			bigint const power = bigint(1) << int(shift);
+			return pushInt(op == "LSHIFT" ? x * power : floorDiv(x, power));
+		}
+		if (op == "MODPOW2") {
+			bigint const x = popInt();
+			bigint const power = bigint(1) << num(0);
+			return pushInt(x - floorDiv(x, power) * power);
+		}
+		if (op == "MULRSHIFT") {
+			int shift;
+			if (args.empty()) {
+				bigint const z = popInt();
+				if (z < 0 || z > 256)
+					throw Exception{TVMStackModel::rangeCheck};
+				shift = int(z);
+			} else {
+				shift = num(0);
+			}
+			bigint const y = popInt(), x = popInt();
+			return pushInt(floorDiv(x * y, bigint(1) << shift));
+		}
+		if (op == "INC") return pushInt(popInt() + 1);
+		if (op == "DEC") return pushInt(popInt() - 1);
+		if (op == "ADDCONST") return pushInt(popInt() + bignum(0));
+		if (op == "MULCONST") return pushInt(popInt() * bignum(0));
+		if (op == "NEGATE") return pushInt(-popInt());
+		if (op == "NOT") {
+			bigint const x = popInt();
+			if (m_booleanNot && x != 0 && x != -1)
+				throw Exception{TVMStackModel::typeCheck};
+			return pushInt(-x - 1);
+		}
+		if (op == "ABS") return pushInt(abs(popInt()));
+		if (op == "EQUAL") return binary([](bigint const& x, bigint const& y) { return bigint(x == y ? -1 : 0); });
+		if (op == "NEQ") return binary([](bigint const& x, bigint const& y) { return bigint(x != y ? -1 : 0); });
+		if (op == "LESS") return binary([](bigint const& x, bigint const& y) { return bigint(x < y ? -1 : 0); });
+		if (op == "GREATER") return binary([](bigint const& x, bigint const& y) { return bigint(x > y ? -1 : 0); });
+		if (op == "LEQ") return binary([](bigint const& x, bigint const& y) { return bigint(x <= y ? -1 : 0); });
+		if (op == "GEQ") return binary([](bigint const& x, bigint const& y) { return bigint(x >= y ? -1 : 0); });
+		if (op == "EQINT") return pushInt(popInt() == bignum(0) ? -1 : 0);
+		if (op == "NEQINT") return pushInt(popInt() != bignum(0) ? -1 : 0);
+		if (op == "GTINT") return pushInt(popInt() > bignum(0) ? -1 : 0);
+		if (op == "LESSINT") return pushInt(popInt() < bignum(0) ? -1 : 0);
+		if (op == "UFITS" || op == "FITS") {
+			bigint const x = popInt();
+			if (!(op == "UFITS" ? fitsUnsigned(x, num(0)) : fitsSigned(x, num(0))))
+				throw Exception{TVMStackModel::intOverflow};
+			return pushInt(x);
+		}
+
+		// Builders, slices and cells
+		if (op == "NEWC") return push(builder(""));
+		if (op == "ENDC") return push(cell(popKind(Value::Kind::Builder).data));
+		if (op == "CTOS") return push(slice(popKind(Value::Kind::Cell).data));
+		if (op == "SBITS") return pushInt(popKind(Value::Kind::Slice).data.size());
+		if (op == "PUSHSLICE") return push(slice(parseSlice(arg(0))));
+		if (op == "STU" || op == "STI") {
+			Value b = popKind(Value::Kind::Builder);
+			bigint const x = popInt();
+			return push(store(b, x, num(0), op == "STI"));
+		}
+		if (op == "STUR" || op == "STIR") {
+			bigint const x = popInt();
+			Value b = popKind(Value::Kind::Builder);
+			return push(store(b, x, num(0), op == "STIR"));
+		}
+		if (op == "STZERO" || op == "STONE") {
+			Value b = popKind(Value::Kind::Builder);
+			return push(append(b, op == "STZERO" ? "0" : "1"));
+		}
+		if (op == "STZEROES") {
+			bigint const n = popInt();
+			if (n < 0 || n > c_maxCellBits)
+				throw Exception{TVMStackModel::rangeCheck};
+			Value b = popKind(Value::Kind::Builder);
+			return push(append(b, string(size_t(n), '0')));
+		}
+		if (op == "STSLICECONST") {
+			Value b = popKind(Value::Kind::Builder);
+			return push(append(b, parseSlice(arg(0))));
+		}
+		if (op == "STSLICE") {
+			Value b = popKind(Value::Kind::Builder);
+			Value s = popKind(Value::Kind::Slice);
+			return push(append(b, s.data));
+		}
+		if (op == "STSLICER") {
+			Value s = popKind(Value::Kind::Slice);
+			Value b = popKind(Value::Kind::Builder);
+			return push(append(b, s.data));
+		}
+		if (op == "STB" || op == "STBR") {
+			Value top = popKind(Value::Kind::Builder);
+			Value second = popKind(Value::Kind::Builder);
+			return push(op == "STB" ? append(top, second.data) : append(second, top.data));
+		}
+
+		// Tuples
+		if (op == "TUPLE") return makeTuple(num(0));
+		if (op == "PAIR") return makeTuple(2);
+		if (op == "UNTUPLE") return untuple(num(0));
+		if (op == "UNPAIR") return untuple(2);
+		if (op == "INDEX") return index(num(0));
+		if (op == "FIRST") return index(0);
+		if (op == "SECOND") return index(1);
+		if (op == "THIRD") return index(2);
+		if (op == "INDEX2" || op == "INDEX3") {
+			for (size_t i = 0; i < args.size(); ++i)
+				index(num(i));
+			return;
+		}
+
+		// Globals
+		if (op == "GETGLOB") {
+			auto it = m_state.globals.find(num(0));
+			return push(it == m_state.globals.end() ? Value{} : it->second);
+		}
+		if (op == "SETGLOB") {
+			m_state.globals[num(0)] = pop();
+			return;
+		}
+
+		// Exceptions
+		if (op == "THROW") throw Exception{num(0)};
+		if (op == "THROWANY") {
+			bigint const code = popInt();
+			if (code < 0 || code > 0xffff)
+				throw Exception{TVMStackModel::rangeCheck};
+			throw Exception{int(code)};
+		}
+		if (op == "THROWIF" || op == "THROWIFNOT") {
+			bool const condition = popInt() != 0;
+			if (condition == (op == "THROWIF"))
+				throw Exception{num(0)};
+			return;
+		}
+
+		if (op == "NOW") {
+			Value v;
+			v.kind = Value::Kind::Opaque;
+			v.data = op;
+			return push(v);
+		}
+
+		throw UnsupportedCommand{line};
+	}
+
+	void need(int _n) {
+		if (_n < 0 || m_state.stack.size() < size_t(_n))
+			throw Exception{TVMStackModel::stackUnderflow};
+	}
+
+	Value& at(int _i) {
+		need(_i + 1);
+		return m_state.stack[m_state.stack.size() - 1 - _i];
+	}
+
+	void push(Value _v) {
+		m_state.stack.push_back(move(_v));
+	}
+
+	Value pop() {
+		need(1);
+		Value v = move(m_state.stack.back());
+		m_state.stack.pop_back();
+		return v;
+	}
+
+	Value popKind(Value::Kind _kind) {
+		need(1);
+		if (m_state.stack.back().kind != _kind)
+			throw Exception{TVMStackModel::typeCheck};
+		return pop();
+	}
+
+	bigint popInt() {
+		return popKind(Value::Kind::Int).number;
+	}
+
+	void pushInt(bigint const& _x) {
+		if (_x < -c_intLimit || _x >= c_intLimit)
+			throw Exception{TVMStackModel::intOverflow};
+		Value v;
+		v.kind = Value::Kind::Int;
+		v.number = _x;
+		push(v);
+	}
+
+	template <class F>
+	void binary(F _f) {
+		bigint const y = popInt(), x = popInt();
+		pushInt(_f(x, y));
+	}
+
+	void exchange(int _i, int _j) {
+		swap(at(_i), at(_j));
+	}
+
+	// [A B] -> [B A], where A has @a _i elements and B, which is on top, has @a _j elements
+	void blockSwap(int _i, int _j) {
+		need(_i + _j);
+		auto& stack = m_state.stack;
+		rotate(stack.end() - _i - _j, stack.end() - _j, stack.end());
+	}
+
+	void drop(int _n) {
+		need(_n);
+		m_state.stack.resize(m_state.stack.size() - _n);
+	}
+
+	// Drops @a _n elements under the top @a _j elements
+	void dropUnder(int _n, int _j) {
+		need(_n + _j);
+		auto end = m_state.stack.end() - _j;
+		m_state.stack.erase(end - _n, end);
+	}
+
+	static Value builder(string _bits) {
+		Value v;
+		v.kind = Value::Kind::Builder;
+		v.data = move(_bits);
+		return v;
+	}
+
+	static Value slice(string _bits) {
+		Value v = builder(move(_bits));
+		v.kind = Value::Kind::Slice;
+		return v;
+	}
+
+	static Value cell(string _bits) {
+		Value v = builder(move(_bits));
+		v.kind = Value::Kind::Cell;
+		return v;
+	}
+
+	static Value append(Value _b, string const& _bits) {
+		if (_b.data.size() + _bits.size() > size_t(c_maxCellBits))
+			throw Exception{TVMStackModel::cellOverflow};
+		_b.data += _bits;
+		return _b;
+	}
+
+	static Value store(Value _b, bigint const& _x, int _bits, bool _signed) {
+		if (_bits < 1 || _bits > 256)
+			throw Exception{TVMStackModel::rangeCheck};
+		if (!(_signed ? fitsSigned(_x, _bits) : fitsUnsigned(_x, _bits)))
+			throw Exception{TVMStackModel::rangeCheck};
+		return append(move(_b), toBits(_x, _bits));
+	}
+
+	void makeTuple(int _n) {
+		if (_n < 0 || _n > 15)
+			throw Exception{TVMStackModel::rangeCheck};
+		need(_n);
+		Value v;
+		v.kind = Value::Kind::Tuple;
+		v.items.assign(m_state.stack.end() - _n, m_state.stack.end());
+		drop(_n);
+		push(move(v));
+	}
+
+	void untuple(int _n) {
+		Value t = popKind(Value::Kind::Tuple);
+		if (t.items.size() != size_t(_n))
+			throw Exception{TVMStackModel::typeCheck};
+		for (Value& v : t.items)
+			push(move(v));
+	}
+
+	void index(int _k) {
+		Value t = popKind(Value::Kind::Tuple);
+		if (_k < 0 || size_t(_k) >= t.items.size())
+			throw Exception{TVMStackModel::rangeCheck};
+		push(move(t.items[_k]));
+	}
+
+	State& m_state;
+	bool m_booleanNot;
+};
+
+} // end anonymous namespace
+
+string Value::toString() const {
+	switch (kind) {
+	case Kind::Null:
+		return "null";
+	case Kind::Int:
+		return number.str();
+	case Kind::Builder:
+		return "b{" + data + "}";
+	case Kind::Slice:
+		return "s{" + data + "}";
+	case Kind::Cell:
+		return "c{" + data + "}";
+	case Kind::Tuple:
+	case Kind::Opaque: {
+		string res = kind == Kind::Opaque ? data + "(" : "[";
+		for (size_t i = 0; i < items.size(); ++i)
+			res += (i == 0 ? "" : " ") + items[i].toString();
+		return res + (kind == Kind::Opaque ? ")" : "]");
+	}
+	}
+	return "";
+}
+
+string State::toString() const {
+	string res = "stack:";
+	for (Value const& v : stack)
+		res += " " + v.toString();
+	for (auto const& [index, v] : globals)
+		res += "\nglobal " + to_string(index) + ": " + v.toString();
+	return res;
+}
+
+optional<int> TVMStackModel::execute(vector<string> const& _lines, State& _state, bool _booleanNot) {
+	Machine machine{_state, _booleanNot};
+	try {
+		for (size_t i = 0; i < _lines.size(); )
+			i += machine.step(_lines, i);
+	} catch (Exception const& _exception) {
+		return _exception.code;
+	}
+	return nullopt;
+}
@@ -0,0 +1,79 @@
+/*
+ * Copyright 2018-2019 TON DEV SOLUTIONS LTD.
+ *
+ * Licensed under the  terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License.
+ *
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the  GNU General Public License for more details at: https://www.gnu.org/licenses/gpl-3.0.html
+ */
+/**
+ * @author TON Labs <connect@tonlabs.io>
+ * @date 2021
+ * Model of the TVM commands the peephole optimizer works with
+ */
+
+#pragma once
+
+#include <libsolutil/Common.h>
+
+#include <map>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace solidity::frontend::test::tvm_fuzzer {
+
+struct Value {
+	enum class Kind { Null, Int, Builder, Slice, Cell, Tuple, Opaque };
+
+	Kind kind{Kind::Null};
+	bigint number;            // Int
+	std::string data;         // bits of Builder, Slice and Cell; command of Opaque
+	std::vector<Value> items; // elements of Tuple; inputs of Opaque
+
+	bool operator==(Value const& _other) const {
+		return kind == _other.kind && number == _other.number && data == _other.data && items == _other.items;
+	}
+	std::string toString() const;
+};
+
+struct State {
+	std::vector<Value> stack; // the top of the stack is the last element
+	std::map<int, Value> globals;
+
+	bool operator==(State const& _other) const {
+		return stack == _other.stack && globals == _other.globals;
+	}
+	std::string toString() const;
+};
+
+// Thrown for a command the model doesn't know.
+struct UnsupportedCommand {
+	std::string command;
+};
+
+// Executes stack manipulations, integer arithmetic, builders, slices, tuples, globals and exceptions
+// on concrete values. Commands the model has no semantics for but that only depend on their inputs
+// (e.g. NOW) produce opaque values. Integers are 257-bit and all checks of TVM are done, so that the
+// model throws in the same cases TVM does.
+class TVMStackModel {
+public:
+	// Runs the code (one command per line, comments are allowed) on @a _state.
+	// If @a _booleanNot is set, NOT of anything but true (-1) and false (0) fails with a type check
+	// error. The code generator applies NOT to integers only for ~ of signed types and the optimizer
+	// treats NOT followed by a condition as negation of a boolean.
+	// @returns the exception code if the code throws, nullopt otherwise.
+	static std::optional<int> execute(std::vector<std::string> const& _lines, State& _state, bool _booleanNot = false);
+
+	static int constexpr stackUnderflow = 2;
+	static int constexpr intOverflow = 4;
+	static int constexpr rangeCheck = 5;
+	static int constexpr typeCheck = 7;
+	static int constexpr cellOverflow = 8;
+};
+
+}
@@ -0,0 +1,392 @@
+/*
+ * Copyright 2018-2019 TON DEV SOLUTIONS LTD.
+ *
+ * Licensed under the  terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License.
+ *
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the  GNU General Public License for more details at: https://www.gnu.org/licenses/gpl-3.0.html
+ */
+/**
+ * @author TON Labs <connect@tonlabs.io>
+ * @date 2021
+ * Differential fuzzer of the TVM peephole optimizer
+ *
+ * The input selects a starting stack and a sequence of commands that is valid for it. Commands are
+ * written in the forms the code generator uses (e.g. DROP2 rather than BLKDROP 2). The sequence
+ * is optimized with optimize_code() and both versions are executed by TVMStackModel on the starting
+ * stack and on variations of it. If the original code finishes, the optimized code must finish with
+ * the same stack and globals. If the original code throws, nothing is compared: the optimizer may
+ * remove unused computations together with the checks they do. NOT is only applied to booleans, as
+ * in the code generator.
+ */
+
+#include <test/tools/ossfuzz/tvmStackModel.h>
+
+#include <libsolidity/codegen/TVMOptimizations.hpp>
+
+#include <liblangutil/Exceptions.h>
+
+#include <chrono>
+#include <functional>
+#include <iostream>
+
+using namespace std;
+using namespace solidity;
+using namespace solidity::frontend;
+using namespace solidity::frontend::test::tvm_fuzzer;
+
+namespace {
+
+class Input {
+public:
+	Input(uint8_t const* _data, size_t _size) : m_data{_data}, m_size{_size} {}
+
+	bool empty() const { return m_pos >= m_size; }
+	unsigned byte() { return m_pos < m_size ? m_data[m_pos++] : 0; }
+	int choose(int _n) { return _n <= 1 ? 0 : int(byte() % unsigned(_n)); }
+	int range(int _min, int _max) { return _min + choose(_max - _min + 1); }
+
+	bigint integer() {
+		switch (choose(6)) {
+		case 0:
+			return range(-3, 20);
+		case 1:
+			return range(-128, 127);
+		case 2:
+			return (bigint(1) << range(0, 255)) - choose(2);
+		case 3:
+			return -(bigint(1) << range(0, 256));
+		case 4:
+			return bigint(byte()) << (8 * range(0, 31));
+		default:
+			return choose(2);
+		}
+	}
+
+	string bits(int _maxLength) {
+		string res(size_t(range(1, _maxLength)), '0');
+		for (char& ch : res)
+			ch = char('0' + choose(2));
+		return res;
+	}
+
+private:
+	uint8_t const* m_data;
+	size_t m_size;
+	size_t m_pos{};
+};
+
+string sliceLiteral(string const& _bits) {
+	if (_bits == "0" || _bits == "1")
+		return _bits;
+	string s = _bits;
+	bool const completionTag = s.size() % 4 != 0;
+	if (completionTag)
+		s += "1" + string((4 - (s.size() + 1) % 4) % 4, '0');
+	string res = "x";
+	for (size_t i = 0; i < s.size(); i += 4)
+		res += "0123456789ABCDEF"[stoi(s.substr(i, 4), nullptr, 2)];
+	return completionTag ? res + "_" : res;
+}
+
+Value intValue(bigint const& _x) {
+	Value v;
+	v.kind = Value::Kind::Int;
+	v.number = _x;
+	return v;
+}
+
+State initialState(Input& _input) {
+	State state;
+	int const depth = _input.range(3, 8);
+	for (int i = 0; i < depth; ++i) {
+		Value v;
+		switch (_input.choose(8)) {
+		case 5:
+			v.kind = Value::Kind::Builder;
+			v.data = _input.bits(16);
+			break;
+		case 6:
+			v.kind = Value::Kind::Slice;
+			v.data = _input.bits(16);
+			break;
+		case 7:
+			v.kind = Value::Kind::Tuple;
+			v.items = {intValue(_input.integer()), intValue(_input.integer())};
+			break;
+		default:
+			v = intValue(_input.integer());
+			break;
+		}
+		state.stack.push_back(v);
+	}
+	return state;
+}
+
+// Kinds of values on the top of the stack, the top first
+bool topIs(State const& _state, vector<Value::Kind> const& _kinds) {
+	if (_state.stack.size() < _kinds.size())
+		return false;
+	for (size_t i = 0; i < _kinds.size(); ++i)
+		if (_state.stack[_state.stack.size() - 1 - i].kind != _kinds[i])
+			return false;
+	return true;
+}
+
+using Generator = function<optional<string>(Input&, State const&)>;
+
+// Returns a generator of a command that needs @a _depth values on the stack
+Generator stackCommand(int _depth, function<string(Input&, int)> _make) {
+	return [=](Input& _input, State const& _state) -> optional<string> {
+		int const depth = int(_state.stack.size());
+		if (depth < _depth)
+			return nullopt;
+		return _make(_input, depth);
+	};
+}
+
+Generator fixed(string _command, vector<Value::Kind> _kinds = {}) {
+	return [=](Input&, State const& _state) -> optional<string> {
+		if (!topIs(_state, _kinds))
+			return nullopt;
+		return _command;
+	};
+}
+
+Generator withOperand(string _opcode, vector<Value::Kind> _kinds, function<string(Input&)> _operand) {
+	return [=](Input& _input, State const& _state) -> optional<string> {
+		if (!topIs(_state, _kinds))
+			return nullopt;
+		return _opcode + " " + _operand(_input);
+	};
+}
+
+string bitSize(Input& _input) {
+	static int const sizes[] = {1, 8, 16, 32, 64, 128, 255, 256};
+	return _input.choose(2) == 0 ? to_string(sizes[_input.choose(8)]) : to_string(_input.range(1, 256));
+}
+
+vector<Generator> const& generators() {
+	using K = Value::Kind;
+	static vector<Generator> const res = {
+		// Stack manipulations
+		stackCommand(2, [](Input&, int) { return "SWAP"; }),
+		stackCommand(3, [](Input&, int) { return "ROT"; }),
+		stackCommand(3, [](Input&, int) { return "ROTREV"; }),
+		stackCommand(1, [](Input&, int) { return "DUP"; }),
+		stackCommand(1, [](Input&, int) { return "DROP"; }),
+		stackCommand(2, [](Input&, int) { return "NIP"; }),
+		stackCommand(2, [](Input&, int) { return "DROP2"; }),
+		stackCommand(2, [](Input&, int) { return "DUP2"; }),
+		stackCommand(4, [](Input&, int) { return "OVER2"; }),
+		stackCommand(4, [](Input&, int) { return "SWAP2"; }),
+		stackCommand(2, [](Input&, int) { return "TUCK"; }),
+		stackCommand(2, [](Input& _in, int _d) { return "PUSH S" + to_string(_in.range(1, min(_d - 1, 15))); }),
+		stackCommand(2, [](Input& _in, int _d) { return "POP S" + to_string(_in.range(1, min(_d - 1, 15))); }),
+		stackCommand(3, [](Input& _in, int _d) { return "XCHG s" + to_string(_in.range(2, min(_d - 1, 15))); }),
+		stackCommand(3, [](Input& _in, int _d) {
+			int const j = _in.range(2, min(_d - 1, 15));
+			return "XCHG s" + to_string(_in.range(1, j - 1)) + ",s" + to_string(j);
+		}),
+		stackCommand(2, [](Input& _in, int _d) {
+			int const i = _in.range(1, min(_d - 1, 15));
+			int const j = _in.range(1, min(_d - i, 15));
+			if (i <= 2 && j <= 2)
+				return string(i == 1 ? (j == 1 ? "SWAP" : "ROT") : (j == 1 ? "ROTREV" : "SWAP2"));
+			return "BLKSWAP " + to_string(i) + ", " + to_string(j);
+		}),
+		stackCommand(2, [](Input& _in, int _d) {
+			int const n = _in.range(2, min(_d, 15));
+			int const j = _in.range(0, min(_d - n, 15));
+			if (n <= 3 && j == 0)
+				return string(n == 2 ? "SWAP" : "XCHG s2");
+			return "REVERSE " + to_string(n) + ", " + to_string(j);
+		}),
+		stackCommand(3, [](Input& _in, int _d) { return "BLKDROP " + to_string(_in.range(3, min(_d, 15))); }),
+		stackCommand(2, [](Input& _in, int _d) {
+			int const i = _in.range(1, min(_d - 1, 15));
+			int const j = _in.range(1, min(_d - i, 15));
+			if (i == 1 && j == 1)
+				return string("NIP");
+			return "BLKDROP2 " + to_string(i) + ", " + to_string(j);
+		}),
+		stackCommand(1, [](Input& _in, int _d) {
+			return "BLKPUSH " + to_string(_in.range(2, 3)) + ", " + to_string(_in.range(0, min(_d - 1, 15)));
+		}),
+		stackCommand(1, [](Input& _in, int _d) {
+			return "PUSH2 S" + to_string(_in.range(0, min(_d - 1, 15))) + ", S" + to_string(_in.range(0, min(_d - 1, 15)));
+		}),
+
+		// Integers
+		withOperand("PUSHINT", {}, [](Input& _in) { return _in.integer().str(); }),
+		withOperand("PUSHINT", {}, [](Input& _in) { return to_string(_in.range(0, 8)); }),
+		fixed("ZERO"),
+		fixed("TRUE"),
+		fixed("FALSE"),
+		fixed("NOW"),
+		fixed("INC", {K::Int}),
+		fixed("DEC", {K::Int}),
+		[](Input&, State const& _state) -> optional<string> {
+			if (!topIs(_state, {K::Int}) || (_state.stack.back().number != 0 && _state.stack.back().number != -1))
+				return nullopt;
+			return "NOT";
+		},
+		withOperand("ADDCONST", {K::Int}, [](Input& _in) { return to_string(_in.range(-128, 127)); }),
+		withOperand("UFITS", {K::Int}, bitSize),
+		withOperand("FITS", {K::Int}, bitSize),
+		withOperand("EQINT", {K::Int}, [](Input& _in) { return to_string(_in.range(-3, 3)); }),
+		withOperand("THROWIF", {K::Int}, [](Input& _in) { return to_string(_in.range(100, 103)); }),
+		withOperand("THROWIFNOT", {K::Int}, [](Input& _in) { return to_string(_in.range(100, 103)); }),
+		fixed("ADD", {K::Int, K::Int}),
+		fixed("SUB", {K::Int, K::Int}),
+		fixed("SUBR", {K::Int, K::Int}),
+		fixed("MUL", {K::Int, K::Int}),
+		fixed("DIV", {K::Int, K::Int}),
+		fixed("MOD", {K::Int, K::Int}),
+		fixed("AND", {K::Int, K::Int}),
+		fixed("OR", {K::Int, K::Int}),
+		fixed("EQUAL", {K::Int, K::Int}),
+		fixed("NEQ", {K::Int, K::Int}),
+		fixed("LESS", {K::Int, K::Int}),
+		fixed("GREATER", {K::Int, K::Int}),
+		fixed("LSHIFT", {K::Int, K::Int}),
+		fixed("RSHIFT", {K::Int, K::Int}),
+		fixed("THROWANY", {K::Int}),
+
+		// Builders, slices and cells
+		fixed("NEWC"),
+		fixed("NEWC"),
+		fixed("ENDC", {K::Builder}),
+		fixed("STZERO", {K::Builder}),
+		fixed("STONE", {K::Builder}),
+		withOperand("STSLICECONST", {K::Builder}, [](Input& _in) { return sliceLiteral(_in.bits(12)); }),
+		withOperand("PUSHSLICE", {}, [](Input& _in) { return sliceLiteral(_in.bits(40)); }),
+		withOperand("STU", {K::Builder, K::Int}, bitSize),
+		withOperand("STI", {K::Builder, K::Int}, bitSize),
+		withOperand("STUR", {K::Int, K::Builder}, bitSize),
+		withOperand("STIR", {K::Int, K::Builder}, bitSize),
+		fixed("STZEROES", {K::Int, K::Builder}),
+		fixed("STSLICE", {K::Builder, K::Slice}),
+		fixed("STSLICER", {K::Slice, K::Builder}),
+		fixed("STB", {K::Builder, K::Builder}),
+		fixed("CTOS", {K::Cell}),
+		fixed("SBITS", {K::Slice}),
+
+		// Tuples
+		stackCommand(1, [](Input& _in, int _d) { return "TUPLE " + to_string(_in.range(1, min(_d, 3))); }),
+		stackCommand(2, [](Input&, int) { return "PAIR"; }),
+		[](Input&, State const& _state) -> optional<string> {
+			if (!topIs(_state, {Value::Kind::Tuple}))
+				return nullopt;
+			return "UNTUPLE " + to_string(_state.stack.back().items.size());
+		},
+		[](Input& _input, State const& _state) -> optional<string> {
+			if (!topIs(_state, {Value::Kind::Tuple}) || _state.stack.back().items.empty())
+				return nullopt;
+			return "INDEX " + to_string(_input.choose(int(_state.stack.back().items.size())));
+		},
+
+		// Globals
+		withOperand("GETGLOB", {}, [](Input& _in) { return to_string(_in.range(1, 3)); }),
+		stackCommand(1, [](Input& _in, int) { return "SETGLOB " + to_string(_in.range(1, 3)); }),
+	};
+	return res;
+}
+
+// Generates commands while the input lasts or until one of them throws. @a _state is changed.
+vector<string> generateCode(Input& _input, State& _state) {
+	vector<Generator> const& all = generators();
+	vector<string> code;
+	while (!_input.empty() && code.size() < 64) {
+		int const first = _input.choose(int(all.size()));
+		optional<string> command;
+		for (size_t i = 0; i < all.size() && !command; ++i)
+			command = all[(first + i) % all.size()](_input, _state);
+		if (!command)
+			break;
+		code.push_back(*command);
+		if (TVMStackModel::execute({*command}, _state, true))
+			break;
+	}
+	return code;
+}
+
+State variation(State _state, int _seed) {
+	for (Value& v : _state.stack)
+		if (v.kind == Value::Kind::Int)
+			v.number = v.number * (_seed % 2 == 0 ? 1 : -1) + _seed;
+	return _state;
+}
+
+string dump(vector<string> const& _code) {
+	string res;
+	for (string const& line : _code)
+		res += "\t" + line + "\n";
+	return res;
+}
+
+void check(vector<string> const& _original, vector<string> const& _optimized, State const& _initial) {
+	State expected = _initial;
+	if (TVMStackModel::execute(_original, expected, true))
+		return;
+	State actual = _initial;
+	optional<int> exception;
+	try {
+		exception = TVMStackModel::execute(_optimized, actual);
+	} catch (UnsupportedCommand const& _unsupported) {
+		solAssert(false, "The model doesn't support \"" + _unsupported.command + "\" used in the optimized code:\n" + dump(_optimized));
+	}
+	solAssert(
+		!exception && actual == expected,
+		"Optimized code behaves differently.\n"
+		"Initial " + _initial.toString() + "\n"
+		"Original code:\n" + dump(_original) +
+		"Expected " + expected.toString() + "\n"
+		"Optimized code:\n" + dump(_optimized) +
+		(exception ? "Throws " + to_string(*exception) : "Got " + actual.toString())
+	);
+}
+
+// Reports throughput of the optimizer, so that its performance regressions are visible in fuzzer logs
+void reportSpeed(size_t _commands, chrono::steady_clock::duration _time) {
+	static size_t runs = 0;
+	static size_t commands = 0;
+	static chrono::steady_clock::duration time{};
+	++runs;
+	commands += _commands;
+	time += _time;
+	if (runs % 100000 == 0) {
+		double const seconds = chrono::duration<double>(time).count();
+		cerr << "tvm_peephole_ossfuzz: " << runs << " runs, optimize_code: "
+			<< size_t(double(commands) / seconds) << " commands/s" << endl;
+	}
+}
+
+} // end anonymous namespace
+
+extern "C" int LLVMFuzzerTestOneInput(uint8_t const* _data, size_t _size) {
+	if (_size > 600)
+		return 0;
+
+	Input input{_data, _size};
+	State const initial = initialState(input);
+	State state = initial;
+	vector<string> const original = generateCode(input, state);
+	if (original.empty())
+		return 0;
+
+	CodeLines code;
+	for (string const& line : original)
+		code.push(line);
+	auto const start = chrono::steady_clock::now();
+	CodeLines const optimized = optimize_code(code);
+	reportSpeed(original.size(), chrono::steady_clock::now() - start);
+
+	for (int seed = 0; seed < 3; ++seed)
+		check(original, optimized.lines, variation(initial, seed));
+	return 0;
+}
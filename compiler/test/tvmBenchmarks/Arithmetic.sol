@@ -0,0 +1,56 @@
+pragma ton-solidity >= 0.45.0;
+pragma AbiHeader expire;
+
+// Integer arithmetic, checks of overflow and loops
+contract Arithmetic {
+	uint256 m_acc;
+	int64[] m_values;
+
+	modifier onlyOwner {
+		require(msg.pubkey() == tvm.pubkey(), 100);
+		tvm.accept();
+		_;
+	}
+
+	function sum(uint128[] values) public pure returns (uint256 res) {
+		for (uint i = 0; i < values.length; i++) {
+			res += values[i];
+		}
+	}
+
+	function powmod(uint256 base, uint256 exp, uint256 mod) public pure returns (uint256 res) {
+		res = 1;
+		base %= mod;
+		while (exp > 0) {
+			if (exp & 1 == 1) {
+				(, res) = math.muldivmod(res, base, mod);
+			}
+			(, base) = math.muldivmod(base, base, mod);
+			exp >>= 1;
+		}
+	}
+
+	function fib(uint8 n) public pure returns (uint256 a) {
+		uint256 b = 1;
+		for (uint8 i = 0; i < n; i++) {
+			(a, b) = (b, a + b);
+		}
+	}
+
+	function accumulate(int64 value) public onlyOwner {
+		m_values.push(value);
+		m_acc += uint256(value > 0 ? value : -value);
+	}
+
+	function stats() public view returns (int64 min, int64 max, uint256 acc) {
+		acc = m_acc;
+		if (m_values.length > 0) {
+			min = m_values[0];
+			max = m_values[0];
+		}
+		for (int64 v : m_values) {
+			min = math.min(min, v);
+			max = math.max(max, v);
+		}
+	}
+}
@@ -0,0 +1,107 @@
+pragma ton-solidity >= 0.45.0;
+pragma AbiHeader expire;
+pragma AbiHeader time;
+
+contract Multisig {
+	struct Transaction {
+		uint64 id;
+		uint32 confirmationsMask;
+		uint8 signsRequired;
+		uint8 signsReceived;
+		address dest;
+		uint128 value;
+		bool bounce;
+		TvmCell payload;
+	}
+
+	uint8 constant MAX_CUSTODIANS = 32;
+	uint16 constant ERROR_NOT_CUSTODIAN = 100;
+	uint16 constant ERROR_TX_NOT_FOUND = 102;
+	uint16 constant ERROR_ALREADY_CONFIRMED = 103;
+	uint16 constant ERROR_BAD_PARAMS = 104;
+
+	mapping(uint256 => uint8) m_custodians;
+	uint8 m_custodianCount;
+	uint8 m_requiredVotes;
+	mapping(uint64 => Transaction) m_transactions;
+
+	constructor(uint256[] owners, uint8 reqConfirms) public {
+		require(msg.pubkey() == tvm.pubkey(), ERROR_NOT_CUSTODIAN);
+		require(owners.length > 0 && owners.length <= MAX_CUSTODIANS, ERROR_BAD_PARAMS);
+		require(reqConfirms > 0 && reqConfirms <= owners.length, ERROR_BAD_PARAMS);
+		tvm.accept();
+		for (uint8 i = 0; i < owners.length; i++) {
+			m_custodians[owners[i]] = i;
+		}
+		m_custodianCount = uint8(owners.length);
+		m_requiredVotes = reqConfirms;
+	}
+
+	function findCustodian(uint256 key) private view returns (uint8) {
+		optional(uint8) index = m_custodians.fetch(key);
+		require(index.hasValue(), ERROR_NOT_CUSTODIAN);
+		return index.get();
+	}
+
+	function submitTransaction(address dest, uint128 value, bool bounce, TvmCell payload)
+		public returns (uint64 transId)
+	{
+		uint8 index = findCustodian(msg.pubkey());
+		tvm.accept();
+		removeExpiredTransactions();
+		transId = uint64(now) << 32 | tx.timestamp & 0xFFFFFFFF;
+		m_transactions[transId] = Transaction(transId, uint32(1) << index, m_requiredVotes, 1,
+			dest, value, bounce, payload);
+		if (m_requiredVotes == 1) {
+			executeTransaction(transId);
+		}
+	}
+
+	function confirmTransaction(uint64 transactionId) public {
+		uint8 index = findCustodian(msg.pubkey());
+		optional(Transaction) txn = m_transactions.fetch(transactionId);
+		require(txn.hasValue(), ERROR_TX_NOT_FOUND);
+		Transaction t = txn.get();
+		require((t.confirmationsMask >> index) & 1 == 0, ERROR_ALREADY_CONFIRMED);
+		tvm.accept();
+		t.confirmationsMask |= uint32(1) << index;
+		t.signsReceived++;
+		m_transactions[transactionId] = t;
+		if (t.signsReceived >= t.signsRequired) {
+			executeTransaction(transactionId);
+		}
+	}
+
+	function executeTransaction(uint64 transactionId) private {
+		Transaction t = m_transactions[transactionId];
+		t.dest.transfer(t.value, t.bounce, 3, t.payload);
+		delete m_transactions[transactionId];
+	}
+
+	function removeExpiredTransactions() private {
+		uint64 marker = uint64(now - 3600) << 32;
+		optional(uint64, Transaction) first = m_transactions.min();
+		uint8 deleted = 0;
+		while (first.hasValue() && deleted < 10) {
+			(uint64 id, ) = first.get();
+			if (id >= marker) {
+				break;
+			}
+			delete m_transactions[id];
+			deleted++;
+			first = m_transactions.next(id);
+		}
+	}
+
+	function getTransactions() public view returns (Transaction[] transactions) {
+		for ((, Transaction t) : m_transactions) {
+			transactions.push(t);
+		}
+	}
+
+	function getCustodians() public view returns (uint256[] keys) {
+		for ((uint256 key, ) : m_custodians) {
+			keys.push(key);
+		}
+	}
+}
@@ -0,0 +1,71 @@
+pragma ton-solidity >= 0.45.0;
+pragma AbiHeader expire;
+
+// Mapping, struct and array heavy contract
+contract Storage {
+	struct Item {
+		uint32 id;
+		string name;
+		uint128 price;
+		uint32[] tags;
+		mapping(uint32 => bool) flags;
+	}
+
+	mapping(uint32 => Item) m_items;
+	mapping(address => uint32[]) m_owned;
+	uint32[] m_order;
+	uint32 m_nextId;
+
+	modifier onlyOwner {
+		require(msg.pubkey() == tvm.pubkey(), 100);
+		tvm.accept();
+		_;
+	}
+
+	function addItem(string name, uint128 price, uint32[] tags) public onlyOwner returns (uint32 id) {
+		id = m_nextId++;
+		Item item;
+		item.id = id;
+		item.name = name;
+		item.price = price;
+		for (uint32 tag : tags) {
+			item.tags.push(tag);
+			item.flags[tag] = true;
+		}
+		m_items[id] = item;
+		m_order.push(id);
+	}
+
+	function setOwner(uint32 id, address owner) public onlyOwner {
+		require(m_items.exists(id), 101);
+		m_owned[owner].push(id);
+	}
+
+	function removeLast() public onlyOwner {
+		require(!m_order.empty(), 102);
+		uint32 id = m_order[m_order.length - 1];
+		m_order.pop();
+		delete m_items[id];
+	}
+
+	function totalPrice() public view returns (uint256 sum) {
+		for (uint i = 0; i < m_order.length; i++) {
+			optional(Item) item = m_items.fetch(m_order[i]);
+			if (item.hasValue()) {
+				sum += item.get().price;
+			}
+		}
+	}
+
+	function itemsWithTag(uint32 tag) public view returns (uint32[] ids) {
+		for ((uint32 id, Item item) : m_items) {
+			if (item.flags.exists(tag)) {
+				ids.push(id);
+			}
+		}
+	}
+
+	function owned(address owner) public view returns (uint32[]) {
+		return m_owned[owner];
+	}
+}
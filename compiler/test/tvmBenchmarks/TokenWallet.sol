@@ -0,0 +1,65 @@
+pragma ton-solidity >= 0.45.0;
+pragma AbiHeader expire;
+
+interface ITokenWallet {
+	function internalTransfer(uint128 tokens, uint256 senderKey, address senderOwner) external;
+}
+
+contract TokenWallet is ITokenWallet {
+	uint16 constant ERROR_NOT_OWNER = 100;
+	uint16 constant ERROR_NOT_ENOUGH_BALANCE = 101;
+	uint16 constant ERROR_WRONG_SENDER = 102;
+
+	uint256 static s_walletKey;
+	address static s_root;
+	TvmCell static s_code;
+
+	uint128 m_balance;
+	mapping(address => uint128) m_allowance;
+
+	event Transfer(address to, uint128 tokens);
+
+	modifier onlyOwner {
+		require(msg.pubkey() == s_walletKey, ERROR_NOT_OWNER);
+		tvm.accept();
+		_;
+	}
+
+	constructor() public onlyOwner {
+	}
+
+	function calcAddress(uint256 key) private view returns (address) {
+		TvmCell stateInit = tvm.buildStateInit({
+			contr: TokenWallet,
+			varInit: {s_walletKey: key, s_root: s_root, s_code: s_code},
+			pubkey: key,
+			code: s_code
+		});
+		return address(tvm.hash(stateInit));
+	}
+
+	function transfer(uint256 destKey, uint128 tokens, uint128 grams) public onlyOwner {
+		require(tokens <= m_balance, ERROR_NOT_ENOUGH_BALANCE);
+		m_balance -= tokens;
+		address dest = calcAddress(destKey);
+		ITokenWallet(dest).internalTransfer{value: grams, flag: 1}(tokens, s_walletKey, address(0));
+		emit Transfer(dest, tokens);
+	}
+
+	function internalTransfer(uint128 tokens, uint256 senderKey, address senderOwner) external override {
+		require(msg.sender == calcAddress(senderKey) || msg.sender == senderOwner, ERROR_WRONG_SENDER);
+		m_balance += tokens;
+	}
+
+	function approve(address spender, uint128 tokens) public onlyOwner {
+		m_allowance[spender] = tokens;
+	}
+
+	function allowance(address spender) public view returns (uint128) {
+		return m_allowance.exists(spender) ? m_allowance[spender] : 0;
+	}
+
+	function getBalance() public view returns (uint128) {
+		return m_balance;
+	}
+}
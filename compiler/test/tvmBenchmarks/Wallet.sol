@@ -0,0 +1,32 @@
+pragma ton-solidity >= 0.45.0;
+pragma AbiHeader expire;
+
+contract Wallet {
+	uint16 constant ERROR_NOT_OWNER = 100;
+	uint16 constant ERROR_LOW_BALANCE = 101;
+
+	modifier onlyOwner {
+		require(msg.pubkey() == tvm.pubkey(), ERROR_NOT_OWNER);
+		tvm.accept();
+		_;
+	}
+
+	constructor() public {
+		require(tvm.pubkey() != 0, ERROR_NOT_OWNER);
+		require(msg.pubkey() == tvm.pubkey(), ERROR_NOT_OWNER);
+		tvm.accept();
+	}
+
+	function sendTransaction(address dest, uint128 value, bool bounce) public pure onlyOwner {
+		require(value > 0 && value < address(this).balance, ERROR_LOW_BALANCE);
+		dest.transfer(value, bounce, 0);
+	}
+
+	function sendAll(address dest) public pure onlyOwner {
+		dest.transfer({value: 0, bounce: false, flag: 128});
+	}
+
+	function getBalance() public pure returns (uint128) {
+		return address(this).balance;
+	}
+}
@@ -0,0 +1,517 @@
+#!/usr/bin/env bash
+
+#------------------------------------------------------------------------------
+# Bash script to run commandline tests of TVM code generation.
+#
+# Usage: tvmCmdlineTests.sh [path/to/solc]
+#
+# It is run by ctest (see CMakeLists.txt). Unlike cmdlineTests.sh it does not
+# need the EVM tools of upstream solidity.
+# ------------------------------------------------------------------------------
+# This file is part of solidity.
+#
+# solidity is free software: you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation, either version 3 of the License, or
+# (at your option) any later version.
+#
+# solidity is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+#
+# You should have received a copy of the GNU General Public License
+# along with solidity.  If not, see <http://www.gnu.org/licenses/>
+#------------------------------------------------------------------------------
+
+set -e
+
+## GLOBAL VARIABLES
+
+REPO_ROOT=$(cd $(dirname "$0")/.. && pwd)
+SOLIDITY_BUILD_DIR=${SOLIDITY_BUILD_DIR:-build}
+export TERM="${TERM:-dumb}"
+source "${REPO_ROOT}/scripts/common.sh"
+SOLC=$(realpath "${1:-$REPO_ROOT/${SOLIDITY_BUILD_DIR}/solc/solc}")
+
+## FUNCTIONS
+
+# Prints the TVM assembly of the internal macro of the function without comments and empty lines
+function tvm_macro_body()
+{
+    local code_file="${1}"
+    local function_name="${2}"
+    awk "/^\\.macro ${function_name}_internal_macro\$/{p=1;next} /^\\.(macro|globl)/{p=0} p" "$code_file" | grep -v '^\s*;\|^\s*$'
+}
+
+## RUN
+
+printTask "Testing TVM profile..."
+SOLTMPDIR=$(mktemp -d)
+(
+    cd "$SOLTMPDIR"
+    set -e
+    # Locations are kept as comments when the profile is used without --debug,
+    # they must not break the code that looks back at the last opcodes, e.g. at the RET of a function
+    cat > x.sol <<'EOF_SOL'
+pragma ton-solidity >= 0.35.0;
+contract C {
+    uint m_value;
+    function f(uint a) public returns (uint) {
+        m_value += a;
+        return m_value;
+    }
+    function g(uint a) public returns (uint) {
+        if (a == 0) {
+            return 1;
+        }
+        m_value = a;
+        return m_value;
+    }
+}
+EOF_SOL
+    echo '{ "functions": { "f": 10, "g": 10 }, "branches": { "x.sol:9": { "taken": 1, "total": 10 } } }' > profile.json
+    "$SOLC" x.sol --tvm --tvm-profile profile.json -o out >/dev/null
+    grep -q '^\.macro f$' out/x.code
+    "$SOLC" x.sol --tvm --tvm-profile profile.json --debug -o out_debug >/dev/null
+    grep -q '^\.loc x.sol, 5$' out_debug/x.code
+)
+rm -rf "$SOLTMPDIR"
+
+printTask "Testing TVM constant folding..."
+SOLTMPDIR=$(mktemp -d)
+(
+    cd "$SOLTMPDIR"
+    set -e
+    cat > x.sol <<'EOF_SOL'
+pragma ton-solidity >= 0.35.0;
+contract C {
+    function sar(int a, uint b) private pure returns (int) { return a >> b; }
+    function shl(int a, uint b) private pure returns (int) { return a << b; }
+    function div(int a, int b) private pure returns (int) { return a / b; }
+    function mod(int a, int b) private pure returns (int) { return a % b; }
+    function foldedSar() public pure returns (int) { return sar(-5, 1); }
+    function foldedDiv() public pure returns (int) { return div(-7, 2) * 1000 + mod(-7, 2); }
+    function foldedShl() public pure returns (int) { return shl(3, 4); }
+    function bigSar() public pure returns (int) { return sar(-5, 2000); }
+    function bigShl() public pure returns (int) { return shl(1, 2000); }
+    function divByZero() public pure returns (int) { return div(1, 0); }
+}
+EOF_SOL
+    "$SOLC" x.sol --tvm -o out >/dev/null
+    # DIV and MOD round to -inf
+    [[ "$(tvm_macro_body out/x.code foldedSar)" == "PUSHINT -3" ]]
+    [[ "$(tvm_macro_body out/x.code foldedDiv)" == "PUSHINT -3999" ]]
+    [[ "$(tvm_macro_body out/x.code foldedShl)" == "PUSHINT 48" ]]
+    # shifts out of 0..1023 and division by zero throw at run time, they must not be folded
+    tvm_macro_body out/x.code bigSar | grep -q 'CALL \$sar_internal_macro\$'
+    tvm_macro_body out/x.code bigShl | grep -q 'CALL \$shl_internal_macro\$'
+    tvm_macro_body out/x.code divByZero | grep -q 'CALL \$div_internal_macro\$'
+
+    # hashes and concatenations of constant strings
+    cat > y.sol <<'EOF_SOL'
+pragma ton-solidity >= 0.35.0;
+contract D {
+    string constant PREFIX = "hello, ";
+    string constant NAME = "world";
+    string m_greeting = PREFIX + NAME;
+    function hash() public pure returns (uint) { return sha256("abc"); }
+    function hashConcat() public pure returns (uint) { return sha256(bytes(PREFIX + NAME)); }
+    function greeting() public pure returns (string) { return PREFIX + NAME; }
+    function hashLong() public pure returns (uint) {
+        return sha256("0123456789012345678901234567890123456789012345678901234567890123456789012345678901234567890123456789012345678901234567890123456789");
+    }
+}
+EOF_SOL
+    "$SOLC" y.sol -o out >/dev/null
+    [[ "$(tvm_macro_body out/y.code hash)" == "PUSHINT 84342368487090800366523834928142263660104883695016514377462985829716817089965" ]]
+    [[ "$(tvm_macro_body out/y.code hashConcat)" == "PUSHINT 4428590485198730962618347421586128158219990685327130383730397533073118203227" ]]
+    [[ "$(tvm_macro_body out/y.code greeting | tr -d '\t' | tr '\n' ' ')" == "PUSHREF { .blob x68656c6c6f2c20776f726c64 } " ]]
+    awk '/; init m_greeting/{p=1} p && /SETGLOB/{exit} p' out/y.code | grep -q '\.blob x68656c6c6f2c20776f726c64'
+    # SHA256U hashes the first cell of the string only
+    tvm_macro_body out/y.code hashLong | grep -q 'SHA256U'
+)
+rm -rf "$SOLTMPDIR"
+
+printTask "Testing TVM array bounds checks in modifiers..."
+SOLTMPDIR=$(mktemp -d)
+(
+    cd "$SOLTMPDIR"
+    set -e
+    cat > x.sol <<'EOF_SOL'
+pragma ton-solidity >= 0.35.0;
+contract C {
+    uint[] arr;
+    modifier m(uint i) {
+        require(i < arr.length);
+        _;
+        arr[i] = 5;
+    }
+    function f(uint i) public m(i) {
+        arr.pop();
+    }
+    function g(uint i) public {
+        require(i < arr.length);
+        arr[i] = 5;
+    }
+}
+EOF_SOL
+    "$SOLC" x.sol --tvm -o out >/dev/null
+    # the function body (`_`) can change the array, the bounds check (exception 50) must stay
+    tvm_macro_body out/x.code f | grep -q 'THROWIFNOT 50'
+    [[ "$(tvm_macro_body out/x.code g | grep -c 'THROWIFNOT 50')" == 0 ]]
+)
+rm -rf "$SOLTMPDIR"
+
+printTask "Testing binary AST..."
+SOLTMPDIR=$(mktemp -d)
+(
+    cd "$SOLTMPDIR"
+    set -e
+    # --ast-binary-to-json must print the same ASTs as --ast-compact-json
+    cat > a.sol <<'EOF_SOL'
+pragma ton-solidity >= 0.35.0;
+import "b.sol";
+/// @title A
+contract A is B {
+    int8 constant c_neg = -5;
+    bool m_flag = true;
+    string m_name = "a \\ \"b\" \u00e9";
+    function f(uint a) public returns (uint) {
+        m_flag = !m_flag;
+        return g(a) + uint(c_neg + 10);
+    }
+}
+EOF_SOL
+    cat > b.sol <<'EOF_SOL'
+pragma ton-solidity >= 0.35.0;
+contract B {
+    uint[] m_values;
+    function g(uint a) internal returns (uint) {
+        m_values.push(a);
+        return m_values.length;
+    }
+}
+EOF_SOL
+    "$SOLC" a.sol --ast-compact-json --ast-binary x.ast | sed -n '/^JSON AST (compact format):$/,$p' > expected.txt
+    "$SOLC" --ast-binary-to-json x.ast > actual.txt
+    [[ -s expected.txt ]]
+    diff expected.txt actual.txt
+    head -c 100 x.ast > truncated.ast
+    [[ "$("$SOLC" --ast-binary-to-json truncated.ast 2>&1 || true)" == "Failed to read the binary AST: truncated.ast" ]]
+)
+rm -rf "$SOLTMPDIR"
+
+printTask "Testing TVM call graph..."
+SOLTMPDIR=$(mktemp -d)
+(
+    cd "$SOLTMPDIR"
+    set -e
+    cat > x.sol <<'EOF_SOL'
+pragma ton-solidity >= 0.35.0;
+contract A {
+    function f(uint a) internal virtual returns (uint) { return a + 1; }
+    function g(uint a) public returns (uint) { return f(a); }
+}
+contract B is A {
+    function f(uint a) internal override returns (uint) { return A.f(a) * 2 + super.f(a); }
+    function even(uint a) public returns (bool) { return a == 0 ? true : odd(a - 1); }
+    function odd(uint a) public returns (bool) { return a == 0 ? false : even(a - 1); }
+}
+EOF_SOL
+    "$SOLC" x.sol --contract B -o out >/dev/null 2>&1
+    # an override that calls its base function is not recursive, the base function is inlined
+    [[ "$(tvm_macro_body out/x.code f | grep 'CALL')" == "$(printf 'CALL $A_f_macro$\nCALL $A_f_macro$')" ]]
+    [[ "$(tvm_macro_body out/x.code g | grep 'CALL')" == 'CALL $f_internal_macro$' ]]
+    # mutually recursive functions are called by id
+    tvm_macro_body out/x.code even | grep -q 'CALL \$odd_internal\$'
+
+    # g calls the override of f by name and the override calls g: that is a recursion
+    cat > y.sol <<'EOF_SOL'
+pragma ton-solidity >= 0.35.0;
+abstract contract A {
+    function f(uint n) internal pure virtual returns (uint) { return n; }
+    function g(uint n) internal pure returns (uint) { if (n == 0) return 0; return f(n - 1); }
+}
+contract B is A {
+    function f(uint n) internal pure override returns (uint) { return g(n) + 1; }
+    function run(uint n) public pure returns (uint) { return f(n); }
+}
+EOF_SOL
+    "$SOLC" y.sol -o out >/dev/null 2>&1
+    tvm_macro_body out/y.code g | grep -q 'CALL \$f_internal\$'
+)
+rm -rf "$SOLTMPDIR"
+
+printTask "Testing TVM shared modifiers..."
+SOLTMPDIR=$(mktemp -d)
+(
+    cd "$SOLTMPDIR"
+    set -e
+    # the prologue of a modifier used by several functions is compiled once, it can call inline functions
+    cat > x.sol <<'EOF_SOL'
+pragma ton-solidity >= 0.35.0;
+contract C {
+    uint m_a;
+    uint m_b;
+    uint m_c;
+    function check(uint x) private inline view {
+        require(x < m_a, 101);
+        require(x != m_b, 102);
+        require(x + m_c > 10, 103);
+    }
+    modifier guard(uint x) {
+        check(x);
+        require(msg.sender != address(0), 104);
+        require(m_a + m_b + m_c > x * 3, 105);
+        tvm.accept();
+        _;
+    }
+    function f(uint x) public guard(x) { m_a = x; }
+    function g(uint x) public guard(x) { m_b = x; }
+    function h(uint x) public guard(x) { m_c = x; }
+}
+EOF_SOL
+    "$SOLC" x.sol -o out >/dev/null
+    awk '/^\.globl\tC_guard_modifier$/{p=1;next} /^\.(macro|globl)/{p=0} p' out/x.code | grep -q 'THROWIFNOT 101'
+    [[ "$(grep -c 'CALL \$C_guard_modifier\$' out/x.code)" == 3 ]]
+)
+rm -rf "$SOLTMPDIR"
+
+printTask "Testing TVM loop invariants..."
+SOLTMPDIR=$(mktemp -d)
+(
+    cd "$SOLTMPDIR"
+    set -e
+    # a state variable is read once before the loop, the code after the loop reads it again
+    cat > x.sol <<'EOF_SOL'
+pragma ton-solidity >= 0.35.0;
+contract C {
+    uint x;
+    function f(uint n) public view returns (uint) {
+        uint s = 0;
+        for (uint i = 0; i < n; i++) {
+            s += x;
+        }
+        return s + (n + x);
+    }
+}
+EOF_SOL
+    "$SOLC" x.sol -o out >/dev/null
+    [[ "$(tvm_macro_body out/x.code f | grep -c 'GETGLOB 10')" == 2 ]]
+    [[ "$(tvm_macro_body out/x.code f | tail -n 4 | tr -d '\t' | tr '\n' ' ')" == "SWAP GETGLOB 10 ADD ADD " ]]
+    # the loop variable stays on the top of the stack and is changed in place
+    [[ "$(tvm_macro_body out/x.code f | grep -B1 'INC' | grep -c 'PUSH')" == 0 ]]
+)
+rm -rf "$SOLTMPDIR"
+
+printTask "Testing TVM message templates..."
+SOLTMPDIR=$(mktemp -d)
+(
+    cd "$SOLTMPDIR"
+    set -e
+    # the template built before the loop doesn't contain the value, STGRAMS throws on values out of
+    # range and the loop can have no iterations
+    cat > x.sol <<'EOF_SOL'
+pragma ton-solidity >= 0.35.0;
+interface IR { function onPay(uint128 amount, uint32 id) external; }
+contract C {
+    address[] m_addrs;
+    function notify(uint128 v, uint128 amount) public view {
+        tvm.accept();
+        for (uint i = 0; i < m_addrs.length; i++) {
+            IR(m_addrs[i]).onPay{value: v, flag: 1}(amount, 7);
+        }
+    }
+    function pay(uint128 v) public view {
+        tvm.accept();
+        for (uint i = 0; i < m_addrs.length; i++) {
+            m_addrs[i].transfer(v, false, 1);
+        }
+    }
+}
+EOF_SOL
+    "$SOLC" x.sol -o out >/dev/null
+    [[ "$(tvm_macro_body out/x.code notify | awk '/^PUSHCONT/{exit} 1' | grep -c 'STGRAMS')" == 0 ]]
+    [[ "$(tvm_macro_body out/x.code notify | grep -c 'STGRAMS')" == 1 ]]
+    [[ "$(tvm_macro_body out/x.code notify | grep -c 'STBR')" == 1 ]]
+    # only the value is sent, there is nothing to build before the loop
+    [[ "$(tvm_macro_body out/x.code pay | grep -c 'STBR')" == 0 ]]
+)
+rm -rf "$SOLTMPDIR"
+
+printTask "Testing TVM break and continue by RETALT..."
+SOLTMPDIR=$(mktemp -d)
+(
+    cd "$SOLTMPDIR"
+    set -e
+    cat > x.sol <<'EOF_SOL'
+pragma ton-solidity >= 0.35.0;
+contract C {
+    function forBreak(uint n) public pure returns (uint s) {
+        for (uint i = 0; i < n; i++) { if (i == 5) break; s += i; }
+    }
+    function forContinue(uint n) public pure returns (uint s) {
+        for (uint i = 0; i < n; i++) { if (i == 5) continue; s += i; }
+    }
+    function whileBreak(uint n) public pure returns (uint s) {
+        while (s < n) { s++; if (s == 5) break; }
+    }
+    function whileContinue(uint n) public pure returns (uint s) {
+        uint i = 0;
+        while (i < n) { i++; if (i == 5) continue; s += i; }
+    }
+    function doWhileBreak(uint n) public pure returns (uint s) {
+        do { s++; if (s == 5) break; } while (s < n);
+    }
+    function doWhileContinue(uint n) public pure returns (uint s) {
+        uint i = 0;
+        do { i++; if (i == 5) continue; s += i; } while (i < n);
+    }
+    function repeatBreak(uint n) public pure returns (uint s) {
+        repeat (n) { s++; if (s == 5) break; }
+    }
+    function repeatContinue(uint n) public pure returns (uint s) {
+        repeat (n) { s++; if (s == 5) continue; s++; }
+    }
+    function nested(uint n) public pure returns (uint s) {
+        for (uint i = 0; i < n; i++) {
+            if (i == 2) continue;
+            for (uint j = 0; j < n; j++) { if (j == i) break; s += j; }
+            if (s > 100) break;
+        }
+    }
+    function dropLocals(uint n) public pure returns (uint s) {
+        for (uint i = 0; i < n; i++) {
+            uint a = i * 2;
+            uint b = a + 1;
+            if (b > 10) break;
+            s += b;
+        }
+    }
+}
+EOF_SOL
+    "$SOLC" x.sol -o out >/dev/null
+    # a loop with only `break` or only `continue` has no flag, c1 is set by SAMEALTSAVE to the end of
+    # the loop (the loop is called by CALLX) or to the end of the body
+    for kind in for while doWhile repeat; do
+        for exit in Break Continue; do
+            body=$(tvm_macro_body out/x.code "${kind}${exit}")
+            [[ "$(echo "$body" | grep -c 'SAMEALTSAVE')" == 1 ]]
+            [[ "$(echo "$body" | grep -c 'RETALT')" == 1 ]]
+            [[ "$(echo "$body" | grep -c 'IFRET\|flag')" == 0 ]]
+            [[ "$(echo "$body" | grep -c '^CALLX$')" == "$([[ $exit == Break ]] && echo 1 || echo 0)" ]]
+        done
+    done
+    # the outer loop has both `break` and `continue` and keeps the flag, the inner one exits by RETALT
+    tvm_macro_body out/x.code nested | grep -q 'decl return flag'
+    [[ "$(tvm_macro_body out/x.code nested | grep -c 'RETALT')" == 1 ]]
+    [[ "$(tvm_macro_body out/x.code nested | grep -c 'SAMEALTSAVE')" == 1 ]]
+    # locals of the body are dropped before RETALT
+    [[ "$(tvm_macro_body out/x.code dropLocals | grep -B1 'RETALT' | head -n 1 | tr -d '\t')" == "DROP2" ]]
+)
+rm -rf "$SOLTMPDIR"
+
+printTask "Testing TVM tuple arrays..."
+SOLTMPDIR=$(mktemp -d)
+(
+    cd "$SOLTMPDIR"
+    set -e
+    cat > x.sol <<'EOF_SOL'
+pragma ton-solidity >= 0.35.0;
+contract C {
+    uint[] m_stored;
+    function small(uint x) public pure returns (uint sum) {
+        uint[] arr = new uint[](3);
+        arr[0] = x;
+        arr.push(7);
+        for (uint v : arr) {
+            sum += v;
+        }
+        arr.pop();
+        sum += arr[1] + arr.length;
+    }
+    function unbounded(uint n) public pure returns (uint) {
+        uint[] a;
+        for (uint i = 0; i < n; i++) a.push(i);
+        return a.length;
+    }
+    function stored() public {
+        uint[] b = new uint[](2);
+        m_stored = b;
+    }
+    function big() public pure returns (uint) {
+        uint[] c = new uint[](300);
+        return c[299];
+    }
+}
+EOF_SOL
+    "$SOLC" x.sol -o out >/dev/null
+    # a local array of bounded size is a tuple, indexes are checked against TLEN and `pop` of an empty array throws
+    [[ "$(tvm_macro_body out/x.code small | grep -c 'DICT')" == 0 ]]
+    tvm_macro_body out/x.code small | grep -q 'TPUSH'
+    tvm_macro_body out/x.code small | grep -q 'TPOP'
+    tvm_macro_body out/x.code small | grep -q 'SETINDEXVAR'
+    [[ "$(tvm_macro_body out/x.code small | grep -c 'THROWIFNOT 50')" == 2 ]]
+    tvm_macro_body out/x.code small | grep -q 'THROWIFNOT 54'
+    # unbounded pushes, assignments to state variables and long arrays keep the dictionary
+    for f in unbounded stored big; do
+        [[ "$(tvm_macro_body out/x.code $f | grep -c 'TUPLE\|TPUSH\|INDEXVAR')" == 0 ]]
+    done
+    tvm_macro_body out/x.code unbounded | grep -q 'DICTUSETB'
+    tvm_macro_body out/x.code big | grep -q 'DICTUGET'
+)
+rm -rf "$SOLTMPDIR"
+
+printTask "Testing TVM constant arrays..."
+SOLTMPDIR=$(mktemp -d)
+(
+    cd "$SOLTMPDIR"
+    set -e
+    cat > x.sol <<'EOF_SOL'
+pragma ton-solidity >= 0.35.0;
+contract C {
+    uint8[] m_bytes;
+    uint32[] m_ids;
+    function setLiteral() public {
+        m_bytes = [uint8(1), 2, 3];
+    }
+    function setZeroes() public {
+        m_ids = new uint32[](3);
+    }
+    function setSized(uint n) public {
+        m_ids = new uint32[](n);
+    }
+}
+EOF_SOL
+    "$SOLC" x.sol -o out >/dev/null
+    # the dictionary of constant elements is built at compile time in the canonical form
+    [[ "$(tvm_macro_body out/x.code setLiteral | tr -d '\t' | tr '\n' ' ')" == \
+        "PUSHINT 3 PUSHREF { .blob xcf4_ .cell { .blob x2_ .cell { .blob x006_ } .cell { .blob x00a_ } } .cell { .blob x403 } } PAIR SETGLOB 10 " ]]
+    [[ "$(tvm_macro_body out/x.code setZeroes | grep -c 'DICT')" == 0 ]]
+    tvm_macro_body out/x.code setZeroes | grep -q 'PUSHREF'
+    # the value of n elements is stored once, the loop only sets keys
+    [[ "$(tvm_macro_body out/x.code setSized | grep -c 'NEWC')" == 1 ]]
+    [[ "$(tvm_macro_body out/x.code setSized | grep -c 'DICTUSETB')" == 1 ]]
+    tvm_macro_body out/x.code setSized | grep -q 'REPEAT'
+)
+rm -rf "$SOLTMPDIR"
+
+printTask "Testing Standard JSON..."
+(
+    cd "$REPO_ROOT"/test/tvmCmdlineTests/
+    for tdir in */
+    do
+        printTask " - ${tdir}"
+        # Replace escaped newlines by actual newlines for readability
+        output=$("$SOLC" --standard-json "${tdir}input.json" | sed -E -e 's/\\n/\'$'\n/g')
+        if [[ "$output" != "$(cat "${tdir}output.json")" ]]
+        then
+            printError "Incorrect output of ${tdir}input.json:"
+            diff <(echo "$output") "${tdir}output.json" || true
+            exit 1
+        fi
+    done
+)
+
+echo "Commandline tests successful."